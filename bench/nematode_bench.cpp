@@ -0,0 +1,1741 @@
+/*
+ * nematode_bench.cpp
+ *
+ *  Self-contained benchmark suite for the parsers, GPS services, arenas, events,
+ *  command and fix encoding, fix serialization, the geodesy kernels, fix history
+ *  lookups, geofences, track simplification, stream demultiplexing, receiver
+ *  output profiles, log seek indexes, checkpoints, AIS decoding and the
+ *  synthetic stream generator.
+ *
+ *  Usage: nematode_bench [--quick] [--filter text] [corpus.txt]
+ *
+ *  See the license file included with this source.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "nmeaparse/nmea.hpp"
+#include "nmeaparse/SharedFix.hpp"
+
+#ifndef NEMATODE_BENCH_CORPUS
+#	define NEMATODE_BENCH_CORPUS "nmea_log.txt"
+#endif
+
+using namespace std;
+using namespace std::chrono;
+using namespace nmea;
+
+// ---------------- Allocation counting ----------------
+
+static atomic<uint64_t> allocations{ 0 };
+
+void*
+operator new(size_t size)
+{
+	allocations.fetch_add(1, memory_order_relaxed);
+	if ( void* ptr = malloc(size == 0 ? 1 : size) ) {
+		return ptr;
+	}
+	throw bad_alloc();
+}
+
+// std::pmr's default resource allocates with the alignment
+void*
+operator new(size_t size, align_val_t alignment)
+{
+	allocations.fetch_add(1, memory_order_relaxed);
+	auto align = static_cast<size_t>(alignment);
+	if ( void* ptr = aligned_alloc(align, (size + align - 1) / align * align) ) {
+		return ptr;
+	}
+	throw bad_alloc();
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t /*size*/) noexcept
+{
+	free(ptr);
+}
+
+void
+operator delete(void* ptr, align_val_t /*alignment*/) noexcept
+{
+	free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t /*size*/, align_val_t /*alignment*/) noexcept
+{
+	free(ptr);
+}
+
+// ---------------- Harness ----------------
+
+struct Options {
+	bool           quick{ false };
+	string         filter;
+	string         corpusPath{ NEMATODE_BENCH_CORPUS };
+	nanoseconds    minTime{ milliseconds(300) };
+	vector<string> corpus;    // lines of the log file
+	vector<string> synthetic; // 10 Hz multi-GNSS lines
+};
+
+struct Result {
+	double ns;     // per item
+	double mbps;   // 0 if bytes are unknown
+	double allocs; // per item
+};
+
+static volatile uint64_t sink = 0;
+
+static int failures = 0; // checks that didn't hold, main() returns non-zero if any
+
+// For the sections that check results: reports a failure and carries on
+static void
+expect(bool ok, const string& what)
+{
+	if ( !ok ) {
+		cout << "  FAILED: " << what << endl;
+		failures++;
+	}
+}
+
+// Runs body (which processes `items` items and `bytes` bytes) until the minimum time has passed.
+static Result
+measure(const Options& opts, uint64_t items, uint64_t bytes, const function<void()>& body)
+{
+	body(); // warm up
+
+	uint64_t rounds = 0;
+	uint64_t allocs = allocations.load(memory_order_relaxed);
+	auto     start  = steady_clock::now();
+	auto     now    = start;
+	do {
+		body();
+		rounds++;
+		now = steady_clock::now();
+	} while ( now - start < opts.minTime );
+	allocs = allocations.load(memory_order_relaxed) - allocs;
+
+	auto   total   = static_cast<double>(duration_cast<nanoseconds>(now - start).count());
+	double count   = static_cast<double>(rounds * items);
+	double seconds = total / 1e9;
+
+	Result res{};
+	res.ns     = total / count;
+	res.mbps   = bytes != 0 ? static_cast<double>(rounds * bytes) / seconds / 1e6 : 0.0;
+	res.allocs = static_cast<double>(allocs) / count;
+	return res;
+}
+
+static void
+report(const Options& opts, const string& name, const string& unit, uint64_t items, uint64_t bytes, const function<void()>& body)
+{
+	if ( !opts.filter.empty() && name.find(opts.filter) == string::npos ) {
+		return;
+	}
+
+	Result res = measure(opts, items, bytes, body);
+	cout << left << setw(50) << name << right << fixed
+	     << setw(10) << setprecision(1) << res.ns << " ns/" << left << setw(9) << unit << right;
+	if ( res.mbps > 0 ) {
+		cout << setw(9) << setprecision(1) << res.mbps << " MB/s";
+	}
+	else {
+		cout << setw(14) << "";
+	}
+	cout << setw(9) << setprecision(2) << res.allocs << " allocs/" << unit << endl;
+}
+
+static uint64_t
+totalBytes(const vector<string>& lines)
+{
+	uint64_t bytes = 0;
+	for ( const auto& line: lines ) {
+		bytes += line.size() + 2; // readLine() appends \r\n
+	}
+	return bytes;
+}
+
+// ---------------- Binary frames ----------------
+
+static void
+appendUBX(vector<uint8_t>& out, uint16_t type, const vector<uint8_t>& payload)
+{
+	size_t start = out.size();
+	out.insert(out.end(), { 0xB5, 0x62, static_cast<uint8_t>(type >> 8), static_cast<uint8_t>(type), static_cast<uint8_t>(payload.size()),
+	                        static_cast<uint8_t>(payload.size() >> 8) });
+	out.insert(out.end(), payload.begin(), payload.end());
+	uint16_t checksum = StreamDemultiplexer::ubxChecksum(out.data() + start + 2, out.size() - start - 2);
+	out.push_back(static_cast<uint8_t>(checksum));
+	out.push_back(static_cast<uint8_t>(checksum >> 8));
+}
+
+static void
+appendSiRF(vector<uint8_t>& out, const vector<uint8_t>& payload)
+{
+	uint32_t sum = 0;
+	for ( auto byte: payload ) {
+		sum += byte;
+	}
+	out.insert(out.end(), { 0xA0, 0xA2, static_cast<uint8_t>(payload.size() >> 8), static_cast<uint8_t>(payload.size()) });
+	out.insert(out.end(), payload.begin(), payload.end());
+	out.insert(out.end(), { static_cast<uint8_t>((sum >> 8) & 0x7F), static_cast<uint8_t>(sum), 0xB0, 0xB3 });
+}
+
+static void
+appendRTCM3(vector<uint8_t>& out, const vector<uint8_t>& payload)
+{
+	size_t start = out.size();
+	out.insert(out.end(), { 0xD3, static_cast<uint8_t>(payload.size() >> 8), static_cast<uint8_t>(payload.size()) });
+	out.insert(out.end(), payload.begin(), payload.end());
+	uint32_t crc = StreamDemultiplexer::crc24q(out.data() + start, out.size() - start);
+	out.insert(out.end(), { static_cast<uint8_t>(crc >> 16), static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc) });
+}
+
+static void
+putLE(vector<uint8_t>& payload, size_t offset, uint32_t value, size_t size)
+{
+	for ( size_t i = 0; i < size; i++ ) {
+		payload[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+	}
+}
+
+// A UBX-NAV-PVT payload for the ith 10 Hz epoch, 3D fix
+static vector<uint8_t>
+makeNavPvt(size_t i)
+{
+	vector<uint8_t> p(92);
+	auto            tenths = static_cast<uint32_t>(i % 864000);
+	putLE(p, 0, static_cast<uint32_t>(i * 100), 4);
+	putLE(p, 4, 2011, 2);
+	p[6]  = 5;
+	p[7]  = 28;
+	p[8]  = static_cast<uint8_t>(tenths / 36000);
+	p[9]  = static_cast<uint8_t>(tenths / 600 % 60);
+	p[10] = static_cast<uint8_t>(tenths / 10 % 60);
+	p[11] = 0x07;
+	putLE(p, 16, tenths % 10 * 100000000, 4);
+	p[20] = 3;
+	p[21] = 0x01;
+	p[23] = 9;
+	putLE(p, 24, static_cast<uint32_t>(-65000000 + static_cast<int32_t>(i % 10000)), 4);
+	putLE(p, 28, static_cast<uint32_t>(533600000 + static_cast<int32_t>(i % 10000)), 4);
+	putLE(p, 36, 45200, 4);
+	putLE(p, 60, 13900, 4);
+	putLE(p, 64, 9000000, 4);
+	putLE(p, 76, 130, 2);
+	return p;
+}
+
+// ---------------- Corpus ----------------
+
+static vector<string>
+loadCorpus(const string& path)
+{
+	vector<string> lines;
+	ifstream       file(path);
+	for ( string line; getline(file, line); ) {
+		if ( !line.empty() && line.back() == '\r' ) {
+			line.pop_back();
+		}
+		if ( !line.empty() ) {
+			lines.push_back(line);
+		}
+	}
+	return lines;
+}
+
+static void
+splitLines(const char* text, size_t size, vector<string>& lines)
+{
+	const char* end = text + size;
+	while ( text < end ) {
+		auto* eol = static_cast<const char*>(memchr(text, '\n', static_cast<size_t>(end - text)));
+		eol       = eol != nullptr ? eol : end;
+		lines.emplace_back(text, eol != text && eol[-1] == '\r' ? eol - 1 : eol);
+		text = eol + 1;
+	}
+}
+
+// 10 epochs per second, GPS + GLONASS + Galileo satellites in view.
+static vector<string>
+makeSynthetic(int epochs)
+{
+	NMEAGeneratorSettings gps;
+	gps.rate = 10.0;
+
+	// The other constellations only add their own GSA and GSV
+	NMEAGeneratorSettings glonass = gps;
+	glonass.talker                = "GL";
+	glonass.satellites            = 8;
+	glonass.sentences             = (1u << NMEASentence::GSA) | (1u << NMEASentence::GSV);
+	glonass.seed                  = 2;
+	NMEAGeneratorSettings galileo = glonass;
+	galileo.talker                = "GA";
+	galileo.seed                  = 3;
+
+	NMEAGenerator  generators[] = { NMEAGenerator(gps), NMEAGenerator(glonass), NMEAGenerator(galileo) };
+	vector<string> lines;
+	char           buf[NMEAGenerator::MaxEpochSize];
+	for ( int e = 0; e < epochs; e++ ) {
+		for ( auto& generator: generators ) {
+			splitLines(buf, generator.nextEpoch(buf, sizeof(buf)), lines);
+		}
+	}
+	return lines;
+}
+
+// ---------------- Benchmarks ----------------
+
+static void
+parseQuietly(NMEAParser& parser, const string& line)
+{
+	try {
+		parser.readLine(line);
+	}
+	catch ( exception& ) {
+		// bad sentences are part of the corpus
+	}
+}
+
+static void
+benchReaders(const Options& opts, const string& label, const vector<string>& lines)
+{
+	string text;
+	for ( const auto& line: lines ) {
+		text += line + "\r\n";
+	}
+	uint64_t bytes = text.size();
+	auto     count = static_cast<uint64_t>(lines.size());
+
+	NMEAParser parser;
+	GPSService gps(parser);
+
+	report(opts, "readByte    " + label, "sentence", count, bytes, [&]() {
+		for ( auto chr: text ) {
+			try {
+				parser.readByte(static_cast<uint8_t>(chr));
+			}
+			catch ( exception& ) {
+			}
+		}
+	});
+
+	report(opts, "readBuffer  " + label, "sentence", count, bytes, [&]() {
+		// the parser throws out of the middle of the buffer, continue behind the bad sentence
+		auto*    data = reinterpret_cast<uint8_t*>(&text[0]);
+		uint32_t pos  = 0;
+		while ( pos < bytes ) {
+			const void* nl   = memchr(data + pos, '\n', bytes - pos);
+			uint32_t    next = nl != nullptr ? static_cast<uint32_t>(static_cast<const uint8_t*>(nl) - data) + 1 : static_cast<uint32_t>(bytes);
+			try {
+				parser.readBuffer(data + pos, next - pos);
+			}
+			catch ( exception& ) {
+			}
+			pos = next;
+		}
+	});
+
+	report(opts, "readLine    " + label, "sentence", count, bytes, [&]() {
+		for ( const auto& line: lines ) {
+			parseQuietly(parser, line);
+		}
+	});
+
+	NMEAParser bare; // no handlers, just tokenizing
+	report(opts, "readSentence/parseText " + label, "sentence", count, bytes, [&]() {
+		for ( const auto& line: lines ) {
+			try {
+				bare.readSentence(line);
+			}
+			catch ( exception& ) {
+			}
+		}
+	});
+}
+
+// A single-purpose extract job (fix quality of every GGA) through handlers
+// against a pull loop the compiler can inline
+static void
+benchExtract(const Options& opts, const string& label, const vector<string>& lines)
+{
+	string text;
+	for ( const auto& line: lines ) {
+		text += line + "\r\n";
+	}
+	uint64_t bytes = text.size();
+	auto     count = static_cast<uint64_t>(lines.size());
+	uint64_t found = 0;
+
+	auto isGGA = [](string_view name) { return name.size() == 5 && name.compare(2, 3, "GGA") == 0; };
+
+	NMEAParser parser;
+	parser.onSentence_ += [&](const NMEASentence& nmea) {
+		if ( isGGA(nmea.name_) && nmea.parameters_.size() > 5 && !nmea.parameters_[5].empty() ) {
+			found += static_cast<uint64_t>(nmea.parameters_[5][0] - '0');
+		}
+	};
+	report(opts, "Extract GGA, onSentence_ " + label, "sentence", count, bytes, [&]() {
+		try {
+			parser.readBuffer(reinterpret_cast<uint8_t*>(&text[0]), static_cast<uint32_t>(bytes));
+		}
+		catch ( exception& ) {
+		}
+	});
+
+	static uint64_t fixedFound = 0;
+	FixedNMEAParser fixedParser;
+	fixedParser.setAnySentenceHandler([](void*, const SentenceView& sentence) {
+		if ( sentence.name_.size() == 5 && sentence.name_.compare(2, 3, "GGA") == 0 && !sentence.parameter(5).empty() ) {
+			fixedFound += static_cast<uint64_t>(sentence.parameter(5)[0] - '0');
+		}
+		return ParseStatus::Ok;
+	});
+	report(opts, "Extract GGA, FixedNMEAParser " + label, "sentence", count, bytes, [&]() {
+		fixedParser.readBuffer(reinterpret_cast<const uint8_t*>(text.data()), bytes);
+	});
+
+	report(opts, "Extract GGA, sentences() " + label, "sentence", count, bytes, [&]() {
+		uint64_t sum = 0;
+		for ( const SentenceView& sentence: sentences(text) ) {
+			if ( isGGA(sentence.name_) && !sentence.parameter(5).empty() ) {
+				sum += static_cast<uint64_t>(sentence.parameter(5)[0] - '0');
+			}
+		}
+		sink = sink + sum;
+	});
+	sink = sink + found + fixedFound;
+}
+
+// GGA and RMC handlers by name: looked up in a map and called through
+// std::function, through a table of function pointers, or fixed at compile time
+static void
+benchDispatch(const Options& opts, const string& label, const vector<string>& lines)
+{
+	string text;
+	for ( const auto& line: lines ) {
+		text += line + "\r\n";
+	}
+	uint64_t bytes = text.size();
+	auto     count = static_cast<uint64_t>(lines.size());
+	uint64_t gga   = 0;
+	uint64_t rmc   = 0;
+
+	NMEAParser parser;
+	parser.setSentenceHandler("GPGGA", [&](const NMEASentence&) { gga++; });
+	parser.setSentenceHandler("GPRMC", [&](const NMEASentence&) { rmc++; });
+	report(opts, "Dispatch, NMEAParser " + label, "sentence", count, bytes, [&]() {
+		try {
+			parser.readBuffer(reinterpret_cast<uint8_t*>(&text[0]), static_cast<uint32_t>(bytes));
+		}
+		catch ( exception& ) {
+		}
+	});
+
+	FixedNMEAParser fixedParser;
+	fixedParser.setSentenceHandler("GPGGA", [](void* context, const SentenceView&) {
+		(*static_cast<uint64_t*>(context))++;
+		return ParseStatus::Ok;
+	}, &gga);
+	fixedParser.setSentenceHandler("GPRMC", [](void* context, const SentenceView&) {
+		(*static_cast<uint64_t*>(context))++;
+		return ParseStatus::Ok;
+	}, &rmc);
+	report(opts, "Dispatch, FixedNMEAParser " + label, "sentence", count, bytes, [&]() {
+		fixedParser.readBuffer(reinterpret_cast<const uint8_t*>(text.data()), bytes);
+	});
+
+	BasicNMEAParser basicParser(on<sentenceKey("GPGGA")>([&](const SentenceView&) { gga++; }),
+	                            on<sentenceKey("GPRMC")>([&](const SentenceView&) { rmc++; }));
+	report(opts, "Dispatch, BasicNMEAParser " + label, "sentence", count, bytes, [&]() {
+		basicParser.readBuffer(reinterpret_cast<const uint8_t*>(text.data()), bytes);
+	});
+	sink = sink + gga + rmc;
+}
+
+// GGA and RMC handlers on a stream that has every sentence type, reading
+// everything or skipping the rest of a line once its name is unwanted
+static void
+benchInterest(const Options& opts, const string& label, const vector<string>& lines)
+{
+	string text;
+	for ( const auto& line: lines ) {
+		text += line + "\r\n";
+	}
+	uint64_t bytes = text.size();
+	auto     count = static_cast<uint64_t>(lines.size());
+	uint64_t gga   = 0;
+	uint64_t rmc   = 0;
+
+	Metrics metrics;
+	for ( auto interest: { NMEAParser::Interest::All, NMEAParser::Interest::Handlers } ) {
+		NMEAParser parser;
+		parser.setSentenceHandler("GPGGA", [&](const NMEASentence&) { gga++; });
+		parser.setSentenceHandler("GPRMC", [&](const NMEASentence&) { rmc++; });
+		parser.setInterest(interest);
+		if ( interest == NMEAParser::Interest::Handlers ) {
+			parser.setMetrics(&metrics);
+		}
+		string name = interest == NMEAParser::Interest::All ? "Interest, all " : "Interest, GGA+RMC handlers ";
+		report(opts, name + label, "sentence", count, bytes, [&]() {
+			try {
+				parser.readBuffer(reinterpret_cast<uint8_t*>(&text[0]), static_cast<uint32_t>(bytes));
+			}
+			catch ( exception& ) {
+			}
+		});
+	}
+	sink = sink + gga + rmc;
+
+	if ( !opts.filter.empty() && string("Interest").find(opts.filter) == string::npos ) {
+		return;
+	}
+	cout << "  " << fixed << setprecision(0) << 100.0 * static_cast<double>(metrics.get(Metrics::SkippedBytes)) / static_cast<double>(metrics.get(Metrics::BytesIn))
+	     << "% of the bytes skipped" << endl;
+}
+
+// ---------------- AIS ----------------
+
+// 6-bit fields written most significant bit first, then armored
+class AISPayload {
+private:
+	string bits_;
+
+public:
+	void put(uint32_t value, size_t size)
+	{
+		while ( size-- > 0 ) {
+			bits_ += (value >> size & 1) != 0 ? '1' : '0';
+		}
+	}
+
+	void putText(const string& text, size_t size)
+	{
+		for ( size_t i = 0; i < size; i++ ) {
+			char chr = i < text.size() ? text[i] : '@';
+			put(static_cast<uint32_t>(chr >= 64 ? chr - 64 : chr), 6);
+		}
+	}
+
+	// The armored characters and the fill bits
+	pair<string, size_t> armor() const
+	{
+		string padded = bits_;
+		size_t fill   = (6 - padded.size() % 6) % 6;
+		padded.append(fill, '0');
+		string out;
+		for ( size_t i = 0; i < padded.size(); i += 6 ) {
+			auto value = static_cast<char>(stoi(padded.substr(i, 6), nullptr, 2));
+			out += value < 40 ? static_cast<char>(value + 48) : static_cast<char>(value + 56);
+		}
+		return { out, fill };
+	}
+};
+
+static string
+aisSentence(size_t count, size_t number, const string& sequence, char channel, const string& payload, size_t fill)
+{
+	string body = "AIVDM," + to_string(count) + "," + to_string(number) + "," + sequence + "," + channel + "," + payload + "," + to_string(fill);
+	char   checksum[4];
+	snprintf(checksum, sizeof(checksum), "*%02X", xorChecksum(body));
+	return "!" + body + checksum;
+}
+
+// A busy coastal feed: class A and class B position reports of 200 vessels,
+// every tenth message a voyage report in two sentences
+static vector<string>
+makeAIS(size_t messages)
+{
+	vector<string> lines;
+	for ( size_t i = 0; i < messages; i++ ) {
+		auto       vessel = static_cast<uint32_t>(i % 200);
+		auto       mmsi   = 244000000 + vessel;
+		AISPayload payload;
+		if ( i % 10 == 9 ) {
+			payload.put(5, 6);
+			payload.put(0, 2);
+			payload.put(mmsi, 30);
+			payload.put(0, 2);
+			payload.put(9000000 + vessel, 30);
+			payload.putText("PD" + to_string(vessel), 7);
+			payload.putText("VESSEL " + to_string(vessel), 20);
+			payload.put(70, 8);
+			payload.put(100, 9);
+			payload.put(20, 9);
+			payload.put(6, 6);
+			payload.put(6, 6);
+			payload.put(1, 4);
+			payload.put(5, 4);
+			payload.put(28, 5);
+			payload.put(12, 5);
+			payload.put(30, 6);
+			payload.put(85, 8);
+			payload.putText("ROTTERDAM", 20);
+			payload.put(0, 2);
+			auto [armored, fill] = payload.armor();
+			string sequence      = to_string(i / 10 % 10);
+			lines.push_back(aisSentence(2, 1, sequence, 'A', armored.substr(0, 60), 0));
+			lines.push_back(aisSentence(2, 2, sequence, 'A', armored.substr(60), fill));
+			continue;
+		}
+		bool classB    = vessel % 4 == 0;
+		auto longitude = static_cast<int32_t>((4.0 + vessel * 0.001 + static_cast<double>(i % 1000) * 1e-6) * 600000);
+		auto latitude  = static_cast<int32_t>((51.9 + vessel * 0.0005) * 600000);
+		payload.put(classB ? 18 : 1, 6);
+		payload.put(0, 2);
+		payload.put(mmsi, 30);
+		if ( classB ) {
+			payload.put(0, 8); // reserved
+		}
+		else {
+			payload.put(0, 4);    // under way using engine
+			payload.put(0x80, 8); // no turn indicator
+		}
+		payload.put(123, 10);
+		payload.put(1, 1);
+		payload.put(static_cast<uint32_t>(longitude) & 0x0FFFFFFF, 28);
+		payload.put(static_cast<uint32_t>(latitude) & 0x07FFFFFF, 27);
+		payload.put(2240, 12);
+		payload.put(215, 9);
+		payload.put(static_cast<uint32_t>(i % 60), 6);
+		payload.put(0, classB ? 29 : 25);
+		auto [armored, fill] = payload.armor();
+		lines.push_back(aisSentence(1, 1, "", i % 2 == 0 ? 'A' : 'B', armored, fill));
+	}
+	return lines;
+}
+
+static void
+benchAIS(const Options& opts)
+{
+	vector<string> lines = makeAIS(opts.quick ? 500 : 5000);
+	string         text;
+	for ( const auto& line: lines ) {
+		text += line + "\r\n";
+	}
+	uint64_t bytes = text.size();
+	auto     count = static_cast<uint64_t>(lines.size());
+
+	static uint64_t found = 0;
+	AISDecoder      ais;
+	ais.setPositionHandler([](void*, const AISPosition& report) { found += report.mmsi_; });
+	ais.setVoyageHandler([](void*, const AISVoyage& report) { found += report.imo_; });
+
+	FixedNMEAParser fixedParser;
+	ais.attachToParser(fixedParser);
+	report(opts, "AIS, FixedNMEAParser + AISDecoder", "sentence", count, bytes, [&]() {
+		fixedParser.readBuffer(reinterpret_cast<const uint8_t*>(text.data()), bytes);
+	});
+
+	NMEAParser parser;
+	parser.setSentenceHandler("AIVDM", [&](const NMEASentence& nmea) { ais.readSentence(nmea.text_); });
+	report(opts, "AIS, NMEAParser + AISDecoder", "sentence", count, bytes, [&]() {
+		try {
+			parser.readBuffer(reinterpret_cast<uint8_t*>(&text[0]), static_cast<uint32_t>(bytes));
+		}
+		catch ( exception& ) {
+		}
+	});
+
+	report(opts, "AIS, sentences() + AISDecoder", "sentence", count, bytes, [&]() {
+		for ( const SentenceView& sentence: sentences(text) ) {
+			ais.readSentence(sentence);
+		}
+	});
+	sink = sink + found;
+
+	if ( !opts.filter.empty() && string("AIS").find(opts.filter) == string::npos ) {
+		return;
+	}
+	AISDecoder      check;
+	FixedNMEAParser checkParser;
+	check.attachToParser(checkParser);
+	checkParser.readBuffer(reinterpret_cast<const uint8_t*>(text.data()), bytes);
+	cout << "  " << count << " sentences: " << check.messages() << " messages decoded, " << check.unsupported() << " unsupported, " << check.dropped()
+	     << " dropped, " << checkParser.errors() << " errors" << endl;
+}
+
+static void
+benchNumbers(const Options& opts)
+{
+	const vector<string> doubles = { "4807.038", "01131.000", "545.4", "0.9", "-30.8", "092750.000", "" };
+	const vector<string> ints    = { "1", "08", "280511", "137", "", "46" };
+
+	report(opts, "parseDouble", "call", doubles.size(), 0, [&]() {
+		double sum = 0;
+		for ( const auto& str: doubles ) {
+			sum += parseDouble(str);
+		}
+		sink = static_cast<uint64_t>(sum);
+	});
+
+	report(opts, "parseInt", "call", ints.size(), 0, [&]() {
+		int64_t sum = 0;
+		for ( const auto& str: ints ) {
+			sum += parseInt(str);
+		}
+		sink = static_cast<uint64_t>(sum);
+	});
+}
+
+static void
+benchService(const Options& opts, const string& label, const vector<string>& lines)
+{
+	// One run per sentence type, each sentence goes through parse and GPSService decode
+	vector<string> names;
+	for ( const auto& line: lines ) {
+		string name = line.substr(1, line.find(',') - 1);
+		if ( find(names.begin(), names.end(), name) == names.end() ) {
+			names.push_back(name);
+		}
+	}
+
+	for ( const auto& name: names ) {
+		vector<string> subset;
+		for ( const auto& line: lines ) {
+			if ( line.compare(1, name.size(), name) == 0 ) {
+				subset.push_back(line);
+			}
+		}
+
+		NMEAParser parser;
+		GPSService gps(parser);
+		gps.onUpdate += []() { sink = sink + 1; };
+
+		report(opts, "GPSService dispatch " + name + " " + label, "sentence", subset.size(), totalBytes(subset), [&]() {
+			for ( const auto& line: subset ) {
+				try {
+					parser.readSentence(line);
+				}
+				catch ( exception& ) {
+				}
+			}
+		});
+
+		FixedNMEAParser fixedParser;
+		FixedGPSService fixedGps(fixedParser);
+		fixedGps.setUpdateHandler([](void*, const GPSFix&) { sink = sink + 1; });
+
+		report(opts, "FixedGPSService dispatch " + name + " " + label, "sentence", subset.size(), totalBytes(subset), [&]() {
+			for ( const auto& line: subset ) {
+				sink = sink + static_cast<uint64_t>(fixedParser.readSentence(line));
+			}
+		});
+	}
+}
+
+// A receiver from connect to disconnect: set up, read the stream, torn down.
+// On an arena the teardown frees nothing piecewise, the arena goes at once.
+static void
+benchConnections(const Options& opts, const string& label, const vector<string>& lines)
+{
+	auto connection = [&](pmr::memory_resource* resource) {
+		NMEAParser parser(resource);
+		GPSService gps(parser);
+		gps.onUpdate += []() { sink = sink + 1; };
+		for ( const auto& line: lines ) {
+			parseQuietly(parser, line);
+		}
+	};
+
+	report(opts, "Receiver lifetime, default resource " + label, "receiver", 1, totalBytes(lines), [&]() {
+		connection(pmr::get_default_resource());
+	});
+	report(opts, "Receiver lifetime, monotonic arena " + label, "receiver", 1, totalBytes(lines), [&]() {
+		pmr::monotonic_buffer_resource arena;
+		connection(&arena);
+	});
+}
+
+static void
+benchEvents(const Options& opts)
+{
+	for ( int handlers: { 0, 1, 4, 16 } ) {
+		Event<void(int)> event;
+		for ( int i = 0; i < handlers; i++ ) {
+			event += [](int value) { sink = sink + static_cast<uint64_t>(value); };
+		}
+		const uint64_t calls = 1000;
+		report(opts, "Event::call " + to_string(handlers) + " handlers", "call", calls, 0, [&]() {
+			for ( uint64_t i = 0; i < calls; i++ ) {
+				event.call(1);
+			}
+		});
+	}
+}
+
+static void
+benchCommands(const Options& opts)
+{
+	NMEACommand generic("CMD1");
+	generic.message_ = "nothing,special";
+
+	NMEACommandQueryRate rate;
+	rate.messageID_ = NMEASentence::GGA;
+	rate.rate_      = 1;
+
+	NMEACommandSerialConfiguration serial;
+	serial.baud_ = 9600;
+
+	report(opts, "NMEACommand::toString", "command", 1, 0, [&]() { sink = generic.toString().size(); });
+	report(opts, "NMEACommandQueryRate::toString", "command", 1, 0, [&]() { sink = rate.toString().size(); });
+	report(opts, "NMEACommandSerialConfiguration::toString", "command", 1, 0, [&]() { sink = serial.toString().size(); });
+
+	array<char, NMEACommand::MaxSize> out;
+	report(opts, "NMEACommandQueryRate::encode", "command", 1, 0, [&]() { sink = rate.encode(out); });
+	report(opts, "NMEACommandSerialConfiguration::encode", "command", 1, 0, [&]() { sink = serial.encode(out); });
+
+	// a reconnect's worth of configuration: port settings plus a rate for every sentence type
+	array<char, 1024>    batchBuf;
+	NMEACommandQueryRate rates[6];
+	for ( int i = 0; i < 6; i++ ) {
+		rates[i].messageID_ = static_cast<NMEASentence::MessageID>(i);
+		rates[i].rate_      = 1;
+	}
+	// same command from a compile-time template, only the digits and checksum are patched
+	auto     rateTemplate = makeSentence("PSRF103,##,00,##,01");
+	uint32_t counter      = 0;
+	report(opts, "StaticSentence::set (PSRF103 template)", "command", 1, 0, [&]() {
+		rateTemplate.set(1, counter++ % 100);
+		sink = rateTemplate.checksum();
+	});
+
+	report(opts, "NMEACommandBatch (7 commands)", "batch", 1, 0, [&]() {
+		NMEACommandBatch batch(batchBuf);
+		batch.add(serial);
+		for ( const auto& cmd: rates ) {
+			batch.add(cmd);
+		}
+		sink = batch.size();
+	});
+}
+
+static void
+benchGenerator(const Options& opts)
+{
+	NMEAGeneratorSettings settings;
+	settings.rate = 10.0;
+	NMEAGenerator generator(settings);
+	vector<char>  buf(1 << 20);
+
+	// bytes per fill() vary a little with the epoch, measure one to size the report
+	size_t bytes = generator.fill(buf.data(), buf.size());
+	report(opts, "NMEAGenerator::fill (1 MiB)", "buffer", 1, bytes, [&]() { sink = generator.fill(buf.data(), buf.size()); });
+
+	char epoch[NMEAGenerator::MaxEpochSize];
+	report(opts, "NMEAGenerator::nextEpoch", "epoch", 1, generator.nextEpoch(epoch, sizeof(epoch)), [&]() { sink = generator.nextEpoch(epoch, sizeof(epoch)); });
+}
+
+// Rebroadcasting a fix read from the synthetic stream
+static void
+benchFixEncoder(const Options& opts)
+{
+	NMEAParser parser;
+	GPSService gps(parser);
+	for ( const auto& line: opts.synthetic ) {
+		parseQuietly(parser, line);
+	}
+
+	GPSFixEncoder encoder;
+	char          buf[2048];
+	size_t        bytes = encoder.encode(gps.fix_, buf, sizeof(buf));
+	size_t        gga   = encoder.encodeGGA(gps.fix_, buf, sizeof(buf));
+
+	report(opts, "GPSFixEncoder::encodeGGA", "sentence", 1, gga, [&]() { sink = encoder.encodeGGA(gps.fix_, buf, sizeof(buf)); });
+	report(opts, "GPSFixEncoder::encode (GGA,GSA,GSV,RMC,VTG)", "fix", 1, bytes, [&]() { sink = encoder.encode(gps.fix_, buf, sizeof(buf)); });
+}
+
+// Telemetry output of the fix read from the synthetic stream
+static void
+benchSerializer(const Options& opts)
+{
+	NMEAParser parser;
+	GPSService gps(parser);
+	for ( const auto& line: opts.synthetic ) {
+		parseQuietly(parser, line);
+	}
+	const GPSFix& fix = gps.fix_;
+
+	uint64_t bytes   = 0;
+	auto     counter = [&bytes](const char* /*data*/, size_t size) { bytes += size; };
+
+	auto run = [&](const string& name, FixSerializerSettings settings) {
+		FixSerializer out(counter, settings);
+		out.write(fix);
+		size_t size = out.buffered();
+		report(opts, name, "fix", 1000, size * 1000, [&]() {
+			for ( int i = 0; i < 1000; i++ ) {
+				out.write(fix);
+			}
+		});
+		sink = bytes;
+	};
+
+	FixSerializerSettings json;
+	run("FixSerializer JSON Lines (shortest)", json);
+	json.coordinatePrecision = 7;
+	json.valuePrecision      = 2;
+	run("FixSerializer JSON Lines (7/2 decimals)", json);
+	FixSerializerSettings csv;
+	csv.format = SerialFormat::CSV;
+	run("FixSerializer CSV (shortest)", csv);
+
+	// what formatting by hand with iostreams costs
+	report(opts, "ostringstream JSON (for comparison)", "fix", 1, 0, [&]() {
+		ostringstream strm;
+		strm << setprecision(17) << "{\"lat\":" << fix.latitude_ << ",\"lon\":" << fix.longitude_ << ",\"alt\":" << fix.altitude_
+		     << ",\"speed\":" << fix.speed_ << ",\"course\":" << fix.travelAngle_ << ",\"pdop\":" << fix.dilution_
+		     << ",\"hdop\":" << fix.horizontalDilution_ << ",\"vdop\":" << fix.verticalDilution_
+		     << ",\"tracking\":" << fix.trackingSatellites_ << ",\"visible\":" << fix.visibleSatellites_ << "}\n";
+		sink = strm.str().size();
+	});
+}
+
+// Publishing a fix into shared memory and reading it back, then how long a
+// fix takes to reach a reader that polls and one that sleeps on the futex
+static void
+benchSharedFix(const Options& opts)
+{
+	NMEAParser parser;
+	GPSService gps(parser);
+	for ( const auto& line: opts.synthetic ) {
+		parseQuietly(parser, line);
+	}
+	string name = "nematode-bench-" + to_string(steady_clock::now().time_since_epoch().count());
+
+	try {
+		SharedFixPublisher publisher(name);
+		SharedFixReader    reader(name);
+		SharedFixRecord    record;
+
+		report(opts, "SharedFixPublisher::publish", "fix", 1000, 0, [&]() {
+			for ( int i = 0; i < 1000; i++ ) {
+				publisher.publish(gps.fix_);
+			}
+		});
+		report(opts, "SharedFixReader::latest", "fix", 1000, 0, [&]() {
+			for ( int i = 0; i < 1000; i++ ) {
+				reader.latest(record);
+			}
+			sink = record.sequence_;
+		});
+
+		if ( !opts.filter.empty() && string("SharedFix latency").find(opts.filter) == string::npos ) {
+			SharedFixPublisher::remove(name);
+			return;
+		}
+		for ( bool sleeping: { false, true } ) {
+			vector<int64_t> ages;
+			atomic<bool>    ready{ false };
+			auto            live = make_unique<SharedFixPublisher>(name); // the same layout, carries on
+			thread          consumer([&]() {
+				SharedFixReader own(name);
+				SharedFixRecord fix;
+				own.latest(fix);
+				ready = true;
+				while ( !own.closed() ) {
+					if ( sleeping ? own.wait(fix, milliseconds(100)) : own.next(fix) ) {
+						ages.push_back(fix.age().count());
+					}
+				}
+			});
+			while ( !ready ) {
+				this_thread::yield();
+			}
+			for ( int i = 0; i < 2000; i++ ) {
+				live->publish(gps.fix_);
+				this_thread::sleep_for(microseconds(200));
+			}
+			live.reset(); // closes the segment, the consumer stops
+			consumer.join();
+			sort(ages.begin(), ages.end());
+			if ( !ages.empty() ) {
+				cout << "  " << (sleeping ? "wait(), futex" : "next(), polling") << ": " << ages.size() << " fixes, publish to read median "
+				     << fixed << setprecision(1) << static_cast<double>(ages[ages.size() / 2]) / 1000 << " us, 99% "
+				     << static_cast<double>(ages[ages.size() * 99 / 100]) / 1000 << " us" << endl;
+			}
+		}
+	}
+	catch ( exception& e ) {
+		cout << "SharedFix skipped: " << e.what() << endl;
+	}
+	SharedFixPublisher::remove(name);
+}
+
+// Batch geodesy over a track against the scalar reference, plus how far apart they are
+static void
+benchGeodesy(const Options& opts)
+{
+	const size_t Size = 4096;
+
+	// a drive at 10 Hz, and points anywhere on earth for the accuracy check
+	mt19937                          random(7);
+	uniform_real_distribution<double> step(-2e-5, 2e-5);
+	uniform_real_distribution<double> anyLat(-89.9, 89.9);
+	uniform_real_distribution<double> anyLon(-180, 180);
+	CoordinateArrays                  track;
+	CoordinateArrays                  world;
+	track.reserve(Size);
+	world.reserve(Size);
+	double lat = 47.2;
+	double lon = 8.5;
+	for ( size_t i = 0; i < Size; i++ ) {
+		lat += step(random);
+		lon += step(random);
+		track.append(lat, lon, 400 + step(random) * 1e5);
+		world.append(anyLat(random), anyLon(random), step(random) * 1e8);
+	}
+	const double* latitude  = track.latitude_.data();
+	const double* longitude = track.longitude_.data();
+	const double* altitude  = track.altitude_.data();
+
+	vector<double>   out(Size);
+	vector<double>   x(Size);
+	vector<double>   y(Size);
+	vector<double>   z(Size);
+	vector<uint64_t> hashes(Size);
+	LocalFrame       frame(latitude[0], longitude[0], altitude[0]);
+
+	string mode = geodesyUsesAVX2() ? " (AVX2)" : " (scalar)";
+	report(opts, "haversineDistance (scalar)", "fix", Size - 1, 0, [&]() {
+		for ( size_t i = 0; i + 1 < Size; i++ ) {
+			out[i] = haversineDistance(latitude[i], longitude[i], latitude[i + 1], longitude[i + 1]);
+		}
+	});
+	report(opts, "haversineSegments" + mode, "fix", Size - 1, 0, [&]() { haversineSegments(latitude, longitude, Size, out.data()); });
+	report(opts, "odometer" + mode, "fix", Size - 1, 0, [&]() { sink = static_cast<uint64_t>(odometer(track)); });
+	report(opts, "vincentySegments", "fix", Size - 1, 0, [&]() { vincentySegments(latitude, longitude, Size, out.data()); });
+	report(opts, "initialBearing (scalar)", "fix", Size - 1, 0, [&]() {
+		for ( size_t i = 0; i + 1 < Size; i++ ) {
+			out[i] = initialBearing(latitude[i], longitude[i], latitude[i + 1], longitude[i + 1]);
+		}
+	});
+	report(opts, "bearingSegments" + mode, "fix", Size - 1, 0, [&]() { bearingSegments(latitude, longitude, Size, out.data()); });
+	report(opts, "LocalFrame::toENU (scalar)", "fix", Size, 0, [&]() {
+		for ( size_t i = 0; i < Size; i++ ) {
+			ENU local = frame.toENU(latitude[i], longitude[i], altitude[i]);
+			x[i]      = local.east;
+		}
+	});
+	report(opts, "LocalFrame::toENU batch" + mode, "fix", Size, 0, [&]() { frame.toENU(track, x.data(), y.data(), z.data()); });
+	report(opts, "geohashBits (scalar, 9 chars)", "fix", Size, 0, [&]() {
+		for ( size_t i = 0; i < Size; i++ ) {
+			hashes[i] = geohashBits(latitude[i], longitude[i], 9);
+		}
+	});
+	report(opts, "geohashBits batch (9 chars)" + mode, "fix", Size, 0, [&]() { geohashBits(latitude, longitude, Size, 9, hashes.data()); });
+
+	if ( !opts.filter.empty() && string("geodesy accuracy").find(opts.filter) == string::npos ) {
+		return;
+	}
+
+	// largest difference of the batch kernels from the scalar reference, over the world points
+	const double* wLat = world.latitude_.data();
+	const double* wLon = world.longitude_.data();
+	const double* wAlt = world.altitude_.data();
+	double        distanceError = 0;
+	double        bearingError  = 0;
+	double        ecefError     = 0;
+	double        enuError      = 0;
+	size_t        hashMismatch  = 0;
+
+	haversineSegments(wLat, wLon, Size, out.data());
+	for ( size_t i = 0; i + 1 < Size; i++ ) {
+		double reference = haversineDistance(wLat[i], wLon[i], wLat[i + 1], wLon[i + 1]);
+		distanceError    = max(distanceError, fabs(out[i] - reference) / max(reference, 1.0));
+	}
+	bearingSegments(wLat, wLon, Size, out.data());
+	for ( size_t i = 0; i + 1 < Size; i++ ) {
+		double difference = fabs(out[i] - initialBearing(wLat[i], wLon[i], wLat[i + 1], wLon[i + 1]));
+		bearingError      = max(bearingError, min(difference, 360 - difference));
+	}
+	toECEF(wLat, wLon, wAlt, Size, x.data(), y.data(), z.data());
+	for ( size_t i = 0; i < Size; i++ ) {
+		ECEF point = toECEF(wLat[i], wLon[i], wAlt[i]);
+		ecefError  = max({ ecefError, fabs(x[i] - point.x), fabs(y[i] - point.y), fabs(z[i] - point.z) });
+	}
+	frame.toENU(world, x.data(), y.data(), z.data());
+	for ( size_t i = 0; i < Size; i++ ) {
+		ENU local = frame.toENU(wLat[i], wLon[i], wAlt[i]);
+		enuError  = max({ enuError, fabs(x[i] - local.east), fabs(y[i] - local.north), fabs(z[i] - local.up) });
+	}
+	for ( int precision = 1; precision <= 12; precision++ ) {
+		geohashBits(wLat, wLon, Size, precision, hashes.data());
+		for ( size_t i = 0; i < Size; i++ ) {
+			hashMismatch += hashes[i] != geohashBits(wLat[i], wLon[i], precision) ? 1 : 0;
+		}
+	}
+
+	cout << "Geodesy batch vs scalar" << mode << ": haversine " << scientific << setprecision(1) << distanceError
+	     << " relative, bearing " << bearingError << " deg, ECEF " << ecefError << " m, ENU " << enuError << " m, "
+	     << hashMismatch << " geohash mismatches" << fixed << endl;
+	expect(distanceError < 1e-12, "batch haversine within 1e-12 of the scalar reference" + mode);
+	expect(bearingError < 1e-9, "batch bearing within 1e-9 deg of the scalar reference" + mode);
+	expect(ecefError < 1e-6 && enuError < 1e-6, "batch ECEF and ENU within 1 um of the scalar reference" + mode);
+	expect(hashMismatch == 0, "batch geohash equal to the scalar reference" + mode);
+}
+
+// Looking up positions at times between the fixes of the synthetic stream
+static void
+benchHistory(const Options& opts)
+{
+	NMEAParser parser;
+	GPSService gps(parser);
+	gps.enableHistory(600);
+	for ( const auto& line: opts.synthetic ) {
+		parseQuietly(parser, line);
+	}
+	const FixHistory& history = *gps.history();
+	if ( history.size() < 2 ) {
+		return;
+	}
+
+	// query times spread over the whole history, off the fix times
+	vector<UTCTime> times(1024);
+	auto            span = (history.back().time_ - history.front().time_).count();
+	for ( size_t i = 0; i < times.size(); i++ ) {
+		times[i] = history.front().time_ + milliseconds(static_cast<int64_t>(i * 7919 % times.size()) * span / static_cast<int64_t>(times.size()) + 3);
+	}
+
+	FixRecord at;
+	report(opts, "FixHistory::positionAt (linear)", "query", times.size(), 0, [&]() {
+		for ( auto time: times ) {
+			sink = history.positionAt(time, at, FixHistory::Linear) ? 1 : 0;
+		}
+	});
+	report(opts, "FixHistory::positionAt (Hermite)", "query", times.size(), 0, [&]() {
+		for ( auto time: times ) {
+			sink = history.positionAt(time, at, FixHistory::Hermite) ? 1 : 0;
+		}
+	});
+	report(opts, "FixHistory::window (1 s)", "query", times.size(), 0, [&]() {
+		for ( auto time: times ) {
+			sink = history.window(time, time + seconds(1)).size();
+		}
+	});
+}
+
+// Vehicles driving among small fences: the grid index against testing every fence
+static void
+benchGeofence(const Options& opts)
+{
+	const size_t Fences   = opts.quick ? 2000 : 20000;
+	const size_t Vehicles = 1000;
+
+	// hexagons of 100-400 m over half a degree square
+	mt19937                           random(11);
+	uniform_real_distribution<double> anyLat(53.0, 53.5);
+	uniform_real_distribution<double> anyLon(-6.5, -6.0);
+	uniform_real_distribution<double> radius(0.001, 0.004);
+	uniform_real_distribution<double> step(-0.0001, 0.0001);
+	GeofenceEngine                    engine(0.005);
+	vector<vector<GeoPoint>>          polygons;
+	for ( size_t f = 0; f < Fences; f++ ) {
+		double           lat = anyLat(random);
+		double           lon = anyLon(random);
+		double           r   = radius(random);
+		vector<GeoPoint> polygon;
+		for ( int corner = 0; corner < 6; corner++ ) {
+			double angle = corner * 3.14159265358979323846 / 3;
+			polygon.push_back(GeoPoint{ lat + r * sin(angle), lon + r * cos(angle) * 1.7 });
+		}
+		polygons.push_back(polygon);
+		engine.addFence(polygon);
+	}
+
+	vector<uint32_t> ids(Vehicles);
+	vector<double>   lats(Vehicles);
+	vector<double>   lons(Vehicles);
+	for ( size_t v = 0; v < Vehicles; v++ ) {
+		ids[v]  = static_cast<uint32_t>(v);
+		lats[v] = anyLat(random);
+		lons[v] = anyLon(random);
+	}
+	auto drive = [&]() {
+		for ( size_t v = 0; v < Vehicles; v++ ) {
+			lats[v] += step(random);
+			lons[v] += step(random);
+		}
+	};
+
+	uint64_t transitions = 0;
+	engine.onEnter += [&transitions](uint32_t, uint32_t) { transitions++; };
+	engine.onExit += [&transitions](uint32_t, uint32_t) { transitions++; };
+
+	string size = " (" + to_string(Fences) + " fences)";
+	report(opts, "GeofenceEngine::update batch" + size, "fix", Vehicles, 0, [&]() {
+		drive();
+		engine.update(ids.data(), lats.data(), lons.data(), Vehicles);
+	});
+	report(opts, "Geofence, testing every fence" + size, "fix", Vehicles, 0, [&]() {
+		drive();
+		uint64_t inside = 0;
+		for ( size_t v = 0; v < Vehicles; v++ ) {
+			for ( uint32_t f = 0; f < Fences; f++ ) {
+				inside += engine.contains(f, lats[v], lons[v]) ? 1 : 0;
+			}
+		}
+		sink = inside;
+	});
+
+	if ( !opts.filter.empty() && string("geofence accuracy").find(opts.filter) == string::npos ) {
+		return;
+	}
+
+	// the index must agree with testing every fence
+	engine.update(ids.data(), lats.data(), lons.data(), Vehicles);
+	size_t mismatches = 0;
+	for ( size_t v = 0; v < Vehicles; v++ ) {
+		vector<uint32_t> inside;
+		for ( uint32_t f = 0; f < Fences; f++ ) {
+			if ( engine.contains(f, lats[v], lons[v]) ) {
+				inside.push_back(f);
+			}
+		}
+		mismatches += inside != engine.fencesOf(ids[v]) ? 1 : 0;
+	}
+	cout << "GeofenceEngine: " << engine.cells() << " cells, " << engine.memoryUsage() / 1024 << " KiB, " << transitions
+	     << " transitions, " << mismatches << " vehicles differing from the full test" << endl;
+	expect(mismatches == 0, "geofence index agrees with testing every fence");
+}
+
+// A 10 Hz drive of straights and turns with half a meter of noise, simplified
+// both ways. tests/test_track_simplifier checks the error of the same drive.
+static void
+benchSimplifier(const Options& opts)
+{
+	const size_t Size = opts.quick ? 6000 : 36000;
+
+	mt19937                    random(13);
+	normal_distribution<double> noise(0, 0.5 / 111000);
+	vector<FixRecord>          drive;
+	double                     lat     = 53.36;
+	double                     lon     = -6.50;
+	double                     heading = 0;
+	for ( size_t i = 0; i < Size; i++ ) {
+		double turning = (i / 300) % 3 == 0 ? 0.0 : (i / 300) % 3 == 1 ? 0.6 : -0.3; // degrees per fix
+		heading += turning;
+		lat += 1.4 / 111000 * cos(heading * 3.14159265358979323846 / 180);
+		lon += 1.4 / 111000 * sin(heading * 3.14159265358979323846 / 180) / cos(lat * 3.14159265358979323846 / 180);
+
+		FixRecord record;
+		record.time_        = UTCTime(milliseconds(1306574870000 + static_cast<int64_t>(i) * 100));
+		record.latitude_    = lat + noise(random);
+		record.longitude_   = lon + noise(random);
+		record.speed_       = 50;
+		record.travelAngle_ = static_cast<float>(fmod(heading + 360 * 100, 360));
+		drive.push_back(record);
+	}
+
+	auto run = [&](const string& name, TrackSimplifierSettings settings) {
+		TrackSimplifier   simplifier(settings);
+		vector<FixRecord> kept;
+		simplifier.onPoint += [&kept](const FixRecord& point) { kept.push_back(point); };
+		report(opts, name, "fix", Size, 0, [&]() {
+			kept.clear();
+			simplifier.reset();
+			for ( const auto& record: drive ) {
+				simplifier.push(record);
+			}
+			simplifier.flush();
+		});
+		cout << "  kept " << kept.size() << " of " << Size << " fixes (" << setprecision(1) << 100.0 * static_cast<double>(kept.size()) / static_cast<double>(Size)
+		     << "%)" << endl;
+	};
+
+	TrackSimplifierSettings window;
+	run("TrackSimplifier opening window (5 m)", window);
+	TrackSimplifierSettings deadBand;
+	deadBand.mode          = SimplifyMode::DeadBand;
+	deadBand.tolerance     = 25;
+	deadBand.headingChange = 15;
+	run("TrackSimplifier dead band (25 m, 15 deg)", deadBand);
+}
+
+// NMEA lines with UBX, SiRF and RTCM3 frames and some damage in between, like
+// a receiver port with binary output and corrections turned on
+static void
+benchDemultiplexer(const Options& opts)
+{
+	vector<uint8_t> sat(8 + 12 * 16);
+	sat[5] = 16;
+	for ( uint8_t n = 0; n < 16; n++ ) {
+		uint8_t* s = sat.data() + 8 + 12 * n;
+		s[0]       = n < 10 ? 0 : 6;
+		s[1]       = static_cast<uint8_t>(n % 10 + 1);
+		s[2]       = static_cast<uint8_t>(30 + n);
+		s[3]       = static_cast<uint8_t>(10 + 4 * n);
+		s[4]       = static_cast<uint8_t>(20 * n);
+	}
+	vector<uint8_t> sirf(41, 0);
+	sirf[0] = 41; // geodetic navigation data
+	vector<uint8_t> rtcm(19, 0);
+	rtcm[0] = 1005 >> 4;
+	rtcm[1] = (1005 & 0xF) << 4;
+
+	vector<uint8_t> stream;
+	uint64_t        expected[static_cast<size_t>(FrameProtocol::Count)]{};
+	size_t          epoch = 0;
+	for ( size_t i = 0; i < opts.synthetic.size(); i++ ) {
+		stream.insert(stream.end(), opts.synthetic[i].begin(), opts.synthetic[i].end());
+		stream.insert(stream.end(), { '\r', '\n' });
+		expected[static_cast<size_t>(FrameProtocol::NMEA)]++;
+		if ( i % 8 != 0 ) {
+			continue;
+		}
+		appendUBX(stream, 0x0107, makeNavPvt(epoch++));
+		appendUBX(stream, 0x0135, sat);
+		appendSiRF(stream, sirf);
+		appendRTCM3(stream, rtcm);
+		expected[static_cast<size_t>(FrameProtocol::UBX)] += 2;
+		expected[static_cast<size_t>(FrameProtocol::SiRF)]++;
+		expected[static_cast<size_t>(FrameProtocol::RTCM3)]++;
+		if ( i % 64 == 0 ) {
+			size_t start = stream.size();
+			appendRTCM3(stream, rtcm);
+			stream[start + 10] ^= 0x40; // a flipped bit, caught by the CRC
+			stream.insert(stream.end(), { 0x00, 0xFF, 0x13 }); // line noise
+		}
+	}
+
+	NMEAParser          parser;
+	GPSService          gps(parser);
+	StreamDemultiplexer demux(&parser);
+	gps.attachToDemultiplexer(demux);
+	uint64_t rtcm3 = 0;
+	demux.onFrame += [&rtcm3](const BinaryFrame& frame) { rtcm3 += frame.protocol_ == FrameProtocol::RTCM3 ? 1 : 0; };
+	report(opts, "StreamDemultiplexer mixed stream", "byte", stream.size(), stream.size(), [&]() {
+		demux.reset();
+		try {
+			demux.readBuffer(stream.data(), stream.size());
+		}
+		catch ( exception& ) {
+		}
+	});
+
+	// the position of one epoch, binary against text
+	vector<uint8_t> pvt;
+	size_t          frames = 0;
+	for ( ; frames < 1000; frames++ ) {
+		appendUBX(pvt, 0x0107, makeNavPvt(frames));
+	}
+	StreamDemultiplexer pvtDemux;
+	gps.attachToDemultiplexer(pvtDemux);
+	report(opts, "GPSService UBX-NAV-PVT via demultiplexer", "epoch", frames, pvt.size(), [&]() {
+		pvtDemux.readBuffer(pvt.data(), pvt.size());
+	});
+
+	vector<string> text;
+	for ( const auto& line: opts.synthetic ) {
+		if ( line.compare(0, 6, "$GPGGA") == 0 || line.compare(0, 6, "$GPRMC") == 0 ) {
+			text.push_back(line + "\r\n");
+		}
+	}
+	StreamDemultiplexer textDemux(&parser);
+	report(opts, "GPSService GGA + RMC via demultiplexer", "epoch", text.size() / 2, totalBytes(text) - 2 * text.size(), [&]() {
+		for ( const auto& line: text ) {
+			try {
+				textDemux.readBuffer(reinterpret_cast<const uint8_t*>(line.data()), line.size());
+			}
+			catch ( exception& ) {
+			}
+		}
+	});
+	sink = rtcm3;
+
+	if ( !opts.filter.empty() && string("demultiplexer frames").find(opts.filter) == string::npos ) {
+		return;
+	}
+
+	// every frame found once, the damaged ones counted
+	StreamDemultiplexer counted(&parser);
+	gps.attachToDemultiplexer(counted);
+	counted.readBuffer(stream.data(), stream.size());
+	bool match = true;
+	for ( size_t p = 0; p < static_cast<size_t>(FrameProtocol::Count); p++ ) {
+		auto protocol = static_cast<FrameProtocol>(p);
+		match         = match && counted.frames(protocol) == expected[p];
+		cout << "  " << frameProtocolName(protocol) << " " << counted.frames(protocol) << " of " << expected[p];
+	}
+	cout << ", " << counted.checksumErrors() << " checksum errors, " << counted.discarded() << " bytes discarded"
+	     << (match ? "" : " (MISMATCH)") << endl;
+	expect(match, "demultiplexer finds every frame once");
+}
+
+// A receiver at its defaults and the same one after the set rate commands for
+// an application that only reads the position
+static void
+benchOutputProfile(const Options& opts)
+{
+	const int Seconds = 60;
+
+	NMEAParser    parser;
+	GPSService    gps(parser);
+	ServiceNeeds  needs;
+	OutputProfile wanted;
+	wanted.addHandlers(parser, &needs);
+
+	NMEAGenerator receiver;
+
+	auto stream = [&receiver](int seconds) {
+		vector<char> out(NMEAGenerator::MaxEpochSize * static_cast<size_t>(seconds));
+		size_t       size = 0;
+		for ( int i = 0; i < seconds; i++ ) {
+			size += receiver.nextEpoch(out.data() + size, out.size() - size);
+		}
+		out.resize(size);
+		return out;
+	};
+	auto parse = [&parser](vector<char>& data) {
+		try {
+			parser.readBuffer(reinterpret_cast<uint8_t*>(data.data()), static_cast<uint32_t>(data.size()));
+		}
+		catch ( exception& ) {
+		}
+	};
+
+	vector<char> before = stream(Seconds);
+	report(opts, "GPSService, receiver defaults (1 min)", "second", Seconds, before.size(), [&]() { parse(before); });
+
+	// what it sends, the commands for the difference, and what it sends then
+	OutputMonitor monitor(parser);
+	vector<char>  sample = stream(10);
+	parse(sample);
+	array<char, 512> buf;
+	NMEACommandBatch batch(buf);
+	size_t           commands = wanted.commands(monitor.profile(10), batch);
+	string_view      sent(batch.data(), batch.size());
+	for ( size_t start = 0; start < sent.size(); ) {
+		size_t end = sent.find('\n', start) + 1;
+		receiver.readCommand(sent.substr(start, end - start));
+		start = end;
+	}
+	monitor.reset();
+	sample = stream(10);
+	parse(sample);
+	uint32_t differences = wanted.differences(monitor.profile(10));
+
+	vector<char> after = stream(Seconds);
+	report(opts, "GPSService, output for position only (1 min)", "second", Seconds, after.size(), [&]() { parse(after); });
+	if ( !opts.filter.empty() && string("GPSService, output profile").find(opts.filter) == string::npos ) {
+		return;
+	}
+	cout << "  " << commands << " commands (" << batch.size() << " bytes), " << before.size() / Seconds << " -> " << after.size() / Seconds
+	     << " bytes/s, " << differences << " sentence types off profile" << endl;
+}
+
+// An hour (6 minutes with --quick) of a 10 Hz receiver: indexing it, and reading
+// one second from the middle through the index against parsing up to it
+static void
+benchLogIndex(const Options& opts)
+{
+	const int Epochs = opts.quick ? 3600 : 36000;
+
+	NMEAGeneratorSettings settings;
+	settings.rate = 10;
+	NMEAGenerator generator(settings);
+	string        text(NMEAGenerator::MaxEpochSize * Epochs, '\0');
+	size_t        size = 0;
+	for ( int i = 0; i < Epochs; i++ ) {
+		size += generator.nextEpoch(&text[size], text.size() - size);
+	}
+	text.resize(size);
+	istringstream log(text);
+
+	LogIndex index;
+	index.build(log);
+	report(opts, "LogIndex::build", "byte", size, size, [&]() {
+		log.clear();
+		log.seekg(0);
+		index.build(log);
+	});
+
+	UTCTime      target = index.entries()[index.entries().size() / 2].time_ + milliseconds(300);
+	NMEAParser   parser;
+	GPSService   gps(parser);
+	LogReader    reader(log, index, parser);
+	stringstream sidecar;
+	index.save(sidecar);
+
+	report(opts, "LogReader::seek to the middle, then 1 s", "query", 1, 0, [&]() {
+		reader.seek(target, &gps);
+		while ( gps.fix_.timestamp_.toUTCTime() < target + seconds(1) && reader.next() ) {
+		}
+	});
+	report(opts, "Log without index, to the middle, then 1 s", "query", 1, 0, [&]() {
+		NMEAParser fromStart;
+		GPSService service(fromStart);
+		log.clear();
+		log.seekg(0);
+		string line;
+		while ( service.fix_.timestamp_.toUTCTime() < target + seconds(1) && getline(log, line) ) {
+			line.pop_back(); // '\r'
+			parseQuietly(fromStart, line);
+		}
+	});
+
+	if ( !opts.filter.empty() && string("log index accuracy").find(opts.filter) == string::npos ) {
+		return;
+	}
+
+	// the first epoch after a seek must read like it does after the whole log before it
+	NMEAParser fullParser;
+	GPSService full(fullParser);
+	log.clear();
+	log.seekg(0);
+	string line;
+	while ( full.fix_.timestamp_.toUTCTime() < target && getline(log, line) ) {
+		line.pop_back();
+		parseQuietly(fullParser, line);
+	}
+	NMEAParser seekParser;
+	GPSService seeked(seekParser);
+	LogReader  seekReader(log, index, seekParser);
+	seekReader.seek(target, &seeked);
+	while ( seeked.fix_.timestamp_.toUTCTime() < target && seekReader.next() ) {
+	}
+	bool same = full.fix_.timestamp_.toUTCTime() == seeked.fix_.timestamp_.toUTCTime() && full.fix_.latitude_ == seeked.fix_.latitude_
+	            && full.fix_.longitude_ == seeked.fix_.longitude_ && full.fix_.dilution_ == seeked.fix_.dilution_
+	            && full.fix_.almanac_.satellites_.size() == seeked.fix_.almanac_.satellites_.size() && full.fix_.locked() == seeked.fix_.locked();
+	cout << "  " << index.entries().size() << " entries, " << sidecar.str().size() << " bytes of index for " << size / 1024 << " KiB of log, "
+	     << (same ? "same fix" : "FIX DIFFERS") << " after seeking" << endl;
+	expect(same, "seeking gives the fix of reading the whole log");
+}
+
+// A pool of 10000 streams (1000 with --quick), each cut off somewhere in its
+// fifth second: a snapshot of all of them, a restore into a fresh pool, and
+// whether the restored streams finish that second like uninterrupted ones
+static void
+benchCheckpoint(const Options& opts)
+{
+	const size_t Streams = opts.quick ? 1000 : 10000;
+	const int    Epochs  = 5;
+
+	struct Stream {
+		NMEAParser parser;
+		GPSService gps{ parser };
+	};
+	auto pool = [Streams]() {
+		vector<unique_ptr<Stream>> streams(Streams);
+		for ( auto& stream: streams ) {
+			stream = make_unique<Stream>();
+		}
+		return streams;
+	};
+	auto parse = [](NMEAParser& parser, const char* data, size_t size) {
+		try {
+			parser.readBuffer(reinterpret_cast<uint8_t*>(const_cast<char*>(data)), static_cast<uint32_t>(size));
+		}
+		catch ( exception& ) {
+		}
+	};
+
+	NMEAGenerator  generator;
+	string         text(NMEAGenerator::MaxEpochSize * Epochs, '\0');
+	vector<size_t> ends; // of each epoch
+	size_t         size = 0;
+	for ( int i = 0; i < Epochs; i++ ) {
+		size += generator.nextEpoch(&text[size], text.size() - size);
+		ends.push_back(size);
+	}
+	text.resize(size);
+
+	// all in the fifth epoch, which ends at ends[4]
+	vector<size_t> cuts(Streams);
+	auto           running = pool();
+	for ( size_t i = 0; i < Streams; i++ ) {
+		cuts[i] = ends[3] + (i * 37) % (ends[4] - ends[3]);
+		parse(running[i]->parser, text.data(), cuts[i]);
+	}
+
+	stringstream snapshot;
+	auto write = [&]() {
+		snapshot.str("");
+		CheckpointWriter checkpoint(snapshot);
+		for ( size_t i = 0; i < Streams; i++ ) {
+			checkpoint.add(i, running[i]->gps, &running[i]->parser, cuts[i]);
+		}
+		checkpoint.finish();
+	};
+	write();
+	report(opts, "CheckpointWriter, whole pool", "stream", Streams, 0, write);
+	string bytes = snapshot.str();
+
+	auto restored = pool();
+	auto restore  = [&]() {
+		istringstream    in(bytes);
+		CheckpointReader checkpoint(in);
+		while ( checkpoint.next() ) {
+			auto& stream = *restored[checkpoint.stream()];
+			checkpoint.restore(stream.gps, &stream.parser);
+		}
+	};
+	restore();
+	report(opts, "CheckpointReader::restore, whole pool", "stream", Streams, bytes.size(), restore);
+
+	if ( !opts.filter.empty() && string("checkpoint restore").find(opts.filter) == string::npos ) {
+		return;
+	}
+
+	// the rest of the epoch into the uninterrupted, restored and cold started pools
+	auto   cold = pool();
+	size_t same = 0;
+	size_t warm = 0;
+	auto   equal = [](const GPSFix& a, const GPSFix& b) {
+		return a.locked() == b.locked() && a.latitude_ == b.latitude_ && a.longitude_ == b.longitude_ && a.timestamp_.toUTCTime() == b.timestamp_.toUTCTime()
+		    && a.almanac_.satellites_.size() == b.almanac_.satellites_.size() && a.almanac_.percentComplete() == b.almanac_.percentComplete();
+	};
+	for ( size_t i = 0; i < Streams; i++ ) {
+		parse(running[i]->parser, text.data() + cuts[i], ends[4] - cuts[i]);
+		parse(restored[i]->parser, text.data() + cuts[i], ends[4] - cuts[i]);
+		parse(cold[i]->parser, text.data() + cuts[i], ends[4] - cuts[i]);
+		same += equal(running[i]->gps.fix_, restored[i]->gps.fix_) ? 1 : 0;
+		warm += equal(running[i]->gps.fix_, cold[i]->gps.fix_) ? 1 : 0;
+	}
+	cout << "  " << bytes.size() / Streams << " bytes/stream, " << same << "/" << Streams << " restored and " << warm << "/" << Streams
+	     << " cold started streams end the second like uninterrupted ones" << endl;
+	expect(same == Streams, "every restored stream ends the second like an uninterrupted one");
+}
+
+// Aggregate throughput with one parser + service per thread.
+static void
+benchScaling(const Options& opts, const vector<string>& lines)
+{
+	if ( !opts.filter.empty() && string("scaling").find(opts.filter) == string::npos ) {
+		return;
+	}
+
+	uint64_t bytes     = totalBytes(lines);
+	unsigned maxThread = max(2U, thread::hardware_concurrency());
+
+	cout << endl
+	     << "Thread scaling (synthetic stream, one parser + GPSService per thread)" << endl;
+	for ( unsigned threads = 1; threads <= maxThread; threads *= 2 ) {
+		atomic<uint64_t> sentences{ 0 };
+		atomic<bool>     stop{ false };
+		vector<thread>   workers;
+
+		auto start = steady_clock::now();
+		for ( unsigned t = 0; t < threads; t++ ) {
+			workers.emplace_back([&]() {
+				NMEAParser parser;
+				GPSService gps(parser);
+				uint64_t   done = 0;
+				while ( !stop.load(memory_order_relaxed) ) {
+					for ( const auto& line: lines ) {
+						parseQuietly(parser, line);
+					}
+					done += lines.size();
+				}
+				sentences += done;
+			});
+		}
+		this_thread::sleep_for(opts.minTime);
+		stop = true;
+		for ( auto& worker: workers ) {
+			worker.join();
+		}
+		double seconds = duration<double>(steady_clock::now() - start).count();
+		double rate    = static_cast<double>(sentences.load()) / seconds;
+		double mbps    = rate / static_cast<double>(lines.size()) * static_cast<double>(bytes) / 1e6;
+
+		cout << "  " << setw(3) << threads << " threads " << fixed << setprecision(0) << setw(12) << rate << " sentences/s "
+		     << setprecision(1) << setw(9) << mbps << " MB/s" << endl;
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	Options opts;
+	for ( int i = 1; i < argc; i++ ) {
+		string arg = argv[i];
+		if ( arg == "--quick" ) {
+			opts.quick   = true;
+			opts.minTime = milliseconds(50);
+		}
+		else if ( arg == "--filter" && i + 1 < argc ) {
+			opts.filter = argv[++i];
+		}
+		else {
+			opts.corpusPath = arg;
+		}
+	}
+
+	opts.corpus    = loadCorpus(opts.corpusPath);
+	opts.synthetic = makeSynthetic(opts.quick ? 10 : 100);
+	if ( opts.corpus.empty() ) {
+		cerr << "Could not read corpus \"" << opts.corpusPath << "\", using the synthetic stream only." << endl;
+	}
+
+	// Comment lines in the corpus aren't sentences
+	vector<string> sentences;
+	for ( const auto& line: opts.corpus ) {
+		if ( line[0] == '$' ) {
+			sentences.push_back(line);
+		}
+	}
+
+	cout << "NemaTode benchmarks (" << opts.corpus.size() << " corpus lines, " << opts.synthetic.size() << " synthetic sentences)" << endl
+	     << endl;
+
+	if ( !sentences.empty() ) {
+		benchReaders(opts, "(corpus)", opts.corpus);
+	}
+	benchReaders(opts, "(10 Hz multi-GNSS)", opts.synthetic);
+	benchExtract(opts, "(10 Hz multi-GNSS)", opts.synthetic);
+	benchDispatch(opts, "(10 Hz multi-GNSS)", opts.synthetic);
+	benchInterest(opts, "(10 Hz multi-GNSS)", opts.synthetic);
+	benchAIS(opts);
+	benchNumbers(opts);
+	benchService(opts, "(10 Hz multi-GNSS)", opts.synthetic);
+	if ( !sentences.empty() ) {
+		benchService(opts, "(corpus)", sentences);
+	}
+	benchConnections(opts, "(10 Hz multi-GNSS)", opts.synthetic);
+	benchEvents(opts);
+	benchCommands(opts);
+	benchGenerator(opts);
+	benchFixEncoder(opts);
+	benchSerializer(opts);
+	benchSharedFix(opts);
+	benchGeodesy(opts);
+	benchHistory(opts);
+	benchGeofence(opts);
+	benchSimplifier(opts);
+	benchDemultiplexer(opts);
+	benchOutputProfile(opts);
+	benchLogIndex(opts);
+	benchCheckpoint(opts);
+	benchScaling(opts, opts.synthetic);
+
+	return failures != 0 ? 1 : 0;
+}
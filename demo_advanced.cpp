@@ -191,6 +191,18 @@ main(int argc, char** argv)
 	test_parser.readSentence(cmd3.toString());
 	test_parser.readSentence(cmd4.toString());
 
+	// Commands known while compiling are built by the compiler, checksum included.
+	// '#' marks digits that are filled in later, only they and the checksum change.
+	constexpr auto gsvOnce      = makeSentence("PSRF103,03,01,00,01");
+	constexpr auto rateTemplate = makeSentence("PSRF103,##,00,##,01");
+
+	auto rmcEvery2s = rateTemplate;
+	rmcEvery2s.set(0, NMEASentence::MessageID::RMC);
+	rmcEvery2s.set(1, 2);
+
+	test_parser.readSentence(gsvOnce.view());
+	test_parser.readSentence(rmcEvery2s.view());
+
 	cout << endl;
 	cout << endl;
 	cout << "-------- ALL DONE --------" << endl;
@@ -0,0 +1,201 @@
+/*
+ * demo_async.cpp
+ *
+ *  Reads a minute of a simulated 10 Hz receiver through AsyncSentenceStream,
+ *  in small chunks that each complete on a later turn of an event loop, as a
+ *  socket would. Fails if anything was allocated per awaited sentence, epoch
+ *  or fix once the stream is warmed up.
+ *
+ *  Needs C++20 (cmake -DNEMATODE_COROUTINES=ON).
+ *
+ *  See the license file included with this source.
+ */
+
+#include <algorithm>
+#include <coroutine>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "nmeaparse/AsyncSentenceStream.hpp"
+#include "nmeaparse/nmea.hpp"
+
+using namespace std;
+using namespace nmea;
+
+// ---------------- Allocation counting ----------------
+
+static size_t allocations = 0;
+
+void*
+operator new(size_t size)
+{
+	allocations++;
+	if ( void* ptr = malloc(size == 0 ? 1 : size) ) {
+		return ptr;
+	}
+	throw bad_alloc();
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t /*size*/) noexcept
+{
+	free(ptr);
+}
+
+// ---------------- A pretend event loop and socket ----------------
+
+// Resumes whatever is waiting, one turn at a time
+class EventLoop {
+private:
+	coroutine_handle<> ready_[8];
+	size_t             count_ = 0;
+
+public:
+	void post(coroutine_handle<> waiting)
+	{
+		ready_[count_++] = waiting;
+	}
+
+	void run()
+	{
+		while ( count_ != 0 ) {
+			coroutine_handle<> next = ready_[--count_];
+			next.resume();
+		}
+	}
+};
+
+// Hands out a buffer 64 bytes per read, each read finishing on the next turn
+class ChunkedSource {
+private:
+	EventLoop&    loop_;
+	const string& data_;
+	size_t        pos_ = 0;
+
+public:
+	ChunkedSource(EventLoop& loop, const string& data)
+	    : loop_(loop)
+	    , data_(data)
+	{
+	}
+
+	auto read(uint8_t* out, size_t size)
+	{
+		struct Read {
+			ChunkedSource& source;
+			uint8_t*       out;
+			size_t         size;
+
+			bool await_ready() { return false; }
+			void await_suspend(coroutine_handle<> waiting) { source.loop_.post(waiting); }
+
+			size_t await_resume()
+			{
+				size_t bytes = min({ size, size_t(64), source.data_.size() - source.pos_ });
+				copy_n(source.data_.data() + source.pos_, bytes, out);
+				source.pos_ += bytes;
+				return bytes;
+			}
+		};
+		return Read{ *this, out, size };
+	}
+};
+
+// A coroutine that runs on its own until done, for the top of the demo. Its
+// frame comes from FrameArena too, on the heap outside of a stream.
+struct Detached {
+	struct promise_type {
+		static void* operator new(size_t size) { return FrameArena::allocate(size); }
+		static void  operator delete(void* frame, size_t size) { FrameArena::deallocate(frame, size); }
+
+		Detached            get_return_object() { return {}; }
+		suspend_never       initial_suspend() noexcept { return {}; }
+		suspend_never       final_suspend() noexcept { return {}; }
+		void                return_void() {}
+		[[noreturn]] void   unhandled_exception() { abort(); }
+	};
+};
+
+// ---------------- The sequential part ----------------
+
+using Stream = AsyncSentenceStream<ChunkedSource>;
+
+struct Result {
+	size_t fixes     = 0;
+	size_t allocated = 0; // after the first second
+	bool   done      = false;
+};
+
+static Detached
+track(Stream& stream, GPSService& gps, Result& result)
+{
+	printf("First sentences:\n");
+	for ( int i = 0; i < 3; i++ ) {
+		const SentenceView* sentence = co_await stream.next();
+		if ( sentence == nullptr ) {
+			break;
+		}
+		printf("  %.*s\n", static_cast<int>(sentence->text().size()), sentence->text().data());
+	}
+
+	// the rest of the first second fills the almanac, history and parser tables
+	for ( int i = 0; i < 10; i++ ) {
+		co_await stream.nextEpoch();
+	}
+	allocations = 0;
+
+	printf("\nFixes:\n");
+	while ( true ) {
+		const GPSFix* fix = co_await stream.nextFix(gps);
+		if ( fix == nullptr ) {
+			break;
+		}
+		if ( result.fixes++ % 100 == 0 ) {
+			printf("  %02d:%02d:%04.1f  %.6f, %.6f  %zu satellites\n", fix->timestamp_.hour_, fix->timestamp_.min_, fix->timestamp_.sec_,
+			       fix->latitude_, fix->longitude_, fix->almanac_.satellites_.size());
+		}
+	}
+	result.allocated = allocations;
+	result.done      = true;
+}
+
+int
+main()
+{
+	NMEAGeneratorSettings settings;
+	settings.rate = 10;
+	NMEAGenerator generator(settings);
+	string        data(NMEAGenerator::MaxEpochSize * 600, '\0');
+	size_t        size = 0;
+	for ( int i = 0; i < 600; i++ ) {
+		size += generator.nextEpoch(&data[size], data.size() - size);
+	}
+	data.resize(size);
+
+	EventLoop     loop;
+	ChunkedSource source(loop, data);
+	NMEAParser    parser;
+	GPSService    gps(parser);
+	Stream        stream(source, &parser);
+	Result        result;
+
+	track(stream, gps, result);
+	loop.run();
+
+	printf("\n%zu bytes: %zu fixes after the first second, %llu lines skipped\n", data.size(), result.fixes,
+	       static_cast<unsigned long long>(stream.rejected()));
+	printf("Coroutine frames on the heap: %u, allocations after the first second: %zu\n", stream.frames().heapFrames(), result.allocated);
+	if ( !result.done || result.fixes == 0 || result.allocated != 0 || stream.frames().heapFrames() != 0 ) {
+		printf("FAILED\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * demo_embedded.cpp
+ *
+ *  Runs the fixed-capacity parser and GPS service (the NEMATODE_EMBEDDED
+ *  build) over a log and fails if anything was allocated after construction,
+ *  or if the log isn't read as expected. Prints the memory each instance
+ *  takes. Also run by ctest.
+ *
+ *  See the license file included with this source.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "nmeaparse/nmea.hpp"
+
+using namespace nmea;
+
+// ---------------- Allocation counting ----------------
+
+static size_t allocations = 0;
+
+void*
+operator new(size_t size)
+{
+	allocations++;
+	if ( void* ptr = malloc(size == 0 ? 1 : size) ) {
+		return ptr;
+	}
+	abort(); // no exceptions to throw bad_alloc with
+}
+
+void*
+operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+// std::pmr's default resource allocates with the alignment
+void*
+operator new(size_t size, std::align_val_t alignment)
+{
+	allocations++;
+	auto align = static_cast<size_t>(alignment);
+	if ( void* ptr = aligned_alloc(align, (size + align - 1) / align * align) ) {
+		return ptr;
+	}
+	abort();
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t /*size*/) noexcept
+{
+	free(ptr);
+}
+
+void
+operator delete(void* ptr, std::align_val_t /*alignment*/) noexcept
+{
+	free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t /*size*/, std::align_val_t /*alignment*/) noexcept
+{
+	free(ptr);
+}
+
+void
+operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void
+operator delete[](void* ptr, size_t /*size*/) noexcept
+{
+	free(ptr);
+}
+
+// ---------------- Data ----------------
+
+// From nmea_log.txt, plus the kinds of damage a serial line produces
+static const char nmeaLog[] = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n"
+                              "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A\r\n"
+                              "$GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30*70\r\n"
+                              "$GPGSV,3,2,11,02,39,223,19,13,28,070,17,26,23,252,,04,14,186,14*79\r\n"
+                              "$GPGSV,3,3,11,29,09,301,24,16,09,020,,36,,,*76\r\n"
+                              "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n"
+                              "$GPVTG,31.66,T,,M,0.02,N,0.04,K,A*09\r\n"
+                              "garbage between sentences\r\n"
+                              "$GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,*75\r\n"
+                              "$GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,*00\r\n" // wrong checksum
+                              "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38\r\n"               // no checksum
+                              "$GPRMC,092751.000,A,5321.6802,N,00630.3371,W,0.06,31.66,280511,,,A*45\r\n"
+                              "$GPRMC,092751.000,A,5321.6802,N,00630.3371,W,0.06,31.66,280511,,,A,,,,,,,,,,,,,,,,,,,,*45\r\n"; // too long
+
+// What the damaged lines have to be reported as, in order
+static const ParseStatus expectedProblems[] = { ParseStatus::ChecksumMismatch, ParseStatus::MissingChecksum, ParseStatus::Overflow };
+
+static bool        firstPass = true;
+static ParseStatus problems[8];
+static size_t      problemCount = 0;
+
+static void
+printStatus(void* /*unused*/, ParseStatus status, const SentenceView& sentence)
+{
+	if ( firstPass ) {
+		printf("  %-17s $%.*s\n", parseStatusName(status), static_cast<int>(sentence.name_.size()), sentence.name_.data());
+		if ( problemCount < sizeof(problems) / sizeof(problems[0]) ) {
+			problems[problemCount] = status;
+		}
+		problemCount++;
+	}
+}
+
+static int failures = 0;
+
+static void
+expect(bool ok, const char* what)
+{
+	if ( !ok ) {
+		printf("  FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+int
+main()
+{
+	// Everything that may allocate happens here
+	FixedNMEAParser parser;
+	FixedGPSService gps(parser);
+	GPSFixEncoder   encoder;
+	parser.setErrorHandler(&printStatus);
+
+	static size_t updates   = 0;
+	static size_t reencoded = 0;
+	gps.setUpdateHandler([](void* context, const GPSFix& fix) {
+		char out[GPSFixEncoder::MaxSentenceSize * 16];
+		updates++;
+		reencoded += static_cast<GPSFixEncoder*>(context)->encode(fix, out, sizeof(out));
+	},
+	                     &encoder);
+
+	allocations = 0;
+
+	printf("Problems found in the log:\n");
+	const int passes = 1000;
+	for ( int pass = 0; pass < passes; pass++ ) {
+		parser.readBuffer(reinterpret_cast<const uint8_t*>(nmeaLog), sizeof(nmeaLog) - 1);
+		firstPass = false;
+	}
+	size_t allocated = allocations;
+
+	printf("\n%d passes: %u sentences, %u errors (%u too long), %zu updates, %zu bytes re-encoded\n",
+	       passes, parser.sentences(), parser.errors(), parser.overflows(), updates, reencoded);
+	printf("Fix: %s %.6f, %.6f, %zu satellites\n", gps.fix_.locked() ? "locked" : "no lock",
+	       gps.fix_.latitude_, gps.fix_.longitude_, gps.fix_.almanac_.satellites_.size());
+
+	printf("\nMemory per instance:\n");
+	printf("  FixedNMEAParser  %6zu bytes\n", parser.memoryUsage());
+	printf("  FixedGPSService  %6zu bytes\n", gps.memoryUsage());
+	printf("  GPSFixEncoder    %6zu bytes\n", sizeof(GPSFixEncoder));
+#ifndef NEMATODE_EMBEDDED
+	{
+		NMEAParser parserForComparison;
+		GPSService gpsForComparison(parserForComparison);
+		printf("  (NMEAParser       %6zu bytes, GPSService %zu bytes, before any data)\n",
+		       parserForComparison.memoryUsage(), gpsForComparison.memoryUsage());
+	}
+#endif
+
+	printf("\nAllocations after construction: %zu\n", allocated);
+
+	const size_t expectedCount = sizeof(expectedProblems) / sizeof(expectedProblems[0]);
+	bool         sameProblems  = problemCount == expectedCount;
+	for ( size_t i = 0; sameProblems && i < expectedCount; i++ ) {
+		sameProblems = problems[i] == expectedProblems[i];
+	}
+	expect(allocated == 0, "no allocation after construction");
+	expect(sameProblems, "the damaged lines reported as ChecksumMismatch, MissingChecksum and Overflow");
+	expect(parser.sentences() == 11u * passes && parser.errors() == 3u * passes && parser.overflows() == 1u * passes,
+	       "11 sentences, 3 errors and 1 overflow per pass");
+	expect(updates == 9u * passes, "9 updates per pass");
+	expect(gps.fix_.locked() && std::fabs(gps.fix_.latitude_ - 53.3613367) < 1e-6 && std::fabs(gps.fix_.longitude_ + 6.5056183) < 1e-6,
+	       "locked at the last good position");
+	expect(gps.fix_.almanac_.satellites_.size() == 11, "11 satellites in the almanac");
+	return failures != 0 ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * AISDecoder.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+#include "nmeaparse/FixedNMEAParser.hpp"
+#include "nmeaparse/SentenceView.hpp"
+
+namespace nmea {
+
+// What every decoded AIS message starts with
+struct AISMessage {
+	uint8_t  type_{ 0 };      // message type, 1 to 27
+	uint8_t  repeat_{ 0 };    // times repeated by base stations, 3 = do not repeat
+	uint32_t mmsi_{ 0 };      // the transmitting station
+	char     channel_{ 0 };   // radio channel, 'A' or 'B' (or '1', '2'), 0 if the sentence had none
+	bool     own_{ false };   // from a VDO sentence: the receiver's own vessel
+};
+
+// Position report of a class A transponder (types 1, 2 and 3) or a class B
+// one (type 18). Values the transponder doesn't know are NaN, or the AIS
+// "not available" code where noted.
+struct AISPosition : AISMessage {
+	uint8_t  status_{ 15 };                                         // navigation status, 0 under way using engine, 1 at anchor, 5 moored ..., 15 not defined (always for class B)
+	int8_t   turn_{ -128 };                                         // rate of turn as sent, 4.733 * sqrt(deg/min), +-127 turning without indicator, -128 not available (always for class B)
+	double   speed_{ std::numeric_limits<double>::quiet_NaN() };     // knots over ground
+	bool     accurate_{ false };                                    // position better than 10 m
+	double   latitude_{ std::numeric_limits<double>::quiet_NaN() };  // degrees, north positive
+	double   longitude_{ std::numeric_limits<double>::quiet_NaN() }; // degrees, east positive
+	double   course_{ std::numeric_limits<double>::quiet_NaN() };    // degrees over ground
+	uint16_t heading_{ 511 };                                       // true heading in degrees, 511 not available
+	uint8_t  second_{ 60 };                                         // UTC second of the report, 60 and up not available
+	bool     raim_{ false };                                        // receiver autonomous integrity monitoring in use
+};
+
+// Static and voyage related data of a class A transponder (type 5). Texts
+// are without the '@' padding and trailing spaces.
+struct AISVoyage : AISMessage {
+	uint8_t  version_{ 0 };         // AIS version of the transponder
+	uint32_t imo_{ 0 };             // IMO ship number, 0 not available
+	char     callsign_[8]{};        // 7 characters
+	char     name_[21]{};           // 20 characters
+	uint8_t  shipType_{ 0 };        // 0 not available, 30 fishing, 60-69 passenger, 70-79 cargo, 80-89 tanker ...
+	uint16_t toBow_{ 0 };           // meters from the position reference, 0 not available
+	uint16_t toStern_{ 0 };
+	uint8_t  toPort_{ 0 };
+	uint8_t  toStarboard_{ 0 };
+	uint8_t  epfd_{ 0 };            // position fix device, 0 undefined, 1 GPS, 2 GLONASS, 3 combined ...
+	uint8_t  etaMonth_{ 0 };        // ETA in UTC, month 0, day 0, hour 24 and minute 60 not available
+	uint8_t  etaDay_{ 0 };
+	uint8_t  etaHour_{ 24 };
+	uint8_t  etaMinute_{ 60 };
+	double   draught_{ 0 };         // meters, 0 not available
+	char     destination_[21]{};    // 20 characters
+	bool     dte_{ true };          // data terminal not ready
+};
+
+// Static data of a class B transponder (type 24). It comes in two messages:
+// part A has the name, part B the rest, the fields of the other part are left
+// empty.
+struct AISStaticData : AISMessage {
+	uint8_t  part_{ 0 };         // 0 part A, 1 part B
+	char     name_[21]{};        // part A, 20 characters
+	uint8_t  shipType_{ 0 };     // part B from here, as in AISVoyage
+	char     vendor_[4]{};       // manufacturer, 3 characters
+	uint8_t  model_{ 0 };
+	uint32_t serial_{ 0 };
+	char     callsign_[8]{};
+	uint16_t toBow_{ 0 };        // meters, auxiliary craft (MMSI 98xxxxxxx) send their mother ship instead
+	uint16_t toStern_{ 0 };
+	uint8_t  toPort_{ 0 };
+	uint8_t  toStarboard_{ 0 };
+};
+
+// Decodes AIS messages out of !xxVDM (other vessels) and !xxVDO (own vessel)
+// sentences. Messages that span several sentences are put back together by
+// sequential message id and channel, then the 6-bit armored payload is read
+// through a lookup table into the structs above. Position reports (1, 2, 3,
+// 18), static and voyage data (5) and class B static data (24) are decoded,
+// other types are counted. Nothing is allocated, no exceptions: it runs in the
+// embedded build.
+//
+//   FixedNMEAParser parser;
+//   AISDecoder      ais;
+//   ais.attachToParser(parser);
+//   ais.setPositionHandler([](void*, const AISPosition& report) { ... });
+//
+// With NMEAParser, give it the text of each sentence:
+//
+//   parser.setSentenceHandler("AIVDM", [&](const NMEASentence& nmea) { ais.readSentence(nmea.text_); });
+class AISDecoder {
+public:
+	static constexpr size_t MaxPayload = 168; // armored characters of one message, 1008 bits or 5 slots
+	static constexpr size_t MaxPending = 4;   // messages being put together at once, the oldest is dropped for a new one
+
+	// context is the pointer given when setting the handler
+	using PositionHandler   = void (*)(void* context, const AISPosition& report);
+	using VoyageHandler     = void (*)(void* context, const AISVoyage& report);
+	using StaticDataHandler = void (*)(void* context, const AISStaticData& report);
+
+private:
+	struct Pending {
+		uint8_t  sequence{ 0 }; // sequential message id + 1, 0 for a free slot
+		char     channel{ 0 };
+		bool     own{ false };
+		uint8_t  count{ 0 };    // sentences in the message
+		uint8_t  next{ 0 };     // the fragment number expected next
+		uint32_t started{ 0 };  // when the first fragment came, in sentences
+		size_t   size{ 0 };
+		char     payload[MaxPayload]{};
+	};
+
+	Pending  pending_[MaxPending]{};
+	uint32_t clock_{ 0 };
+	uint8_t  bits_[MaxPayload * 6 / 8 + 8]{}; // the message being decoded, with room to read 8 bytes at any bit
+	size_t   bitCount_{ 0 };
+
+	PositionHandler   onPosition_{ nullptr };
+	void*             positionContext_{ nullptr };
+	VoyageHandler     onVoyage_{ nullptr };
+	void*             voyageContext_{ nullptr };
+	StaticDataHandler onStaticData_{ nullptr };
+	void*             staticDataContext_{ nullptr };
+
+	uint32_t messages_{ 0 };
+	uint32_t unsupported_{ 0 };
+	uint32_t dropped_{ 0 };
+
+	static ParseStatus read_VDM(void* decoder, const SentenceView& sentence);
+
+	ParseStatus unarmor(std::string_view payload, uint8_t fillBits);
+	ParseStatus decode(char channel, bool own);
+
+	[[nodiscard]] uint32_t bits(size_t start, size_t size) const;
+	[[nodiscard]] int32_t  signedBits(size_t start, size_t size) const;
+	void                   text(size_t start, size_t size, char* out) const; // size characters and a '\0'
+
+public:
+	// Takes 2 of the parser's handler slots, for AIVDM and AIVDO. False if they weren't free.
+	bool attachToParser(FixedNMEAParser& parser);
+
+	void setPositionHandler(PositionHandler handler, void* context = nullptr);     // types 1, 2, 3 and 18
+	void setVoyageHandler(VoyageHandler handler, void* context = nullptr);         // type 5
+	void setStaticDataHandler(StaticDataHandler handler, void* context = nullptr); // type 24
+
+	// One VDM or VDO sentence. Pending while a message waits for more sentences
+	// (Ok to a FixedNMEAParser), MissingFragment for a sentence without the ones
+	// before it. Ok for other sentences, which are left alone.
+	ParseStatus readSentence(const SentenceView& sentence);
+	ParseStatus readSentence(std::string_view line); // the text of one sentence, line ending allowed
+
+	// A whole message's armored payload and its fill bits, however it arrived
+	ParseStatus readPayload(std::string_view payload, uint8_t fillBits, char channel = 0, bool own = false);
+
+	[[nodiscard]] uint32_t messages() const { return messages_; }       // decoded and handed to a handler (or not, if none is set)
+	[[nodiscard]] uint32_t unsupported() const { return unsupported_; } // good messages of types this doesn't decode
+	[[nodiscard]] uint32_t dropped() const { return dropped_; }         // messages given up on while putting them together
+};
+
+} // namespace nmea
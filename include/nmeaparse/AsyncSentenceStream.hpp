@@ -0,0 +1,402 @@
+/*
+ * AsyncSentenceStream.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+// The one part of NemaTode that needs C++20, header only. The library itself
+// stays C++17, this is included by the code that uses it.
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "AsyncSentenceStream.hpp needs C++20 coroutines"
+#endif
+
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <string_view>
+#include <utility>
+
+#include "nmeaparse/GPSService.hpp"
+#include "nmeaparse/NMEAParser.hpp"
+#include "nmeaparse/SentenceFramer.hpp"
+#include "nmeaparse/SentenceView.hpp"
+
+namespace nmea {
+
+// Coroutine frames, allocated as a stack in a buffer of fixed size. The
+// coroutines of a stream await one another strictly nested, so their frames
+// are freed in the reverse order and the buffer is reused for every awaited
+// item. Frames that don't fit go to the heap, and are counted.
+//
+// A coroutine gets its frame from the arena of the Scope it is called in, and
+// from the heap outside of one.
+class FrameArena {
+public:
+	static constexpr size_t Size = 1024; // bytes, room for the three nested frames of nextFix()
+
+	// The arena for the coroutines called while it lives, in this thread
+	class Scope {
+	private:
+		FrameArena* previous_;
+
+	public:
+		explicit Scope(FrameArena& arena)
+		    : previous_(std::exchange(current_, &arena))
+		{
+		}
+
+		~Scope() { current_ = previous_; }
+
+		Scope(const Scope&)            = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+private:
+	static constexpr size_t Align = alignof(std::max_align_t); // each frame starts with its owner, padded to this
+
+	static inline thread_local FrameArena* current_ = nullptr;
+
+	alignas(std::max_align_t) std::byte buffer_[Size];
+	size_t   top_{ 0 };
+	size_t   live_{ 0 };
+	uint32_t heapFrames_{ 0 };
+
+	static size_t total(size_t size) { return Align + (size + Align - 1) / Align * Align; }
+
+public:
+	FrameArena() = default;
+
+	FrameArena(const FrameArena&)            = delete; // frames point back into it
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	static void* allocate(size_t size)
+	{
+		FrameArena* arena = current_;
+		std::byte*  base  = nullptr;
+		if ( arena != nullptr && arena->top_ + total(size) <= Size ) {
+			base = arena->buffer_ + arena->top_;
+			arena->top_ += total(size);
+			arena->live_++;
+		}
+		else {
+			if ( arena != nullptr ) {
+				arena->heapFrames_++;
+				arena = nullptr;
+			}
+			base = static_cast<std::byte*>(::operator new(total(size)));
+		}
+		std::memcpy(base, &arena, sizeof(arena));
+		return base + Align;
+	}
+
+	static void deallocate(void* frame, size_t size)
+	{
+		std::byte*  base  = static_cast<std::byte*>(frame) - Align;
+		FrameArena* arena = nullptr;
+		std::memcpy(&arena, base, sizeof(arena));
+		if ( arena == nullptr ) {
+			::operator delete(base);
+			return;
+		}
+		if ( base + total(size) == arena->buffer_ + arena->top_ ) {
+			arena->top_ -= total(size);
+		}
+		if ( --arena->live_ == 0 ) {
+			arena->top_ = 0; // in case frames were freed out of order after all
+		}
+	}
+
+	[[nodiscard]] uint32_t heapFrames() const { return heapFrames_; } // frames that didn't fit
+};
+
+// The result of a coroutine of AsyncSentenceStream, to co_await once. Lazy:
+// the coroutine starts when awaited, and resumes the awaiting one when done.
+// Exceptions thrown inside come out of the co_await.
+template <class T>
+class StreamTask {
+public:
+	struct promise_type {
+		T                       value_{};
+		std::exception_ptr      error_;
+		std::coroutine_handle<> continuation_;
+
+		// the frame comes from the FrameArena of the Scope the coroutine is called in
+		static void* operator new(size_t size)
+		{
+			return FrameArena::allocate(size);
+		}
+
+		static void operator delete(void* frame, size_t size)
+		{
+			FrameArena::deallocate(frame, size);
+		}
+
+		StreamTask get_return_object() { return StreamTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+		std::suspend_always initial_suspend() noexcept { return {}; }
+
+		auto final_suspend() noexcept
+		{
+			struct Resume {
+				bool await_ready() noexcept { return false; }
+				void await_resume() noexcept {}
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> done) noexcept
+				{
+					std::coroutine_handle<> next = done.promise().continuation_;
+					return next ? next : std::noop_coroutine();
+				}
+			};
+			return Resume{};
+		}
+
+		void return_value(T value) { value_ = std::move(value); }
+		void unhandled_exception() { error_ = std::current_exception(); }
+	};
+
+private:
+	std::coroutine_handle<promise_type> handle_;
+
+	explicit StreamTask(std::coroutine_handle<promise_type> handle)
+	    : handle_(handle)
+	{
+	}
+
+public:
+	StreamTask(StreamTask&& other) noexcept
+	    : handle_(std::exchange(other.handle_, nullptr))
+	{
+	}
+
+	StreamTask(const StreamTask&)            = delete;
+	StreamTask& operator=(const StreamTask&) = delete;
+	StreamTask& operator=(StreamTask&&)      = delete;
+
+	~StreamTask()
+	{
+		if ( handle_ ) {
+			handle_.destroy();
+		}
+	}
+
+	bool await_ready() const noexcept { return false; }
+
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+	{
+		handle_.promise().continuation_ = awaiting;
+		return handle_;
+	}
+
+	T await_resume()
+	{
+		if ( handle_.promise().error_ ) {
+			std::rethrow_exception(handle_.promise().error_);
+		}
+		return std::move(handle_.promise().value_);
+	}
+};
+
+// Anything with read(data, size) giving an awaitable of the bytes read into
+// data, 0 once the stream is closed: a socket or a serial port of whatever
+// event loop the application runs.
+template <class Source>
+concept AsyncByteSource = requires(Source& source, uint8_t* data, size_t size) {
+	source.read(data, size);
+};
+
+// Sentences, epochs and fixes of an async byte source, to co_await one after
+// another in sequential code, instead of handlers on a parser.
+//
+//   AsyncSentenceStream stream(socket, &parser);  // GPSService gps(parser)
+//   while ( true ) {
+//       const GPSFix* fix = co_await stream.nextFix(gps);
+//       if ( fix == nullptr ) {
+//           break;
+//       }
+//       ...
+//   }
+//
+// Sentences are views into the stream, good until the next co_await on it.
+// Lines that don't parse (SentenceView rules, bad checksums included) are
+// skipped and counted. Each good sentence also goes to the parser, if there is
+// one, so a GPSService on it keeps its fix up to date.
+//
+// Nothing is allocated per awaited item: the coroutine frames come from the
+// stream's FrameArena, the line from its framer. Only one co_await on a stream
+// may be pending at a time.
+template <AsyncByteSource Source, size_t BufferSize = 512>
+class AsyncSentenceStream {
+private:
+	static constexpr size_t MaxTimeSize = 16; // hhmmss.sss with room to spare, a longer field is no time
+
+	Source&                                            source_;
+	NMEAParser*                                        parser_;
+	FrameArena                                         frames_;
+	uint8_t                                            buffer_[BufferSize]{};
+	size_t                                             pos_{ 0 };
+	size_t                                             end_{ 0 };
+	BasicSentenceFramer<SentenceView::MaxSentenceSize> framer_;
+	SentenceView                                       sentence_;
+	bool                                               pending_{ false };     // sentence_ starts the next epoch, read but not handed out
+	char                                               epoch_[MaxTimeSize]{}; // time field of the current epoch
+	size_t                                             epochSize_{ 0 };
+	uint64_t                                           rejected_{ 0 };
+
+	// The coroutines behind read() and the public functions, each called in
+	// the stream's FrameArena::Scope by its wrapper so its frame comes from
+	// the arena
+	StreamTask<const SentenceView*> readCoroutine()
+	{
+		if ( pending_ ) {
+			pending_ = false;
+			co_return &sentence_;
+		}
+		while ( true ) {
+			while ( pos_ < end_ ) {
+				if ( framer_.push(buffer_[pos_++]) != decltype(framer_)::Complete ) {
+					continue;
+				}
+				if ( parseSentenceView(framer_.line(), sentence_) == ParseStatus::Ok && !sentence_.checksumMismatch() ) {
+					co_return &sentence_;
+				}
+				rejected_++;
+			}
+			size_t size = co_await source_.read(buffer_, BufferSize);
+			if ( size == 0 ) {
+				co_return nullptr;
+			}
+			pos_ = 0;
+			end_ = size < BufferSize ? size : BufferSize;
+		}
+	}
+
+	StreamTask<const SentenceView*> nextCoroutine()
+	{
+		const SentenceView* sentence = co_await read();
+		if ( sentence != nullptr ) {
+			handle();
+		}
+		co_return sentence;
+	}
+
+	StreamTask<size_t> nextEpochCoroutine()
+	{
+		// no co_await in loop conditions here, GCC 12 gets those wrong
+		size_t count = 0;
+		while ( true ) {
+			const SentenceView* sentence = co_await read();
+			if ( sentence == nullptr ) {
+				break;
+			}
+			std::string_view time = timeOf(*sentence);
+			if ( !time.empty() && time != std::string_view(epoch_, epochSize_) ) {
+				epochSize_ = time.size(); // timeOf() makes sure it fits
+				std::memcpy(epoch_, time.data(), epochSize_);
+				if ( count != 0 ) {
+					pending_ = true;
+					co_return count;
+				}
+			}
+			handle();
+			count++;
+		}
+		co_return count;
+	}
+
+	StreamTask<const GPSFix*> nextFixCoroutine(GPSService& gps)
+	{
+		while ( true ) {
+			size_t count = co_await nextEpoch();
+			if ( count == 0 ) {
+				co_return nullptr;
+			}
+			if ( gps.fix_.locked() ) {
+				co_return &gps.fix_;
+			}
+		}
+	}
+
+	// The next good sentence, not yet given to the parser. nullptr at the end.
+	StreamTask<const SentenceView*> read()
+	{
+		FrameArena::Scope scope(frames_);
+		return readCoroutine();
+	}
+
+	// The line of sentence_ to the parser
+	void handle()
+	{
+		if ( parser_ == nullptr ) {
+			return;
+		}
+		try {
+			parser_->readSentence(framer_.line());
+		}
+		catch ( NMEAParseError& ) {
+			// the handlers' business, the stream goes on
+		}
+	}
+
+	// The time field of the sentences that start an epoch, empty for others
+	static std::string_view timeOf(const SentenceView& sentence)
+	{
+		std::string_view name = sentence.name_;
+		std::string_view time;
+		if ( name.size() != 5 ) {
+			return time;
+		}
+		std::string_view type = name.substr(2);
+		if ( type == "GGA" || type == "RMC" || type == "ZDA" || type == "GNS" ) {
+			time = sentence.parameter(0);
+		}
+		else if ( type == "GLL" ) {
+			time = sentence.parameter(4);
+		}
+		return time.size() <= MaxTimeSize ? time : std::string_view();
+	}
+
+public:
+	explicit AsyncSentenceStream(Source& source, NMEAParser* parser = nullptr) // both must outlive the stream
+	    : source_(source)
+	    , parser_(parser)
+	{
+	}
+
+	AsyncSentenceStream(const AsyncSentenceStream&)            = delete;
+	AsyncSentenceStream& operator=(const AsyncSentenceStream&) = delete;
+
+	// The next sentence, nullptr once the source is closed
+	StreamTask<const SentenceView*> next()
+	{
+		FrameArena::Scope scope(frames_);
+		return nextCoroutine();
+	}
+
+	// Reads the sentences up to the next one with another time (GGA, RMC, ZDA,
+	// GNS, GLL), which starts the next epoch. Returns how many there were, 0 once
+	// the source is closed. The last epoch of a stream ends with it.
+	StreamTask<size_t> nextEpoch()
+	{
+		FrameArena::Scope scope(frames_);
+		return nextEpochCoroutine();
+	}
+
+	// The fix of gps after the next epoch that leaves it locked, nullptr once the
+	// source is closed. gps has to be attached to the stream's parser.
+	StreamTask<const GPSFix*> nextFix(GPSService& gps)
+	{
+		FrameArena::Scope scope(frames_);
+		return nextFixCoroutine(gps);
+	}
+
+	[[nodiscard]] FrameArena& frames() { return frames_; }
+	[[nodiscard]] uint64_t    rejected() const { return rejected_; } // lines skipped
+};
+
+} // namespace nmea
@@ -0,0 +1,101 @@
+/*
+ * Checkpoint.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace nmea {
+
+class GPSService;
+class NMEAParser;
+
+class CheckpointError : public std::exception {
+private:
+	const std::string message_;
+
+public:
+	explicit CheckpointError(std::string msg)
+	    : message_(std::move(msg)){};
+
+	[[nodiscard]] const char* what() const noexcept override
+	{
+		return message_.c_str();
+	}
+};
+
+// Writes the state of many streams, each a GPSService and the parser under it,
+// into one binary snapshot, so a restarted process picks up where the old one
+// left off instead of waiting for a full GSV cycle and an RMC.
+//
+// Kept per stream: the fix with its lock state and almanac (including the GSV
+// pages read so far), the partial sentence in the parser's line buffer, and
+// the caller's byte offset into the stream. Handlers, metrics, the fix history
+// and the clock are not; they belong to the new process.
+//
+//   std::ofstream out("ingest.ckpt.tmp", std::ios::binary);
+//   CheckpointWriter checkpoint(out);
+//   for ( auto& s: streams ) {
+//       checkpoint.add(s.id, s.gps, &s.parser, s.bytesRead);
+//   }
+//   checkpoint.finish();
+//   // then rename over ingest.ckpt
+class CheckpointWriter {
+private:
+	std::ostream&     out_;
+	std::vector<char> record_; // reused for each stream
+	bool              finished_{ false };
+
+public:
+	// 2: the parser may be skipping a sentence (NMEAParser::setInterest())
+	static constexpr uint32_t Version = 2;
+
+	explicit CheckpointWriter(std::ostream& out); // writes the header
+
+	void add(uint64_t stream, const GPSService& gps, const NMEAParser* parser = nullptr, uint64_t offset = 0);
+
+	// Ends the snapshot. A snapshot without its end, e.g. from a crash while
+	// writing, is rejected by CheckpointReader.
+	void finish();
+};
+
+// Reads a snapshot of CheckpointWriter, stream by stream, of this version or an
+// older one. Throws CheckpointError for a snapshot of a newer version, a damaged
+// or a truncated one.
+//
+//   std::ifstream    in("ingest.ckpt", std::ios::binary);
+//   CheckpointReader checkpoint(in);
+//   while ( checkpoint.next() ) {
+//       auto& s = streams[checkpoint.stream()];
+//       checkpoint.restore(s.gps, &s.parser);
+//       s.source.seek(checkpoint.offset());
+//   }
+class CheckpointReader {
+private:
+	std::istream&     in_;
+	std::vector<char> record_; // of the current stream
+	uint32_t          version_{ 0 };
+	uint64_t          stream_{ 0 };
+	uint64_t          offset_{ 0 };
+
+public:
+	explicit CheckpointReader(std::istream& in); // reads the header
+
+	// Goes to the next stream, false after the last one.
+	bool next();
+
+	[[nodiscard]] uint64_t stream() const;
+	[[nodiscard]] uint64_t offset() const;
+
+	// Sets the fix of gps, and the line buffer of parser, to those of the current
+	// stream. No events are called. Streams that are not restored are skipped.
+	void restore(GPSService& gps, NMEAParser* parser = nullptr) const;
+};
+
+} // namespace nmea
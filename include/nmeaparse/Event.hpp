@@ -12,6 +12,7 @@
 #include <cstdint>
 #include <functional>
 #include <list>
+#include <memory_resource>
 
 namespace nmea {
 
@@ -99,10 +100,10 @@ class Event<void(Args...)> {
 
 private:
 	// Typenames
-	using ListIterator = typename std::list<EventHandler<void(Args...)>>::iterator;
+	using ListIterator = typename std::pmr::list<EventHandler<void(Args...)>>::iterator;
 
 	// Properties
-	std::list<EventHandler<void(Args...)>> handlers_;
+	std::pmr::list<EventHandler<void(Args...)>> handlers_; // nodes come from the resource given to the constructor
 
 	// Functions
 	void _copy(const Event& ref)
@@ -127,6 +128,12 @@ public:
 	bool enabled{ true };
 
 	// Functions
+	Event() = default;
+
+	explicit Event(std::pmr::memory_resource* resource)
+	    : handlers_(resource)
+	{
+	}
 
 	void call(Args... args)
 	{
@@ -170,6 +177,9 @@ public:
 		handlers_.clear();
 	};
 
+	[[nodiscard]] size_t size() const { return handlers_.size(); }
+	[[nodiscard]] bool   empty() const { return handlers_.empty(); }
+
 	void                        operator()(Args... args) { return call(args...); };
 	EventHandler<void(Args...)> operator+=(EventHandler<void(Args...)> handler) { return registerHandler(handler); };
 	EventHandler<void(Args...)> operator+=(std::function<void(Args...)> handler) { return registerHandler(handler); };
@@ -0,0 +1,163 @@
+/*
+ * FixHistory.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <vector>
+
+#include "nmeaparse/GPSFix.hpp"
+
+namespace nmea {
+
+// What a fix history keeps of a fix, 48 bytes.
+struct FixRecord {
+	UTCTime time_;
+	double  latitude_{ 0 };  // degrees N
+	double  longitude_{ 0 }; // degrees E
+	double  altitude_{ 0 };  // meters
+	float   speed_{ 0 };       // km/h
+	float   travelAngle_{ 0 }; // degrees true north (0-360)
+	float   horizontalDilution_{ 0 };
+	uint8_t quality_{ 0 };
+	uint8_t type_{ 1 };
+	uint8_t trackingSatellites_{ 0 };
+	char    status_{ 'V' };
+
+	FixRecord() = default;
+	explicit FixRecord(const GPSFix& fix);
+};
+
+// The last capacity locked fixes, oldest first, in a ring allocated once by the
+// constructor. Records are kept in time order, so looking up a time is a binary
+// search.
+//
+//   FixHistory history(600);                 // a minute at 10 Hz
+//   gps.onUpdate += [&]() { history.record(gps.fix_); };
+//   FixRecord at;
+//   if ( history.positionAt(frameTime, at, FixHistory::Hermite) ) { ... }
+//
+// GPSService::enableHistory() keeps one up to date for you.
+class FixHistory {
+public:
+	enum Interpolation {
+		Linear, // straight between the two fixes
+		Hermite // cubic, with the speed and course of both fixes as tangents
+	};
+
+	class const_iterator {
+		friend FixHistory;
+
+	private:
+		const FixHistory* history_{ nullptr };
+		size_t            index_{ 0 };
+
+		const_iterator(const FixHistory* history, size_t index)
+		    : history_(history)
+		    , index_(index)
+		{
+		}
+
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type        = FixRecord;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = const FixRecord*;
+		using reference         = const FixRecord&;
+
+		const_iterator() = default;
+
+		reference       operator*() const { return (*history_)[index_]; }
+		pointer         operator->() const { return &(*history_)[index_]; }
+		const_iterator& operator++()
+		{
+			index_++;
+			return *this;
+		}
+		const_iterator operator++(int)
+		{
+			const_iterator old = *this;
+			index_++;
+			return old;
+		}
+		bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+		bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+	};
+
+	// The records of a time range, for range-for
+	class Window {
+		friend FixHistory;
+
+	private:
+		const_iterator begin_;
+		const_iterator end_;
+
+		Window(const_iterator begin, const_iterator end)
+		    : begin_(begin)
+		    , end_(end)
+		{
+		}
+
+	public:
+		[[nodiscard]] const_iterator begin() const { return begin_; }
+		[[nodiscard]] const_iterator end() const { return end_; }
+		[[nodiscard]] size_t         size() const { return end_.index_ - begin_.index_; }
+		[[nodiscard]] bool           empty() const { return size() == 0; }
+	};
+
+private:
+	std::pmr::vector<FixRecord> ring_;
+	size_t                      start_{ 0 }; // oldest record
+	size_t                      size_{ 0 };
+	int32_t                     rawDate_{ 0 }; // GPSTimestamp::rawDate_ of the last fix recorded
+
+public:
+	// Throws std::invalid_argument if capacity is 0.
+	explicit FixHistory(size_t capacity, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	// Adds a locked fix. A fix with the time of the newest record replaces it
+	// (GGA, RMC and the rest of one epoch all land in one record), unlocked fixes
+	// and fixes without a date (before the first RMC) are skipped. GGA carries
+	// the date of the last RMC: while the date stays the same, a time more than
+	// 12 hours before the newest record is past midnight, moved to the next day.
+	void record(const GPSFix& fix);
+
+	// Appends, dropping the oldest record when full. A record older than the
+	// newest one means the receiver's clock went back, the history starts over.
+	void push(const FixRecord& record);
+	void clear();
+
+	[[nodiscard]] size_t size() const;
+	[[nodiscard]] size_t capacity() const;
+	[[nodiscard]] bool   empty() const;
+
+	[[nodiscard]] const FixRecord& operator[](size_t index) const; // 0 is the oldest
+	[[nodiscard]] const FixRecord& front() const;
+	[[nodiscard]] const FixRecord& back() const;
+
+	[[nodiscard]] const_iterator begin() const;
+	[[nodiscard]] const_iterator end() const;
+
+	// Index of the first record at or after time, size() if there is none.
+	[[nodiscard]] size_t lowerBound(UTCTime time) const;
+
+	// The record closest in time, nullptr if empty.
+	[[nodiscard]] const FixRecord* nearest(UTCTime time) const;
+
+	// Position at time, between the records on either side of it. False, leaving
+	// out alone, if time is before the oldest or after the newest record.
+	bool positionAt(UTCTime time, FixRecord& out, Interpolation mode = Linear) const;
+
+	// The records from `from` to `to`, both included.
+	[[nodiscard]] Window window(UTCTime from, UTCTime to) const;
+
+	[[nodiscard]] size_t memoryUsage() const; // bytes of the ring
+};
+
+} // namespace nmea
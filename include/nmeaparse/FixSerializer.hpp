@@ -0,0 +1,112 @@
+/*
+ * FixSerializer.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "nmeaparse/GPSFix.hpp"
+#include "nmeaparse/NMEAParser.hpp"
+
+namespace nmea {
+
+enum class SerialFormat {
+	JSONLines, // one JSON object per line
+	CSV        // comma separated, header on request
+};
+
+struct FixSerializerSettings {
+	SerialFormat format{ SerialFormat::JSONLines };
+	uint32_t     fields{ 0 };               // FixSerializer::Field bits of a fix to write, 0 = all
+	int          coordinatePrecision{ -1 }; // decimals of latitude/longitude, -1 = shortest that reads back exactly
+	int          valuePrecision{ -1 };      // decimals of the other numbers, same
+	size_t       bufferSize{ 1 << 20 };     // records are collected in this many bytes before being passed on
+};
+
+// Writes fixes, almanacs and raw sentences as JSON Lines or CSV for machines
+// to read. Numbers are formatted with std::to_chars, records collected in one
+// large buffer and handed to the sink in big blocks, so a record costs no
+// allocation and no system call.
+//
+//   FixSerializer out(stdout);
+//   gps.onUpdate_ += [&]() { out.write(gps.fix_); };
+//
+// A sink that can't write throws std::system_error (FILE*) or whatever the
+// sink throws, from the write() that filled the buffer or from flush().
+class FixSerializer {
+public:
+	using Sink = std::function<void(const char* data, size_t size)>;
+
+	// Fields of a fix, in the order they are written
+	enum Field : uint32_t {
+		Time      = 1U << 0,  // "2011-05-28T09:27:50.000Z"
+		Status    = 1U << 1,  // 'A' or 'V'
+		Lock      = 1U << 2,
+		Type      = 1U << 3,
+		Quality   = 1U << 4,
+		Latitude  = 1U << 5,
+		Longitude = 1U << 6,
+		Altitude  = 1U << 7,
+		Speed     = 1U << 8,  // km/h
+		Course    = 1U << 9,  // travel angle
+		PDOP      = 1U << 10,
+		HDOP      = 1U << 11,
+		VDOP      = 1U << 12,
+		Tracking  = 1U << 13, // tracking satellites
+		Visible   = 1U << 14, // visible satellites
+		AllFields = (1U << 15) - 1
+	};
+
+	// Kinds of records, for the CSV header
+	enum Record {
+		FixRecord,
+		SatelliteRecord, // one row or object per satellite of an almanac
+		SentenceRecord
+	};
+
+private:
+	Sink                  sink_;
+	FixSerializerSettings settings_;
+	std::vector<char>     buffer_;
+	char*                 pos_;
+	char*                 end_;
+	uint64_t              records_{ 0 };
+
+	char* reserve(size_t size); // room for size more bytes, flushes or grows as needed
+	void  put(std::string_view text);
+	void  putString(std::string_view text); // quoted and escaped for the format
+	void  endRecord();
+
+	char* number(char* out, double value, int precision) const;
+
+public:
+	explicit FixSerializer(FILE* file, FixSerializerSettings settings = FixSerializerSettings());
+	explicit FixSerializer(Sink sink, FixSerializerSettings settings = FixSerializerSettings());
+	~FixSerializer(); // flushes, errors are dropped here, call flush() to see them
+
+	FixSerializer(const FixSerializer&)            = delete;
+	FixSerializer& operator=(const FixSerializer&) = delete;
+
+	// The CSV column names of a record kind, as a line. Nothing for JSON Lines.
+	void writeHeader(Record kind);
+
+	void write(const GPSFix& fix);
+	void write(const GPSAlmanac& almanac);
+	void write(const NMEASentence& sentence);
+
+	// Hands everything buffered to the sink.
+	void flush();
+
+	[[nodiscard]] const FixSerializerSettings& settings() const;
+	[[nodiscard]] uint64_t                     records() const; // records written so far
+	[[nodiscard]] size_t                       buffered() const; // bytes not yet passed to the sink
+};
+
+} // namespace nmea
@@ -0,0 +1,57 @@
+/*
+ * FixedGPSService.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "nmeaparse/FixedNMEAParser.hpp"
+#include "nmeaparse/GPSFix.hpp"
+
+namespace nmea {
+
+// GPSService on top of FixedNMEAParser: reads the same sentences into the same
+// GPSFix with the same GPSSentenceDecoder, but reports problems as ParseStatus
+// and calls plain function pointers. Allocates nothing after the constructor
+// (in the NEMATODE_EMBEDDED build the almanac is inline, otherwise room for all
+// satellites is reserved up front).
+class FixedGPSService {
+public:
+	static constexpr size_t MaxSatellites = 32;
+
+	using UpdateHandler = void (*)(void* context, const GPSFix& fix);
+	using LockHandler   = void (*)(void* context, bool locked);
+
+private:
+	UpdateHandler onUpdate_{ nullptr };
+	void*         updateContext_{ nullptr };
+	LockHandler   onLockStateChanged_{ nullptr };
+	void*         lockContext_{ nullptr };
+
+	void update(bool lockupdate);
+
+	static ParseStatus read_PSRF150(void* service, const SentenceView& nmea);
+	static ParseStatus read_GPGGA(void* service, const SentenceView& nmea);
+	static ParseStatus read_GPGSA(void* service, const SentenceView& nmea);
+	static ParseStatus read_GPGSV(void* service, const SentenceView& nmea);
+	static ParseStatus read_GPRMC(void* service, const SentenceView& nmea);
+	static ParseStatus read_GPVTG(void* service, const SentenceView& nmea);
+
+public:
+	GPSFix fix_;
+
+	explicit FixedGPSService(FixedNMEAParser& parser);
+
+	// Takes 6 of the parser's handler slots. False if they weren't all free.
+	bool attachToParser(FixedNMEAParser& parser);
+
+	void setUpdateHandler(UpdateHandler handler, void* context = nullptr);    // called whenever the fix changes
+	void setLockStateHandler(LockHandler handler, void* context = nullptr);   // called whenever lock changes
+
+	[[nodiscard]] size_t memoryUsage() const; // bytes held by this service
+};
+
+} // namespace nmea
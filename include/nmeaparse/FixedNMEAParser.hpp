@@ -0,0 +1,81 @@
+/*
+ * FixedNMEAParser.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "nmeaparse/SentenceFramer.hpp"
+#include "nmeaparse/SentenceView.hpp"
+
+namespace nmea {
+
+// NMEAParser for small targets: an 82 byte line buffer inside the object, a
+// fixed table of plain function handlers, ParseStatus instead of exceptions
+// and no allocation at all. Works with -fno-exceptions, it is the parser of
+// the NEMATODE_EMBEDDED build.
+//
+//   FixedNMEAParser parser;
+//   parser.setSentenceHandler("GPGGA", &onGGA, &state);
+//   if ( parser.readByte(byte) > ParseStatus::Pending ) { ... }
+class FixedNMEAParser {
+public:
+	static constexpr size_t MaxHandlers = 16;
+
+	// context is the pointer given when setting the handler
+	using Handler      = ParseStatus (*)(void* context, const SentenceView& sentence);
+	using ErrorHandler = void (*)(void* context, ParseStatus status, const SentenceView& sentence);
+
+private:
+	using Framer = BasicSentenceFramer<SentenceView::MaxSentenceSize>;
+
+	struct HandlerEntry {
+		uint64_t key{ 0 }; // sentenceKey() of the name
+		Handler  handler{ nullptr };
+		void*    context{ nullptr };
+	};
+
+	HandlerEntry handlers_[MaxHandlers]{};
+	size_t       handlerCount_{ 0 };
+	HandlerEntry anySentence_{};
+	ErrorHandler onError_{ nullptr };
+	void*        errorContext_{ nullptr };
+
+	Framer       framer_;
+	SentenceView sentence_;
+
+	uint32_t sentences_{ 0 };
+	uint32_t errors_{ 0 };
+
+	ParseStatus dispatch(std::string_view line);
+	ParseStatus fail(ParseStatus status);
+
+public:
+	// Sets or replaces the handler of the named sentence (up to 8 characters).
+	// Returns false if the name is too long or the table is full.
+	bool setSentenceHandler(std::string_view name, Handler handler, void* context = nullptr);
+	void setAnySentenceHandler(Handler handler, void* context = nullptr); // every valid sentence, before its own handler
+	void setErrorHandler(ErrorHandler handler, void* context = nullptr);  // every status other than Ok and Pending
+
+	// Pending until a newline completes a sentence, then the parse result or what its handler returned.
+	ParseStatus readByte(uint8_t byte);
+
+	// Ok if every sentence completed in ptr was, else the status of the last one that failed.
+	ParseStatus readBuffer(const uint8_t* ptr, size_t size);
+
+	// One sentence, with or without the line ending.
+	ParseStatus readSentence(std::string_view line);
+
+	[[nodiscard]] uint32_t sentences() const; // read without a parse error
+	[[nodiscard]] uint32_t errors() const;    // everything reported to the error handler
+	[[nodiscard]] uint32_t overflows() const; // lines dropped for being longer than 82 characters
+
+	[[nodiscard]] size_t memoryUsage() const; // bytes held by this parser, all of them inside the object
+};
+
+} // namespace nmea
@@ -0,0 +1,55 @@
+/*
+ * FixedVector.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace nmea {
+
+// The parts of std::vector this library uses, with the storage inline and a
+// fixed capacity. Never allocates; push_back() past the capacity drops the
+// element and returns false.
+template <typename T, size_t Capacity>
+class FixedVector {
+private:
+	T      items_[Capacity]{};
+	size_t size_{ 0 };
+
+public:
+	using value_type     = T;
+	using iterator       = T*;
+	using const_iterator = const T*;
+
+	bool push_back(const T& item)
+	{
+		if ( size_ == Capacity ) {
+			return false;
+		}
+		items_[size_++] = item;
+		return true;
+	}
+
+	bool emplace_back(const T& item) { return push_back(item); }
+
+	void clear() { size_ = 0; }
+
+	[[nodiscard]] size_t size() const { return size_; }
+	[[nodiscard]] bool   empty() const { return size_ == 0; }
+	[[nodiscard]] bool   full() const { return size_ == Capacity; }
+
+	[[nodiscard]] static constexpr size_t capacity() { return Capacity; }
+
+	T&       operator[](size_t index) { return items_[index]; }
+	const T& operator[](size_t index) const { return items_[index]; }
+
+	iterator       begin() { return items_; }
+	iterator       end() { return items_ + size_; }
+	const_iterator begin() const { return items_; }
+	const_iterator end() const { return items_ + size_; }
+};
+
+} // namespace nmea
@@ -17,12 +17,61 @@
 #include <string>
 #include <vector>
 
+#include "nmeaparse/FixedVector.hpp"
+
 namespace nmea {
 
 struct GPSSatellite;
+class CheckpointReader;
+class CheckpointWriter;
 class GPSAlmanac;
 class GPSFix;
 class GPSService;
+class GPSSentenceDecoder;
+class FixedGPSService;
+
+// Milliseconds since Jan 1, 1970 UTC (the system_clock epoch).
+using UTCTime = std::chrono::time_point<std::chrono::system_clock, std::chrono::milliseconds>;
+
+// Source of "now" for fix age calculations. Swap in a cached or simulated
+// clock so age queries don't have to ask the OS every time.
+using UTCClock = UTCTime (*)();
+
+UTCTime systemUTCNow();
+
+// Days since Jan 1, 1970 for a proleptic Gregorian date (month 1-12).
+// Pure arithmetic, no timezone database involved.
+constexpr int64_t
+daysFromCivil(int64_t year, uint32_t month, uint32_t day)
+{
+	year -= month <= 2 ? 1 : 0;
+	const int64_t  era = (year >= 0 ? year : year - 399) / 400;
+	const auto     yoe = static_cast<uint32_t>(year - era * 400);                  // [0, 399]
+	const uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // [0, 365]
+	const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                     // [0, 146096]
+	return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+struct CivilDate {
+	int32_t  year;
+	uint32_t month; // 1-12
+	uint32_t day;   // 1-31
+};
+
+// Inverse of daysFromCivil()
+constexpr CivilDate
+civilFromDays(int64_t days)
+{
+	days += 719468;
+	const int64_t  era = (days >= 0 ? days : days - 146096) / 146097;
+	const auto     doe = static_cast<uint32_t>(days - era * 146097);               // [0, 146096]
+	const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;  // [0, 399]
+	const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                // [0, 365]
+	const uint32_t mp  = (5 * doy + 2) / 153;                                    // [0, 11]
+	const uint32_t day = doy - (153 * mp + 2) / 5 + 1;                           // [1, 31]
+	const uint32_t mon = mp < 10 ? mp + 3 : mp - 9;                              // [1, 12]
+	return CivilDate{ static_cast<int32_t>(static_cast<int64_t>(yoe) + era * 400 + (mon <= 2 ? 1 : 0)), mon, day };
+}
 
 // =========================== GPS SATELLITE =====================================
 
@@ -40,8 +89,19 @@ struct GPSSatellite {
 
 // =========================== GPS ALMANAC =====================================
 
+#ifdef NEMATODE_EMBEDDED
+// GPS has at most 32 satellites, the almanac of the embedded build holds them inline
+using SatelliteList = FixedVector<GPSSatellite, 32>;
+#else
+using SatelliteList = std::vector<GPSSatellite>;
+#endif
+
 class GPSAlmanac {
 	friend GPSService;
+	friend GPSSentenceDecoder;
+	friend FixedGPSService;
+	friend CheckpointReader;
+	friend CheckpointWriter;
 
 private:
 	uint32_t visibleSize{};
@@ -54,7 +114,7 @@ private:
 
 public:
 	// mapped by prn
-	std::vector<GPSSatellite> satellites_;
+	SatelliteList satellites_;
 
 	[[nodiscard]] double averageSNR() const;
 	[[nodiscard]] double minSNR() const;
@@ -73,6 +133,7 @@ public:
 	int32_t hour_{ 0 };
 	int32_t min_{ 0 };
 	double  sec_{ 0 };
+	int32_t milliseconds_{ 0 }; // sec_ as whole milliseconds (0-60999)
 
 	int32_t month_{ 1 };
 	int32_t day_{ 1 };
@@ -82,7 +143,8 @@ public:
 	double  rawTime_{ 0 };
 	int32_t rawDate_{ 0 };
 
-	[[nodiscard]] time_t getTime() const;
+	[[nodiscard]] time_t  getTime() const;    // seconds since Jan 1, 1970 UTC
+	[[nodiscard]] UTCTime toUTCTime() const;  // milliseconds since Jan 1, 1970 UTC
 
 	// Set directly from the NMEA time stamp
 	// hhmmss.sss
@@ -99,6 +161,10 @@ public:
 
 class GPSFix {
 	friend GPSService;
+	friend GPSSentenceDecoder;
+	friend FixedGPSService;
+	friend CheckpointReader;
+	friend CheckpointWriter;
 
 private:
 	bool haslock{ false };
@@ -131,12 +197,15 @@ public:
 	int32_t trackingSatellites_{ 0 };
 	int32_t visibleSatellites_{ 0 };
 
+	UTCClock clock_{ &systemUTCNow }; // "now" used by timeSinceLastUpdate()
+
 	[[nodiscard]] bool   locked() const;
 	[[nodiscard]] double horizontalAccuracy() const;
 	[[nodiscard]] double verticalAccuracy() const;
 	[[nodiscard]] bool   hasEstimate() const;
 
-	[[nodiscard]] std::chrono::seconds timeSinceLastUpdate() const; // Returns seconds difference from last timestamp and right now.
+	[[nodiscard]] std::chrono::seconds timeSinceLastUpdate() const;            // Returns seconds difference from last timestamp and right now.
+	[[nodiscard]] std::chrono::seconds timeSinceLastUpdate(UTCTime now) const; // Same, against a caller supplied "now".
 
 	[[nodiscard]] std::string toString() const;
 
@@ -0,0 +1,88 @@
+/*
+ * GPSFixEncoder.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "nmeaparse/GPSFix.hpp"
+#include "nmeaparse/NMEAParser.hpp"
+#include "nmeaparse/SentenceWriter.hpp"
+
+namespace nmea {
+
+// Turns a GPSFix back into standard NMEA sentences, e.g. to rebroadcast a
+// corrected fix to downstream equipment. Sentences are formatted straight into
+// the caller's buffer: "$GPGGA" etc. are pre-rendered with their checksum,
+// coordinates are fixed point, nothing is allocated.
+//
+// What GPSService reads from a sentence round-trips exactly: reading the output
+// back and encoding the resulting fix again gives the same bytes. Values are
+// quantized to what the sentences can carry (coordinateDecimals of minutes,
+// 0.001 s, 0.01 km/h and degree for speed and course, 0.1 for altitude and DOP,
+// whole degrees and dB for satellites). Fields GPSService doesn't read, like the
+// HDOP in GGA, only survive if another sentence (GSA) carries them too. Only
+// the "GP" talker is read back by GPSService.
+//
+// GSV has one digit for its page count, so at most 9 pages of 4, the first 36
+// satellites of the almanac, are written. gsvDropped() tells how many of a fix
+// are left out, and encode() counts the fixes it had to cut short.
+class GPSFixEncoder {
+public:
+	// Bit (1 << MessageID) per sentence for encode(), in the order they are written
+	static constexpr uint32_t AllSentences = (1U << NMEASentence::GGA) | (1U << NMEASentence::GSA) | (1U << NMEASentence::GSV) | (1U << NMEASentence::RMC) | (1U << NMEASentence::VTG);
+
+	static constexpr size_t MaxSentenceSize  = 82;
+	static constexpr size_t MaxGSVPages      = 9;               // the page count is one digit
+	static constexpr size_t MaxGSVSatellites = MaxGSVPages * 4; // the rest are left out
+
+private:
+	struct Prefix {
+		char    text[8];
+		size_t  size;
+		uint8_t checksum;
+	};
+
+	std::array<Prefix, 6> prefixes_{}; // by MessageID, GGA - VTG
+	int                   coordinateDecimals_;
+	uint64_t              truncatedFixes_{ 0 };
+
+	void start(SentenceWriter& writer, NMEASentence::MessageID id) const;
+
+	static void time(SentenceWriter& writer, const GPSTimestamp& timestamp);
+
+public:
+	// coordinateDecimals are the decimals of minutes, 4 is ~0.2 m, 7 (the max) ~0.2 mm.
+	explicit GPSFixEncoder(const std::string& talker = "GP", int coordinateDecimals = 4);
+
+	// Each returns the sentence length, or 0 if it doesn't fit in size.
+	size_t encodeGGA(const GPSFix& fix, char* out, size_t size) const;
+	size_t encodeGSA(const GPSFix& fix, char* out, size_t size) const;
+	size_t encodeGSV(const GPSFix& fix, uint32_t page, char* out, size_t size) const; // page 1 - gsvPages()
+	size_t encodeRMC(const GPSFix& fix, char* out, size_t size) const;
+	size_t encodeVTG(const GPSFix& fix, char* out, size_t size) const;
+
+	// Writes the selected sentences (bit 1 << MessageID each), all GSV pages included.
+	// Returns the bytes written, or 0 if they don't all fit. Not const, it counts
+	// truncatedFixes(): one encoder per thread.
+	size_t encode(const GPSFix& fix, char* out, size_t size, uint32_t sentences = AllSentences);
+
+	template <size_t N>
+	size_t encode(const GPSFix& fix, std::array<char, N>& out, uint32_t sentences = AllSentences)
+	{
+		return encode(fix, out.data(), N, sentences);
+	}
+
+	[[nodiscard]] static uint32_t gsvPages(const GPSFix& fix);
+	[[nodiscard]] static size_t   gsvDropped(const GPSFix& fix); // satellites past MaxGSVSatellites
+
+	// Fixes encode() wrote GSV for without all their satellites
+	[[nodiscard]] uint64_t truncatedFixes() const { return truncatedFixes_; }
+};
+
+} // namespace nmea
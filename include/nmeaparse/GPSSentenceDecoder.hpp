@@ -0,0 +1,383 @@
+/*
+ * GPSSentenceDecoder.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "nmeaparse/GPSFix.hpp"
+#include "nmeaparse/NumberConversion.hpp"
+#include "nmeaparse/SentenceView.hpp"
+
+namespace nmea {
+
+// Reads the GGA, GSA, GSV, RMC and VTG sentences into a GPSFix, for
+// GPSService and FixedGPSService. Works on a SentenceView or an NMEASentence
+// (anything with size(), parameter(), checksumIsCalculated_ and checksumOK()),
+// doesn't throw or allocate, and reports problems as ParseStatus. The fix is
+// only changed if the whole sentence could be read. lockupdate is set if the
+// lock changed, the caller calls its handlers.
+class GPSSentenceDecoder {
+public:
+	static constexpr size_t SatellitesPerGSV = 4;
+
+	// These sentences need a checksum
+	template <typename Sentence>
+	static ParseStatus checkChecksum(const Sentence& nmea)
+	{
+		if ( !nmea.checksumIsCalculated_ ) {
+			return ParseStatus::MissingChecksum;
+		}
+		return nmea.checksumOK() ? ParseStatus::Ok : ParseStatus::ChecksumMismatch;
+	}
+
+	template <typename Sentence>
+	static ParseStatus readGGA(const Sentence& nmea, GPSFix& fix, bool& lockupdate)
+	{
+		/* -- EXAMPLE --
+		$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47
+
+		$GPGGA,205630.945,3346.1070,N,08423.6687,W,0,03,,30.8,M,-30.8,M,,0000*73		// ATLANTA!!!!
+
+		Where:
+		GGA          Global Positioning System Fix Data
+		index:
+		[0] 123519       Fix taken at 12:35:19 UTC
+		[1-2] 4807.038,N   Latitude 48 deg 07.038' N
+		[3-4] 1131.000,E  Longitude 11 deg 31.000' E
+		[5] 1            Fix quality: 0 = invalid
+		1 = GPS fix (SPS)
+		2 = DGPS fix
+		3 = PPS fix
+		4 = Real Time Kinematic
+		5 = Float RTK
+		6 = estimated (dead reckoning) (2.3 feature)
+		7 = Manual input mode
+		8 = Simulation mode
+		[6] 08           Number of satellites being tracked
+		[7] 0.9          Horizontal dilution of position
+		[8-9] 545.4,M      Altitude, Meters, above mean sea level
+		[10-11] 46.9,M       Height of geoid (mean sea level) above WGS84
+		ellipsoid
+		[12] (empty field) time in seconds since last DGPS update
+		[13] (empty field) DGPS station ID number
+		[13]  *47          the checksum data, always begins with *
+		*/
+		lockupdate = false;
+		if ( ParseStatus status = checkChecksum(nmea); status != ParseStatus::Ok ) {
+			return status;
+		}
+		if ( nmea.size() < 14 ) {
+			return ParseStatus::MissingFields;
+		}
+
+		double  time      = 0;
+		double  latitude  = fix.latitude_;
+		double  longitude = fix.longitude_;
+		double  altitude  = fix.altitude_; // empty leaves the old value
+		uint8_t quality   = 0;
+		int32_t tracking  = 0;
+		if ( !tryParseDouble(nmea.parameter(0), time)
+		     || !readLatLong(nmea.parameter(1), nmea.parameter(2), latitude)
+		     || !readLatLong(nmea.parameter(3), nmea.parameter(4), longitude)
+		     || !readInt(nmea.parameter(5), quality)
+		     || !readInt(nmea.parameter(6), tracking)
+		     || (!nmea.parameter(8).empty() && !tryParseDouble(nmea.parameter(8), altitude)) ) {
+			return ParseStatus::BadNumber;
+		}
+
+		fix.timestamp_.setTime(time);
+		fix.latitude_  = latitude;
+		fix.longitude_ = longitude;
+		fix.altitude_  = altitude;
+
+		// FIX QUALITY
+		fix.quality_ = quality;
+		if ( quality == 0 ) {
+			lockupdate = fix.setlock(false);
+		}
+		else if ( quality == 1 ) {
+			lockupdate = fix.setlock(true);
+		}
+
+		// TRACKING SATELLITES
+		fix.trackingSatellites_ = tracking;
+		if ( fix.visibleSatellites_ < fix.trackingSatellites_ ) {
+			fix.visibleSatellites_ = fix.trackingSatellites_; // the visible count is in another sentence.
+		}
+		return ParseStatus::Ok;
+	}
+
+	template <typename Sentence>
+	static ParseStatus readGSA(const Sentence& nmea, GPSFix& fix, bool& lockupdate)
+	{
+		/*  -- EXAMPLE --
+		$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39
+
+		$GPGSA,A,3,18,21,22,14,27,19,,,,,,,4.4,2.7,3.4*32
+
+		Where:
+		GSA      Satellite status
+		[0] A        Auto selection of 2D or 3D fix (M = manual)
+		[1] 3        3D fix - values include: 1 = no fix
+		2 = 2D fix
+		3 = 3D fix
+		[2-13] 04,05... PRNs of satellites used for fix (space for 12)
+		[14] 2.5      PDOP (dilution of precision)
+		[15] 1.3      Horizontal dilution of precision (HDOP)
+		[16] 2.1      Vertical dilution of precision (VDOP)
+		[16] *39      the checksum data, always begins with *
+		*/
+		lockupdate = false;
+		if ( ParseStatus status = checkChecksum(nmea); status != ParseStatus::Ok ) {
+			return status;
+		}
+		if ( nmea.size() < 17 ) {
+			return ParseStatus::MissingFields;
+		}
+
+		int64_t fixtype = 0;
+		double  pdop    = 0;
+		double  hdop    = 0;
+		double  vdop    = 0;
+		if ( !tryParseInt(nmea.parameter(1), fixtype) || !tryParseDouble(nmea.parameter(14), pdop)
+		     || !tryParseDouble(nmea.parameter(15), hdop) || !tryParseDouble(nmea.parameter(16), vdop) ) {
+			return ParseStatus::BadNumber;
+		}
+
+		// FIX TYPE
+		fix.type_ = static_cast<uint8_t>(fixtype);
+		if ( fixtype == 1 ) {
+			lockupdate = fix.setlock(false);
+		}
+		else if ( fixtype == 3 ) {
+			lockupdate = fix.setlock(true);
+		}
+
+		fix.dilution_           = pdop;
+		fix.horizontalDilution_ = hdop;
+		fix.verticalDilution_   = vdop;
+		return ParseStatus::Ok;
+	}
+
+	// Adds the page's satellites to the almanac while it has fewer than maxSatellites.
+	template <typename Sentence>
+	static ParseStatus readGSV(const Sentence& nmea, GPSFix& fix, size_t maxSatellites)
+	{
+		/*  -- EXAMPLE --
+		$GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45*75
+
+
+		$GPGSV,3,1,12,01,00,000,,02,00,000,,03,00,000,,04,00,000,*7C
+		$GPGSV,3,2,12,05,00,000,,06,00,000,,07,00,000,,08,00,000,*77
+		$GPGSV,3,3,12,09,00,000,,10,00,000,,11,00,000,,12,00,000,*71
+
+		Where:
+		GSV          Satellites in view
+		[0] 2            Number of sentences for full data
+		[1] 1            sentence 1 of 2
+		[2] 08           Number of satellites in view
+
+		[3] 01           Satellite PRN number
+		[4] 40           Elevation, degrees
+		[5] 083          Azimuth, degrees
+		[6] 46           SNR - higher is better
+		[...]   for up to 4 satellites per sentence
+		[17] *75          the checksum data, always begins with *
+		*/
+		if ( ParseStatus status = checkChecksum(nmea); status != ParseStatus::Ok ) {
+			return status;
+		}
+		// no parameter count check, the length varies with the satellites
+
+		int32_t  visible     = 0;
+		uint32_t totalPages  = 0;
+		uint32_t currentPage = 0;
+		if ( !readInt(nmea.parameter(2), visible) || !readInt(nmea.parameter(0), totalPages) || !readInt(nmea.parameter(1), currentPage) ) {
+			return ParseStatus::BadNumber;
+		}
+
+		// first 3 are not satellite info, entries come in 4-ples and truncate
+		size_t entriesInPage = nmea.size() < 3 ? 0 : (nmea.size() - 3) / 4;
+		if ( entriesInPage > SatellitesPerGSV ) {
+			entriesInPage = SatellitesPerGSV;
+		}
+		GPSSatellite sats[SatellitesPerGSV];
+		for ( size_t i = 0; i < entriesInPage; i++ ) {
+			size_t prop = 3 + i * 4;
+
+			// PRN, ELEVATION, AZIMUTH, SNR
+			uint32_t elevation = 0;
+			uint32_t azimuth   = 0;
+			uint32_t snr       = 0;
+			if ( !readInt(nmea.parameter(prop), sats[i].prn_) || !readInt(nmea.parameter(prop + 1), elevation)
+			     || !readInt(nmea.parameter(prop + 2), azimuth) || !readInt(nmea.parameter(prop + 3), snr) ) {
+				return ParseStatus::BadNumber;
+			}
+			sats[i].elevation_ = elevation;
+			sats[i].azimuth_   = azimuth;
+			sats[i].snr_       = snr;
+		}
+
+		// VISIBLE SATELLITES
+		GPSAlmanac& almanac    = fix.almanac_;
+		fix.visibleSatellites_ = visible;
+		if ( fix.trackingSatellites_ == 0 ) {
+			fix.visibleSatellites_ = 0; // if no satellites are tracking, then none are visible!
+		}                               // Also NMEA defaults to 12 visible when chip powers on. Obviously not right.
+
+		// if this is the first page, then reset the almanac
+		if ( currentPage == 1 ) {
+			almanac.clear();
+		}
+
+		almanac.lastPage    = currentPage;
+		almanac.totalPages  = totalPages;
+		almanac.visibleSize = static_cast<uint32_t>(fix.visibleSatellites_);
+
+		for ( size_t i = 0; i < entriesInPage; i++ ) {
+			if ( almanac.satellites_.size() < maxSatellites ) {
+				almanac.updateSatellite(sats[i]);
+			}
+		}
+
+		almanac.processedPages++;
+
+		if ( fix.visibleSatellites_ == 0 ) {
+			almanac.clear();
+		}
+		return ParseStatus::Ok;
+	}
+
+	template <typename Sentence>
+	static ParseStatus readRMC(const Sentence& nmea, GPSFix& fix, bool& lockupdate)
+	{
+		/*  -- EXAMPLE ---
+		$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A
+		$GPRMC,235957.025,V,,,,,,,070810,,,N*4B
+		$GPRMC,061425.000,A,3346.2243,N,08423.4706,W,0.45,18.77,060914,,,A*47
+
+		Where:
+		RMC          Recommended Minimum sentence C
+		[0] 123519       Fix taken at 12:35:19 UTC
+		[1] A            Status A=active or V=Void.
+		[2-3] 4807.038,N   Latitude 48 deg 07.038' N
+		[4-5] 01131.000,E  Longitude 11 deg 31.000' E
+		[6] 022.4        Speed over the ground in knots
+		[7] 084.4        Track angle in degrees True
+		[8] 230394       Date - 23rd of March 1994
+		[9-10] 003.1,W      Magnetic Variation
+		[10] *6A          The checksum data, always begins with *
+		// NMEA 2.3 includes another field after
+		*/
+		lockupdate = false;
+		if ( ParseStatus status = checkChecksum(nmea); status != ParseStatus::Ok ) {
+			return status;
+		}
+		if ( nmea.size() < 11 ) {
+			return ParseStatus::MissingFields;
+		}
+
+		double  time      = 0;
+		double  latitude  = fix.latitude_;
+		double  longitude = fix.longitude_;
+		double  knots     = 0;
+		double  angle     = 0;
+		int32_t date      = 0;
+		if ( !tryParseDouble(nmea.parameter(0), time)
+		     || !readLatLong(nmea.parameter(2), nmea.parameter(3), latitude)
+		     || !readLatLong(nmea.parameter(4), nmea.parameter(5), longitude)
+		     || !tryParseDouble(nmea.parameter(6), knots)
+		     || !tryParseDouble(nmea.parameter(7), angle)
+		     || !readInt(nmea.parameter(8), date) ) {
+			return ParseStatus::BadNumber;
+		}
+
+		fix.timestamp_.setTime(time);
+		fix.latitude_  = latitude;
+		fix.longitude_ = longitude;
+
+		// ACTIVE
+		char status = nmea.parameter(1).empty() ? 'V' : nmea.parameter(1)[0];
+		fix.status_ = status;
+		lockupdate  = fix.setlock(status == 'A'); // V, or not A or V so must be wrong... no lock
+
+		fix.speed_       = knots * KilometersPerKnot; // received as knots, convert to km/h
+		fix.travelAngle_ = angle;
+		fix.timestamp_.setDate(date);
+		return ParseStatus::Ok;
+	}
+
+	template <typename Sentence>
+	static ParseStatus readVTG(const Sentence& nmea, GPSFix& fix)
+	{
+		/*
+		$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48
+
+		where:
+		VTG          Track made good and ground speed
+		[0-1]	054.7,T      True track made good (degrees)
+		[2-3]	034.4,M      Magnetic track made good
+		[4-5]	005.5,N      Ground speed, knots
+		[6-7]	010.2,K      Ground speed, Kilometers per hour
+		[7]	*48          Checksum
+		*/
+		if ( ParseStatus status = checkChecksum(nmea); status != ParseStatus::Ok ) {
+			return status;
+		}
+		if ( nmea.size() < 8 ) {
+			return ParseStatus::MissingFields;
+		}
+
+		double speed = 0;
+		if ( !tryParseDouble(nmea.parameter(6), speed) ) { // km/h, empty is 0
+			return ParseStatus::BadNumber;
+		}
+		fix.speed_ = speed;
+		return ParseStatus::Ok;
+	}
+
+private:
+	static constexpr double KilometersPerKnot = 1.852;
+
+	// Takes the NMEA lat/long format (dddmm.mmmm, [N/S,E/W]) and converts to
+	// degrees N,E only. Empty leaves deg alone.
+	static bool readLatLong(std::string_view llstr, std::string_view dir, double& deg)
+	{
+		if ( llstr.empty() ) {
+			return true;
+		}
+		double pd = 0;
+		if ( !tryParseDouble(llstr, pd) ) {
+			return false;
+		}
+		deg         = std::trunc(pd / 100); // get ddd from dddmm.mmmm
+		double mins = pd - deg * 100;
+		deg         = deg + mins / 60.0;
+
+		// everything should be N/E, so flip S,W
+		if ( !dir.empty() && (dir[0] == 'S' || dir[0] == 'W') ) {
+			deg *= -1.0;
+		}
+		return true;
+	}
+
+	template <typename T>
+	static bool readInt(std::string_view str, T& value)
+	{
+		int64_t parsed = 0;
+		if ( !tryParseInt(str, parsed) ) {
+			return false;
+		}
+		value = static_cast<T>(parsed);
+		return true;
+	}
+};
+
+} // namespace nmea
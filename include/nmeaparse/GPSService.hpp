@@ -11,16 +11,32 @@
 
 #include <chrono>
 #include <functional>
+#include <memory_resource>
+#include <optional>
 #include <string>
 
 #include "nmeaparse/Event.hpp"
+#include "nmeaparse/FixHistory.hpp"
 #include "nmeaparse/GPSFix.hpp"
 #include "nmeaparse/NMEAParser.hpp"
 
 namespace nmea {
 
+class Metrics;
+class StreamDemultiplexer;
+struct BinaryFrame;
+
+// The event handlers and the fix history come from the memory resource given
+// to the constructor, the parser's by default.
 class GPSService {
 private:
+	Metrics*                   metrics_{ nullptr };
+	std::pmr::memory_resource* resource_;
+	std::optional<FixHistory>  history_;
+
+	void updated(); // records the fix in the history, then calls onUpdate
+
+	void read(void (GPSService::*reader)(const NMEASentence&), const NMEASentence& nmea);
 	void read_PSRF150(const NMEASentence& nmea);
 	void read_GPGGA(const NMEASentence& nmea);
 	void read_GPGSA(const NMEASentence& nmea);
@@ -28,15 +44,36 @@ private:
 	void read_GPRMC(const NMEASentence& nmea);
 	void read_GPVTG(const NMEASentence& nmea);
 
+	void read_UBX(const BinaryFrame& frame);
+	void read_UBX_NAV_PVT(const BinaryFrame& frame);
+	void read_UBX_NAV_SAT(const BinaryFrame& frame);
+
 public:
 	GPSFix fix_;
 
 	explicit GPSService(NMEAParser& parser);
+	GPSService(NMEAParser& parser, std::pmr::memory_resource* resource);
 
 	Event<void(bool)> onLockStateChanged; // user assignable handler, called whenever lock changes
 	Event<void()>     onUpdate;           // user assignable handler, called whenever fix changes
 
 	void attachToParser(NMEAParser& parser); // will attach to this parser's nmea sentence events
+
+	// Also reads UBX NAV-PVT (position, time, speed, fix) and NAV-SAT (the
+	// almanac) frames from a mixed stream. Other frames are left to the caller.
+	void attachToDemultiplexer(StreamDemultiplexer& demux);
+
+	// Counts sentences rejected by the handlers, by name. Pass nullptr to stop.
+	void setMetrics(Metrics* metrics);
+
+	// Keeps the last capacity locked fixes, one per epoch, before onUpdate is
+	// called. The ring is allocated here, from the service's memory resource.
+	// 0 turns the history off.
+	void enableHistory(size_t capacity);
+
+	[[nodiscard]] const FixHistory* history() const; // nullptr unless enabled
+
+	[[nodiscard]] size_t memoryUsage() const; // approximate bytes held by this service
 };
 
 } // namespace nmea
@@ -0,0 +1,114 @@
+/*
+ * Geofence.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "nmeaparse/Event.hpp"
+
+namespace nmea {
+
+class GPSService;
+
+struct GeoPoint {
+	double latitude_{ 0 };  // degrees N
+	double longitude_{ 0 }; // degrees E
+};
+
+// Tells which polygonal fences each vehicle is in, and when that changes.
+//
+// Fences are spread over a uniform grid of cellSize degrees. Every cell lists
+// the fences covering it completely and the ones whose edge runs through it.
+// A vehicle remembers its cell and the fences it is in: while it stays in a
+// cell only the fences with an edge in that cell are tested again, a cell with
+// none costs nothing. Moving to another cell tests only the fences listed there.
+//
+//   GeofenceEngine fences;
+//   auto depot = fences.addFence({ { 53.36, -6.51 }, { 53.37, -6.51 }, { 53.37, -6.49 } });
+//   fences.onEnter += [](uint32_t vehicle, uint32_t fence) { ... };
+//   fences.attachToService(gps, truck); // or update(truck, lat, lon) yourself
+//
+// Polygons are in degrees, must not cross the 180th meridian and may be concave.
+// Points on an edge may count as either side.
+class GeofenceEngine {
+public:
+	using FenceId   = uint32_t;
+	using VehicleId = uint32_t;
+
+private:
+	struct Fence {
+		std::vector<GeoPoint> polygon_;
+		GeoPoint              min_; // bounding box
+		GeoPoint              max_;
+	};
+
+	struct CellEntry {
+		FenceId fence_;
+		bool    boundary_; // an edge runs through the cell, test the point
+	};
+
+	struct Vehicle {
+		uint64_t             cell_{ 0 };
+		uint64_t             generation_{ 0 }; // of the fences when the vehicle was placed
+		bool                 placed_{ false };
+		GeoPoint             position_;
+		std::vector<FenceId> inside_; // sorted
+	};
+
+	double                                               cellSize_;
+	std::vector<Fence>                                   fences_;
+	std::unordered_map<uint64_t, std::vector<CellEntry>> cells_;
+	std::unordered_map<VehicleId, Vehicle>               vehicles_;
+	std::vector<FenceId>                                 scratch_;
+	uint64_t                                             generation_{ 0 }; // bumped by addFence()
+	uint64_t                                             pointTests_{ 0 };
+
+	[[nodiscard]] uint64_t cellOf(double latitude, double longitude) const;
+	[[nodiscard]] bool     boxTouchesEdge(const Fence& fence, const GeoPoint& low, const GeoPoint& high) const;
+	[[nodiscard]] bool     contains(const Fence& fence, double latitude, double longitude) const;
+
+	void place(VehicleId id, Vehicle& vehicle, double latitude, double longitude);
+
+public:
+	// cellSize in degrees, about the size of a typical fence works best.
+	explicit GeofenceEngine(double cellSize = 0.01);
+
+	Event<void(VehicleId, FenceId)> onEnter;
+	Event<void(VehicleId, FenceId)> onExit;
+
+	// Throws std::invalid_argument for fewer than 3 points. Vehicles already
+	// placed see the new fence on their next update.
+	FenceId addFence(std::vector<GeoPoint> polygon);
+
+	// Moves a vehicle, calling onEnter/onExit for every fence it crossed. The
+	// handlers must not update vehicles themselves.
+	void update(VehicleId vehicle, double latitude, double longitude);
+	void update(const VehicleId* vehicles, const double* latitude, const double* longitude, size_t size);
+
+	// Updates vehicle with every locked fix of the service.
+	void attachToService(GPSService& gps, VehicleId vehicle);
+
+	// Fences the vehicle is in, sorted. Empty for an unknown vehicle.
+	[[nodiscard]] const std::vector<FenceId>& fencesOf(VehicleId vehicle) const;
+
+	// Point in polygon, without the index.
+	[[nodiscard]] bool contains(FenceId fence, double latitude, double longitude) const;
+
+	void removeVehicle(VehicleId vehicle); // forgets it, no onExit
+	void clear();                          // fences and vehicles
+
+	[[nodiscard]] size_t   fences() const;
+	[[nodiscard]] size_t   vehicles() const;
+	[[nodiscard]] size_t   cells() const;      // grid cells with at least one fence
+	[[nodiscard]] uint64_t pointTests() const; // polygon tests run by update() so far
+	[[nodiscard]] size_t   memoryUsage() const; // approximate bytes of fences, grid and vehicles
+};
+
+} // namespace nmea
@@ -0,0 +1,110 @@
+/*
+ * LatencyHistogram.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace nmea {
+
+// HDR style log-linear histogram of nanosecond values.
+// Every power of two is split into 16 linear sub buckets, so any recorded value
+// is reported within ~6% of its real value. Values from 0 up to ~17 seconds
+// are covered, larger ones are counted in the last bucket.
+// record() is lock-free and may be called from any number of threads.
+class LatencyHistogram {
+public:
+	static constexpr uint32_t SubBucketBits  = 4;
+	static constexpr uint32_t SubBucketCount = 1U << SubBucketBits;
+	static constexpr uint32_t MaxValueBits   = 34;
+	static constexpr uint32_t BucketCount    = (MaxValueBits - SubBucketBits + 1) * SubBucketCount;
+
+private:
+	std::array<std::atomic<uint64_t>, BucketCount> buckets_{};
+	std::atomic<uint64_t>                          count_{ 0 };
+	std::atomic<uint64_t>                          sum_{ 0 };
+	std::atomic<uint64_t>                          max_{ 0 };
+
+public:
+	static uint32_t bucketIndex(uint64_t value);
+	static uint64_t bucketUpperBound(uint32_t index); // highest value counted in this bucket
+
+	void record(uint64_t nanoseconds);
+	void record(std::chrono::nanoseconds duration);
+	void reset();
+
+	[[nodiscard]] uint64_t count() const;
+	[[nodiscard]] uint64_t max() const;
+	[[nodiscard]] double   mean() const;
+	[[nodiscard]] uint64_t percentile(double pct) const; // pct 0-100, in nanoseconds
+};
+
+// The steps a sentence goes through, from the first byte on the wire to the
+// return of its handler. Each one is measured separately.
+enum class LatencyStage {
+	Receive,  // '$' received -> '\n' received
+	Parse,    // '\n' received -> sentence tokenized
+	Dispatch, // tokenized -> named handler called (includes onSentence)
+	Handler,  // named handler run time
+	Total,    // '$' received -> named handler returned
+	Count
+};
+
+const char* latencyStageName(LatencyStage stage);
+
+// One set of stage histograms per sentence name.
+// Names are claimed lock-free in a fixed table the first time they are seen;
+// names that don't fit in the table are counted under "other".
+class LatencyTracker {
+public:
+	static constexpr size_t MaxSentenceTypes = 64;
+
+	using StageHistograms = std::array<LatencyHistogram, static_cast<size_t>(LatencyStage::Count)>;
+
+	struct Sample {
+		std::chrono::steady_clock::time_point received;   // '$'
+		std::chrono::steady_clock::time_point terminated; // '\n'
+		std::chrono::steady_clock::time_point parsed;
+		std::chrono::steady_clock::time_point dispatched;
+		std::chrono::steady_clock::time_point returned;
+	};
+
+private:
+	struct Slot {
+		std::atomic<uint64_t>         key{ 0 };
+		std::atomic<StageHistograms*> histograms{ nullptr };
+	};
+
+	std::array<Slot, MaxSentenceTypes> slots_;
+	StageHistograms                    other_;
+
+	StageHistograms* find(uint64_t key, bool create);
+
+public:
+	LatencyTracker() = default;
+	~LatencyTracker();
+
+	LatencyTracker(const LatencyTracker&)            = delete;
+	LatencyTracker& operator=(const LatencyTracker&) = delete;
+
+	void record(std::string_view name, const Sample& sample);
+	void record(std::string_view name, LatencyStage stage, std::chrono::nanoseconds duration);
+
+	// null if nothing was recorded for this name yet
+	[[nodiscard]] const LatencyHistogram* histogram(std::string_view name, LatencyStage stage) const;
+
+	void reset();
+
+	[[nodiscard]] std::string toString() const; // table of count/p50/p90/p99/max per sentence and stage
+};
+
+} // namespace nmea
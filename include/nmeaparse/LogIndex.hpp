@@ -0,0 +1,104 @@
+/*
+ * LogIndex.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "nmeaparse/GPSFix.hpp"
+
+namespace nmea {
+
+class GPSService;
+class NMEAParser;
+
+// Where the first epoch at or after time_ starts in a log, in bytes.
+struct LogIndexEntry {
+	UTCTime  time_;
+	uint64_t offset_;
+};
+
+// Byte offsets of the epochs of a text NMEA log, by UTC time, so a time window
+// of a long capture can be read without parsing everything before it. Times
+// come from RMC and GGA sentences (GGA takes its date from the RMC before).
+// One entry is kept per interval of receiver time, which makes the sidecar
+// file about 4 bytes per interval.
+//
+//   std::ifstream log("capture.nmea", std::ios::binary);
+//   LogIndex      index;
+//   index.build(log);
+//   std::ofstream out("capture.nmea.idx", std::ios::binary);
+//   index.save(out);
+//
+// See LogReader for reading from a time on.
+class LogIndex {
+public:
+	static constexpr uint32_t Version = 1;
+
+private:
+	std::vector<LogIndexEntry> entries_;
+	std::chrono::milliseconds  interval_;
+	uint64_t                   logSize_{ 0 }; // bytes of the log when it was indexed
+
+public:
+	explicit LogIndex(std::chrono::milliseconds interval = std::chrono::seconds(1));
+
+	// Indexes the whole log from its current position, which is taken as offset 0.
+	void build(std::istream& log);
+
+	// The compact binary sidecar. load() throws std::runtime_error for anything
+	// that isn't an index of this version.
+	void save(std::ostream& out) const;
+	void load(std::istream& in);
+
+	// The last entry at or before time, the first one for times before it.
+	// nullptr if the index is empty.
+	[[nodiscard]] const LogIndexEntry* find(UTCTime time) const;
+
+	[[nodiscard]] const std::vector<LogIndexEntry>& entries() const;
+	[[nodiscard]] std::chrono::milliseconds         interval() const;
+	[[nodiscard]] uint64_t                          logSize() const;
+};
+
+// Reads an indexed log from a given time on, into a parser.
+//
+//   LogReader reader(log, index, parser);
+//   reader.seek(incident - std::chrono::minutes(1), &gps);
+//   while ( reader.next() && gps.fix_.timestamp_.toUTCTime() < incident + std::chrono::minutes(1) ) {
+//   }
+class LogReader {
+private:
+	std::istream&   log_;
+	const LogIndex& index_;
+	NMEAParser&     parser_;
+	std::string     line_;
+	bool            pending_{ false }; // line_ is read but not parsed yet
+	uint64_t        lineOffset_{ 0 };  // of line_
+	uint64_t        offset_{ 0 };      // of the line after line_
+
+public:
+	LogReader(std::istream& log, const LogIndex& index, NMEAParser& parser); // all three must outlive the reader
+
+	// Goes to the first epoch at or after time. The epochs of up to warmup before
+	// it are read into the parser first, from the nearest entry, so the services
+	// on it start out as if they had read the log from the start. prime's
+	// onUpdate and onLockStateChanged are held back meanwhile. Sentences that
+	// fail to parse during the warm up are skipped.
+	// Returns false if the log has nothing at or after time.
+	bool seek(UTCTime time, GPSService* prime = nullptr, std::chrono::milliseconds warmup = std::chrono::seconds(10));
+
+	// Reads the next line into the parser. Returns false at the end of the log.
+	// Parse errors pass through as from NMEAParser::readLine().
+	bool next();
+
+	[[nodiscard]] uint64_t offset() const; // of the next line
+};
+
+} // namespace nmea
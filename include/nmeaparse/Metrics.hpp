@@ -0,0 +1,98 @@
+/*
+ * Metrics.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace nmea {
+
+// Health counters of parsers and GPS services.
+// One Metrics object can be shared by any number of parsers/services on any
+// number of threads. Every thread counts into its own cache line sized shard,
+// the shards are only merged when the values are read or exported.
+class Metrics {
+public:
+	enum Counter {
+		BytesIn = 0,      // bytes fed into the parser
+		Sentences,        // sentences with valid syntax
+		ChecksumFailures, // sentences whose checksum didn't match
+		BufferOverflows,  // sentences dropped because no '\n' came within the buffer limit
+		DiscardedBytes,   // bytes outside of any sentence
+		InvalidLines,     // lines that held data, but no '$'
+		InvalidSentences, // sentences rejected for bad syntax
+		HandlerMisses,    // sentences with no named handler
+		DecodeErrors,     // sentences a GPSService handler rejected
+		SkippedSentences, // sentences dropped after their name, see NMEAParser::setInterest()
+		SkippedBytes,     // bytes of those
+		CounterCount
+	};
+
+	static constexpr size_t ShardCount       = 16;
+	static constexpr size_t MaxSentenceTypes = 64;
+
+private:
+	// Fixed table of counts per sentence name, slots are claimed lock-free.
+	struct NameCounts {
+		std::array<std::atomic<uint64_t>, MaxSentenceTypes> keys{};
+		std::array<std::atomic<uint64_t>, MaxSentenceTypes> counts{};
+		std::atomic<uint64_t>                               other{ 0 };
+
+		void add(uint64_t key, uint64_t value);
+	};
+
+	struct alignas(64) Shard {
+		std::array<std::atomic<uint64_t>, CounterCount> counters{};
+		NameCounts                                      sentences;
+		NameCounts                                      decodeErrors;
+	};
+
+	std::array<Shard, ShardCount> shards_;
+
+	mutable std::mutex                             probesMutex_;
+	std::map<std::string, std::function<size_t()>> memoryProbes_;
+
+	Shard& localShard();
+
+	static void mergeNames(const NameCounts& names, std::map<std::string, uint64_t>& out);
+
+public:
+	Metrics() = default;
+
+	Metrics(const Metrics&)            = delete;
+	Metrics& operator=(const Metrics&) = delete;
+
+	void add(Counter counter, uint64_t value = 1);
+	void addSentence(std::string_view name);
+	void addDecodeError(std::string_view name);
+
+	// Reports the memory held by a parser, service etc. under the given name on every export.
+	// The probe is called from the exporting thread, so it must be safe to call from there.
+	void trackMemory(const std::string& name, std::function<size_t()> probe);
+	void untrackMemory(const std::string& name);
+
+	[[nodiscard]] uint64_t                        get(Counter counter) const;
+	[[nodiscard]] std::map<std::string, uint64_t> sentences() const;    // sentence counts by name
+	[[nodiscard]] std::map<std::string, uint64_t> decodeErrors() const; // decode errors by sentence name
+	[[nodiscard]] std::map<std::string, size_t>   memory() const;       // bytes by tracked name
+
+	void reset();
+
+	// labels are added to every sample, e.g. "receiver=\"r42\",site=\"north\""
+	[[nodiscard]] std::string toPrometheus(const std::string& labels = "") const;
+	[[nodiscard]] std::string toJSON() const;
+
+	static const char* counterName(Counter counter);
+};
+
+} // namespace nmea
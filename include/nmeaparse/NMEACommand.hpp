@@ -9,14 +9,18 @@
 
 #pragma once
 
+#include <array>
 #include <string>
 
 #include "nmeaparse/NMEAParser.hpp"
+#include "nmeaparse/SentenceWriter.hpp"
 
 namespace nmea {
 
 class NMEACommand {
 public:
+	static constexpr size_t MaxSize = 82; // longest standard sentence, "$" to "\r\n"
+
 	std::string message_;
 	std::string name_;
 	char        checksum_;
@@ -26,6 +30,21 @@ public:
 
 	virtual std::string toString();
 	std::string         addChecksum(const std::string& str);
+
+	// Writes the complete "$NAME,fields*HH\r\n" sentence into out without allocating.
+	// Returns its length, or 0 if it doesn't fit in size.
+	size_t encode(char* out, size_t size) const;
+	size_t encode(SentenceWriter& writer) const; // appends at the writer's position
+
+	template <size_t N>
+	size_t encode(std::array<char, N>& out) const
+	{
+		return encode(out.data(), N);
+	}
+
+protected:
+	// Writes the fields after the name, each with its leading ','. Defaults to message_.
+	virtual void writeFields(SentenceWriter& writer) const;
 };
 
 class NMEACommandSerialConfiguration : public NMEACommand {
@@ -53,7 +72,8 @@ public:
 	NMEACommandSerialConfiguration()
 	    : NMEACommand("PSRF100"){};
 
-	std::string toString() override;
+protected:
+	void writeFields(SentenceWriter& writer) const override;
 };
 
 class NMEACommandQueryRate : public NMEACommand {
@@ -100,7 +120,39 @@ public:
 	NMEACommandQueryRate()
 	    : NMEACommand("PSRF103"){};
 
-	std::string toString() override;
+protected:
+	void writeFields(SentenceWriter& writer) const override;
+};
+
+// Packs many commands into one outbound buffer, so a whole configuration goes
+// out with a single write(). The buffer is the caller's, nothing is allocated.
+//
+//   std::array<char, 1024> buf;
+//   NMEACommandBatch batch(buf);
+//   batch.add(serial);
+//   batch.add(rate);
+//   ::write(fd, batch.data(), batch.size());
+class NMEACommandBatch {
+private:
+	SentenceWriter writer_;
+	size_t         count_{ 0 };
+
+public:
+	NMEACommandBatch(char* buffer, size_t size);
+
+	template <size_t N>
+	explicit NMEACommandBatch(std::array<char, N>& buffer)
+	    : NMEACommandBatch(buffer.data(), N)
+	{
+	}
+
+	// Appends the command. Returns false, leaving the batch as it was, if it doesn't fit.
+	bool add(const NMEACommand& command);
+	void clear();
+
+	[[nodiscard]] const char* data() const;
+	[[nodiscard]] size_t      size() const;  // bytes
+	[[nodiscard]] size_t      count() const; // commands
 };
 
 } // namespace nmea
@@ -0,0 +1,130 @@
+/*
+ * NMEAGenerator.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "nmeaparse/GPSFix.hpp"
+#include "nmeaparse/NMEAParser.hpp"
+
+namespace nmea {
+
+// Settings of the simulated receiver. Speeds are km/h and angles degrees,
+// like in GPSFix.
+struct NMEAGeneratorSettings {
+	double      rate{ 1.0 };     // epochs per second
+	std::string talker{ "GP" };  // talker ID put in front of every sentence name
+	uint32_t    sentences{ 0 };  // bit (1 << MessageID) per sentence type to emit, 0 = GGA, GSA, GSV, RMC and VTG
+	UTCTime     start{ std::chrono::milliseconds(1306574870000) }; // time of the first epoch (May 28, 2011 09:27:50)
+
+	// Trajectory
+	double latitude{ 53.361337 };   // degrees N
+	double longitude{ -6.505620 };  // degrees E
+	double altitude{ 61.7 };        // meters
+	double speed{ 50.0 };           // km/h
+	double heading{ 31.66 };        // degrees true north
+	double turnRate{ 0.0 };         // degrees per second
+	double climbRate{ 0.0 };        // meters per second
+
+	// Sky
+	uint32_t satellites{ 12 }; // satellites in view (up to 32)
+
+	// Imperfections
+	double   positionNoise{ 0.0 };  // standard deviation of the reported position in meters
+	double   corruptionRate{ 0.0 }; // probability (0-1) that a sentence gets damaged
+	uint64_t seed{ 1 };
+};
+
+// Simulates a receiver moving along a trajectory under a sky of satellites and
+// formats what it would send, GGA/GSA/GSV/RMC/VTG, one epoch at a time.
+// Sentences are written straight into the caller's buffer with correct
+// checksums (same XOR as NMEAParser::calculateChecksum), nothing is allocated
+// per epoch. Output with the "GP" talker reads back through NMEAParser and
+// GPSService.
+class NMEAGenerator {
+public:
+	static constexpr size_t MaxSatellites = 32;
+	static constexpr size_t MaxEpochSize  = 82 * 16; // all sentences of one epoch fit in this
+
+	// Kinds of damage done to corrupted sentences
+	enum Corruption {
+		FlippedBit,  // one payload character changed
+		BadChecksum, // checksum digit changed
+		Truncated    // sentence cut short, no checksum
+	};
+
+private:
+	struct Satellite {
+		uint32_t prn;
+		double   elevation; // deg
+		double   azimuth;   // deg
+		double   drift;     // azimuth change in deg/s
+		double   snr;       // dB, 0 if not tracked
+	};
+
+	NMEAGeneratorSettings                settings_;
+	std::array<Satellite, MaxSatellites> sky_{};
+	uint64_t                             rng_;
+	uint64_t                             epoch_{ 0 };
+	double                               latitude_;
+	double                               longitude_;
+	double                               altitude_;
+	double                               heading_;
+	std::array<uint64_t, 3>              corruptions_{};
+
+	// prefixes like "GPGGA" are kept pre-rendered with their checksum
+	struct Prefix {
+		char    text[8];
+		size_t  size;
+		uint8_t checksum;
+	};
+	std::array<Prefix, 6>    prefixes_{};
+	std::array<uint32_t, 10> rates_{}; // epochs between sentences by MessageID, 0 = off
+
+	uint64_t nextRandom();
+	double   uniform();  // [0, 1)
+	double   gaussian(); // standard normal
+	void     step(double seconds);
+	size_t   corrupt(char* sentence, size_t size);
+
+	size_t writeGGA(char* out, size_t size, UTCTime time, double lat, double lon, uint32_t used);
+	size_t writeGSA(char* out, size_t size, uint32_t used);
+	size_t writeGSV(char* out, size_t size, uint32_t page, uint32_t pages);
+	size_t writeRMC(char* out, size_t size, UTCTime time, double lat, double lon);
+	size_t writeVTG(char* out, size_t size);
+
+public:
+	explicit NMEAGenerator(NMEAGeneratorSettings settings = NMEAGeneratorSettings());
+
+	// Writes all sentences of the next epoch to out and advances the simulation.
+	// Returns the bytes written, 0 if they don't fit in size (the epoch is kept for the next call).
+	size_t nextEpoch(char* out, size_t size);
+
+	// Fills out with as many whole epochs as fit, returns the bytes written.
+	size_t fill(char* out, size_t size);
+
+	// Sets how many epochs apart a sentence type is emitted (1 = every epoch, 0 = off).
+	void setSentenceRate(NMEASentence::MessageID id, uint32_t everyEpochs);
+
+	// Takes a command sent to the receiver. $PSRF103 set rate commands change the
+	// sentence rates, like on a SiRF receiver, the rate in seconds rounded to
+	// whole epochs. Returns false for anything else or a bad checksum.
+	bool readCommand(std::string_view sentence);
+
+	[[nodiscard]] const NMEAGeneratorSettings& settings() const;
+	[[nodiscard]] uint64_t                     epoch() const;      // epochs generated so far
+	[[nodiscard]] UTCTime                      time() const;       // time of the next epoch
+	[[nodiscard]] double                       latitude() const;   // true position of the next epoch, without noise
+	[[nodiscard]] double                       longitude() const;
+	[[nodiscard]] double                       altitude() const;
+	[[nodiscard]] uint64_t                     corruptions(Corruption kind) const;
+};
+
+} // namespace nmea
@@ -9,10 +9,16 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <exception>
 #include <functional>
+#include <initializer_list>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -23,8 +29,18 @@
 
 namespace nmea {
 
+class CheckpointReader;
+class CheckpointWriter;
 class NMEAParser;
+class LatencyTracker;
+class Metrics;
+class OutputMonitor;
 
+using ReceiveClock = std::chrono::steady_clock; // monotonic clock for host receive timestamps
+
+// The sentences handed to handlers belong to the parser, which reuses them
+// (and their strings) for the next sentence: they are only good until the
+// handler returns. A copy (NMEASentence copy = nmea) can be kept.
 class NMEASentence {
 	friend NMEAParser;
 
@@ -40,6 +56,10 @@ public:
 	uint8_t                  parsedChecksum_;
 	uint8_t                  calculatedChecksum_;
 
+	// Host receive times, only set if the parser captures timestamps.
+	ReceiveClock::time_point receiveStart_; // arrival of the '$'
+	ReceiveClock::time_point receiveEnd_;   // arrival of the '\n'
+
 	enum MessageID { // These ID's are according to NMEA standard.
 		Unknown = -1,
 		GGA     = 0,
@@ -55,6 +75,11 @@ public:
 
 	[[nodiscard]] bool checksumOK() const;
 	[[nodiscard]] bool valid() const;
+	[[nodiscard]] bool hasTimestamps() const;
+
+	// Same as SentenceView's
+	[[nodiscard]] size_t           size() const;                 // number of parameters
+	[[nodiscard]] std::string_view parameter(size_t index) const; // an empty view if there are fewer
 };
 
 class NMEAParseError : public std::exception {
@@ -68,38 +93,112 @@ public:
 	[[nodiscard]] const char* what() const noexcept override;
 };
 
+// Everything the parser keeps (line buffer, handler table, onSentence_ handlers)
+// comes from the memory resource given to the constructor. The sentences it
+// parses into are reused, their strings keep their buffers from one sentence
+// to the next: once the longest sentences have been seen a sentence costs no
+// heap allocation.
 class NMEAParser {
+	friend CheckpointReader;
+	friend CheckpointWriter;
+	friend OutputMonitor;
+
+public:
+	// Which sentences are read past their name, see setInterest()
+	enum class Interest : uint8_t {
+		All,      // every sentence, the default
+		Handlers, // names with a handler, every name while onSentence_ has a listener (see hasListeners())
+		Listed    // the names given to setInterest()
+	};
+
 private:
-	std::unordered_map<std::string, std::function<void(NMEASentence)>> eventTable_;
-	std::string                                                        buffer_;
-	bool                                                               fillingbuffer_;
-	uint32_t                                                           maxbuffersize_; // limit the max size if no newline ever comes... Prevents huge buffer string internally
+	using HandlerTable = std::pmr::unordered_map<std::pmr::string, std::function<void(const NMEASentence&)>>;
 
-	void parseText(NMEASentence& nmea, std::string txt); // fills the given NMEA sentence with the results of parsing the string.
+	// What a sentence is parsed into, one per dispatch depth (handlers may read sentences)
+	struct Scratch {
+		NMEASentence             sentence;
+		std::vector<std::string> spare; // strings of parameters a longer sentence had, to be reused
+	};
 
-	void onInfo(NMEASentence& nmea, const std::string& txt) const;
-	void onWarning(NMEASentence& nmea, const std::string& txt) const;
-	void onError(NMEASentence& nmea, const std::string& txt) const;
+	std::pmr::memory_resource* resource_;
+	HandlerTable               eventTable_;
+	std::pmr::string           buffer_;
+	bool                       fillingbuffer_;
+	uint32_t                   maxbuffersize_; // limit the max size if no newline ever comes... Prevents huge buffer string internally
+	ReceiveClock::time_point   receiveStart_;
+	ReceiveClock::time_point   receiveEnd_;
+	LatencyTracker*            latency_;
+	Metrics*                   metrics_;
+	uint32_t                   discarded_; // bytes outside a sentence since the last newline
+	Interest                   interest_;
+	std::pmr::vector<uint64_t> interestKeys_; // sentenceKey() of the names read, for Handlers and Listed
+	bool                       skipping_;     // in a sentence that isn't wanted, up to the newline
+	bool                       nameChecked_;  // the name of the sentence being buffered is wanted, or can't be told
+	size_t                     nameStart_;    // where in buffer_ its start byte is
+	uint32_t                   skippedBytes_; // of the sentence being skipped
+	std::pmr::deque<Scratch>   scratch_;       // references stay good as it grows
+	uint32_t                   dispatchDepth_; // sentences being dispatched, index into scratch_
+	uint32_t                   monitors_;      // onSentence_ listeners of OutputMonitors
+
+	void readByte(uint8_t byte, const ReceiveClock::time_point* rxTime);
+	[[nodiscard]] bool timestampsEnabled() const;
+	[[nodiscard]] bool wanted(std::string_view name) const;
+	void               handlersChanged();
+	void               skip(uint32_t bytes); // counts one skipped sentence
+
+	void parseText(Scratch& scratch, std::string_view txt); // fills the scratch sentence with the results of parsing the string.
+
+	void onInfo(NMEASentence& nmea, std::string_view txt) const;
+	void onWarning(NMEASentence& nmea, std::string_view txt) const;
+	void onError(NMEASentence& nmea, std::string_view txt) const;
 
 public:
-	NMEAParser();
+	explicit NMEAParser(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
 	bool log_;
+	bool captureTimestamps_; // stamp each sentence with the host receive time of its '$' and '\n'
 
 	Event<void(const NMEASentence&)> onSentence_;                                                                                             // called every time parser receives any NMEA sentence
 
 	void                             setSentenceHandler(const std::string& cmdKey, const std::function<void(const NMEASentence&)>& handler); // one handler called for any named sentence where name is the "cmdKey"
 	[[nodiscard]] std::string        getRegisteredSentenceHandlersCSV() const;                                                               // show a list of message names that currently have handlers.
 
+	// Records per sentence latency of every stage into tracker (and captures timestamps).
+	// The tracker must outlive the parser, pass nullptr to stop.
+	void setLatencyTracker(LatencyTracker* tracker);
+
+	// Counts bytes, sentences and everything that gets dropped into metrics.
+	// The metrics must outlive the parser, pass nullptr to stop.
+	void setMetrics(Metrics* metrics);
+
+	// Sentences whose name isn't of interest are dropped as soon as the name is
+	// read: the rest of the line is skipped up to the newline without being
+	// buffered, checksummed or split, and only counted (Metrics::SkippedSentences
+	// and SkippedBytes). Names longer than 8 characters are always read.
+	void                   setInterest(Interest interest);
+	void                   setInterest(std::initializer_list<std::string_view> names); // Listed, only these
+	[[nodiscard]] Interest interest() const;
+
+	// onSentence_ has a listener other than an OutputMonitor's, which only counts
+	// what the parser reads anyway
+	[[nodiscard]] bool hasListeners() const;
+
+	[[nodiscard]] size_t                     memoryUsage() const; // approximate bytes held by this parser
+	[[nodiscard]] std::pmr::memory_resource* resource() const;
+
 	// Byte streaming functions
 	void readByte(uint8_t byte);
 	void readBuffer(uint8_t* ptr, uint32_t size);
 	void readLine(const std::string& line);
 
+	// Same, for data whose receive time is already known (e.g. a kernel timestamp).
+	void readByte(uint8_t byte, ReceiveClock::time_point rxTime);
+	void readBuffer(uint8_t* ptr, uint32_t size, ReceiveClock::time_point rxTime);
+
 	// This function expects the data to be a single line with an actual sentence in it, else it throws an error.
-	void readSentence(std::string cmd); // called when parser receives a sentence from the byte stream. Can also be called by user to inject sentences.
+	void readSentence(std::string_view cmd); // called when parser receives a sentence from the byte stream. Can also be called by user to inject sentences.
 
-	static uint8_t calculateChecksum(const std::string&); // returns checksum of string -- XOR
+	static uint8_t calculateChecksum(std::string_view); // returns checksum of string -- XOR
 };
 
 } // namespace nmea
@@ -9,10 +9,12 @@
 
 #pragma once
 
+#include <charconv>
 #include <cstdint>
 #include <exception>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>
 
 namespace nmea {
@@ -31,9 +33,46 @@ public:
 	}
 };
 
-double parseDouble(const std::string& str);
+double parseDouble(std::string_view str);
 
-int64_t parseInt(const std::string& str, int radix = 10);
+int64_t parseInt(std::string_view str, int radix = 10);
+
+// Non-throwing versions for builds without exceptions. Like the ones above an
+// empty string reads as 0, the whole string has to be the number and there is
+// at most one sign.
+inline bool
+tryParseDouble(std::string_view str, double& value)
+{
+	if ( !str.empty() && str[0] == '+' ) {
+		str.remove_prefix(1);
+		if ( str.empty() || str[0] == '+' || str[0] == '-' ) { // "+" alone or a second sign, strto*() reject those too
+			return false;
+		}
+	}
+	if ( str.empty() ) {
+		value = 0;
+		return true;
+	}
+	auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+	return result.ec == std::errc() && result.ptr == str.data() + str.size();
+}
+
+inline bool
+tryParseInt(std::string_view str, int64_t& value, int radix = 10)
+{
+	if ( !str.empty() && str[0] == '+' ) {
+		str.remove_prefix(1);
+		if ( str.empty() || str[0] == '+' || str[0] == '-' ) { // "+" alone or a second sign, strto*() reject those too
+			return false;
+		}
+	}
+	if ( str.empty() ) {
+		value = 0;
+		return true;
+	}
+	auto result = std::from_chars(str.data(), str.data() + str.size(), value, radix);
+	return result.ec == std::errc() && result.ptr == str.data() + str.size();
+}
 
 // void NumberConversion_test();
 
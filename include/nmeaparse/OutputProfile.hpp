@@ -0,0 +1,110 @@
+/*
+ * OutputProfile.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "nmeaparse/Event.hpp"
+#include "nmeaparse/NMEAParser.hpp"
+
+namespace nmea {
+
+class NMEACommandBatch;
+
+// What an application reads from a GPSService. Rates are seconds between
+// sentences, 0 = not read.
+struct ServiceNeeds {
+	uint32_t position{ 1 };   // GGA and RMC: position, time, fix, speed and course
+	uint32_t dilution{ 0 };   // GSA
+	uint32_t satellites{ 0 }; // GSV, the almanac
+};
+
+// The rate of every sentence type a receiver sends, in seconds between
+// sentences (0 = off), by $PSRF103 message number (NMEASentence::MessageID).
+//
+// Built from what the application actually handles, it gives the set rate
+// commands that turn everything else off; an OutputMonitor then shows whether
+// the receiver did.
+//
+//   OutputProfile wanted;
+//   ServiceNeeds  needs;                   // position only
+//   wanted.addHandlers(parser, &needs);
+//
+//   OutputMonitor monitor(parser);         // what the receiver sends now
+//   ... read 10 s of the stream ...
+//   OutputProfile current = monitor.profile(10);
+//
+//   std::array<char, 512> buf;
+//   NMEACommandBatch batch(buf);
+//   wanted.commands(current, batch);
+//   ::write(fd, batch.data(), batch.size());
+//
+//   monitor.reset();
+//   ... read another 10 s ...
+//   bool done = wanted.differences(monitor.profile(10)) == 0;
+class OutputProfile {
+public:
+	static constexpr size_t   Types   = 10;  // $PSRF103 message numbers 0-9
+	static constexpr uint32_t MaxRate = 255; // seconds
+
+private:
+	std::array<uint8_t, Types> rates_{};
+
+public:
+	OutputProfile() = default; // everything off
+
+	// Sentence types other than GGA, GLL, GSA, GSV, RMC, VTG and ZDA are ignored.
+	void                   setRate(NMEASentence::MessageID id, uint32_t seconds);
+	[[nodiscard]] uint32_t rate(NMEASentence::MessageID id) const;
+
+	// Turns on each sentence type the parser has a named handler for, from any
+	// talker, every second. A handler on onSentence_ wants every type, an
+	// OutputMonitor's doesn't count. With
+	// service, the sentences of a GPSService attached to the parser are only
+	// turned on as often as it says.
+	void addHandlers(const NMEAParser& parser, const ServiceNeeds* service = nullptr);
+
+	// Appends a set rate command for every type whose rate differs in current.
+	// Returns how many were added, fewer than differences() if the batch is full.
+	size_t                 commands(const OutputProfile& current, NMEACommandBatch& batch) const;
+	[[nodiscard]] uint32_t differences(const OutputProfile& other) const; // types with another rate
+
+	// The type a sentence name like "GPGGA" is, Unknown if none of the above.
+	static NMEASentence::MessageID typeOf(std::string_view name);
+};
+
+// Counts the sentence types coming through a parser, to see what a receiver
+// actually sends. Multi-page GSV counts once per set of pages. The monitor
+// doesn't make the parser read more: with an Interest other than All it only
+// sees the sentences that are read anyway.
+class OutputMonitor {
+private:
+	NMEAParser&                                parser_;
+	EventHandler<void(const NMEASentence&)>    handler_;
+	std::array<uint64_t, OutputProfile::Types> counts_{};
+
+	void seen(const NMEASentence& nmea);
+
+public:
+	explicit OutputMonitor(NMEAParser& parser); // the parser must outlive the monitor
+	~OutputMonitor();
+
+	OutputMonitor(const OutputMonitor&)            = delete;
+	OutputMonitor& operator=(const OutputMonitor&) = delete;
+
+	void reset();
+
+	[[nodiscard]] uint64_t count(NMEASentence::MessageID id) const;
+
+	// The rates seen, given how many seconds of the stream were read since the
+	// last reset(). Read a few times the slowest rate expected.
+	[[nodiscard]] OutputProfile profile(double seconds) const;
+};
+
+} // namespace nmea
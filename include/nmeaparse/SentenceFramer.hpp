@@ -0,0 +1,76 @@
+/*
+ * SentenceFramer.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace nmea {
+
+// Cuts a byte stream into sentence lines in a buffer of fixed size: from the
+// last '$' (or '!', which starts encapsulation sentences like AIS) up to the
+// newline, CR, LF, spaces and tabs dropped, which is what NMEAParser hands to
+// parseText(). A line that doesn't fit is thrown away and counted, the framer
+// then waits for the next start.
+template <size_t Capacity>
+class BasicSentenceFramer {
+private:
+	char     line_[Capacity]{};
+	size_t   size_{ 0 };
+	bool     filling_{ false };
+	uint32_t overflows_{ 0 };
+
+public:
+	enum Result : uint8_t {
+		Pending,  // nothing to do
+		Complete, // line() is a full line until the next push()
+		Overflow  // the current line got too long and was dropped
+	};
+
+	Result push(uint8_t byte)
+	{
+		if ( byte == '$' || byte == '!' ) { // a new start drops whatever came before, like the last-'$' rule
+			filling_ = true;
+			line_[0] = static_cast<char>(byte);
+			size_    = 1;
+			return Pending;
+		}
+		if ( !filling_ ) {
+			return Pending;
+		}
+		if ( byte == '\n' ) {
+			filling_ = false;
+			return Complete;
+		}
+		if ( byte == '\r' || byte == ' ' || byte == '\t' ) {
+			return Pending;
+		}
+		if ( size_ == Capacity ) {
+			filling_ = false;
+			size_    = 0;
+			overflows_++;
+			return Overflow;
+		}
+		line_[size_++] = static_cast<char>(byte);
+		return Pending;
+	}
+
+	void reset()
+	{
+		filling_ = false;
+		size_    = 0;
+	}
+
+	[[nodiscard]] std::string_view line() const { return std::string_view(line_, size_); }
+	[[nodiscard]] bool             filling() const { return filling_; }
+	[[nodiscard]] uint32_t         overflows() const { return overflows_; }
+
+	[[nodiscard]] static constexpr size_t capacity() { return Capacity; }
+};
+
+} // namespace nmea
@@ -0,0 +1,42 @@
+/*
+ * SentenceKey.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace nmea {
+
+// Packs a sentence name of up to 8 characters into an integer, first character
+// in the lowest byte. Lets hot paths compare and index sentence names without
+// touching strings. Longer names don't fit and return 0.
+constexpr uint64_t
+sentenceKey(std::string_view name)
+{
+	if ( name.empty() || name.size() > 8 ) {
+		return 0;
+	}
+
+	uint64_t key = 0;
+	for ( size_t i = 0; i < name.size(); i++ ) {
+		key |= static_cast<uint64_t>(static_cast<uint8_t>(name[i])) << (8 * i);
+	}
+	return key;
+}
+
+// Writes the name packed in key into out (at least 8 chars), returns its length.
+inline size_t
+sentenceKeyName(uint64_t key, char* out)
+{
+	size_t len = 0;
+	for ( ; len < 8 && (key & 0xFF) != 0; len++, key >>= 8 ) {
+		out[len] = static_cast<char>(key & 0xFF);
+	}
+	return len;
+}
+
+} // namespace nmea
@@ -0,0 +1,201 @@
+/*
+ * SentenceRange.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+#include "nmeaparse/SentenceFramer.hpp"
+#include "nmeaparse/SentenceView.hpp"
+
+namespace nmea {
+
+class SentenceRange;
+
+// What carries over from one buffer to the next: the line cut off at the end
+// of the last one, and counts of what was dropped.
+//
+//   SentenceScanner scanner;
+//   while ( size_t size = read(fd, buf, sizeof(buf)) ) {
+//       for ( const SentenceView& sentence: scanner.sentences(std::string_view(buf, size)) ) {
+//           ...
+//       }
+//   }
+class SentenceScanner {
+	friend SentenceRange;
+
+private:
+	using Framer = BasicSentenceFramer<SentenceView::MaxSentenceSize>;
+
+	Framer   framer_;
+	uint32_t rejected_{ 0 };  // lines that didn't parse
+	uint32_t overflows_{ 0 }; // lines too long, found without the framer
+
+public:
+	// The sentences in buffer, after the one cut off at the end of the last
+	// buffer. Only one range of a scanner may be read at a time.
+	SentenceRange sentences(std::string_view buffer);
+
+	void reset() { framer_.reset(); } // drops the line cut off at the end of the last buffer
+
+	[[nodiscard]] uint32_t rejected() const { return rejected_; }
+	[[nodiscard]] uint32_t overflows() const { return overflows_ + framer_.overflows(); }
+};
+
+// The good sentences of a buffer, for a plain loop instead of handlers: framed
+// like NMEAParser does (last '$' or '!' up to the newline, CR, spaces and tabs
+// dropped) and checked by parseSentenceView(), and against their checksum if
+// they have one. Lines that fail are skipped and counted by the scanner.
+// Everything is in this header, so the compiler sees the whole loop.
+//
+// A sentence is a view into the buffer, or into the scanner for a line that
+// started in the buffer before, and is good until the iterator moves on.
+class SentenceRange {
+public:
+	class iterator {
+	private:
+		const char*      pos_{ nullptr };
+		const char*      end_{ nullptr };
+		SentenceScanner* scanner_{ nullptr }; // nullptr at the end
+		SentenceView     sentence_;
+
+		static bool isStart(char chr) { return chr == '$' || chr == '!'; }
+
+		bool found(std::string_view line)
+		{
+			if ( parseSentenceView(line, sentence_) == ParseStatus::Ok && !sentence_.checksumMismatch() ) {
+				return true;
+			}
+			scanner_->rejected_++;
+			return false;
+		}
+
+		// Lines that are whole in the buffer and have nothing to drop are read in
+		// place, everything else goes through the framer byte by byte.
+		void advance()
+		{
+			auto& framer = scanner_->framer_;
+			while ( pos_ != end_ ) {
+				if ( !framer.filling() ) {
+					const auto* newline = static_cast<const char*>(std::memchr(pos_, '\n', static_cast<size_t>(end_ - pos_)));
+					if ( newline == nullptr ) {
+						// the rest is a line cut off, if anything
+						const char* start = std::find_if(pos_, end_, isStart);
+						if ( start == end_ ) {
+							break;
+						}
+						pos_ = start;
+					}
+					else {
+						const char* start = newline; // the last start before it
+						while ( start != pos_ && !isStart(*--start) ) {
+						}
+						if ( !isStart(*start) ) {
+							pos_ = newline + 1;
+							continue;
+						}
+						const char* last = *(newline - 1) == '\r' ? newline - 1 : newline;
+						if ( std::find_if(start, last, [](char c) { return c == '\r' || c == ' ' || c == '\t'; }) == last ) {
+							pos_ = newline + 1;
+							auto size = static_cast<size_t>(last - start);
+							if ( size > SentenceView::MaxSentenceSize ) {
+								scanner_->overflows_++;
+							}
+							else if ( found(std::string_view(start, size)) ) {
+								return;
+							}
+							continue;
+						}
+						pos_ = start;
+					}
+				}
+
+				auto result = framer.push(static_cast<uint8_t>(*pos_++));
+				if ( result == SentenceScanner::Framer::Complete && found(framer.line()) ) {
+					return;
+				}
+			}
+			scanner_ = nullptr;
+		}
+
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type        = SentenceView;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = const SentenceView*;
+		using reference         = const SentenceView&;
+
+		iterator() = default; // the end
+
+		iterator(std::string_view buffer, SentenceScanner& scanner)
+		    : pos_(buffer.data())
+		    , end_(buffer.data() + buffer.size())
+		    , scanner_(&scanner)
+		{
+			advance();
+		}
+
+		reference operator*() const { return sentence_; }
+		pointer   operator->() const { return &sentence_; }
+
+		iterator& operator++()
+		{
+			advance();
+			return *this;
+		}
+
+		// only the end compares equal to the end
+		bool operator==(const iterator& other) const { return scanner_ == other.scanner_; }
+		bool operator!=(const iterator& other) const { return scanner_ != other.scanner_; }
+	};
+
+private:
+	std::string_view buffer_;
+	SentenceScanner  own_;                // for one buffer on its own
+	SentenceScanner* scanner_{ nullptr }; // or the caller's
+
+public:
+	explicit SentenceRange(std::string_view buffer)
+	    : buffer_(buffer)
+	{
+	}
+
+	SentenceRange(std::string_view buffer, SentenceScanner& scanner)
+	    : buffer_(buffer)
+	    , scanner_(&scanner)
+	{
+	}
+
+	[[nodiscard]] iterator begin() { return iterator(buffer_, scanner_ != nullptr ? *scanner_ : own_); }
+	[[nodiscard]] iterator end() const { return iterator(); }
+
+	// Counts of a range on its own, after the loop
+	[[nodiscard]] const SentenceScanner& scanner() const { return scanner_ != nullptr ? *scanner_ : own_; }
+};
+
+inline SentenceRange
+SentenceScanner::sentences(std::string_view buffer)
+{
+	return SentenceRange(buffer, *this);
+}
+
+// The sentences of one buffer that stands on its own, e.g. a whole file
+//
+//   for ( const SentenceView& sentence: nmea::sentences(log) ) {
+//       if ( sentence.name_ == "GPGGA" ) { ... }
+//   }
+inline SentenceRange
+sentences(std::string_view buffer)
+{
+	return SentenceRange(buffer);
+}
+
+} // namespace nmea
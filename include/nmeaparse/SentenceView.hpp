@@ -0,0 +1,79 @@
+/*
+ * SentenceView.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace nmea {
+
+// Outcome of reading a byte or a sentence where exceptions aren't available.
+enum class ParseStatus : uint8_t {
+	Ok,               // sentence read (and handled, if there is a handler)
+	Pending,          // no complete sentence yet
+	Overflow,         // more than 82 characters without a newline, dropped
+	Empty,            // "$" and nothing else
+	BadName,          // name missing or not alphanumeric
+	BadCharacter,     // a parameter with something other than alphanumerics, '-' and '.' ('!' sentences: a reserved one)
+	BadChecksum,      // '*' not followed by two hex digits
+	TooManyFields,    // more parameters than SentenceView can hold
+	ChecksumMismatch, // checksum present but wrong
+	MissingFields,    // fewer parameters than the sentence needs
+	BadNumber,        // a numeric parameter that isn't a number
+	MissingFragment,  // a later sentence of a multi-sentence message (AIS) without the ones before it
+	MissingChecksum   // no checksum on a sentence that has to have one
+};
+
+[[nodiscard]] const char* parseStatusName(ParseStatus status);
+
+// A parsed sentence as views into the text it was read from, NMEASentence
+// without the strings. The text has to outlive the view; views handed to
+// handlers point into the parser's line buffer and are only good for the call.
+class SentenceView {
+public:
+	static constexpr size_t MaxSentenceSize = 82;                   // "$", data, "*HH\r\n"
+	static constexpr size_t MaxParameters   = MaxSentenceSize / 2;  // ",x" each at least
+
+private:
+	std::string_view text_;
+	uint8_t          starts_[MaxParameters + 1]{}; // offset of each parameter into text_, then one past the end of the last
+	uint8_t          parameterCount_{ 0 };
+
+	friend ParseStatus parseSentenceView(std::string_view line, SentenceView& sentence);
+
+public:
+	std::string_view name_;
+	bool             checksumIsCalculated_{ false };
+	uint8_t          parsedChecksum_{ 0 };
+	uint8_t          calculatedChecksum_{ 0 };
+
+	[[nodiscard]] std::string_view text() const { return text_; }
+	[[nodiscard]] size_t           size() const { return parameterCount_; }
+
+	// Parameter index, or an empty view if the sentence has fewer
+	[[nodiscard]] std::string_view parameter(size_t index) const
+	{
+		if ( index >= parameterCount_ ) {
+			return std::string_view();
+		}
+		return text_.substr(starts_[index], starts_[index + 1] - starts_[index] - 1u);
+	}
+
+	[[nodiscard]] bool checksumOK() const { return checksumIsCalculated_ && parsedChecksum_ == calculatedChecksum_; }
+
+	// A checksum that is there and wrong. Without one there is nothing to
+	// mismatch, readers that require it use GPSSentenceDecoder::checkChecksum().
+	[[nodiscard]] bool checksumMismatch() const { return checksumIsCalculated_ && parsedChecksum_ != calculatedChecksum_; }
+};
+
+// Splits one line ("$GPGGA,...*47" or "!AIVDM,...*hh", no CR/LF, no
+// whitespace) the way NMEAParser does, without copying or allocating. Lines
+// longer than MaxSentenceSize are rejected with ParseStatus::Overflow.
+ParseStatus parseSentenceView(std::string_view line, SentenceView& sentence);
+
+} // namespace nmea
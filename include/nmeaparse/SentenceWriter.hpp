@@ -0,0 +1,258 @@
+/*
+ * SentenceWriter.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace nmea {
+
+// Formats one NMEA sentence straight into a caller supplied buffer.
+// The checksum is accumulated while the characters are written, so finishing
+// the sentence is just appending it. Nothing is allocated. Writing past the end
+// of the buffer is refused and reported by finish() returning 0.
+//
+//   char buf[82 + 1];
+//   SentenceWriter w(buf, sizeof(buf));
+//   w.start("GPVTG");
+//   w.field(84.4, 1).field('T');
+//   size_t len = w.finish();   // "$GPVTG,84.4,T*hh\r\n"
+class SentenceWriter {
+private:
+	char*   begin_;
+	char*   sentence_; // start of the current sentence
+	char*   pos_;
+	char*   end_;
+	uint8_t checksum_{ 0 };
+	bool    overflow_{ false };
+
+	static constexpr const char* HexDigits = "0123456789ABCDEF";
+
+	void put(char chr)
+	{
+		if ( pos_ < end_ ) {
+			*pos_++ = chr;
+			checksum_ ^= static_cast<uint8_t>(chr);
+		}
+		else {
+			overflow_ = true;
+		}
+	}
+
+	void putDigits(uint64_t value, int width)
+	{
+		char  digits[24];
+		char* last = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+		for ( auto len = static_cast<int>(last - digits); len < width; len++ ) {
+			put('0');
+		}
+		append(std::string_view(digits, static_cast<size_t>(last - digits)));
+	}
+
+	static uint64_t pow10(int exp)
+	{
+		uint64_t value = 1;
+		while ( exp-- > 0 ) {
+			value *= 10;
+		}
+		return value;
+	}
+
+public:
+	SentenceWriter(char* buffer, size_t size)
+	    : begin_(buffer)
+	    , sentence_(buffer)
+	    , pos_(buffer)
+	    , end_(buffer + size)
+	{
+	}
+
+	// Writes the start character and name, e.g. "$GPGGA". Restarts the sentence at the current position.
+	SentenceWriter& start(std::string_view name, char startChar = '$')
+	{
+		sentence_ = pos_;
+		checksum_ = 0;
+		if ( pos_ < end_ ) {
+			*pos_++ = startChar; // not part of the checksum
+		}
+		else {
+			overflow_ = true;
+		}
+		append(name);
+		return *this;
+	}
+
+	// Continues a sentence whose first part (start character, name, maybe some fields) was already
+	// formatted elsewhere. checksum is the XOR of that part after the start character.
+	SentenceWriter& resume(std::string_view prefix, uint8_t checksum)
+	{
+		sentence_ = pos_;
+		if ( static_cast<size_t>(end_ - pos_) >= prefix.size() ) {
+			memcpy(pos_, prefix.data(), prefix.size());
+			pos_ += prefix.size();
+			checksum_ = checksum;
+		}
+		else {
+			overflow_ = true;
+		}
+		return *this;
+	}
+
+	// Appends text without a field separator.
+	SentenceWriter& append(std::string_view text)
+	{
+		if ( static_cast<size_t>(end_ - pos_) >= text.size() ) {
+			for ( auto chr: text ) {
+				*pos_++ = chr;
+				checksum_ ^= static_cast<uint8_t>(chr);
+			}
+		}
+		else {
+			overflow_ = true;
+		}
+		return *this;
+	}
+
+	// Appends an unsigned integer without a field separator, zero padded to width digits.
+	SentenceWriter& appendDigits(uint64_t value, int width = 0)
+	{
+		putDigits(value, width);
+		return *this;
+	}
+
+	// Empty field
+	SentenceWriter& field()
+	{
+		put(',');
+		return *this;
+	}
+
+	SentenceWriter& field(std::string_view text)
+	{
+		put(',');
+		return append(text);
+	}
+
+	SentenceWriter& field(const char* text) { return field(std::string_view(text)); }
+
+	SentenceWriter& field(char chr)
+	{
+		put(',');
+		put(chr);
+		return *this;
+	}
+
+	// Integer, zero padded to width digits
+	SentenceWriter& field(int64_t value, int width = 0)
+	{
+		put(',');
+		if ( value < 0 ) {
+			put('-');
+			putDigits(0 - static_cast<uint64_t>(value), width - 1); // INT64_MIN has no positive int64_t
+		}
+		else {
+			putDigits(static_cast<uint64_t>(value), width);
+		}
+		return *this;
+	}
+
+	SentenceWriter& field(int value, int width = 0) { return field(static_cast<int64_t>(value), width); }
+	SentenceWriter& field(uint32_t value, int width = 0) { return field(static_cast<int64_t>(value), width); }
+
+	// Fixed point number with the given decimals, integer part zero padded to width digits.
+	// Rounds half away from zero.
+	SentenceWriter& field(double value, int decimals, int width = 0)
+	{
+		put(',');
+		appendFixed(value, decimals, width);
+		return *this;
+	}
+
+	SentenceWriter& appendFixed(double value, int decimals, int width = 0)
+	{
+		if ( !std::isfinite(value) ) {
+			return *this; // leave the field empty
+		}
+		uint64_t scale  = pow10(decimals);
+		auto     scaled = static_cast<uint64_t>(std::llround(std::fabs(value) * static_cast<double>(scale)));
+		if ( value < 0 && scaled != 0 ) { // no "-0.0" for what rounds to zero
+			put('-');
+		}
+		putDigits(scaled / scale, width);
+		if ( decimals > 0 ) {
+			put('.');
+			putDigits(scaled % scale, decimals);
+		}
+		return *this;
+	}
+
+	// Latitude as two fields "ddmm.mmmm,N" with the given decimals of minutes
+	SentenceWriter& latitude(double deg, int decimals = 4) { return angle(deg, 2, decimals, deg < 0 ? 'S' : 'N'); }
+
+	// Longitude as two fields "dddmm.mmmm,E" with the given decimals of minutes
+	SentenceWriter& longitude(double deg, int decimals = 4) { return angle(deg, 3, decimals, deg < 0 ? 'W' : 'E'); }
+
+	SentenceWriter& angle(double deg, int degWidth, int decimals, char hemisphere)
+	{
+		put(',');
+		deg             = std::fabs(deg);
+		uint64_t scale  = pow10(decimals);
+		auto     whole  = static_cast<uint64_t>(deg);
+		auto     scaled = static_cast<uint64_t>(std::llround((deg - static_cast<double>(whole)) * 60.0 * static_cast<double>(scale)));
+		if ( scaled >= 60 * scale ) { // minutes rounded up to 60
+			whole++;
+			scaled -= 60 * scale;
+		}
+		putDigits(whole, degWidth);
+		putDigits(scaled / scale, 2);
+		if ( decimals > 0 ) {
+			put('.');
+			putDigits(scaled % scale, decimals);
+		}
+		put(',');
+		put(hemisphere);
+		return *this;
+	}
+
+	// Appends "*hh" and optionally "\r\n". Returns the sentence length, or 0 if it didn't fit.
+	size_t finish(bool crlf = true)
+	{
+		uint8_t sum     = checksum_;
+		char    tail[5] = { '*', HexDigits[sum >> 4], HexDigits[sum & 0xF], '\r', '\n' };
+		size_t  len     = crlf ? 5 : 3;
+		if ( static_cast<size_t>(end_ - pos_) < len ) {
+			overflow_ = true;
+		}
+		if ( overflow_ ) {
+			return 0;
+		}
+		memcpy(pos_, tail, len);
+		pos_ += len;
+		return static_cast<size_t>(pos_ - sentence_);
+	}
+
+	// Drops everything after the first len bytes, e.g. to undo a sentence that didn't fit.
+	void truncate(size_t len)
+	{
+		if ( len < size() ) {
+			pos_ = begin_ + len;
+		}
+		sentence_ = pos_;
+		overflow_ = false;
+	}
+
+	[[nodiscard]] uint8_t checksum() const { return checksum_; }
+	[[nodiscard]] bool    overflow() const { return overflow_; }
+	[[nodiscard]] size_t  size() const { return static_cast<size_t>(pos_ - begin_); } // all sentences written so far
+	[[nodiscard]] char*   data() const { return begin_; }
+	[[nodiscard]] char*   position() const { return pos_; }
+};
+
+} // namespace nmea
@@ -0,0 +1,177 @@
+/*
+ * SharedFix.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "nmeaparse/GPSFix.hpp"
+
+namespace nmea {
+
+class GPSService;
+
+// One published fix, as it is laid out in shared memory: 128 bytes, plain
+// fixed size types, the same for every process on the machine.
+struct SharedFixRecord {
+	// Groups of fields for dirty_
+	enum Field : uint32_t {
+		Time       = 1U << 0, // time_
+		Lock       = 1U << 1, // locked_, status_, type_, quality_
+		Position   = 1U << 2, // latitude_, longitude_
+		Altitude   = 1U << 3,
+		Velocity   = 1U << 4, // speed_, travelAngle_
+		Dilution   = 1U << 5, // the three DOPs
+		Satellites = 1U << 6, // trackingSatellites_, visibleSatellites_
+		Almanac    = 1U << 7, // the almanac summary
+		AllFields  = (1U << 8) - 1
+	};
+
+	uint64_t sequence_{ 0 };  // 1 for the first fix published in the segment
+	int64_t  published_{ 0 }; // steady_clock (CLOCK_MONOTONIC) nanoseconds when it was published, the same clock in every process
+	int64_t  time_{ 0 };      // UTC milliseconds since Jan 1, 1970
+
+	double latitude_{ 0 };    // degrees N
+	double longitude_{ 0 };   // degrees E
+	double altitude_{ 0 };    // meters
+	double speed_{ 0 };       // km/h
+	double travelAngle_{ 0 }; // degrees true north (0-360)
+	double dilution_{ 0 };
+	double horizontalDilution_{ 0 };
+	double verticalDilution_{ 0 };
+
+	int32_t  trackingSatellites_{ 0 };
+	int32_t  visibleSatellites_{ 0 };
+	uint32_t dirty_{ 0 }; // Field bits that changed since the fix published before, all for the first, 0 if the publisher doesn't track them
+
+	char    status_{ 'V' }; // A=active, V=void
+	uint8_t type_{ 1 };     // 1=none, 2=2d, 3=3d
+	uint8_t quality_{ 0 };
+	bool    locked_{ false };
+
+	// Almanac summary, 0 if the publisher leaves it out
+	uint32_t satellites_{ 0 };      // in the almanac
+	float    averageSNR_{ 0 };      // dB
+	float    minSNR_{ 0 };
+	float    maxSNR_{ 0 };
+	float    almanacComplete_{ 0 }; // percent of the GSV pages read
+
+	uint32_t reserved_{ 0 };
+
+	[[nodiscard]] UTCTime                  utcTime() const { return UTCTime(std::chrono::milliseconds(time_)); }
+	[[nodiscard]] std::chrono::nanoseconds age() const; // since it was published
+};
+
+struct SharedFixSettings {
+	uint32_t slots{ 64 };         // fixes kept in the ring, readers that fall further behind miss some
+	bool     almanac{ true };     // fill in the almanac summary
+	bool     dirtyMask{ true };   // fill in dirty_
+	uint32_t permissions{ 0660 }; // of a newly created segment, readers need write access to sleep in wait()
+};
+
+// Publishes each fix of a GPSService into a POSIX shared memory segment
+// (/dev/shm/<name>), for other processes on the same machine to read with
+// SharedFixReader without a socket or a copy through the kernel.
+//
+// The segment starts with a versioned header, then a ring of slots, each a
+// seqlock (a counter that is odd while the slot is written) and one record. A
+// publish writes the next slot and moves the head. Readers copy a slot and
+// check the counter didn't move meanwhile, so neither side ever waits for the
+// other and no system call is made, except to wake readers that sleep on the
+// futex in the header.
+//
+//   SharedFixPublisher publisher("nematode-fix");
+//   publisher.attachToService(gps);
+//
+// A publisher that starts on an existing segment of the same layout carries on
+// its sequence, so readers don't notice a restart. One publisher per name.
+// Linux only, the constructors throw elsewhere.
+class SharedFixPublisher {
+private:
+	std::string       name_;
+	SharedFixSettings settings_;
+	void*             map_{ nullptr };
+	size_t            size_{ 0 };
+	uint64_t          sequence_{ 0 };
+	SharedFixRecord   last_;
+
+	void write(SharedFixRecord& record); // stamps, publishes and wakes
+
+public:
+	explicit SharedFixPublisher(const std::string& name, SharedFixSettings settings = SharedFixSettings());
+	~SharedFixPublisher(); // marks the segment closed for readers, leaves it in place
+
+	SharedFixPublisher(const SharedFixPublisher&)            = delete;
+	SharedFixPublisher& operator=(const SharedFixPublisher&) = delete;
+
+	void publish(const GPSFix& fix);
+	void attachToService(GPSService& gps); // publishes the fix on every onUpdate
+
+	[[nodiscard]] const std::string&       name() const;
+	[[nodiscard]] const SharedFixSettings& settings() const;
+	[[nodiscard]] uint64_t                 published() const; // sequence of the last fix, counting from the segment's first
+
+	// Deletes the segment, readers that have it mapped keep their copy
+	static void remove(const std::string& name);
+};
+
+// Reads fixes published by a SharedFixPublisher in another process (or this
+// one). latest() and next() are a few loads and a copy of the record, without
+// locks or system calls; wait() sleeps on the segment's futex when there is
+// nothing new.
+//
+//   SharedFixReader reader("nematode-fix");
+//   SharedFixRecord fix;
+//   while ( reader.wait(fix, std::chrono::seconds(1)) || !reader.closed() ) { ... }
+//
+// Throws std::system_error if the segment doesn't exist and
+// std::runtime_error if it isn't one of this version (or not set up yet).
+class SharedFixReader {
+private:
+	void*    map_{ nullptr };
+	size_t   size_{ 0 };
+	uint32_t slots_{ 0 };
+	uint32_t contents_{ 0 };
+	uint64_t last_{ 0 }; // sequence read last
+	uint64_t missed_{ 0 };
+
+	bool read(uint64_t sequence, SharedFixRecord& record) const; // false if the slot holds another fix by now
+
+public:
+	// What the publisher fills in, bits of Contents
+	enum Contents : uint32_t {
+		Almanac   = 1U << 0,
+		DirtyMask = 1U << 1
+	};
+
+	explicit SharedFixReader(const std::string& name);
+	~SharedFixReader();
+
+	SharedFixReader(const SharedFixReader&)            = delete;
+	SharedFixReader& operator=(const SharedFixReader&) = delete;
+
+	// The newest fix, false if none was published yet or its slot stays half
+	// written (a publisher that died in the middle). Later next() calls go on from it.
+	bool latest(SharedFixRecord& record);
+
+	// The fix after the one read last, false if there is none yet. A reader that
+	// fell more than a ring behind skips to the oldest fix still there, see missed().
+	bool next(SharedFixRecord& record);
+
+	// next(), sleeping until a fix is published, the publisher closes or timeout passes
+	bool wait(SharedFixRecord& record, std::chrono::nanoseconds timeout);
+
+	[[nodiscard]] uint64_t published() const; // sequence of the newest fix
+	[[nodiscard]] uint64_t missed() const;    // fixes next() skipped because they were overwritten
+	[[nodiscard]] bool     closed() const;    // the publisher went away, the last fixes stay readable
+	[[nodiscard]] uint32_t slots() const;
+	[[nodiscard]] uint32_t contents() const; // Contents bits
+};
+
+} // namespace nmea
@@ -0,0 +1,190 @@
+/*
+ * StaticNMEAParser.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "nmeaparse/SentenceFramer.hpp"
+#include "nmeaparse/SentenceKey.hpp"
+#include "nmeaparse/SentenceView.hpp"
+
+namespace nmea {
+
+// The handler of the sentence whose sentenceKey() is Key, see on()
+template <uint64_t Key, class Handler>
+struct SentenceHandler {
+	static constexpr uint64_t key = Key;
+
+	Handler handler_;
+};
+
+// A handler for BasicNMEAParser. It is called with the SentenceView and may
+// return a ParseStatus, anything but Ok counting as an error.
+//
+//   on<sentenceKey("GPGGA")>([&](const SentenceView& gga) { ... })
+template <uint64_t Key, class Handler>
+constexpr SentenceHandler<Key, Handler>
+on(Handler handler)
+{
+	static_assert(Key != 0, "sentence names are 1 to 8 characters");
+	return SentenceHandler<Key, Handler>{ std::move(handler) };
+}
+
+// A parser whose sentences and handlers are fixed at compile time. A complete
+// line whose name has no handler is dropped right after framing, before it is
+// split or its checksum checked. The others are parsed by parseSentenceView(),
+// failed with ChecksumMismatch if their checksum is wrong, and dispatched by
+// comparing the packed name with each key in turn, which the compiler turns
+// into a switch with the handlers inlined. No allocation, no exceptions, no
+// indirect calls.
+//
+//   BasicNMEAParser parser(
+//       on<sentenceKey("GPGGA")>([&](const SentenceView& gga) { ... }),
+//       on<sentenceKey("GPRMC")>([&](const SentenceView& rmc) { ... }));
+//   parser.readBuffer(data, size);
+//
+// FixedNMEAParser is the same with handlers set at runtime, through function
+// pointers.
+template <class... Handlers>
+class BasicNMEAParser {
+private:
+	using Framer = BasicSentenceFramer<SentenceView::MaxSentenceSize>;
+
+	static_assert(sizeof...(Handlers) > 0, "a parser without handlers has nothing to do");
+
+	std::tuple<Handlers...> handlers_;
+	Framer                  framer_;
+	SentenceView            sentence_;
+
+	uint32_t sentences_{ 0 };
+	uint32_t errors_{ 0 };
+	uint32_t skipped_{ 0 };
+
+	static constexpr bool distinct()
+	{
+		constexpr uint64_t keys[] = { Handlers::key... };
+		for ( size_t i = 0; i < sizeof...(Handlers); i++ ) {
+			for ( size_t j = i + 1; j < sizeof...(Handlers); j++ ) {
+				if ( keys[i] == keys[j] ) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// The packed name of a framed line, 0 if it has none or it is too long. The
+	// name is found the way parseSentenceView() finds it: after the last '$' or
+	// '!', up to the first comma before the checksum.
+	static uint64_t keyOf(std::string_view line)
+	{
+		size_t dollar = line.find_last_of("$!");
+		if ( dollar == std::string_view::npos ) {
+			return 0;
+		}
+		size_t star  = line.rfind('*');
+		size_t end   = star != std::string_view::npos && star > dollar ? star : line.size();
+		size_t comma = line.substr(0, end).find(',', dollar + 1);
+		return sentenceKey(line.substr(dollar + 1, (comma < end ? comma : end) - dollar - 1));
+	}
+
+	template <class Handler>
+	ParseStatus call(Handler& handler)
+	{
+		if constexpr ( std::is_same_v<std::invoke_result_t<decltype(handler.handler_)&, const SentenceView&>, ParseStatus> ) {
+			return handler.handler_(sentence_);
+		}
+		else {
+			handler.handler_(sentence_);
+			return ParseStatus::Ok;
+		}
+	}
+
+	template <size_t... I>
+	ParseStatus dispatch(uint64_t key, std::index_sequence<I...> /*unused*/)
+	{
+		ParseStatus status = ParseStatus::Ok;
+		static_cast<void>(((key == std::tuple_element_t<I, std::tuple<Handlers...>>::key && ((status = call(std::get<I>(handlers_))), true)) || ...));
+		return status;
+	}
+
+	ParseStatus fail(ParseStatus status)
+	{
+		errors_++;
+		return status;
+	}
+
+public:
+	explicit BasicNMEAParser(Handlers... handlers)
+	    : handlers_(std::move(handlers)...)
+	{
+		static_assert(distinct(), "one handler per sentence name");
+	}
+
+	// Whether a sentence name has a handler
+	static constexpr bool handles(uint64_t key)
+	{
+		return ((key == Handlers::key) || ...);
+	}
+
+	// One sentence, without the line ending. Ok for sentences without a handler.
+	ParseStatus readSentence(std::string_view line)
+	{
+		uint64_t key = keyOf(line);
+		if ( !handles(key) ) {
+			skipped_++;
+			return ParseStatus::Ok;
+		}
+		ParseStatus status = parseSentenceView(line, sentence_);
+		if ( status != ParseStatus::Ok ) {
+			return fail(status);
+		}
+		if ( sentence_.checksumMismatch() ) {
+			return fail(ParseStatus::ChecksumMismatch);
+		}
+		sentences_++;
+		status = dispatch(key, std::index_sequence_for<Handlers...>());
+		return status == ParseStatus::Ok ? status : fail(status);
+	}
+
+	// Pending until a newline completes a sentence, then as readSentence()
+	ParseStatus readByte(uint8_t byte)
+	{
+		switch ( framer_.push(byte) ) {
+		case Framer::Complete:
+			return readSentence(framer_.line());
+		case Framer::Overflow:
+			return fail(ParseStatus::Overflow);
+		default:
+			return ParseStatus::Pending;
+		}
+	}
+
+	// Ok if every sentence completed in ptr was, else the status of the last one that failed.
+	ParseStatus readBuffer(const uint8_t* ptr, size_t size)
+	{
+		ParseStatus result = ParseStatus::Ok;
+		for ( size_t i = 0; i < size; i++ ) {
+			ParseStatus status = readByte(ptr[i]);
+			if ( status != ParseStatus::Ok && status != ParseStatus::Pending ) {
+				result = status;
+			}
+		}
+		return result;
+	}
+
+	[[nodiscard]] uint32_t sentences() const { return sentences_; } // handled without a parse error
+	[[nodiscard]] uint32_t errors() const { return errors_; }       // parse errors and handler failures
+	[[nodiscard]] uint32_t skipped() const { return skipped_; }     // dropped after framing, no handler
+};
+
+} // namespace nmea
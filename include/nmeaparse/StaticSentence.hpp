@@ -0,0 +1,156 @@
+/*
+ * StaticSentence.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string_view>
+
+namespace nmea {
+
+// Not constexpr, so reaching it while evaluating a constant is a compile error.
+// At runtime it throws, or aborts where exceptions are off (-fno-exceptions).
+[[noreturn]] inline void
+invalidStaticSentence(const char* reason)
+{
+#if defined(__cpp_exceptions)
+	throw std::invalid_argument(reason);
+#else
+	(void) reason;
+	std::abort();
+#endif
+}
+
+// XOR of all characters, the NMEA checksum of the text between '$' and '*'.
+constexpr uint8_t
+xorChecksum(std::string_view text)
+{
+	uint8_t checksum = 0;
+	for ( auto chr: text ) {
+		checksum ^= static_cast<uint8_t>(chr);
+	}
+	return checksum;
+}
+
+// A complete sentence, "$" + body + "*HH\r\n", built at compile time.
+//
+//   constexpr auto GGAOnce = makeSentence("PSRF103,00,00,01,01");
+//   write(fd, GGAOnce.data(), GGAOnce.size());
+//
+// The body is checked while compiling: printable characters only, none of the
+// characters NMEA reserves ($ * ! \ ^ ~), and at most 82 characters in all.
+//
+// Runs of '#' in the body are digits filled in at runtime. Setting them only
+// rewrites those digits and updates the checksum by XOR-ing out the old ones and
+// in the new ones, the rest of the sentence is never formatted again.
+//
+//   constexpr auto RateTemplate = makeSentence("PSRF103,##,00,##,01");
+//   auto cmd = RateTemplate;
+//   cmd.set(0, NMEASentence::RMC);   // first run of '#'
+//   cmd.set(1, 1);                   // second one
+template <size_t N> // N is the size of the body literal, its terminating '\0' included
+class StaticSentence {
+public:
+	static constexpr size_t Size            = N + 5; // '$', body, '*', 2 hex digits, "\r\n"
+	static constexpr size_t MaxPlaceholders = 16;
+
+	static_assert(N > 1, "NMEA sentence body is empty");
+	static_assert(Size <= 82, "NMEA sentence is longer than 82 characters");
+
+private:
+	struct Placeholder {
+		uint8_t offset{ 0 }; // into text_
+		uint8_t width{ 0 };
+	};
+
+	char        text_[Size]{};
+	uint8_t     checksum_{ 0 };
+	Placeholder placeholders_[MaxPlaceholders]{};
+	size_t      placeholderCount_{ 0 };
+
+	static constexpr char hexDigit(uint8_t value) { return static_cast<char>(value < 10 ? '0' + value : 'A' + value - 10); }
+
+	constexpr void writeChecksum()
+	{
+		text_[N + 1] = hexDigit(checksum_ >> 4);
+		text_[N + 2] = hexDigit(checksum_ & 0xF);
+	}
+
+public:
+	// Failing here during constant evaluation makes the compiler reject the sentence.
+	constexpr explicit StaticSentence(const char (&body)[N])
+	{
+		text_[0] = '$';
+		for ( size_t i = 0; i + 1 < N; i++ ) {
+			char chr = body[i];
+			if ( chr < 0x20 || chr > 0x7E || chr == '$' || chr == '*' || chr == '!' || chr == '\\' || chr == '^' || chr == '~' ) {
+				invalidStaticSentence("NMEA sentence body contains a reserved or non-printable character");
+			}
+			if ( chr == '#' ) {
+				if ( i == 0 || body[i - 1] != '#' ) {
+					if ( placeholderCount_ == MaxPlaceholders ) {
+						invalidStaticSentence("NMEA sentence template has too many '#' fields");
+					}
+					placeholders_[placeholderCount_++].offset = static_cast<uint8_t>(i + 1);
+				}
+				if ( ++placeholders_[placeholderCount_ - 1].width > 10 ) {
+					invalidStaticSentence("NMEA sentence template has a '#' field wider than 10 digits");
+				}
+				chr = '0';
+			}
+			text_[i + 1] = chr;
+			checksum_ ^= static_cast<uint8_t>(chr);
+		}
+		text_[N]     = '*';
+		text_[N + 3] = '\r';
+		text_[N + 4] = '\n';
+		writeChecksum();
+	}
+
+	// Writes value, zero padded, into the placeholder-th run of '#'. Returns false,
+	// changing nothing, if there is no such run or the value has too many digits.
+	constexpr bool set(size_t placeholder, uint32_t value)
+	{
+		if ( placeholder >= placeholderCount_ ) {
+			return false;
+		}
+		const Placeholder& field = placeholders_[placeholder];
+
+		char digits[10]{};
+		for ( size_t i = field.width; i-- > 0; ) {
+			digits[i] = static_cast<char>('0' + value % 10);
+			value /= 10;
+		}
+		if ( value != 0 ) {
+			return false;
+		}
+
+		for ( size_t i = 0; i < field.width; i++ ) {
+			char& chr = text_[field.offset + i];
+			checksum_ ^= static_cast<uint8_t>(chr) ^ static_cast<uint8_t>(digits[i]);
+			chr = digits[i];
+		}
+		writeChecksum();
+		return true;
+	}
+
+	[[nodiscard]] constexpr const char*      data() const { return text_; }
+	[[nodiscard]] constexpr size_t           size() const { return Size; }
+	[[nodiscard]] constexpr std::string_view view() const { return std::string_view(text_, Size); }
+	[[nodiscard]] constexpr uint8_t          checksum() const { return checksum_; }
+	[[nodiscard]] constexpr size_t           placeholders() const { return placeholderCount_; }
+};
+
+template <size_t N>
+constexpr StaticSentence<N>
+makeSentence(const char (&body)[N])
+{
+	return StaticSentence<N>(body);
+}
+
+} // namespace nmea
@@ -0,0 +1,109 @@
+/*
+ * StreamDemultiplexer.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "nmeaparse/Event.hpp"
+
+namespace nmea {
+
+class NMEAParser;
+
+enum class FrameProtocol : uint8_t {
+	NMEA,  // '$' or '!' ... '\n'
+	UBX,   // u-blox, 0xB5 0x62
+	SiRF,  // SiRF binary, 0xA0 0xA2 ... 0xB0 0xB3
+	RTCM3, // 0xD3
+	Count
+};
+
+const char* frameProtocolName(FrameProtocol protocol);
+
+// A binary frame with a good checksum. The bytes belong to the demultiplexer
+// and are only valid during the onFrame call.
+struct BinaryFrame {
+	FrameProtocol  protocol_;
+	uint16_t       type_;        // UBX: class << 8 | id, SiRF: message id, RTCM3: message number
+	const uint8_t* frame_;       // everything from the sync bytes to the checksum, to pass on untouched
+	size_t         frameSize_;
+	const uint8_t* payload_;     // UBX: after the length, SiRF: from the message id, RTCM3: after the length
+	size_t         payloadSize_;
+};
+
+// Splits one byte stream carrying NMEA, UBX, SiRF binary and RTCM3 into its
+// frames. Every binary frame is checked (UBX Fletcher, SiRF 15 bit sum, RTCM3
+// CRC-24Q) and the good ones are passed to onFrame. NMEA lines go to the parser,
+// which checks them itself.
+//
+//   StreamDemultiplexer demux(&parser);
+//   gps.attachToDemultiplexer(demux);       // NAV-PVT and NAV-SAT into gps.fix_
+//   demux.onFrame += [&](const BinaryFrame& frame) {
+//       if ( frame.protocol_ == FrameProtocol::RTCM3 ) {
+//           caster.write(frame.frame_, frame.frameSize_);
+//       }
+//   };
+//   demux.readBuffer(data, size);
+//
+// A frame with a bad checksum, or longer than MaxFrameSize, is dropped and its
+// bytes after the sync byte are read again, so a sync byte that turns up in
+// other data doesn't cost the frames behind it. Exceptions from the parser or
+// the handlers pass through like they do from NMEAParser::readBuffer().
+class StreamDemultiplexer {
+public:
+	static constexpr size_t MaxFrameSize = 2048; // bytes, RTCM3 frames are at most 1029
+
+private:
+	enum class State : uint8_t {
+		Idle, // between frames
+		Line, // NMEA, until '\n'
+		Frame // binary, until frameSize_ bytes
+	};
+
+	NMEAParser*               parser_;
+	std::pmr::vector<uint8_t> buffer_;
+	std::pmr::vector<uint8_t> rescan_; // bytes of dropped frames to read again, last one first
+	bool                      rescanning_{ false };
+	State                     state_{ State::Idle };
+	FrameProtocol             protocol_{ FrameProtocol::NMEA };
+	size_t                    frameSize_{ 0 }; // once the header is in, 0 before
+	uint64_t                  frames_[static_cast<size_t>(FrameProtocol::Count)]{};
+	uint64_t                  checksumErrors_{ 0 };
+	uint64_t                  oversize_{ 0 };
+	uint64_t                  discarded_{ 0 };
+
+	void step(uint8_t byte);
+	void start(uint8_t byte);
+	void frameByte(uint8_t byte);
+	void finishFrame();
+	void drop(bool checksumError); // back to Idle without a frame, the bytes after the sync byte are read again
+	void rescan();
+
+public:
+	explicit StreamDemultiplexer(NMEAParser* parser = nullptr, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	Event<void(const BinaryFrame&)> onFrame; // every UBX, SiRF and RTCM3 frame with a good checksum
+
+	void setParser(NMEAParser* parser); // where NMEA lines go, nullptr drops them
+
+	void readByte(uint8_t byte);
+	void readBuffer(const uint8_t* data, size_t size);
+	void reset(); // drops a partly read frame
+
+	[[nodiscard]] uint64_t frames(FrameProtocol protocol) const; // good frames (NMEA: lines) so far
+	[[nodiscard]] uint64_t checksumErrors() const;
+	[[nodiscard]] uint64_t oversize() const;  // frames longer than MaxFrameSize
+	[[nodiscard]] uint64_t discarded() const; // bytes outside any frame
+
+	static uint16_t ubxChecksum(const uint8_t* data, size_t size); // CK_A | CK_B << 8
+	static uint32_t crc24q(const uint8_t* data, size_t size);
+};
+
+} // namespace nmea
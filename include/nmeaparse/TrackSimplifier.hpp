@@ -0,0 +1,100 @@
+/*
+ * TrackSimplifier.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "nmeaparse/Event.hpp"
+#include "nmeaparse/FixHistory.hpp"
+
+namespace nmea {
+
+class GPSService;
+
+enum class SimplifyMode {
+	OpeningWindow, // Douglas-Peucker over a window that grows from the last kept point
+	DeadBand       // keep a point once it is tolerance away from the last kept one, or turned
+};
+
+struct TrackSimplifierSettings {
+	SimplifyMode              mode{ SimplifyMode::OpeningWindow };
+	double                    tolerance{ 5.0 };     // meters, see TrackSimplifier for what is guaranteed
+	double                    headingChange{ 0.0 }; // degrees, DeadBand also keeps a point when the course turned this much, 0 = off
+	size_t                    maxWindow{ 256 };     // points held at most, a point is kept when it's full
+	std::chrono::milliseconds maxInterval{ 0 };     // keep a point at least this often, 0 = off
+};
+
+// Drops the fixes that add nothing to the shape of a track, one fix at a time
+// and in bounded memory, and passes the rest to onPoint.
+//
+// OpeningWindow keeps a point only when the straight line from the last kept
+// point would pass more than tolerance away from one of the points since. Every
+// dropped point is within tolerance of the simplified track.
+//
+// DeadBand keeps a point when it is more than tolerance from the last kept
+// point, or when the course changed more than headingChange. Every dropped point
+// is within tolerance of a kept point.
+//
+//   TrackSimplifier track;                 // one per vehicle, each with its own settings
+//   track.onPoint += [&](const FixRecord& point) { uplink.send(point); };
+//   track.attachToService(gps);
+//   ...
+//   track.flush();                         // end of the track, keeps the last point
+class TrackSimplifier {
+private:
+	struct Offset {
+		double east;  // meters from the last kept point
+		double north;
+	};
+
+	TrackSimplifierSettings settings_;
+	std::vector<FixRecord>  window_;  // last kept point first, then the ones since
+	std::vector<Offset>     offsets_; // of the window, worked out once per point
+	double                  anchorCos_{ 1 };
+	FixRecord               pending_; // epoch being read by attachToService()
+	bool                    hasPending_{ false };
+	uint64_t                received_{ 0 };
+	uint64_t                kept_{ 0 };
+
+	void                 keep(const FixRecord& point);
+	void                 restart(const FixRecord& point); // point is the new last kept one
+	[[nodiscard]] Offset offset(const FixRecord& point) const;
+	[[nodiscard]] bool   windowFits(Offset end) const;
+
+public:
+	explicit TrackSimplifier(TrackSimplifierSettings settings = TrackSimplifierSettings());
+
+	Event<void(const FixRecord&)> onPoint; // every point kept, in order
+
+	// Settings apply from the next point on.
+	void                                         setSettings(const TrackSimplifierSettings& settings);
+	[[nodiscard]] const TrackSimplifierSettings& settings() const;
+
+	// The next fix of the track, in time order.
+	void push(const FixRecord& point);
+
+	// Keeps the last point if it wasn't, e.g. when the vehicle parks.
+	void flush();
+
+	// Starts a new track, without keeping anything pending.
+	void reset();
+
+	// Pushes every locked epoch of the service, once all its sentences are read,
+	// so one epoch later than onUpdate.
+	void attachToService(GPSService& gps);
+
+	// The points of a whole history the settings keep, appended to out.
+	void simplify(const FixHistory& history, std::vector<FixRecord>& out) const;
+
+	[[nodiscard]] uint64_t received() const; // points pushed
+	[[nodiscard]] uint64_t kept() const;     // points passed to onPoint
+};
+
+} // namespace nmea
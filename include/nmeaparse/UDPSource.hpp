@@ -0,0 +1,43 @@
+/*
+ * UDPSource.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "nmeaparse/NMEAParser.hpp"
+
+namespace nmea {
+
+// Receives NMEA datagrams from a UDP socket and feeds them to a parser.
+// On Linux the receive time of each datagram is taken from the kernel's
+// SO_TIMESTAMPING software timestamp, so it excludes the time the datagram
+// spent queued in the socket. Where the kernel refuses, the time recvmsg()
+// returned is used instead. Not available on other platforms.
+class UDPSource {
+private:
+	int                  fd_;
+	bool                 kernelTimestamps_;
+	std::vector<uint8_t> buffer_;
+
+public:
+	explicit UDPSource(uint16_t port, const std::string& bindAddress = "0.0.0.0");
+	~UDPSource();
+
+	UDPSource(const UDPSource&)            = delete;
+	UDPSource& operator=(const UDPSource&) = delete;
+
+	[[nodiscard]] int  fd() const;
+	[[nodiscard]] bool kernelTimestamps() const; // true if SO_TIMESTAMPING is active
+
+	// Blocks for one datagram, feeds it to the parser stamped with its receive time.
+	// Returns the datagram size.
+	size_t receive(NMEAParser& parser);
+};
+
+} // namespace nmea
@@ -10,10 +10,49 @@
 // The implementation of a NMEA 0183 parser.
 // The implementation of a NMEA 0183 sentence generator.
 // The implementation of a GPS data service.
+// A synthetic NMEA stream generator.
+// An AIS message decoder.
+//
+// With NEMATODE_EMBEDDED only the parts without exceptions and heap allocation
+// are built: FixedNMEAParser, BasicNMEAParser, FixedGPSService, GPSFixEncoder,
+// AISDecoder.
 
 #pragma once
 
+#ifdef NEMATODE_EMBEDDED
+
+#include "nmeaparse/AISDecoder.hpp"
+#include "nmeaparse/FixedGPSService.hpp"
+#include "nmeaparse/FixedNMEAParser.hpp"
+#include "nmeaparse/GPSFixEncoder.hpp"
+#include "nmeaparse/SentenceRange.hpp"
+#include "nmeaparse/StaticNMEAParser.hpp"
+#include "nmeaparse/StaticSentence.hpp"
+
+#else
+
+#include "nmeaparse/AISDecoder.hpp"
+#include "nmeaparse/Checkpoint.hpp"
+#include "nmeaparse/FixHistory.hpp"
+#include "nmeaparse/FixSerializer.hpp"
+#include "nmeaparse/FixedGPSService.hpp"
+#include "nmeaparse/FixedNMEAParser.hpp"
+#include "nmeaparse/Geodesy.hpp"
+#include "nmeaparse/Geofence.hpp"
+#include "nmeaparse/GPSFixEncoder.hpp"
 #include "nmeaparse/GPSService.hpp"
+#include "nmeaparse/LatencyHistogram.hpp"
+#include "nmeaparse/LogIndex.hpp"
+#include "nmeaparse/Metrics.hpp"
 #include "nmeaparse/NMEACommand.hpp"
+#include "nmeaparse/NMEAGenerator.hpp"
 #include "nmeaparse/NMEAParser.hpp"
 #include "nmeaparse/NumberConversion.hpp"
+#include "nmeaparse/OutputProfile.hpp"
+#include "nmeaparse/SentenceRange.hpp"
+#include "nmeaparse/StaticNMEAParser.hpp"
+#include "nmeaparse/StaticSentence.hpp"
+#include "nmeaparse/StreamDemultiplexer.hpp"
+#include "nmeaparse/TrackSimplifier.hpp"
+
+#endif
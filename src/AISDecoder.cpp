@@ -0,0 +1,425 @@
+/*
+ * AISDecoder.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/AISDecoder.hpp"
+
+#include <cstring>
+
+#include "nmeaparse/NumberConversion.hpp"
+
+using namespace std;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+namespace {
+
+constexpr uint8_t NotArmored = 0xFF;
+
+// Armored character -> its 6 bits: '0'-'W' are 0-39, '`'-'w' are 40-63
+struct SixBitTable {
+	uint8_t values[256]{};
+
+	constexpr SixBitTable()
+	{
+		for ( int chr = 0; chr < 256; chr++ ) {
+			values[chr] = NotArmored;
+		}
+		for ( int chr = '0'; chr <= 'W'; chr++ ) {
+			values[chr] = static_cast<uint8_t>(chr - '0');
+		}
+		for ( int chr = '`'; chr <= 'w'; chr++ ) {
+			values[chr] = static_cast<uint8_t>(chr - '`' + 40);
+		}
+	}
+};
+
+constexpr SixBitTable SixBit;
+
+// 6-bit ASCII -> text: 0-31 are '@'-'_', 32-63 are ' '-'?'
+constexpr char AISChars[] = "@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_ !\"#$%&'()*+,-./0123456789:;<=>?";
+
+constexpr double Quiet = numeric_limits<double>::quiet_NaN();
+
+// The last bit each message type needs
+constexpr size_t PositionBits = 149;  // types 1, 2, 3, up to RAIM
+constexpr size_t ClassBBits   = 148;  // type 18, up to RAIM
+constexpr size_t VoyageBits   = 422;  // type 5, up to the destination, some leave out DTE and the spare
+constexpr size_t PartABits    = 160;  // type 24 part A
+constexpr size_t PartBBits    = 162;  // type 24 part B, up to the dimensions
+
+bool
+isAIS(string_view name)
+{
+	return name.size() == 5 && name[2] == 'V' && name[3] == 'D' && (name[4] == 'M' || name[4] == 'O');
+}
+
+} // namespace
+
+// ------------- AISDECODER CLASS -------------
+
+bool
+AISDecoder::attachToParser(FixedNMEAParser& parser)
+{
+	bool attached = true;
+	attached      = parser.setSentenceHandler("AIVDM", &AISDecoder::read_VDM, this) && attached;
+	attached      = parser.setSentenceHandler("AIVDO", &AISDecoder::read_VDM, this) && attached;
+	return attached;
+}
+
+void
+AISDecoder::setPositionHandler(PositionHandler handler, void* context)
+{
+	onPosition_      = handler;
+	positionContext_ = context;
+}
+
+void
+AISDecoder::setVoyageHandler(VoyageHandler handler, void* context)
+{
+	onVoyage_      = handler;
+	voyageContext_ = context;
+}
+
+void
+AISDecoder::setStaticDataHandler(StaticDataHandler handler, void* context)
+{
+	onStaticData_      = handler;
+	staticDataContext_ = context;
+}
+
+ParseStatus
+AISDecoder::read_VDM(void* decoder, const SentenceView& sentence)
+{
+	// for the parser a sentence kept for the rest of its message is handled
+	ParseStatus status = static_cast<AISDecoder*>(decoder)->readSentence(sentence);
+	return status == ParseStatus::Pending ? ParseStatus::Ok : status;
+}
+
+ParseStatus
+AISDecoder::readSentence(string_view line)
+{
+	while ( !line.empty() && (line.back() == '\n' || line.back() == '\r' || line.back() == ' ' || line.back() == '\t') ) {
+		line.remove_suffix(1);
+	}
+	SentenceView sentence;
+	ParseStatus  status = parseSentenceView(line, sentence);
+	if ( status != ParseStatus::Ok ) {
+		return status;
+	}
+	return readSentence(sentence);
+}
+
+ParseStatus
+AISDecoder::readSentence(const SentenceView& sentence)
+{
+	// !AIVDM,<sentences>,<sentence number>,<sequential message id>,<channel>,<payload>,<fill bits>*hh
+	if ( !isAIS(sentence.name_) ) {
+		return ParseStatus::Ok;
+	}
+	if ( !sentence.checksumOK() ) {
+		return ParseStatus::ChecksumMismatch;
+	}
+	if ( sentence.size() < 6 ) {
+		return ParseStatus::MissingFields;
+	}
+
+	int64_t count    = 0;
+	int64_t number   = 0;
+	int64_t sequence = -1;
+	int64_t fill     = 0;
+	if ( !tryParseInt(sentence.parameter(0), count) || !tryParseInt(sentence.parameter(1), number) || !tryParseInt(sentence.parameter(5), fill) ) {
+		return ParseStatus::BadNumber;
+	}
+	if ( !sentence.parameter(2).empty() && !tryParseInt(sentence.parameter(2), sequence) ) {
+		return ParseStatus::BadNumber;
+	}
+	if ( count < 1 || count > 9 || number < 1 || number > count || sequence > 9 || fill < 0 || fill > 5 ) {
+		return ParseStatus::BadNumber;
+	}
+	string_view payload = sentence.parameter(4);
+	char        channel = sentence.parameter(3).empty() ? '\0' : sentence.parameter(3)[0];
+	bool        own     = sentence.name_[4] == 'O';
+
+	clock_++;
+	if ( count == 1 ) {
+		return readPayload(payload, static_cast<uint8_t>(fill), channel, own);
+	}
+
+	auto     key  = static_cast<uint8_t>(sequence + 1); // 0 if there was none
+	Pending* slot = nullptr;
+	for ( auto& pending: pending_ ) {
+		if ( pending.count != 0 && pending.sequence == key && pending.channel == channel && pending.own == own ) {
+			slot = &pending;
+			break;
+		}
+	}
+
+	if ( number == 1 ) {
+		if ( slot == nullptr ) {
+			// a free slot, or the oldest one
+			slot = &pending_[0];
+			for ( auto& pending: pending_ ) {
+				if ( pending.count == 0 ) {
+					slot = &pending;
+					break;
+				}
+				if ( clock_ - pending.started > clock_ - slot->started ) {
+					slot = &pending;
+				}
+			}
+		}
+		if ( slot->count != 0 ) {
+			dropped_++; // never finished, or its id was reused
+		}
+		slot->sequence = key;
+		slot->channel  = channel;
+		slot->own      = own;
+		slot->count    = static_cast<uint8_t>(count);
+		slot->started  = clock_;
+		slot->size     = 0;
+	}
+	else if ( slot == nullptr || slot->count != count || slot->next != number ) {
+		if ( slot != nullptr ) {
+			slot->count = 0;
+			dropped_++;
+		}
+		return ParseStatus::MissingFragment;
+	}
+
+	if ( slot->size + payload.size() > MaxPayload ) {
+		slot->count = 0;
+		dropped_++;
+		return ParseStatus::Overflow;
+	}
+	memcpy(slot->payload + slot->size, payload.data(), payload.size());
+	slot->size += payload.size();
+	slot->next  = static_cast<uint8_t>(number + 1);
+	if ( number < count ) {
+		return ParseStatus::Pending;
+	}
+
+	slot->count = 0;
+	return readPayload(string_view(slot->payload, slot->size), static_cast<uint8_t>(fill), channel, own);
+}
+
+ParseStatus
+AISDecoder::readPayload(string_view payload, uint8_t fillBits, char channel, bool own)
+{
+	ParseStatus status = unarmor(payload, fillBits);
+	if ( status != ParseStatus::Ok ) {
+		return status;
+	}
+	return decode(channel, own);
+}
+
+// The armored characters into bits_, 6 bits each, most significant first
+ParseStatus
+AISDecoder::unarmor(string_view payload, uint8_t fillBits)
+{
+	if ( payload.size() > MaxPayload ) {
+		return ParseStatus::Overflow;
+	}
+	if ( payload.empty() || fillBits > 5 ) {
+		return ParseStatus::MissingFields;
+	}
+
+	uint32_t acc   = 0; // bits not written yet, in the low end
+	size_t   held  = 0;
+	size_t   bytes = 0;
+	for ( auto chr: payload ) {
+		uint8_t value = SixBit.values[static_cast<uint8_t>(chr)];
+		if ( value == NotArmored ) {
+			return ParseStatus::BadCharacter;
+		}
+		acc = acc << 6 | value;
+		held += 6;
+		if ( held >= 8 ) {
+			held -= 8;
+			bits_[bytes++] = static_cast<uint8_t>(acc >> held);
+		}
+	}
+	if ( held != 0 ) {
+		bits_[bytes++] = static_cast<uint8_t>(acc << (8 - held));
+	}
+	memset(bits_ + bytes, 0, sizeof(bits_) - bytes);
+	bitCount_ = payload.size() * 6 - fillBits;
+	return ParseStatus::Ok;
+}
+
+// size bits (at most 32) from bit start of the message, the first bit highest
+uint32_t
+AISDecoder::bits(size_t start, size_t size) const
+{
+	const uint8_t* ptr    = bits_ + start / 8;
+	uint64_t       window = 0;
+	for ( size_t i = 0; i < 8; i++ ) {
+		window = window << 8 | ptr[i];
+	}
+	return static_cast<uint32_t>((window << (start % 8)) >> (64 - size));
+}
+
+int32_t
+AISDecoder::signedBits(size_t start, size_t size) const
+{
+	uint32_t value = bits(start, size);
+	uint32_t sign  = 1u << (size - 1);
+	return static_cast<int32_t>(value ^ sign) - static_cast<int32_t>(sign);
+}
+
+void
+AISDecoder::text(size_t start, size_t size, char* out) const
+{
+	size_t length = 0;
+	while ( length < size ) {
+		char chr = AISChars[bits(start + length * 6, 6)];
+		if ( chr == '@' ) {
+			break; // padding to the end
+		}
+		out[length++] = chr;
+	}
+	while ( length > 0 && out[length - 1] == ' ' ) {
+		length--;
+	}
+	out[length] = '\0';
+}
+
+ParseStatus
+AISDecoder::decode(char channel, bool own)
+{
+	if ( bitCount_ < 38 ) {
+		return ParseStatus::MissingFields;
+	}
+	auto type = static_cast<uint8_t>(bits(0, 6));
+
+	auto header = [&](AISMessage& message) {
+		message.type_    = type;
+		message.repeat_  = static_cast<uint8_t>(bits(6, 2));
+		message.mmsi_    = bits(8, 30);
+		message.channel_ = channel;
+		message.own_     = own;
+	};
+	auto position = [&](AISPosition& report, size_t offset) {
+		// speed, accuracy, longitude, latitude, course, heading and second are
+		// the same in types 1-3 and 18, 4 bits further on in the former
+		uint32_t speed     = bits(offset, 10);
+		int32_t  longitude = signedBits(offset + 11, 28);
+		int32_t  latitude  = signedBits(offset + 39, 27);
+		uint32_t course    = bits(offset + 66, 12);
+		report.speed_      = speed == 1023 ? Quiet : speed / 10.0;
+		report.accurate_   = bits(offset + 10, 1) != 0;
+		report.longitude_  = longitude == 181 * 600000 ? Quiet : longitude / 600000.0;
+		report.latitude_   = latitude == 91 * 600000 ? Quiet : latitude / 600000.0;
+		report.course_     = course >= 3600 ? Quiet : course / 10.0;
+		report.heading_    = static_cast<uint16_t>(bits(offset + 78, 9));
+		report.second_     = static_cast<uint8_t>(bits(offset + 87, 6));
+	};
+
+	switch ( type ) {
+	case 1:
+	case 2:
+	case 3: {
+		if ( bitCount_ < PositionBits ) {
+			return ParseStatus::MissingFields;
+		}
+		AISPosition report;
+		header(report);
+		report.status_ = static_cast<uint8_t>(bits(38, 4));
+		report.turn_   = static_cast<int8_t>(signedBits(42, 8));
+		position(report, 50);
+		report.raim_ = bits(148, 1) != 0;
+		messages_++;
+		if ( onPosition_ != nullptr ) {
+			onPosition_(positionContext_, report);
+		}
+		return ParseStatus::Ok;
+	}
+
+	case 18: {
+		if ( bitCount_ < ClassBBits ) {
+			return ParseStatus::MissingFields;
+		}
+		AISPosition report;
+		header(report);
+		position(report, 46);
+		report.raim_ = bits(147, 1) != 0;
+		messages_++;
+		if ( onPosition_ != nullptr ) {
+			onPosition_(positionContext_, report);
+		}
+		return ParseStatus::Ok;
+	}
+
+	case 5: {
+		if ( bitCount_ < VoyageBits ) {
+			return ParseStatus::MissingFields;
+		}
+		AISVoyage report;
+		header(report);
+		report.version_ = static_cast<uint8_t>(bits(38, 2));
+		report.imo_     = bits(40, 30);
+		text(70, 7, report.callsign_);
+		text(112, 20, report.name_);
+		report.shipType_    = static_cast<uint8_t>(bits(232, 8));
+		report.toBow_       = static_cast<uint16_t>(bits(240, 9));
+		report.toStern_     = static_cast<uint16_t>(bits(249, 9));
+		report.toPort_      = static_cast<uint8_t>(bits(258, 6));
+		report.toStarboard_ = static_cast<uint8_t>(bits(264, 6));
+		report.epfd_        = static_cast<uint8_t>(bits(270, 4));
+		report.etaMonth_    = static_cast<uint8_t>(bits(274, 4));
+		report.etaDay_      = static_cast<uint8_t>(bits(278, 5));
+		report.etaHour_     = static_cast<uint8_t>(bits(283, 5));
+		report.etaMinute_   = static_cast<uint8_t>(bits(288, 6));
+		report.draught_     = bits(294, 8) / 10.0;
+		text(302, 20, report.destination_);
+		report.dte_ = bitCount_ <= VoyageBits || bits(422, 1) != 0;
+		messages_++;
+		if ( onVoyage_ != nullptr ) {
+			onVoyage_(voyageContext_, report);
+		}
+		return ParseStatus::Ok;
+	}
+
+	case 24: {
+		AISStaticData report;
+		header(report);
+		report.part_ = static_cast<uint8_t>(bits(38, 2));
+		if ( report.part_ == 0 ) {
+			if ( bitCount_ < PartABits ) {
+				return ParseStatus::MissingFields;
+			}
+			text(40, 20, report.name_);
+		}
+		else if ( report.part_ == 1 ) {
+			if ( bitCount_ < PartBBits ) {
+				return ParseStatus::MissingFields;
+			}
+			report.shipType_ = static_cast<uint8_t>(bits(40, 8));
+			text(48, 3, report.vendor_);
+			report.model_  = static_cast<uint8_t>(bits(66, 4));
+			report.serial_ = bits(70, 20);
+			text(90, 7, report.callsign_);
+			report.toBow_       = static_cast<uint16_t>(bits(132, 9));
+			report.toStern_     = static_cast<uint16_t>(bits(141, 9));
+			report.toPort_      = static_cast<uint8_t>(bits(150, 6));
+			report.toStarboard_ = static_cast<uint8_t>(bits(156, 6));
+		}
+		else {
+			return ParseStatus::BadNumber;
+		}
+		messages_++;
+		if ( onStaticData_ != nullptr ) {
+			onStaticData_(staticDataContext_, report);
+		}
+		return ParseStatus::Ok;
+	}
+
+	default:
+		unsupported_++;
+		return ParseStatus::Ok;
+	}
+}
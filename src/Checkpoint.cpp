@@ -0,0 +1,373 @@
+/*
+ * Checkpoint.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/Checkpoint.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+#include "nmeaparse/GPSService.hpp"
+#include "nmeaparse/NMEAParser.hpp"
+
+using namespace std;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+namespace {
+
+constexpr char     Magic[8] = { 'N', 'M', 'E', 'A', 'C', 'K', 'P', 'T' };
+constexpr uint32_t End      = 0xFFFFFFFF; // in place of the size of a record
+constexpr uint32_t MaxSize  = 1 << 20;    // of a record, far more than one stream can have
+
+// FNV-1a, to catch records damaged on disk
+uint32_t
+hashOf(const char* data, size_t size)
+{
+	uint32_t hash = 2166136261U;
+	for ( size_t i = 0; i < size; i++ ) {
+		hash = (hash ^ static_cast<uint8_t>(data[i])) * 16777619U;
+	}
+	return hash;
+}
+
+// Little endian fields appended to a record
+class Put {
+private:
+	vector<char>& out_;
+
+public:
+	explicit Put(vector<char>& out)
+	    : out_(out)
+	{
+	}
+
+	void u(uint64_t value, int bytes)
+	{
+		for ( int i = 0; i < bytes; i++ ) {
+			out_.push_back(static_cast<char>(value >> (8 * i)));
+		}
+	}
+
+	void d(double value)
+	{
+		uint64_t bits = 0;
+		memcpy(&bits, &value, sizeof(bits));
+		u(bits, 8);
+	}
+
+	void i(int32_t value)
+	{
+		u(static_cast<uint32_t>(value), 4);
+	}
+
+	void bytes(const char* data, size_t size)
+	{
+		u(size, 4);
+		out_.insert(out_.end(), data, data + size);
+	}
+};
+
+// The same fields read back, throwing past the end of the record
+class Get {
+private:
+	const char* pos_;
+	const char* end_;
+
+public:
+	Get(const char* data, size_t size)
+	    : pos_(data)
+	    , end_(data + size)
+	{
+	}
+
+	uint64_t u(int bytes)
+	{
+		if ( end_ - pos_ < bytes ) {
+			throw CheckpointError("Truncated checkpoint record");
+		}
+		uint64_t value = 0;
+		for ( int i = 0; i < bytes; i++ ) {
+			value |= static_cast<uint64_t>(static_cast<uint8_t>(*pos_++)) << (8 * i);
+		}
+		return value;
+	}
+
+	double d()
+	{
+		uint64_t bits  = u(8);
+		double   value = 0;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	int32_t i()
+	{
+		return static_cast<int32_t>(static_cast<uint32_t>(u(4)));
+	}
+
+	string_view bytes()
+	{
+		auto size = static_cast<size_t>(u(4));
+		if ( static_cast<size_t>(end_ - pos_) < size ) {
+			throw CheckpointError("Truncated checkpoint record");
+		}
+		string_view value(pos_, size);
+		pos_ += size;
+		return value;
+	}
+};
+
+void
+write(ostream& out, uint32_t value)
+{
+	char bytes[4];
+	for ( int i = 0; i < 4; i++ ) {
+		bytes[i] = static_cast<char>(value >> (8 * i));
+	}
+	out.write(bytes, sizeof(bytes));
+}
+
+uint32_t
+read(istream& in)
+{
+	unsigned char bytes[4];
+	if ( !in.read(reinterpret_cast<char*>(bytes), sizeof(bytes)) ) {
+		throw CheckpointError("Truncated checkpoint");
+	}
+	return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 | static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+}
+
+} // namespace
+
+// ------------- CHECKPOINT WRITER -------------
+
+CheckpointWriter::CheckpointWriter(ostream& out)
+    : out_(out)
+{
+	out_.write(Magic, sizeof(Magic));
+	write(out_, Version);
+}
+
+void
+CheckpointWriter::add(uint64_t stream, const GPSService& gps, const NMEAParser* parser, uint64_t offset)
+{
+	const GPSFix&     fix     = gps.fix_;
+	const GPSAlmanac& almanac = fix.almanac_;
+
+	// size, then stream, offset, fix, almanac, parser, then the hash of all that
+	record_.clear();
+	Put put(record_);
+	put.u(stream, 8);
+	put.u(offset, 8);
+
+	put.u(fix.haslock ? 1 : 0, 1);
+	put.u(static_cast<uint8_t>(fix.status_), 1);
+	put.u(fix.type_, 1);
+	put.u(fix.quality_, 1);
+	put.d(fix.dilution_);
+	put.d(fix.horizontalDilution_);
+	put.d(fix.verticalDilution_);
+	put.d(fix.altitude_);
+	put.d(fix.latitude_);
+	put.d(fix.longitude_);
+	put.d(fix.speed_);
+	put.d(fix.travelAngle_);
+	put.i(fix.trackingSatellites_);
+	put.i(fix.visibleSatellites_);
+
+	const GPSTimestamp& stamp = fix.timestamp_;
+	put.i(stamp.hour_);
+	put.i(stamp.min_);
+	put.d(stamp.sec_);
+	put.i(stamp.milliseconds_);
+	put.i(stamp.month_);
+	put.i(stamp.day_);
+	put.i(stamp.year_);
+	put.d(stamp.rawTime_);
+	put.i(stamp.rawDate_);
+
+	put.u(almanac.visibleSize, 4);
+	put.u(almanac.lastPage, 4);
+	put.u(almanac.totalPages, 4);
+	put.u(almanac.processedPages, 4);
+	put.u(almanac.satellites_.size(), 4);
+	for ( const auto& sat: almanac.satellites_ ) {
+		put.d(sat.snr_);
+		put.u(sat.prn_, 4);
+		put.d(sat.elevation_);
+		put.d(sat.azimuth_);
+	}
+
+	put.u(parser != nullptr ? 1 : 0, 1);
+	if ( parser != nullptr ) {
+		put.u(parser->fillingbuffer_ ? 1 : parser->skipping_ ? 2 : 0, 1); // 0 between sentences, 1 in one, 2 skipping one
+		put.u(parser->discarded_, 4);
+		put.bytes(parser->buffer_.data(), parser->buffer_.size());
+	}
+
+	put.u(hashOf(record_.data(), record_.size()), 4);
+	write(out_, static_cast<uint32_t>(record_.size()));
+	out_.write(record_.data(), static_cast<streamsize>(record_.size()));
+}
+
+void
+CheckpointWriter::finish()
+{
+	if ( !finished_ ) {
+		write(out_, End);
+		finished_ = true;
+	}
+	out_.flush();
+}
+
+// ------------- CHECKPOINT READER -------------
+
+CheckpointReader::CheckpointReader(istream& in)
+    : in_(in)
+{
+	char magic[sizeof(Magic)];
+	if ( !in_.read(magic, sizeof(magic)) || !equal(magic, magic + sizeof(magic), Magic) ) {
+		throw CheckpointError("Not a checkpoint");
+	}
+	version_ = read(in_);
+	if ( version_ == 0 || version_ > CheckpointWriter::Version ) {
+		throw CheckpointError("Unsupported checkpoint version");
+	}
+}
+
+bool
+CheckpointReader::next()
+{
+	uint32_t size = read(in_);
+	if ( size == End ) {
+		record_.clear();
+		return false;
+	}
+	if ( size < 20 || size > MaxSize ) {
+		throw CheckpointError("Bad checkpoint record size");
+	}
+
+	record_.resize(size);
+	if ( !in_.read(record_.data(), size) ) {
+		throw CheckpointError("Truncated checkpoint");
+	}
+	Get get(record_.data() + size - 4, 4);
+	if ( get.u(4) != hashOf(record_.data(), size - 4) ) {
+		throw CheckpointError("Damaged checkpoint record");
+	}
+
+	Get head(record_.data(), size);
+	stream_ = head.u(8);
+	offset_ = head.u(8);
+	return true;
+}
+
+uint64_t
+CheckpointReader::stream() const
+{
+	return stream_;
+}
+
+uint64_t
+CheckpointReader::offset() const
+{
+	return offset_;
+}
+
+void
+CheckpointReader::restore(GPSService& gps, NMEAParser* parser) const
+{
+	if ( record_.empty() ) {
+		throw CheckpointError("No checkpoint record to restore");
+	}
+
+	// everything is decoded before anything is changed
+	GPSFix      fix;
+	GPSAlmanac& almanac = fix.almanac_;
+	Get         get(record_.data() + 16, record_.size() - 20);
+
+	fix.haslock             = get.u(1) != 0;
+	fix.status_             = static_cast<char>(get.u(1));
+	fix.type_               = static_cast<uint8_t>(get.u(1));
+	fix.quality_            = static_cast<uint8_t>(get.u(1));
+	fix.dilution_           = get.d();
+	fix.horizontalDilution_ = get.d();
+	fix.verticalDilution_   = get.d();
+	fix.altitude_           = get.d();
+	fix.latitude_           = get.d();
+	fix.longitude_          = get.d();
+	fix.speed_              = get.d();
+	fix.travelAngle_        = get.d();
+	fix.trackingSatellites_ = get.i();
+	fix.visibleSatellites_  = get.i();
+
+	GPSTimestamp& stamp = fix.timestamp_;
+	stamp.hour_         = get.i();
+	stamp.min_          = get.i();
+	stamp.sec_          = get.d();
+	stamp.milliseconds_ = get.i();
+	stamp.month_        = get.i();
+	stamp.day_          = get.i();
+	stamp.year_         = get.i();
+	stamp.rawTime_      = get.d();
+	stamp.rawDate_      = get.i();
+
+	almanac.visibleSize    = static_cast<uint32_t>(get.u(4));
+	almanac.lastPage       = static_cast<uint32_t>(get.u(4));
+	almanac.totalPages     = static_cast<uint32_t>(get.u(4));
+	almanac.processedPages = static_cast<uint32_t>(get.u(4));
+	auto satellites        = static_cast<size_t>(get.u(4));
+	if ( satellites > 255 ) {
+		throw CheckpointError("Bad checkpoint almanac");
+	}
+	almanac.satellites_.reserve(satellites);
+	for ( size_t i = 0; i < satellites; i++ ) {
+		GPSSatellite sat;
+		sat.snr_       = get.d();
+		sat.prn_       = static_cast<uint32_t>(get.u(4));
+		sat.elevation_ = get.d();
+		sat.azimuth_   = get.d();
+		almanac.satellites_.push_back(sat);
+	}
+
+	bool        hasParser = get.u(1) != 0;
+	uint64_t    framing   = 0;
+	uint32_t    discarded = 0;
+	string_view buffer;
+	if ( hasParser ) {
+		framing   = get.u(1);
+		if ( framing > (version_ >= 2 ? 2 : 1) ) {
+			throw CheckpointError("Bad checkpoint parser state");
+		}
+		discarded = static_cast<uint32_t>(get.u(4));
+		buffer    = get.bytes();
+	}
+
+	// the service keeps its clock
+	fix.clock_ = gps.fix_.clock_;
+	gps.fix_   = fix;
+
+	if ( parser != nullptr && hasParser && buffer.size() <= parser->maxbuffersize_ ) {
+		parser->buffer_.assign(buffer.data(), buffer.size());
+		parser->fillingbuffer_ = framing == 1;
+		parser->skipping_      = framing == 2;
+		parser->discarded_     = discarded;
+	}
+	else if ( parser != nullptr ) {
+		parser->buffer_.clear();
+		parser->fillingbuffer_ = false;
+		parser->skipping_      = false;
+		parser->discarded_     = 0;
+	}
+	if ( parser != nullptr ) {
+		parser->nameChecked_  = true; // a sentence cut by the checkpoint is read whole
+		parser->skippedBytes_ = 0;
+	}
+}
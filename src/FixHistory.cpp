@@ -0,0 +1,271 @@
+/*
+ * FixHistory.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/FixHistory.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "nmeaparse/Geodesy.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+static constexpr double       DegToRad = 3.14159265358979323846 / 180.0;
+static constexpr milliseconds Day      = hours(24);
+
+// b - a, the short way around the circle
+static double
+angleDifference(double a, double b)
+{
+	double difference = fmod(b - a, 360.0);
+	if ( difference > 180 ) {
+		difference -= 360;
+	}
+	else if ( difference < -180 ) {
+		difference += 360;
+	}
+	return difference;
+}
+
+static double
+normalizeLongitude(double longitude)
+{
+	return longitude > 180 ? longitude - 360 : longitude < -180 ? longitude + 360 : longitude;
+}
+
+// ------------- FIX RECORD -------------
+
+FixRecord::FixRecord(const GPSFix& fix)
+    : time_(fix.timestamp_.toUTCTime())
+    , latitude_(fix.latitude_)
+    , longitude_(fix.longitude_)
+    , altitude_(fix.altitude_)
+    , speed_(static_cast<float>(fix.speed_))
+    , travelAngle_(static_cast<float>(fix.travelAngle_))
+    , horizontalDilution_(static_cast<float>(fix.horizontalDilution_))
+    , quality_(fix.quality_)
+    , type_(fix.type_)
+    , trackingSatellites_(static_cast<uint8_t>(min(max(fix.trackingSatellites_, 0), 255)))
+    , status_(fix.status_)
+{
+}
+
+// ------------- FIX HISTORY -------------
+
+FixHistory::FixHistory(size_t capacity, pmr::memory_resource* resource)
+    : ring_(resource)
+{
+	if ( capacity == 0 ) {
+		throw invalid_argument("FixHistory capacity must be at least 1");
+	}
+	ring_.resize(capacity);
+}
+
+void
+FixHistory::record(const GPSFix& fix)
+{
+	if ( !fix.locked() || fix.timestamp_.rawDate_ == 0 ) {
+		return;
+	}
+
+	FixRecord latest(fix);
+	while ( size_ != 0 && fix.timestamp_.rawDate_ == rawDate_ && latest.time_ + Day / 2 < back().time_ ) {
+		latest.time_ += Day; // GGA past midnight, before the RMC with the new date
+	}
+	rawDate_ = fix.timestamp_.rawDate_;
+	if ( size_ != 0 && latest.time_ == back().time_ ) {
+		ring_[(start_ + size_ - 1) % ring_.size()] = latest;
+		return;
+	}
+	push(latest);
+}
+
+void
+FixHistory::push(const FixRecord& record)
+{
+	if ( size_ != 0 && record.time_ < back().time_ ) {
+		clear();
+	}
+
+	if ( size_ == ring_.size() ) {
+		ring_[start_] = record;
+		start_        = (start_ + 1) % ring_.size();
+	}
+	else {
+		ring_[(start_ + size_) % ring_.size()] = record;
+		size_++;
+	}
+}
+
+void
+FixHistory::clear()
+{
+	start_ = 0;
+	size_  = 0;
+}
+
+size_t
+FixHistory::size() const
+{
+	return size_;
+}
+
+size_t
+FixHistory::capacity() const
+{
+	return ring_.size();
+}
+
+bool
+FixHistory::empty() const
+{
+	return size_ == 0;
+}
+
+const FixRecord&
+FixHistory::operator[](size_t index) const
+{
+	size_t slot = start_ + index;
+	return ring_[slot < ring_.size() ? slot : slot - ring_.size()];
+}
+
+const FixRecord&
+FixHistory::front() const
+{
+	return (*this)[0];
+}
+
+const FixRecord&
+FixHistory::back() const
+{
+	return (*this)[size_ - 1];
+}
+
+FixHistory::const_iterator
+FixHistory::begin() const
+{
+	return const_iterator(this, 0);
+}
+
+FixHistory::const_iterator
+FixHistory::end() const
+{
+	return const_iterator(this, size_);
+}
+
+size_t
+FixHistory::lowerBound(UTCTime time) const
+{
+	size_t low  = 0;
+	size_t high = size_;
+	while ( low < high ) {
+		size_t middle = low + (high - low) / 2;
+		if ( (*this)[middle].time_ < time ) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+const FixRecord*
+FixHistory::nearest(UTCTime time) const
+{
+	if ( size_ == 0 ) {
+		return nullptr;
+	}
+	size_t after = lowerBound(time);
+	if ( after == size_ ) {
+		return &back();
+	}
+	if ( after == 0 || (*this)[after].time_ - time < time - (*this)[after - 1].time_ ) {
+		return &(*this)[after];
+	}
+	return &(*this)[after - 1];
+}
+
+bool
+FixHistory::positionAt(UTCTime time, FixRecord& out, Interpolation mode) const
+{
+	size_t after = lowerBound(time);
+	if ( after == size_ || (after == 0 && (*this)[0].time_ != time) ) {
+		return false;
+	}
+
+	const FixRecord& next = (*this)[after];
+	if ( next.time_ == time ) {
+		out = next;
+		return true;
+	}
+	const FixRecord& previous = (*this)[after - 1];
+
+	double span      = duration<double>(next.time_ - previous.time_).count(); // seconds
+	double s         = duration<double>(time - previous.time_).count() / span;
+	double longDelta = angleDifference(previous.longitude_, next.longitude_);
+
+	FixRecord result = previous;
+	result.time_     = time;
+	result.altitude_ = previous.altitude_ + s * (next.altitude_ - previous.altitude_);
+	result.speed_    = static_cast<float>(static_cast<double>(previous.speed_) + s * static_cast<double>(next.speed_ - previous.speed_));
+	result.travelAngle_
+	    = static_cast<float>(fmod(static_cast<double>(previous.travelAngle_) + s * angleDifference(previous.travelAngle_, next.travelAngle_) + 360.0, 360.0));
+
+	if ( mode == Hermite ) {
+		// tangents in degrees over the whole span, from speed and course
+		auto tangents = [span](const FixRecord& record, double& latitude, double& longitude) {
+			double metersPerSecond = static_cast<double>(record.speed_) / 3.6;
+			double course          = static_cast<double>(record.travelAngle_) * DegToRad;
+			double cosLatitude     = cos(record.latitude_ * DegToRad);
+			latitude               = metersPerSecond * cos(course) * span / EarthMeanRadius / DegToRad;
+			longitude              = cosLatitude > 1e-9 ? metersPerSecond * sin(course) * span / (EarthMeanRadius * cosLatitude) / DegToRad : 0;
+		};
+		double latitude0  = 0;
+		double longitude0 = 0;
+		double latitude1  = 0;
+		double longitude1 = 0;
+		tangents(previous, latitude0, longitude0);
+		tangents(next, latitude1, longitude1);
+
+		double s2  = s * s;
+		double s3  = s2 * s;
+		double h00 = 2 * s3 - 3 * s2 + 1;
+		double h10 = s3 - 2 * s2 + s;
+		double h01 = -2 * s3 + 3 * s2;
+		double h11 = s3 - s2;
+
+		result.latitude_  = h00 * previous.latitude_ + h10 * latitude0 + h01 * next.latitude_ + h11 * latitude1;
+		result.longitude_ = normalizeLongitude(previous.longitude_ + h10 * longitude0 + h01 * longDelta + h11 * longitude1);
+	}
+	else {
+		result.latitude_  = previous.latitude_ + s * (next.latitude_ - previous.latitude_);
+		result.longitude_ = normalizeLongitude(previous.longitude_ + s * longDelta);
+	}
+
+	out = result;
+	return true;
+}
+
+FixHistory::Window
+FixHistory::window(UTCTime from, UTCTime to) const
+{
+	size_t first = lowerBound(from);
+	size_t last  = to < from ? first : lowerBound(to + milliseconds(1));
+	return Window(const_iterator(this, first), const_iterator(this, last));
+}
+
+size_t
+FixHistory::memoryUsage() const
+{
+	return ring_.capacity() * sizeof(FixRecord);
+}
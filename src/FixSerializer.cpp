@@ -0,0 +1,477 @@
+/*
+ * FixSerializer.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/FixSerializer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <system_error>
+
+using namespace std;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+static constexpr size_t MaxNumberSize = 48;   // sign, 17 digits, point and up to 17 decimals, or exponent form
+static constexpr size_t MaxFixSize    = 1024; // all fields of a fix with their names
+
+struct FieldName {
+	string_view json; // "\"time\":"
+	string_view csv;  // "time"
+};
+
+// in Field bit order
+static constexpr size_t FieldCount = 15;
+
+static const FieldName fieldNames[FieldCount] = {
+	{ "\"time\":", "time" },
+	{ "\"status\":", "status" },
+	{ "\"lock\":", "lock" },
+	{ "\"type\":", "type" },
+	{ "\"quality\":", "quality" },
+	{ "\"lat\":", "lat" },
+	{ "\"lon\":", "lon" },
+	{ "\"alt\":", "alt" },
+	{ "\"speed\":", "speed" },
+	{ "\"course\":", "course" },
+	{ "\"pdop\":", "pdop" },
+	{ "\"hdop\":", "hdop" },
+	{ "\"vdop\":", "vdop" },
+	{ "\"tracking\":", "tracking" },
+	{ "\"visible\":", "visible" },
+};
+
+static char*
+copyText(char* out, string_view text)
+{
+	memcpy(out, text.data(), text.size());
+	return out + text.size();
+}
+
+static char*
+integer(char* out, int64_t value)
+{
+	return to_chars(out, out + MaxNumberSize, value).ptr;
+}
+
+static constexpr double MaxExactInteger = 9007199254740992.0; // 2^53
+
+static const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17 };
+
+static char*
+digits(char* out, int64_t value, int width)
+{
+	for ( int i = width - 1; i >= 0; i-- ) {
+		out[i] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	}
+	return out + width;
+}
+
+// scaled / 10^decimals as a decimal number
+static char*
+fixedPoint(char* out, uint64_t scaled, int decimals, bool negative)
+{
+	auto scale = static_cast<uint64_t>(powersOf10[decimals]);
+	if ( negative && scaled != 0 ) {
+		*out++ = '-';
+	}
+	out = to_chars(out, out + MaxNumberSize, scaled / scale).ptr;
+	if ( decimals > 0 ) {
+		*out++ = '.';
+		out    = digits(out, static_cast<int64_t>(scaled % scale), decimals);
+	}
+	return out;
+}
+
+// 2011-05-28T09:27:50.000Z, straight from the fields, no calendar math needed
+static char*
+isoTime(char* out, const GPSTimestamp& ts)
+{
+	auto field = [](int32_t value, int32_t limit) { return static_cast<int64_t>(min(max(value, 0), limit)); };
+
+	out    = digits(out, field(ts.year_, 9999), 4);
+	*out++ = '-';
+	out    = digits(out, field(ts.month_, 99), 2);
+	*out++ = '-';
+	out    = digits(out, field(ts.day_, 99), 2);
+	*out++ = 'T';
+	out    = digits(out, field(ts.hour_, 99), 2);
+	*out++ = ':';
+	out    = digits(out, field(ts.min_, 99), 2);
+	*out++ = ':';
+	out    = digits(out, field(ts.milliseconds_ / 1000, 99), 2);
+	*out++ = '.';
+	out    = digits(out, field(ts.milliseconds_ % 1000, 999), 3);
+	*out++ = 'Z';
+	return out;
+}
+
+// ------------- FIXSERIALIZER CLASS -------------
+
+FixSerializer::FixSerializer(FILE* file, FixSerializerSettings settings)
+    : FixSerializer(
+          [file](const char* data, size_t size) {
+	          if ( fwrite(data, 1, size, file) != size ) {
+		          throw system_error(errno, generic_category(), "FixSerializer: write failed");
+	          }
+          },
+          std::move(settings))
+{
+}
+
+FixSerializer::FixSerializer(Sink sink, FixSerializerSettings settings)
+    : sink_(std::move(sink))
+    , settings_(std::move(settings))
+{
+	if ( settings_.fields == 0 ) {
+		settings_.fields = AllFields;
+	}
+	settings_.coordinatePrecision = min(settings_.coordinatePrecision, 17);
+	settings_.valuePrecision      = min(settings_.valuePrecision, 17);
+
+	buffer_.resize(max(settings_.bufferSize, MaxFixSize));
+	pos_ = buffer_.data();
+	end_ = buffer_.data() + buffer_.size();
+}
+
+FixSerializer::~FixSerializer()
+{
+	try {
+		flush();
+	}
+	catch ( ... ) {
+		// nowhere to report it
+	}
+}
+
+void
+FixSerializer::flush()
+{
+	if ( pos_ != buffer_.data() ) {
+		sink_(buffer_.data(), static_cast<size_t>(pos_ - buffer_.data()));
+		pos_ = buffer_.data();
+	}
+}
+
+char*
+FixSerializer::reserve(size_t size)
+{
+	if ( static_cast<size_t>(end_ - pos_) < size ) {
+		flush();
+		if ( buffer_.size() < size ) { // only for huge sentences
+			buffer_.resize(size);
+			pos_ = buffer_.data();
+			end_ = buffer_.data() + buffer_.size();
+		}
+	}
+	return pos_;
+}
+
+void
+FixSerializer::put(string_view text)
+{
+	pos_ = copyText(reserve(text.size()), text);
+}
+
+void
+FixSerializer::putString(string_view text)
+{
+	static constexpr const char* HexDigits = "0123456789abcdef";
+
+	char* out = reserve(text.size() * 6 + 2);
+	*out++    = '"';
+	if ( settings_.format == SerialFormat::CSV ) {
+		for ( auto chr: text ) {
+			if ( chr == '"' ) {
+				*out++ = '"';
+			}
+			*out++ = chr;
+		}
+	}
+	else {
+		for ( auto chr: text ) {
+			auto byte = static_cast<uint8_t>(chr);
+			if ( chr == '"' || chr == '\\' ) {
+				*out++ = '\\';
+				*out++ = chr;
+			}
+			else if ( byte < 0x20 ) {
+				out    = copyText(out, "\\u00");
+				*out++ = HexDigits[byte >> 4];
+				*out++ = HexDigits[byte & 0xF];
+			}
+			else {
+				*out++ = chr;
+			}
+		}
+	}
+	*out++ = '"';
+	pos_   = out;
+}
+
+void
+FixSerializer::endRecord()
+{
+	put("\n");
+	records_++;
+}
+
+char*
+FixSerializer::number(char* out, double value, int precision) const
+{
+	if ( !isfinite(value) ) {
+		return settings_.format == SerialFormat::JSONLines ? copyText(out, "null") : out;
+	}
+
+	// Fixes hold short decimals like 53.36155 or 1.5, to_chars(double) is slow for what they need.
+	// Integers and powers of ten below 2^53 are exact doubles, so their quotient is the correctly
+	// rounded value of the decimal (the strtod fast path): if it equals value, the decimal reads back
+	// exactly. The first number of decimals that does is the shortest such text. Beyond 9 decimals
+	// the value is most likely a computed one with 17 digits anyway, leave that to to_chars.
+	double magnitude = fabs(value);
+	if ( precision >= 0 ) {
+		double scaled = round(magnitude * powersOf10[precision]);
+		if ( scaled < MaxExactInteger ) {
+			return fixedPoint(out, static_cast<uint64_t>(scaled), precision, value < 0);
+		}
+		auto result = to_chars(out, out + MaxNumberSize, value, chars_format::fixed, precision);
+		if ( result.ec == errc() ) {
+			return result.ptr;
+		}
+		// too long written out, like 1e300: the same decimals with an exponent fit
+		return to_chars(out, out + MaxNumberSize, value, chars_format::scientific, precision).ptr;
+	}
+	for ( int decimals = 0; decimals <= 9; decimals++ ) {
+		double scaled = round(magnitude * powersOf10[decimals]);
+		if ( scaled >= MaxExactInteger ) {
+			break;
+		}
+		if ( scaled / powersOf10[decimals] == magnitude ) {
+			return fixedPoint(out, static_cast<uint64_t>(scaled), decimals, value < 0);
+		}
+	}
+	return to_chars(out, out + MaxNumberSize, value).ptr; // shortest text that reads back as the same double
+}
+
+void
+FixSerializer::writeHeader(Record kind)
+{
+	if ( settings_.format != SerialFormat::CSV ) {
+		return;
+	}
+
+	switch ( kind ) {
+	case FixRecord: {
+		bool first = true;
+		for ( size_t i = 0; i < FieldCount; i++ ) {
+			if ( (settings_.fields & (1U << i)) != 0 ) {
+				put(first ? "" : ",");
+				put(fieldNames[i].csv);
+				first = false;
+			}
+		}
+		break;
+	}
+	case SatelliteRecord:
+		put("prn,elevation,azimuth,snr");
+		break;
+	case SentenceRecord:
+		put("name,checksum_ok,text");
+		break;
+	}
+	put("\n");
+}
+
+void
+FixSerializer::write(const GPSFix& fix)
+{
+	const bool json   = settings_.format == SerialFormat::JSONLines;
+	const int  coords = settings_.coordinatePrecision;
+	const int  values = settings_.valuePrecision;
+
+	char* out   = reserve(MaxFixSize);
+	char* start = out;
+	if ( json ) {
+		*out++ = '{';
+	}
+
+	for ( size_t i = 0; i < FieldCount; i++ ) {
+		auto field = static_cast<Field>(1U << i);
+		if ( (settings_.fields & field) == 0 ) {
+			continue;
+		}
+		if ( out != start + (json ? 1 : 0) ) {
+			*out++ = ',';
+		}
+		if ( json ) {
+			out = copyText(out, fieldNames[i].json);
+		}
+
+		switch ( field ) {
+		case Time:
+			if ( json ) {
+				*out++ = '"';
+				out    = isoTime(out, fix.timestamp_);
+				*out++ = '"';
+			}
+			else {
+				out = isoTime(out, fix.timestamp_);
+			}
+			break;
+		case Status: {
+			char status = isalnum(static_cast<unsigned char>(fix.status_)) != 0 ? fix.status_ : '?'; // straight from the sentence
+			if ( json ) {
+				*out++ = '"';
+				*out++ = status;
+				*out++ = '"';
+			}
+			else {
+				*out++ = status;
+			}
+			break;
+		}
+		case Lock:
+			out = json ? copyText(out, fix.locked() ? "true" : "false") : copyText(out, fix.locked() ? "1" : "0");
+			break;
+		case Type:
+			out = integer(out, fix.type_);
+			break;
+		case Quality:
+			out = integer(out, fix.quality_);
+			break;
+		case Latitude:
+			out = number(out, fix.latitude_, coords);
+			break;
+		case Longitude:
+			out = number(out, fix.longitude_, coords);
+			break;
+		case Altitude:
+			out = number(out, fix.altitude_, values);
+			break;
+		case Speed:
+			out = number(out, fix.speed_, values);
+			break;
+		case Course:
+			out = number(out, fix.travelAngle_, values);
+			break;
+		case PDOP:
+			out = number(out, fix.dilution_, values);
+			break;
+		case HDOP:
+			out = number(out, fix.horizontalDilution_, values);
+			break;
+		case VDOP:
+			out = number(out, fix.verticalDilution_, values);
+			break;
+		case Tracking:
+			out = integer(out, fix.trackingSatellites_);
+			break;
+		case Visible:
+			out = integer(out, fix.visibleSatellites_);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if ( json ) {
+		*out++ = '}';
+	}
+	pos_ = out;
+	endRecord();
+}
+
+void
+FixSerializer::write(const GPSAlmanac& almanac)
+{
+	const bool json   = settings_.format == SerialFormat::JSONLines;
+	const int  values = settings_.valuePrecision;
+
+	if ( json ) {
+		put("{\"satellites\":[");
+	}
+	bool first = true;
+	for ( const auto& sat: almanac.satellites_ ) {
+		char* out = reserve(128 + 4 * MaxNumberSize);
+		if ( json ) {
+			out    = copyText(out, first ? "{\"prn\":" : ",{\"prn\":");
+			out    = integer(out, sat.prn_);
+			out    = copyText(out, ",\"elevation\":");
+			out    = number(out, sat.elevation_, values);
+			out    = copyText(out, ",\"azimuth\":");
+			out    = number(out, sat.azimuth_, values);
+			out    = copyText(out, ",\"snr\":");
+			out    = number(out, sat.snr_, values);
+			*out++ = '}';
+			pos_   = out;
+		}
+		else {
+			out    = integer(out, sat.prn_);
+			*out++ = ',';
+			out    = number(out, sat.elevation_, values);
+			*out++ = ',';
+			out    = number(out, sat.azimuth_, values);
+			*out++ = ',';
+			out    = number(out, sat.snr_, values);
+			pos_   = out;
+			endRecord(); // a row per satellite
+		}
+		first = false;
+	}
+	if ( json ) {
+		put("]}");
+		endRecord();
+	}
+}
+
+void
+FixSerializer::write(const NMEASentence& sentence)
+{
+	const bool json = settings_.format == SerialFormat::JSONLines;
+
+	if ( json ) {
+		put("{\"name\":");
+		putString(sentence.name_);
+		put(sentence.checksumOK() ? ",\"checksum_ok\":true,\"parameters\":[" : ",\"checksum_ok\":false,\"parameters\":[");
+		for ( size_t i = 0; i < sentence.parameters_.size(); i++ ) {
+			if ( i != 0 ) {
+				put(",");
+			}
+			putString(sentence.parameters_[i]);
+		}
+		put("]}");
+	}
+	else {
+		putString(sentence.name_);
+		put(sentence.checksumOK() ? ",1," : ",0,");
+		putString(sentence.text_);
+	}
+	endRecord();
+}
+
+const FixSerializerSettings&
+FixSerializer::settings() const
+{
+	return settings_;
+}
+
+uint64_t
+FixSerializer::records() const
+{
+	return records_;
+}
+
+size_t
+FixSerializer::buffered() const
+{
+	return static_cast<size_t>(pos_ - buffer_.data());
+}
@@ -0,0 +1,135 @@
+/*
+ * FixedGPSService.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/FixedGPSService.hpp"
+
+#include "nmeaparse/GPSSentenceDecoder.hpp"
+
+using namespace std;
+
+using namespace nmea;
+
+// ------------- FIXEDGPSSERVICE CLASS -------------
+
+FixedGPSService::FixedGPSService(FixedNMEAParser& parser)
+{
+#ifndef NEMATODE_EMBEDDED
+	fix_.almanac_.satellites_.reserve(MaxSatellites); // the only allocation, SatelliteList is inline in the embedded build
+#endif
+	attachToParser(parser);
+}
+
+bool
+FixedGPSService::attachToParser(FixedNMEAParser& parser)
+{
+	bool attached = true;
+	attached      = parser.setSentenceHandler("PSRF150", &FixedGPSService::read_PSRF150, this) && attached;
+	attached      = parser.setSentenceHandler("GPGGA", &FixedGPSService::read_GPGGA, this) && attached;
+	attached      = parser.setSentenceHandler("GPGSA", &FixedGPSService::read_GPGSA, this) && attached;
+	attached      = parser.setSentenceHandler("GPGSV", &FixedGPSService::read_GPGSV, this) && attached;
+	attached      = parser.setSentenceHandler("GPRMC", &FixedGPSService::read_GPRMC, this) && attached;
+	attached      = parser.setSentenceHandler("GPVTG", &FixedGPSService::read_GPVTG, this) && attached;
+	return attached;
+}
+
+void
+FixedGPSService::setUpdateHandler(UpdateHandler handler, void* context)
+{
+	onUpdate_      = handler;
+	updateContext_ = context;
+}
+
+void
+FixedGPSService::setLockStateHandler(LockHandler handler, void* context)
+{
+	onLockStateChanged_ = handler;
+	lockContext_        = context;
+}
+
+size_t
+FixedGPSService::memoryUsage() const
+{
+#ifdef NEMATODE_EMBEDDED
+	return sizeof(*this);
+#else
+	return sizeof(*this) + fix_.almanac_.satellites_.capacity() * sizeof(GPSSatellite);
+#endif
+}
+
+void
+FixedGPSService::update(bool lockupdate)
+{
+	if ( lockupdate && onLockStateChanged_ != nullptr ) {
+		onLockStateChanged_(lockContext_, fix_.haslock);
+	}
+	if ( onUpdate_ != nullptr ) {
+		onUpdate_(updateContext_, fix_);
+	}
+}
+
+ParseStatus
+FixedGPSService::read_PSRF150(void* /*unused*/, const SentenceView& /*unused*/)
+{
+	return ParseStatus::Ok; // "ok to send", nothing to read
+}
+
+ParseStatus
+FixedGPSService::read_GPGGA(void* service, const SentenceView& nmea)
+{
+	auto&       self       = *static_cast<FixedGPSService*>(service);
+	bool        lockupdate = false;
+	ParseStatus status     = GPSSentenceDecoder::readGGA(nmea, self.fix_, lockupdate);
+	if ( status == ParseStatus::Ok ) {
+		self.update(lockupdate);
+	}
+	return status;
+}
+
+ParseStatus
+FixedGPSService::read_GPGSA(void* service, const SentenceView& nmea)
+{
+	auto&       self       = *static_cast<FixedGPSService*>(service);
+	bool        lockupdate = false;
+	ParseStatus status     = GPSSentenceDecoder::readGSA(nmea, self.fix_, lockupdate);
+	if ( status == ParseStatus::Ok ) {
+		self.update(lockupdate);
+	}
+	return status;
+}
+
+ParseStatus
+FixedGPSService::read_GPGSV(void* service, const SentenceView& nmea)
+{
+	auto&       self   = *static_cast<FixedGPSService*>(service);
+	ParseStatus status = GPSSentenceDecoder::readGSV(nmea, self.fix_, MaxSatellites); // never grow past what the constructor reserved
+	if ( status == ParseStatus::Ok ) {
+		self.update(false);
+	}
+	return status;
+}
+
+ParseStatus
+FixedGPSService::read_GPRMC(void* service, const SentenceView& nmea)
+{
+	auto&       self       = *static_cast<FixedGPSService*>(service);
+	bool        lockupdate = false;
+	ParseStatus status     = GPSSentenceDecoder::readRMC(nmea, self.fix_, lockupdate);
+	if ( status == ParseStatus::Ok ) {
+		self.update(lockupdate);
+	}
+	return status;
+}
+
+ParseStatus
+FixedGPSService::read_GPVTG(void* service, const SentenceView& nmea)
+{
+	auto&       self   = *static_cast<FixedGPSService*>(service);
+	ParseStatus status = GPSSentenceDecoder::readVTG(nmea, self.fix_);
+	if ( status == ParseStatus::Ok ) {
+		self.update(false);
+	}
+	return status;
+}
@@ -0,0 +1,161 @@
+/*
+ * FixedNMEAParser.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/FixedNMEAParser.hpp"
+
+#include "nmeaparse/SentenceKey.hpp"
+
+using namespace std;
+
+using namespace nmea;
+
+// ------------- FIXEDNMEAPARSER CLASS -------------
+
+bool
+FixedNMEAParser::setSentenceHandler(string_view name, Handler handler, void* context)
+{
+	uint64_t key = sentenceKey(name);
+	if ( key == 0 ) {
+		return false;
+	}
+
+	for ( size_t i = 0; i < handlerCount_; i++ ) {
+		if ( handlers_[i].key == key ) {
+			handlers_[i].handler = handler;
+			handlers_[i].context = context;
+			return true;
+		}
+	}
+	if ( handlerCount_ == MaxHandlers ) {
+		return false;
+	}
+	handlers_[handlerCount_++] = HandlerEntry{ key, handler, context };
+	return true;
+}
+
+void
+FixedNMEAParser::setAnySentenceHandler(Handler handler, void* context)
+{
+	anySentence_ = HandlerEntry{ 0, handler, context };
+}
+
+void
+FixedNMEAParser::setErrorHandler(ErrorHandler handler, void* context)
+{
+	onError_      = handler;
+	errorContext_ = context;
+}
+
+ParseStatus
+FixedNMEAParser::fail(ParseStatus status)
+{
+	errors_++;
+	if ( onError_ != nullptr ) {
+		onError_(errorContext_, status, sentence_);
+	}
+	return status;
+}
+
+ParseStatus
+FixedNMEAParser::dispatch(string_view line)
+{
+	ParseStatus status = parseSentenceView(line, sentence_);
+	if ( status != ParseStatus::Ok ) {
+		return fail(status);
+	}
+	sentences_++;
+
+	if ( anySentence_.handler != nullptr ) {
+		status = anySentence_.handler(anySentence_.context, sentence_);
+		if ( status != ParseStatus::Ok ) {
+			return fail(status);
+		}
+	}
+
+	uint64_t key = sentenceKey(sentence_.name_);
+	for ( size_t i = 0; key != 0 && i < handlerCount_; i++ ) {
+		if ( handlers_[i].key == key ) {
+			if ( handlers_[i].handler == nullptr ) {
+				break;
+			}
+			status = handlers_[i].handler(handlers_[i].context, sentence_);
+			return status == ParseStatus::Ok ? status : fail(status);
+		}
+	}
+	return ParseStatus::Ok; // no handler for this one
+}
+
+ParseStatus
+FixedNMEAParser::readByte(uint8_t byte)
+{
+	switch ( framer_.push(byte) ) {
+	case Framer::Complete:
+		return dispatch(framer_.line());
+	case Framer::Overflow:
+		sentence_ = SentenceView();
+		return fail(ParseStatus::Overflow);
+	default:
+		return ParseStatus::Pending;
+	}
+}
+
+ParseStatus
+FixedNMEAParser::readBuffer(const uint8_t* ptr, size_t size)
+{
+	ParseStatus result = ParseStatus::Ok;
+	for ( size_t i = 0; i < size; i++ ) {
+		ParseStatus status = readByte(ptr[i]);
+		if ( status != ParseStatus::Ok && status != ParseStatus::Pending ) {
+			result = status;
+		}
+	}
+	return result;
+}
+
+ParseStatus
+FixedNMEAParser::readSentence(string_view line)
+{
+	framer_.reset();
+	if ( line.find_first_of("$!") == string_view::npos ) {
+		sentence_ = SentenceView();
+		return fail(ParseStatus::Empty);
+	}
+
+	ParseStatus status = ParseStatus::Pending;
+	for ( auto chr: line ) {
+		if ( chr != '\n' ) {
+			status = readByte(static_cast<uint8_t>(chr));
+		}
+		if ( status == ParseStatus::Overflow ) {
+			return status;
+		}
+	}
+	return readByte('\n');
+}
+
+uint32_t
+FixedNMEAParser::sentences() const
+{
+	return sentences_;
+}
+
+uint32_t
+FixedNMEAParser::errors() const
+{
+	return errors_;
+}
+
+uint32_t
+FixedNMEAParser::overflows() const
+{
+	return framer_.overflows();
+}
+
+size_t
+FixedNMEAParser::memoryUsage() const
+{
+	return sizeof(*this);
+}
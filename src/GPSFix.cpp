@@ -166,30 +166,42 @@ GPSTimestamp::monthName(uint32_t index)
 	return names.at(index - 1);
 };
 
+UTCTime
+nmea::systemUTCNow()
+{
+	return time_point_cast<milliseconds>(system_clock::now());
+}
+
 // Returns seconds since Jan 1, 1970. Classic Epoch time.
 time_t
 GPSTimestamp::getTime() const
 {
-	struct tm time {};
-
-	time.tm_year = year_ - 1900; // This is year-1900, so 112 = 2012
-	time.tm_mon  = month_;       // month from 0:Jan
-	time.tm_mday = day_;
-	time.tm_hour = hour_;
-	time.tm_min  = min_;
-	time.tm_sec  = (int) sec_;
+	return static_cast<time_t>(duration_cast<seconds>(toUTCTime().time_since_epoch()).count());
+}
 
-	return mktime(&time);
+// Integer only days-from-civil conversion. Unlike mktime() this is always UTC,
+// never touches the process timezone state and is safe to call from any thread.
+UTCTime
+GPSTimestamp::toUTCTime() const
+{
+	int64_t days = daysFromCivil(year_, static_cast<uint32_t>(month_), static_cast<uint32_t>(day_));
+	int64_t msec = ((days * 24 + hour_) * 60 + min_) * 60000 + milliseconds_;
+	return UTCTime(milliseconds(msec));
 }
 
+// hhmmss.sss
 void
 GPSTimestamp::setTime(double raw_ts)
 {
 	rawTime_ = raw_ts;
 
-	hour_ = (int32_t) trunc(raw_ts / 10000.0);
-	min_  = (int32_t) trunc((raw_ts - hour_ * 10000) / 100.0);
-	sec_  = raw_ts - min_ * 100 - hour_ * 10000;
+	// work in whole milliseconds so the fraction doesn't pick up float noise
+	int64_t raw = llround(raw_ts * 1000.0);
+
+	hour_         = (int32_t) (raw / 10000000);
+	min_          = (int32_t) (raw / 100000 % 100);
+	milliseconds_ = (int32_t) (raw % 100000);
+	sec_          = milliseconds_ / 1000.0;
 }
 
 // ddmmyy
@@ -227,19 +239,13 @@ GPSTimestamp::toString() const
 seconds
 GPSFix::timeSinceLastUpdate() const
 {
-	time_t    now = time(NULL);
-	struct tm time {};
-
-	time.tm_hour = timestamp_.hour_;
-	time.tm_min  = timestamp_.min_;
-	time.tm_sec  = (int) timestamp_.sec_;
-	time.tm_year = timestamp_.year_ - 1900;
-	time.tm_mon  = timestamp_.month_ - 1;
-	time.tm_mday = timestamp_.day_;
-
-	time_t then = mktime(&time);
-	auto   secs = (uint64_t) difftime(now, then);
-	return seconds(secs);
+	return timeSinceLastUpdate(clock_());
+}
+
+seconds
+GPSFix::timeSinceLastUpdate(UTCTime now) const
+{
+	return duration_cast<seconds>(now - timestamp_.toUTCTime());
 }
 
 bool
@@ -0,0 +1,201 @@
+/*
+ * GPSFixEncoder.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/GPSFixEncoder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+static constexpr double KilometersPerKnot = 1.852; // same factor GPSService converts with
+
+// Knots from the km/h as VTG carries them (0.01), so RMC and VTG agree after reading them back
+static double
+knots(double kilometersPerHour)
+{
+	return round(kilometersPerHour * 100.0) / 100.0 / KilometersPerKnot;
+}
+
+// Whole number for the integer satellite fields, which GPSService reads back with parseInt
+static int
+roundInt(double value)
+{
+	return static_cast<int>(lround(value));
+}
+
+// ------------- GPSFIXENCODER CLASS -------------
+
+GPSFixEncoder::GPSFixEncoder(const string& talker, int coordinateDecimals)
+    : coordinateDecimals_(min(max(coordinateDecimals, 0), 7))
+{
+	static const char* names[] = { "GGA", "GLL", "GSA", "GSV", "RMC", "VTG" };
+	for ( size_t id = 0; id < prefixes_.size(); id++ ) {
+		Prefix&        prefix = prefixes_[id];
+		SentenceWriter writer(prefix.text, sizeof(prefix.text));
+		writer.start(talker.substr(0, 2)).append(names[id]);
+		prefix.size     = writer.size();
+		prefix.checksum = writer.checksum();
+	}
+}
+
+void
+GPSFixEncoder::start(SentenceWriter& writer, NMEASentence::MessageID id) const
+{
+	const Prefix& prefix = prefixes_[static_cast<size_t>(id)];
+	writer.resume(string_view(prefix.text, prefix.size), prefix.checksum);
+}
+
+// hhmmss.sss
+void
+GPSFixEncoder::time(SentenceWriter& writer, const GPSTimestamp& timestamp)
+{
+	auto hhmmss = static_cast<uint64_t>(timestamp.hour_ * 10000 + timestamp.min_ * 100 + timestamp.milliseconds_ / 1000);
+	writer.field(static_cast<int64_t>(hhmmss), 6).append(".").appendDigits(static_cast<uint64_t>(timestamp.milliseconds_ % 1000), 3);
+}
+
+uint32_t
+GPSFixEncoder::gsvPages(const GPSFix& fix)
+{
+	auto pages = static_cast<uint32_t>((fix.almanac_.satellites_.size() + 3) / 4);
+	return min<uint32_t>(max<uint32_t>(pages, 1), MaxGSVPages);
+}
+
+size_t
+GPSFixEncoder::gsvDropped(const GPSFix& fix)
+{
+	size_t satellites = fix.almanac_.satellites_.size();
+	return satellites > MaxGSVSatellites ? satellites - MaxGSVSatellites : 0;
+}
+
+size_t
+GPSFixEncoder::encodeGGA(const GPSFix& fix, char* out, size_t size) const
+{
+	SentenceWriter w(out, size);
+	start(w, NMEASentence::GGA);
+	time(w, fix.timestamp_);
+	w.latitude(fix.latitude_, coordinateDecimals_).longitude(fix.longitude_, coordinateDecimals_);
+	w.field(static_cast<int>(fix.quality_)).field(fix.trackingSatellites_, 2);
+	w.field(fix.horizontalDilution_, 1);
+	w.field(fix.altitude_, 1).append(",M,,M,,"); // no geoid separation or DGPS data in a GPSFix
+	return w.finish();
+}
+
+size_t
+GPSFixEncoder::encodeGSA(const GPSFix& fix, char* out, size_t size) const
+{
+	SentenceWriter w(out, size);
+	start(w, NMEASentence::GSA);
+	w.field('A').field(static_cast<int>(fix.type_));
+
+	// Satellites with a signal are taken as the ones used for the fix
+	int listed = 0;
+	for ( const auto& sat: fix.almanac_.satellites_ ) {
+		if ( listed < 12 && sat.snr_ > 0 ) {
+			w.field(sat.prn_, 2);
+			listed++;
+		}
+	}
+	for ( ; listed < 12; listed++ ) {
+		w.field();
+	}
+
+	w.field(fix.dilution_, 1).field(fix.horizontalDilution_, 1).field(fix.verticalDilution_, 1);
+	return w.finish();
+}
+
+size_t
+GPSFixEncoder::encodeGSV(const GPSFix& fix, uint32_t page, char* out, size_t size) const
+{
+	const auto& sats  = fix.almanac_.satellites_;
+	uint32_t    pages = gsvPages(fix);
+	if ( page < 1 || page > pages ) {
+		return 0;
+	}
+
+	SentenceWriter w(out, size);
+	start(w, NMEASentence::GSV);
+	w.field(pages).field(page).field(fix.visibleSatellites_, 2);
+	for ( size_t i = (page - 1) * 4; i < page * 4 && i < sats.size(); i++ ) {
+		const GPSSatellite& sat = sats[i];
+		w.field(sat.prn_, 2).field(roundInt(sat.elevation_), 2).field(roundInt(sat.azimuth_), 3);
+		if ( roundInt(sat.snr_) > 0 ) {
+			w.field(roundInt(sat.snr_), 2);
+		}
+		else {
+			w.field(); // not tracked
+		}
+	}
+	return w.finish();
+}
+
+size_t
+GPSFixEncoder::encodeRMC(const GPSFix& fix, char* out, size_t size) const
+{
+	const GPSTimestamp& ts = fix.timestamp_;
+
+	SentenceWriter w(out, size);
+	start(w, NMEASentence::RMC);
+	time(w, ts);
+	w.field(fix.status_);
+	w.latitude(fix.latitude_, coordinateDecimals_).longitude(fix.longitude_, coordinateDecimals_);
+	w.field(knots(fix.speed_), 2).field(fix.travelAngle_, 2);
+	if ( ts.rawDate_ != 0 ) {
+		w.field(static_cast<int64_t>(ts.day_ * 10000 + ts.month_ * 100 + ts.year_ % 100), 6);
+	}
+	else {
+		w.field(); // no date received yet, reads back as the same "unset" date
+	}
+	w.append(",,,").append(fix.status_ == 'A' ? "A" : "N"); // no magnetic variation, mode
+	return w.finish();
+}
+
+size_t
+GPSFixEncoder::encodeVTG(const GPSFix& fix, char* out, size_t size) const
+{
+	SentenceWriter w(out, size);
+	start(w, NMEASentence::VTG);
+	w.field(fix.travelAngle_, 2).append(",T,,M");
+	w.field(knots(fix.speed_), 2).append(",N");
+	w.field(fix.speed_, 2).append(",K");
+	w.append(fix.status_ == 'A' ? ",A" : ",N");
+	return w.finish();
+}
+
+size_t
+GPSFixEncoder::encode(const GPSFix& fix, char* out, size_t size, uint32_t sentences)
+{
+	size_t used = 0;
+	bool   fits = true;
+	auto   add  = [&](size_t len) {
+		fits = fits && len != 0;
+		used += len;
+	};
+
+	if ( (sentences & (1U << NMEASentence::GGA)) != 0 ) {
+		add(encodeGGA(fix, out, size));
+	}
+	if ( fits && (sentences & (1U << NMEASentence::GSA)) != 0 ) {
+		add(encodeGSA(fix, out + used, size - used));
+	}
+	if ( (sentences & (1U << NMEASentence::GSV)) != 0 ) {
+		for ( uint32_t page = 1, pages = gsvPages(fix); fits && page <= pages; page++ ) {
+			add(encodeGSV(fix, page, out + used, size - used));
+		}
+		truncatedFixes_ += fits && gsvDropped(fix) != 0 ? 1 : 0;
+	}
+	if ( fits && (sentences & (1U << NMEASentence::RMC)) != 0 ) {
+		add(encodeRMC(fix, out + used, size - used));
+	}
+	if ( fits && (sentences & (1U << NMEASentence::VTG)) != 0 ) {
+		add(encodeVTG(fix, out + used, size - used));
+	}
+	return fits ? used : 0;
+}
@@ -9,10 +9,13 @@
 
 #include "nmeaparse/GPSService.hpp"
 
-#include <cmath>
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
-#include "nmeaparse/NumberConversion.hpp"
+#include "nmeaparse/GPSSentenceDecoder.hpp"
+#include "nmeaparse/Metrics.hpp"
+#include "nmeaparse/StreamDemultiplexer.hpp"
 
 using namespace std;
 using namespace std::chrono;
@@ -20,40 +23,63 @@ using namespace std::chrono;
 using namespace nmea;
 
 // ------ Some helpers ----------
-// Takes the NMEA lat/long format (dddmm.mmmm, [N/S,E/W]) and converts to degrees N,E only
-double
-convertLatLongToDeg(const string& llstr, const string& dir)
+// Turns what GPSSentenceDecoder reports into the exceptions of this service
+static void
+throwIfFailed(ParseStatus status, const NMEASentence& nmea)
 {
-	double pd   = parseDouble(llstr);
-	double deg  = trunc(pd / 100); // get ddd from dddmm.mmmm
-	double mins = pd - deg * 100;
-
-	deg = deg + mins / 60.0;
-
-	char hdg = 'x';
-	if ( !dir.empty() ) {
-		hdg = dir[0];
+	if ( status == ParseStatus::Ok ) {
+		return;
 	}
-
-	// everything should be N/E, so flip S,W
-	if ( hdg == 'S' || hdg == 'W' ) {
-		deg *= -1.0;
+	string where = "[$" + nmea.name_ + "] :: ";
+	switch ( status ) {
+	case ParseStatus::MissingChecksum:
+		throw NMEAParseError("GPS Data Bad Format " + where + "Checksum is missing!", nmea);
+	case ParseStatus::ChecksumMismatch:
+		throw NMEAParseError("GPS Data Bad Format " + where + "Checksum is invalid!", nmea);
+	case ParseStatus::MissingFields:
+		throw NMEAParseError("GPS Data Bad Format " + where + "GPS data is missing parameters.", nmea);
+	case ParseStatus::BadNumber:
+		throw NMEAParseError("GPS Number Bad Format " + where + "a parameter is not a number.", nmea);
+	default:
+		throw NMEAParseError("GPS Data Bad Format " + where + parseStatusName(status), nmea);
 	}
+}
 
-	return deg;
+// UBX payloads are little endian
+static uint16_t
+readU16(const uint8_t* p)
+{
+	return static_cast<uint16_t>(p[0] | (p[1] << 8));
 }
 
-double
-convertKnotsToKilometersPerHour(double knots)
+static uint32_t
+readU32(const uint8_t* p)
 {
-	static const auto kilometersPerHour = 1.852;
+	return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16)
+	       | (static_cast<uint32_t>(p[3]) << 24);
+}
 
-	return knots * kilometersPerHour;
+static int32_t
+readI32(const uint8_t* p)
+{
+	return static_cast<int32_t>(readU32(p));
 }
 
+// UBX class << 8 | id
+static constexpr uint16_t UBX_NAV_PVT = 0x0107;
+static constexpr uint16_t UBX_NAV_SAT = 0x0135;
+
 // ------------- GPSSERVICE CLASS -------------
 
 GPSService::GPSService(NMEAParser& parser)
+    : GPSService(parser, parser.resource())
+{
+}
+
+GPSService::GPSService(NMEAParser& parser, pmr::memory_resource* resource)
+    : resource_(resource)
+    , onLockStateChanged(resource)
+    , onUpdate(resource)
 {
 	attachToParser(parser); // attach to parser in the GPS object
 }
@@ -72,409 +98,319 @@ GPSService::attachToParser(NMEAParser& _parser)
 	$PSRF150	- gps module "ok to send"
 	*/
 	_parser.setSentenceHandler("PSRF150", [this](const NMEASentence& nmea) {
-		this->read_PSRF150(nmea);
+		this->read(&GPSService::read_PSRF150, nmea);
 	});
 	_parser.setSentenceHandler("GPGGA", [this](const NMEASentence& nmea) {
-		this->read_GPGGA(nmea);
+		this->read(&GPSService::read_GPGGA, nmea);
 	});
 	_parser.setSentenceHandler("GPGSA", [this](const NMEASentence& nmea) {
-		this->read_GPGSA(nmea);
+		this->read(&GPSService::read_GPGSA, nmea);
 	});
 	_parser.setSentenceHandler("GPGSV", [this](const NMEASentence& nmea) {
-		this->read_GPGSV(nmea);
+		this->read(&GPSService::read_GPGSV, nmea);
 	});
 	_parser.setSentenceHandler("GPRMC", [this](const NMEASentence& nmea) {
-		this->read_GPRMC(nmea);
+		this->read(&GPSService::read_GPRMC, nmea);
 	});
 	_parser.setSentenceHandler("GPVTG", [this](const NMEASentence& nmea) {
-		this->read_GPVTG(nmea);
+		this->read(&GPSService::read_GPVTG, nmea);
 	});
 }
 
 void
-GPSService::read_PSRF150(const NMEASentence& /*unused*/)
+GPSService::attachToDemultiplexer(StreamDemultiplexer& demux)
 {
-	// nothing right now...
-	// Called with checksum 3E (valid) for GPS turning ON
-	// Called with checksum 3F (invalid) for GPS turning OFF
+	demux.onFrame += [this](const BinaryFrame& frame) {
+		if ( frame.protocol_ == FrameProtocol::UBX ) {
+			this->read_UBX(frame);
+		}
+	};
 }
 
 void
-GPSService::read_GPGGA(const NMEASentence& nmea)
+GPSService::setMetrics(Metrics* metrics)
 {
-	/* -- EXAMPLE --
-	$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47
-
-	$GPGGA,205630.945,3346.1070,N,08423.6687,W,0,03,,30.8,M,-30.8,M,,0000*73		// ATLANTA!!!!
+	metrics_ = metrics;
+}
 
-	Where:
-	GGA          Global Positioning System Fix Data
-	index:
-	[0] 123519       Fix taken at 12:35:19 UTC
-	[1-2] 4807.038,N   Latitude 48 deg 07.038' N
-	[3-4] 1131.000,E  Longitude 11 deg 31.000' E
-	[5] 1            Fix quality: 0 = invalid
-	1 = GPS fix (SPS)
-	2 = DGPS fix
-	3 = PPS fix
-	4 = Real Time Kinematic
-	5 = Float RTK
-	6 = estimated (dead reckoning) (2.3 feature)
-	7 = Manual input mode
-	8 = Simulation mode
-	[6] 08           Number of satellites being tracked
-	[7] 0.9          Horizontal dilution of position
-	[8-9] 545.4,M      Altitude, Meters, above mean sea level
-	[10-11] 46.9,M       Height of geoid (mean sea level) above WGS84
-	ellipsoid
-	[12] (empty field) time in seconds since last DGPS update
-	[13] (empty field) DGPS station ID number
-	[13]  *47          the checksum data, always begins with *
-	*/
-	try {
-		if ( !nmea.checksumOK() ) {
-			throw NMEAParseError("Checksum is invalid!");
-		}
+void
+GPSService::enableHistory(size_t capacity)
+{
+	history_.reset();
+	if ( capacity != 0 ) {
+		history_.emplace(capacity, resource_);
+	}
+}
 
-		if ( nmea.parameters_.size() < 14 ) {
-			throw NMEAParseError("GPS data is missing parameters.");
-		}
+const FixHistory*
+GPSService::history() const
+{
+	return history_ ? &*history_ : nullptr;
+}
 
-		// TIMESTAMP
-		this->fix_.timestamp_.setTime(parseDouble(nmea.parameters_[0]));
+void
+GPSService::updated()
+{
+	if ( history_ ) {
+		history_->record(fix_);
+	}
+	this->onUpdate();
+}
 
-		string sll;
-		string dir;
-		// LAT
-		sll = nmea.parameters_[1];
-		dir = nmea.parameters_[2];
-		if ( !sll.empty() ) {
-			this->fix_.latitude_ = convertLatLongToDeg(sll, dir);
-		}
+size_t
+GPSService::memoryUsage() const
+{
+	// list nodes hold the handler plus two links
+	const size_t handlerNode = sizeof(EventHandler<void()>) + 2 * sizeof(void*);
 
-		// LONG
-		sll = nmea.parameters_[3];
-		dir = nmea.parameters_[4];
-		if ( !sll.empty() ) {
-			this->fix_.longitude_ = convertLatLongToDeg(sll, dir);
-		}
+	return sizeof(*this)
+	       + fix_.almanac_.satellites_.capacity() * sizeof(GPSSatellite)
+	       + (onUpdate.size() + onLockStateChanged.size()) * handlerNode
+	       + (history_ ? history_->memoryUsage() : 0);
+}
 
-		// FIX QUALITY
-		bool lockupdate   = false;
-		this->fix_.quality_ = (uint8_t) parseInt(nmea.parameters_[5]);
-		if ( this->fix_.quality_ == 0 ) {
-			lockupdate = this->fix_.setlock(false);
-		}
-		else if ( this->fix_.quality_ == 1 ) {
-			lockupdate = this->fix_.setlock(true);
-		}
-		else {
+void
+GPSService::read(void (GPSService::*reader)(const NMEASentence&), const NMEASentence& nmea)
+{
+	try {
+		(this->*reader)(nmea);
+	}
+	catch ( NMEAParseError& ) {
+		if ( metrics_ != nullptr ) {
+			metrics_->addDecodeError(nmea.name_);
 		}
+		throw;
+	}
+}
 
-		// TRACKING SATELLITES
-		this->fix_.trackingSatellites_ = (int32_t) parseInt(nmea.parameters_[6]);
-		if ( this->fix_.visibleSatellites_ < this->fix_.trackingSatellites_ ) {
-			this->fix_.visibleSatellites_ = this->fix_.trackingSatellites_; // the visible count is in another sentence.
-		}
+void
+GPSService::read_PSRF150(const NMEASentence& /*unused*/)
+{
+	// nothing right now...
+	// Called with checksum 3E (valid) for GPS turning ON
+	// Called with checksum 3F (invalid) for GPS turning OFF
+}
 
-		// ALTITUDE
-		if ( !nmea.parameters_[8].empty() ) {
-			this->fix_.altitude_ = parseDouble(nmea.parameters_[8]);
-		}
-		else {
-			// leave old value
-		}
+void
+GPSService::read_GPGGA(const NMEASentence& nmea)
+{
+	bool lockupdate = false;
+	throwIfFailed(GPSSentenceDecoder::readGGA(nmea, fix_, lockupdate), nmea);
 
-		// calling handlers
-		if ( lockupdate ) {
-			this->onLockStateChanged(this->fix_.haslock);
-		}
-		this->onUpdate();
-	}
-	catch ( NumberConversionError& ex ) {
-		throw NMEAParseError(string("GPS Number Bad Format [$GPGGA] :: ") + ex.what(), nmea);
-	}
-	catch ( NMEAParseError& ex ) {
-		throw NMEAParseError(string("GPS Data Bad Format [$GPGGA] :: ") + ex.what(), nmea);
+	// calling handlers
+	if ( lockupdate ) {
+		this->onLockStateChanged(this->fix_.haslock);
 	}
+	this->updated();
 }
 
 void
 GPSService::read_GPGSA(const NMEASentence& nmea)
 {
-	/*  -- EXAMPLE --
-	$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39
-
-	$GPGSA,A,3,18,21,22,14,27,19,,,,,,,4.4,2.7,3.4*32
-
-	Where:
-	GSA      Satellite status
-	[0] A        Auto selection of 2D or 3D fix (M = manual)
-	[1] 3        3D fix - values include: 1 = no fix
-	2 = 2D fix
-	3 = 3D fix
-	[2-13] 04,05... PRNs of satellites used for fix (space for 12)
-	[14] 2.5      PDOP (dilution of precision)
-	[15] 1.3      Horizontal dilution of precision (HDOP)
-	[16] 2.1      Vertical dilution of precision (VDOP)
-	[16] *39      the checksum data, always begins with *
-	*/
-
-	try {
-		if ( !nmea.checksumOK() ) {
-			throw NMEAParseError("Checksum is invalid!");
-		}
-
-		if ( nmea.parameters_.size() < 17 ) {
-			throw NMEAParseError("GPS data is missing parameters.");
-		}
-
-		// FIX TYPE
-		bool lockupdate = false;
-		auto fixtype    = parseInt(nmea.parameters_[1]);
-		this->fix_.type_  = static_cast<uint8_t>(fixtype);
-		if ( fixtype == 1 ) {
-			lockupdate = this->fix_.setlock(false);
-		}
-		else if ( fixtype == 3 ) {
-			lockupdate = this->fix_.setlock(true);
-		}
-		else {
-		}
-
-		// DILUTION OF PRECISION  -- PDOP
-		double dop         = parseDouble(nmea.parameters_[14]);
-		this->fix_.dilution_ = dop;
-
-		// HORIZONTAL DILUTION OF PRECISION -- HDOP
-		double hdop                  = parseDouble(nmea.parameters_[15]);
-		this->fix_.horizontalDilution_ = hdop;
+	bool lockupdate = false;
+	throwIfFailed(GPSSentenceDecoder::readGSA(nmea, fix_, lockupdate), nmea);
 
-		// VERTICAL DILUTION OF PRECISION -- VDOP
-		double vdop                = parseDouble(nmea.parameters_[16]);
-		this->fix_.verticalDilution_ = vdop;
-
-		// calling handlers
-		if ( lockupdate ) {
-			this->onLockStateChanged(this->fix_.haslock);
-		}
-		this->onUpdate();
-	}
-	catch ( NumberConversionError& ex ) {
-		throw NMEAParseError(string("GPS Number Bad Format [$GPGSA] :: ") + ex.what(), nmea);
-	}
-	catch ( NMEAParseError& ex ) {
-		throw NMEAParseError(string("GPS Data Bad Format [$GPGSA] :: ") + ex.what(), nmea);
+	// calling handlers
+	if ( lockupdate ) {
+		this->onLockStateChanged(this->fix_.haslock);
 	}
+	this->updated();
 }
 
 void
 GPSService::read_GPGSV(const NMEASentence& nmea)
 {
-	/*  -- EXAMPLE --
-	$GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45*75
+	throwIfFailed(GPSSentenceDecoder::readGSV(nmea, fix_, numeric_limits<size_t>::max()), nmea);
+	this->updated();
+}
 
+void
+GPSService::read_GPRMC(const NMEASentence& nmea)
+{
+	bool lockupdate = false;
+	throwIfFailed(GPSSentenceDecoder::readRMC(nmea, fix_, lockupdate), nmea);
 
-	$GPGSV,3,1,12,01,00,000,,02,00,000,,03,00,000,,04,00,000,*7C
-	$GPGSV,3,2,12,05,00,000,,06,00,000,,07,00,000,,08,00,000,*77
-	$GPGSV,3,3,12,09,00,000,,10,00,000,,11,00,000,,12,00,000,*71
+	// calling handlers
+	if ( lockupdate ) {
+		this->onLockStateChanged(this->fix_.haslock);
+	}
+	this->updated();
+}
 
-	Where:
-	GSV          Satellites in view
-	[0] 2            Number of sentences for full data
-	[1] 1            sentence 1 of 2
-	[2] 08           Number of satellites in view
-
-	[3] 01           Satellite PRN number
-	[4] 40           Elevation, degrees
-	[5] 083          Azimuth, degrees
-	[6] 46           SNR - higher is better
-	[...]   for up to 4 satellites per sentence
-	[17] *75          the checksum data, always begins with *
-	*/
+void
+GPSService::read_GPVTG(const NMEASentence& nmea)
+{
+	throwIfFailed(GPSSentenceDecoder::readVTG(nmea, fix_), nmea);
+	this->updated();
+}
 
+void
+GPSService::read_UBX(const BinaryFrame& frame)
+{
+	const char* name = nullptr;
 	try {
-		if ( !nmea.checksumOK() ) {
-			throw NMEAParseError("Checksum is invalid!");
-		}
-
-		// can't do this check because the length varies depending on satallites...
-		// if(nmea.parameters.size() < 18){
-		//	throw NMEAParseError("GPS data is missing parameters.");
-		//}
-
-		// VISIBLE SATELLITES
-		this->fix_.visibleSatellites_ = (int32_t) parseInt(nmea.parameters_[2]);
-		if ( this->fix_.trackingSatellites_ == 0 ) {
-			this->fix_.visibleSatellites_ = 0; // if no satellites are tracking, then none are visible!
-		}                                    // Also NMEA defaults to 12 visible when chip powers on. Obviously not right.
-
-		auto totalPages  = static_cast<uint32_t>(parseInt(nmea.parameters_[0]));
-		auto currentPage = static_cast<uint32_t>(parseInt(nmea.parameters_[1]));
-
-		// if this is the first page, then reset the almanac
-		if ( currentPage == 1 ) {
-			this->fix_.almanac_.clear();
-			// cout << "CLEARING ALMANAC" << endl;
-		}
-
-		this->fix_.almanac_.lastPage    = currentPage;
-		this->fix_.almanac_.totalPages  = totalPages;
-		this->fix_.almanac_.visibleSize = this->fix_.visibleSatellites_;
-
-		int entriesInPage = (nmea.parameters_.size() - 3) >> 2; // first 3 are not satellite info
-		//- entries come in 4-ples, and truncate, so used shift
-		GPSSatellite sat;
-		for ( int i = 0; i < entriesInPage; i++ ) {
-			int prop = 3 + i * 4;
-
-			// PRN, ELEVATION, AZIMUTH, SNR
-			sat.prn_       = (uint32_t) parseInt(nmea.parameters_[prop]);
-			sat.elevation_ = (uint32_t) parseInt(nmea.parameters_[prop + 1]);
-			sat.azimuth_   = (uint32_t) parseInt(nmea.parameters_[prop + 2]);
-			sat.snr_       = (uint32_t) parseInt(nmea.parameters_[prop + 3]);
-
-			// cout << "ADDING SATELLITE ::" << sat.toString() << endl;
-			this->fix_.almanac_.updateSatellite(sat);
+		switch ( frame.type_ ) {
+		case UBX_NAV_PVT:
+			name = "UBX-NAV-PVT";
+			read_UBX_NAV_PVT(frame);
+			break;
+		case UBX_NAV_SAT:
+			name = "UBX-NAV-SAT";
+			read_UBX_NAV_SAT(frame);
+			break;
+		default:
+			break;
 		}
-
-		this->fix_.almanac_.processedPages++;
-
-		//
-		if ( this->fix_.visibleSatellites_ == 0 ) {
-			this->fix_.almanac_.clear();
-		}
-
-		// cout << "ALMANAC FINISHED page " << this->fix.almanac.processedPages << " of " << this->fix.almanac.totalPages << endl;
-		this->onUpdate();
 	}
-	catch ( NumberConversionError& ex ) {
-		throw NMEAParseError(string("GPS Number Bad Format [$GPGSV] :: ") + ex.what(), nmea);
-	}
-	catch ( NMEAParseError& ex ) {
-		throw NMEAParseError(string("GPS Data Bad Format [$GPGSV] :: ") + ex.what(), nmea);
+	catch ( NMEAParseError& ) {
+		if ( metrics_ != nullptr ) {
+			metrics_->addDecodeError(name);
+		}
+		throw;
 	}
 }
 
 void
-GPSService::read_GPRMC(const NMEASentence& nmea)
+GPSService::read_UBX_NAV_PVT(const BinaryFrame& frame)
 {
-	/*  -- EXAMPLE ---
-	$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A
-	$GPRMC,235957.025,V,,,,,,,070810,,,N*4B
-	$GPRMC,061425.000,A,3346.2243,N,08423.4706,W,0.45,18.77,060914,,,A*47
+	/*
+	UBX-NAV-PVT, class 0x01 id 0x07, 92 bytes, little endian
 
 	Where:
-	RMC          Recommended Minimum sentence C
-	[0] 123519       Fix taken at 12:35:19 UTC
-	[1] A            Status A=active or V=Void.
-	[2-3] 4807.038,N   Latitude 48 deg 07.038' N
-	[4-5] 01131.000,E  Longitude 11 deg 31.000' E
-	[6] 022.4        Speed over the ground in knots
-	[7] 084.4        Track angle in degrees True
-	[8] 230394       Date - 23rd of March 1994
-	[9-10] 003.1,W      Magnetic Variation
-	[10] *6A          The checksum data, always begins with *
-	// NMEA 2.3 includes another field after
+	[0]  U4 iTOW          GPS time of week, ms
+	[4]  U2 year          UTC
+	[6]  U1 month, [7] U1 day, [8] U1 hour, [9] U1 min, [10] U1 sec
+	[11] X1 valid         bit 0 date valid, bit 1 time valid
+	[16] I4 nano          fraction of the second, ns, -1e9..1e9
+	[20] U1 fixType       0 none, 1 dead reckoning, 2 2D, 3 3D, 4 GNSS + dead reckoning, 5 time only
+	[21] X1 flags         bit 0 gnssFixOK, bit 1 diffSoln, bits 6-7 carrSoln (1 float, 2 fixed)
+	[23] U1 numSV         satellites used
+	[24] I4 lon, [28] I4 lat     1e-7 deg
+	[36] I4 hMSL          height above mean sea level, mm
+	[60] I4 gSpeed        ground speed, mm/s
+	[64] I4 headMot       heading of motion, 1e-5 deg
+	[76] U2 pDOP          0.01
 	*/
+	const uint8_t* p = frame.payload_;
+	if ( frame.payloadSize_ != 92 ) {
+		throw NMEAParseError("UBX-NAV-PVT has " + to_string(frame.payloadSize_) + " bytes, not 92.");
+	}
 
-	try {
-		if ( !nmea.checksumOK() ) {
-			throw NMEAParseError("Checksum is invalid!");
-		}
-
-		if ( nmea.parameters_.size() < 11 ) {
-			throw NMEAParseError("GPS data is missing parameters.");
-		}
-
-		// TIMESTAMP
-		this->fix_.timestamp_.setTime(parseDouble(nmea.parameters_[0]));
-
-		string sll;
-		string dir;
-		// LAT
-		sll = nmea.parameters_[2];
-		dir = nmea.parameters_[3];
-		if ( !sll.empty() ) {
-			this->fix_.latitude_ = convertLatLongToDeg(sll, dir);
-		}
-
-		// LONG
-		sll = nmea.parameters_[4];
-		dir = nmea.parameters_[5];
-		if ( !sll.empty() ) {
-			this->fix_.longitude_ = convertLatLongToDeg(sll, dir);
-		}
+	uint8_t valid   = p[11];
+	uint8_t fixType = p[20];
+	uint8_t flags   = p[21];
 
-		// ACTIVE
-		bool lockupdate = false;
-		char status     = 'V';
-		if ( !nmea.parameters_[1].empty() ) {
-			status = nmea.parameters_[1][0];
-		}
-		this->fix_.status_ = status;
-		if ( status == 'V' ) {
-			lockupdate = this->fix_.setlock(false);
-		}
-		else if ( status == 'A' ) {
-			lockupdate = this->fix_.setlock(true);
-		}
-		else {
-			lockupdate = this->fix_.setlock(false); // not A or V, so must be wrong... no lock
-		}
+	// TIMESTAMP
+	if ( (valid & 0x02) != 0 ) {
+		double seconds = max(0.0, p[10] + readI32(p + 16) * 1e-9);
+		this->fix_.timestamp_.setTime(p[8] * 10000.0 + p[9] * 100.0 + seconds);
+	}
+	if ( (valid & 0x01) != 0 ) {
+		this->fix_.timestamp_.setDate(p[7] * 10000 + p[6] * 100 + readU16(p + 4) % 100);
+	}
 
-		this->fix_.speed_       = convertKnotsToKilometersPerHour(parseDouble(nmea.parameters_[6])); // received as knots, convert to km/h
-		this->fix_.travelAngle_ = parseDouble(nmea.parameters_[7]);
-		this->fix_.timestamp_.setDate((int32_t) parseInt(nmea.parameters_[8]));
+	// FIX
+	bool locked     = (flags & 0x01) != 0 && fixType >= 1 && fixType <= 4;
+	bool lockupdate = this->fix_.setlock(locked);
 
-		// calling handlers
-		if ( lockupdate ) {
-			this->onLockStateChanged(this->fix_.haslock);
-		}
-		this->onUpdate();
+	this->fix_.status_ = locked ? 'A' : 'V';
+	this->fix_.type_   = fixType == 3 || fixType == 4 ? 3 : fixType == 2 ? 2 : 1;
+	if ( !locked ) {
+		this->fix_.quality_ = 0;
 	}
-	catch ( NumberConversionError& ex ) {
-		throw NMEAParseError(string("GPS Number Bad Format [$GPRMC] :: ") + ex.what(), nmea);
+	else if ( fixType == 1 ) {
+		this->fix_.quality_ = 6; // dead reckoning, as in GGA
 	}
-	catch ( NMEAParseError& ex ) {
-		throw NMEAParseError(string("GPS Data Bad Format [$GPRMC] :: ") + ex.what(), nmea);
+	else if ( (flags >> 6) == 2 ) {
+		this->fix_.quality_ = 4; // RTK fixed
 	}
+	else if ( (flags >> 6) == 1 ) {
+		this->fix_.quality_ = 5; // RTK float
+	}
+	else {
+		this->fix_.quality_ = (flags & 0x02) != 0 ? 2 : 1;
+	}
+	this->fix_.trackingSatellites_ = p[23];
+	if ( this->fix_.visibleSatellites_ < this->fix_.trackingSatellites_ ) {
+		this->fix_.visibleSatellites_ = this->fix_.trackingSatellites_;
+	}
+
+	// POSITION AND MOTION
+	this->fix_.longitude_   = readI32(p + 24) * 1e-7;
+	this->fix_.latitude_    = readI32(p + 28) * 1e-7;
+	this->fix_.altitude_    = readI32(p + 36) * 1e-3;
+	this->fix_.speed_       = readI32(p + 60) * 0.0036; // mm/s to km/h
+	this->fix_.travelAngle_ = readI32(p + 64) * 1e-5;
+	this->fix_.dilution_    = readU16(p + 76) * 0.01;
+
+	// calling handlers
+	if ( lockupdate ) {
+		this->onLockStateChanged(this->fix_.haslock);
+	}
+	this->updated();
 }
 
 void
-GPSService::read_GPVTG(const NMEASentence& nmea)
+GPSService::read_UBX_NAV_SAT(const BinaryFrame& frame)
 {
 	/*
-	$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48
-
-	where:
-	VTG          Track made good and ground speed
-	[0-1]	054.7,T      True track made good (degrees)
-	[2-3]	034.4,M      Magnetic track made good
-	[4-5]	005.5,N      Ground speed, knots
-	[6-7]	010.2,K      Ground speed, Kilometers per hour
-	[7]	*48          Checksum
-	*/
-
-	try {
-		if ( !nmea.checksumOK() ) {
-			throw NMEAParseError("Checksum is invalid!");
-		}
-
-		if ( nmea.parameters_.size() < 8 ) {
-			throw NMEAParseError("GPS data is missing parameters.");
-		}
+	UBX-NAV-SAT, class 0x01 id 0x35, 8 + 12 * numSvs bytes, little endian
 
-		// SPEED
-		// if empty, is converted to 0
-		this->fix_.speed_ = parseDouble(nmea.parameters_[6]); // km/h
-
-		this->onUpdate();
-	}
-	catch ( NumberConversionError& ex ) {
-		throw NMEAParseError(string("GPS Number Bad Format [$GPVTG] :: ") + ex.what(), nmea);
+	Where:
+	[0]  U4 iTOW
+	[4]  U1 version
+	[5]  U1 numSvs
+	then for each satellite, from 8 + 12 * n:
+	[+0] U1 gnssId        0 GPS, 1 SBAS, 2 Galileo, 3 BeiDou, 5 QZSS, 6 GLONASS
+	[+1] U1 svId
+	[+2] U1 cno           dBHz
+	[+3] I1 elev          deg
+	[+4] I2 azim          deg
+	*/
+	const uint8_t* p = frame.payload_;
+	if ( frame.payloadSize_ < 8 || frame.payloadSize_ != 8 + 12 * size_t{ p[5] } ) {
+		throw NMEAParseError("UBX-NAV-SAT has " + to_string(frame.payloadSize_) + " bytes, not 8 + 12 per satellite.");
 	}
-	catch ( NMEAParseError& ex ) {
-		throw NMEAParseError(string("GPS Data Bad Format [$GPVTG] :: ") + ex.what(), nmea);
+
+	uint32_t count = p[5];
+	this->fix_.visibleSatellites_ = static_cast<int32_t>(count);
+
+	// the whole almanac comes in one frame
+	this->fix_.almanac_.clear();
+	this->fix_.almanac_.lastPage       = 1;
+	this->fix_.almanac_.totalPages     = 1;
+	this->fix_.almanac_.visibleSize    = count;
+	this->fix_.almanac_.processedPages = 1;
+
+	GPSSatellite sat;
+	for ( uint32_t i = 0; i < count; i++ ) {
+		const uint8_t* s = p + 8 + 12 * i;
+
+		// PRN as in NMEA 4.1 sentences
+		uint32_t prn = s[1];
+		switch ( s[0] ) {
+		case 2: // Galileo
+			prn += 300;
+			break;
+		case 3: // BeiDou
+			prn += 400;
+			break;
+		case 5: // QZSS
+			prn += 192;
+			break;
+		case 6: // GLONASS
+			prn += 64;
+			break;
+		default: // GPS and SBAS as they are
+			break;
+		}
+		sat.prn_       = prn;
+		sat.snr_       = s[2];
+		sat.elevation_ = static_cast<int8_t>(s[3]);
+		sat.azimuth_   = static_cast<int16_t>(readU16(s + 4));
+
+		this->fix_.almanac_.updateSatellite(sat);
 	}
+
+	this->updated();
 }
@@ -0,0 +1,714 @@
+/*
+ * Geodesy.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/Geodesy.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#	define NEMATODE_GEODESY_AVX2 1
+#	include <immintrin.h>
+#endif
+
+using namespace std;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+static constexpr double Pi        = 3.14159265358979323846;
+static constexpr double DegToRad  = Pi / 180.0;
+static constexpr double RadToDeg  = 180.0 / Pi;
+static constexpr double WGS84E2   = WGS84Flattening * (2 - WGS84Flattening); // first eccentricity squared
+static constexpr double WGS84Minor = WGS84SemiMajor * (1 - WGS84Flattening);
+
+static const char Base32[] = "0123456789bcdefghjkmnpqrstuvwxyz";
+
+// Bits of longitude and latitude in a geohash of precision characters, longitude gets the odd one
+static void
+geohashSplit(int precision, int& lonBits, int& latBits)
+{
+	int total = 5 * min(max(precision, 1), 12);
+	lonBits   = (total + 1) / 2;
+	latBits   = total / 2;
+}
+
+// Moves bit i of value to bit 2i
+static uint64_t
+spreadBits(uint64_t value)
+{
+	value &= 0xFFFFFFFFULL;
+	value = (value | (value << 16)) & 0x0000FFFF0000FFFFULL;
+	value = (value | (value << 8)) & 0x00FF00FF00FF00FFULL;
+	value = (value | (value << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	value = (value | (value << 2)) & 0x3333333333333333ULL;
+	value = (value | (value << 1)) & 0x5555555555555555ULL;
+	return value;
+}
+
+static uint64_t
+interleave(uint64_t lonCell, uint64_t latCell, int lonBits, int latBits)
+{
+	// longitude has the top bit, and the bottom one when the total is odd
+	return lonBits > latBits ? spreadBits(lonCell) | (spreadBits(latCell) << 1)
+	                         : (spreadBits(lonCell) << 1) | spreadBits(latCell);
+}
+
+// Cell index of value in [low, low + span) split into 2^bits cells, clamped to the last one
+static uint64_t
+cell(double value, double low, double span, int bits)
+{
+	double cells = ldexp(1.0, bits);
+	double index = floor((value - low) * (cells / span));
+	return static_cast<uint64_t>(min(max(index, 0.0), cells - 1));
+}
+
+// ------------- COORDINATE ARRAYS -------------
+
+void
+CoordinateArrays::append(const GPSFix& fix)
+{
+	append(fix.latitude_, fix.longitude_, fix.altitude_);
+}
+
+void
+CoordinateArrays::append(double latitude, double longitude, double altitude)
+{
+	latitude_.push_back(latitude);
+	longitude_.push_back(longitude);
+	altitude_.push_back(altitude);
+}
+
+void
+CoordinateArrays::reserve(size_t size)
+{
+	latitude_.reserve(size);
+	longitude_.reserve(size);
+	altitude_.reserve(size);
+}
+
+void
+CoordinateArrays::clear()
+{
+	latitude_.clear();
+	longitude_.clear();
+	altitude_.clear();
+}
+
+size_t
+CoordinateArrays::size() const
+{
+	return latitude_.size();
+}
+
+// ------------- SCALAR REFERENCE -------------
+
+double
+nmea::haversineDistance(double lat1, double lon1, double lat2, double lon2)
+{
+	double phi1   = lat1 * DegToRad;
+	double phi2   = lat2 * DegToRad;
+	double sinPhi = sin((phi2 - phi1) / 2);
+	double sinLam = sin((lon2 - lon1) * DegToRad / 2);
+	double a      = sinPhi * sinPhi + cos(phi1) * cos(phi2) * sinLam * sinLam;
+	a             = min(max(a, 0.0), 1.0);
+	return 2 * EarthMeanRadius * atan2(sqrt(a), sqrt(1 - a));
+}
+
+double
+nmea::vincentyDistance(double lat1, double lon1, double lat2, double lon2)
+{
+	// Vincenty's inverse formula on the WGS84 ellipsoid
+	const double f = WGS84Flattening;
+
+	double L     = (lon2 - lon1) * DegToRad;
+	double U1    = atan((1 - f) * tan(lat1 * DegToRad));
+	double U2    = atan((1 - f) * tan(lat2 * DegToRad));
+	double sinU1 = sin(U1);
+	double cosU1 = cos(U1);
+	double sinU2 = sin(U2);
+	double cosU2 = cos(U2);
+
+	double lambda     = L;
+	double sinSigma   = 0;
+	double cosSigma   = 0;
+	double sigma      = 0;
+	double cosSqAlpha = 0;
+	double cos2SigmaM = 0;
+	for ( int iteration = 0; iteration < 200; iteration++ ) {
+		double sinLambda = sin(lambda);
+		double cosLambda = cos(lambda);
+		double t1        = cosU2 * sinLambda;
+		double t2        = cosU1 * sinU2 - sinU1 * cosU2 * cosLambda;
+		sinSigma         = sqrt(t1 * t1 + t2 * t2);
+		if ( sinSigma == 0 ) {
+			return 0; // same point
+		}
+		cosSigma        = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
+		sigma           = atan2(sinSigma, cosSigma);
+		double sinAlpha = cosU1 * cosU2 * sinLambda / sinSigma;
+		cosSqAlpha      = 1 - sinAlpha * sinAlpha;
+		cos2SigmaM      = cosSqAlpha != 0 ? cosSigma - 2 * sinU1 * sinU2 / cosSqAlpha : 0; // on the equator
+		double C        = f / 16 * cosSqAlpha * (4 + f * (4 - 3 * cosSqAlpha));
+		double previous = lambda;
+		lambda          = L + (1 - C) * f * sinAlpha * (sigma + C * sinSigma * (cos2SigmaM + C * cosSigma * (-1 + 2 * cos2SigmaM * cos2SigmaM)));
+		if ( fabs(lambda - previous) < 1e-12 ) {
+			const double a  = WGS84SemiMajor;
+			const double b  = WGS84Minor;
+			double       u2 = cosSqAlpha * (a * a - b * b) / (b * b);
+			double       A  = 1 + u2 / 16384 * (4096 + u2 * (-768 + u2 * (320 - 175 * u2)));
+			double       B  = u2 / 1024 * (256 + u2 * (-128 + u2 * (74 - 47 * u2)));
+			double       deltaSigma
+			    = B * sinSigma * (cos2SigmaM + B / 4 * (cosSigma * (-1 + 2 * cos2SigmaM * cos2SigmaM) - B / 6 * cos2SigmaM * (-3 + 4 * sinSigma * sinSigma) * (-3 + 4 * cos2SigmaM * cos2SigmaM)));
+			return b * A * (sigma - deltaSigma);
+		}
+	}
+	return numeric_limits<double>::quiet_NaN();
+}
+
+double
+nmea::initialBearing(double lat1, double lon1, double lat2, double lon2)
+{
+	double phi1    = lat1 * DegToRad;
+	double phi2    = lat2 * DegToRad;
+	double dLambda = (lon2 - lon1) * DegToRad;
+	double y       = sin(dLambda) * cos(phi2);
+	double x       = cos(phi1) * sin(phi2) - sin(phi1) * cos(phi2) * cos(dLambda);
+	double deg     = atan2(y, x) * RadToDeg;
+	deg += deg < 0 ? 360 : 0;
+	return deg >= 360 ? deg - 360 : deg;
+}
+
+ECEF
+nmea::toECEF(double latitude, double longitude, double altitude)
+{
+	double sinLat = sin(latitude * DegToRad);
+	double cosLat = cos(latitude * DegToRad);
+	double N      = WGS84SemiMajor / sqrt(1 - WGS84E2 * sinLat * sinLat); // prime vertical radius
+
+	ECEF point;
+	point.x = (N + altitude) * cosLat * cos(longitude * DegToRad);
+	point.y = (N + altitude) * cosLat * sin(longitude * DegToRad);
+	point.z = (N * (1 - WGS84E2) + altitude) * sinLat;
+	return point;
+}
+
+uint64_t
+nmea::geohashBits(double latitude, double longitude, int precision)
+{
+	int lonBits = 0;
+	int latBits = 0;
+	geohashSplit(precision, lonBits, latBits);
+	return interleave(cell(longitude, -180, 360, lonBits), cell(latitude, -90, 180, latBits), lonBits, latBits);
+}
+
+size_t
+nmea::geohashText(uint64_t bits, int precision, char* out)
+{
+	precision = min(max(precision, 1), 12);
+	for ( int i = precision; i-- > 0; ) {
+		out[i] = Base32[bits & 31];
+		bits >>= 5;
+	}
+	return static_cast<size_t>(precision);
+}
+
+size_t
+nmea::geohash(double latitude, double longitude, int precision, char* out)
+{
+	return geohashText(geohashBits(latitude, longitude, precision), precision, out);
+}
+
+// ------------- AVX2 KERNELS -------------
+
+#ifdef NEMATODE_GEODESY_AVX2
+
+#	define NEMATODE_AVX2 __attribute__((target("avx2,fma")))
+
+namespace {
+
+struct SinCos {
+	__m256d sin;
+	__m256d cos;
+};
+
+NEMATODE_AVX2 inline __m256d
+splat(double value)
+{
+	return _mm256_set1_pd(value);
+}
+
+// Cephes sin()/cos(): reduction by multiples of pi/4 in three parts, then the
+// sine or cosine polynomial depending on the octant. Good to about 1 ulp for
+// the angles coordinates have.
+NEMATODE_AVX2 inline SinCos
+sinCos(__m256d x)
+{
+	const __m256d signMask = splat(-0.0);
+
+	__m256d ax    = _mm256_andnot_pd(signMask, x);
+	__m256d xSign = _mm256_and_pd(signMask, x);
+
+	// octant, rounded up to even
+	__m256d y = _mm256_floor_pd(_mm256_mul_pd(ax, splat(1.27323954473516268615))); // 4/pi
+	y         = _mm256_add_pd(y, _mm256_fnmadd_pd(splat(2.0), _mm256_floor_pd(_mm256_mul_pd(y, splat(0.5))), y));
+	__m256d j = _mm256_fnmadd_pd(splat(8.0), _mm256_floor_pd(_mm256_mul_pd(y, splat(0.125))), y); // y mod 8: 0, 2, 4 or 6
+
+	__m256d z  = _mm256_fnmadd_pd(y, splat(7.85398125648498535156E-1), ax);
+	z          = _mm256_fnmadd_pd(y, splat(3.77489470793079817668E-8), z);
+	z          = _mm256_fnmadd_pd(y, splat(2.69515142907905952645E-15), z);
+	__m256d zz = _mm256_mul_pd(z, z);
+
+	__m256d ps = splat(1.58962301576546568060E-10);
+	ps         = _mm256_fmadd_pd(ps, zz, splat(-2.50507477628578072866E-8));
+	ps         = _mm256_fmadd_pd(ps, zz, splat(2.75573136213857245213E-6));
+	ps         = _mm256_fmadd_pd(ps, zz, splat(-1.98412698295895385996E-4));
+	ps         = _mm256_fmadd_pd(ps, zz, splat(8.33333333332211858878E-3));
+	ps         = _mm256_fmadd_pd(ps, zz, splat(-1.66666666666666307295E-1));
+	ps         = _mm256_fmadd_pd(_mm256_mul_pd(z, zz), ps, z);
+
+	__m256d pc = splat(-1.13585365213876817300E-11);
+	pc         = _mm256_fmadd_pd(pc, zz, splat(2.08757008419747316778E-9));
+	pc         = _mm256_fmadd_pd(pc, zz, splat(-2.75573141792967388112E-7));
+	pc         = _mm256_fmadd_pd(pc, zz, splat(2.48015872888517045348E-5));
+	pc         = _mm256_fmadd_pd(pc, zz, splat(-1.38888888888730564116E-3));
+	pc         = _mm256_fmadd_pd(pc, zz, splat(4.16666666666665929218E-2));
+	pc         = _mm256_fmadd_pd(_mm256_mul_pd(zz, zz), pc, _mm256_fnmadd_pd(splat(0.5), zz, splat(1.0)));
+
+	__m256d swap = _mm256_or_pd(_mm256_cmp_pd(j, splat(2.0), _CMP_EQ_OQ), _mm256_cmp_pd(j, splat(6.0), _CMP_EQ_OQ));
+	__m256d high = _mm256_cmp_pd(j, splat(4.0), _CMP_GE_OQ);
+
+	SinCos result;
+	result.sin = _mm256_xor_pd(_mm256_blendv_pd(ps, pc, swap), _mm256_xor_pd(xSign, _mm256_and_pd(high, signMask)));
+	result.cos = _mm256_xor_pd(_mm256_blendv_pd(pc, ps, swap), _mm256_and_pd(_mm256_xor_pd(high, swap), signMask));
+	return result;
+}
+
+// Cephes atan(): reduced to [0, 0.66] around 0, pi/4 or pi/2, then a rational approximation
+NEMATODE_AVX2 inline __m256d
+arcTan(__m256d x)
+{
+	const __m256d signMask = splat(-0.0);
+	const __m256d moreBits = splat(6.123233995736765886130E-17);
+
+	__m256d ax   = _mm256_andnot_pd(signMask, x);
+	__m256d big  = _mm256_cmp_pd(ax, splat(2.41421356237309504880), _CMP_GT_OQ); // tan(3pi/8)
+	__m256d mid  = _mm256_andnot_pd(big, _mm256_cmp_pd(ax, splat(0.66), _CMP_GT_OQ));
+	__m256d xBig = _mm256_div_pd(splat(-1.0), ax);
+	__m256d xMid = _mm256_div_pd(_mm256_sub_pd(ax, splat(1.0)), _mm256_add_pd(ax, splat(1.0)));
+
+	__m256d xr    = _mm256_blendv_pd(_mm256_blendv_pd(ax, xMid, mid), xBig, big);
+	__m256d base  = _mm256_blendv_pd(_mm256_and_pd(mid, splat(Pi / 4)), splat(Pi / 2), big);
+	__m256d extra = _mm256_blendv_pd(_mm256_and_pd(mid, _mm256_mul_pd(moreBits, splat(0.5))), moreBits, big);
+
+	__m256d z = _mm256_mul_pd(xr, xr);
+	__m256d p = splat(-8.750608600031904122785E-1);
+	p         = _mm256_fmadd_pd(p, z, splat(-1.615753718733365076637E1));
+	p         = _mm256_fmadd_pd(p, z, splat(-7.500855792314704667340E1));
+	p         = _mm256_fmadd_pd(p, z, splat(-1.228866684490136173410E2));
+	p         = _mm256_fmadd_pd(p, z, splat(-6.485021904942025371773E1));
+	__m256d q = _mm256_add_pd(z, splat(2.485846490142306297962E1));
+	q         = _mm256_fmadd_pd(q, z, splat(1.650270098316988542046E2));
+	q         = _mm256_fmadd_pd(q, z, splat(4.328810604912902668951E2));
+	q         = _mm256_fmadd_pd(q, z, splat(4.853903996359136964868E2));
+	q         = _mm256_fmadd_pd(q, z, splat(1.945506571482613964425E2));
+
+	z = _mm256_div_pd(_mm256_mul_pd(z, p), q);
+	z = _mm256_fmadd_pd(xr, z, xr);
+	z = _mm256_add_pd(_mm256_add_pd(z, extra), base);
+	return _mm256_or_pd(z, _mm256_and_pd(x, signMask));
+}
+
+NEMATODE_AVX2 inline __m256d
+arcTan2(__m256d y, __m256d x)
+{
+	const __m256d signMask = splat(-0.0);
+	const __m256d zero     = _mm256_setzero_pd();
+
+	__m256d angle  = arcTan(_mm256_div_pd(y, x));
+	__m256d left   = _mm256_cmp_pd(x, zero, _CMP_LT_OQ);
+	__m256d halfPi = _mm256_or_pd(splat(Pi), _mm256_and_pd(y, signMask));
+	angle          = _mm256_add_pd(angle, _mm256_and_pd(left, halfPi)); // +-pi on the left half
+
+	// x == 0: straight up or down, or 0 for the origin (y / x is NaN there)
+	__m256d xZero = _mm256_cmp_pd(x, zero, _CMP_EQ_OQ);
+	__m256d yZero = _mm256_cmp_pd(y, zero, _CMP_EQ_OQ);
+	__m256d axis  = _mm256_andnot_pd(yZero, _mm256_or_pd(splat(Pi / 2), _mm256_and_pd(y, signMask)));
+	return _mm256_blendv_pd(angle, axis, xZero);
+}
+
+// Haversine central angle term a, clamped to [0, 1]
+NEMATODE_AVX2 inline __m256d
+haversineTerm(__m256d phi1, __m256d phi2, __m256d cosPhi1, __m256d cosPhi2, __m256d dLambda)
+{
+	__m256d sinPhi = sinCos(_mm256_mul_pd(_mm256_sub_pd(phi2, phi1), splat(0.5))).sin;
+	__m256d sinLam = sinCos(_mm256_mul_pd(dLambda, splat(0.5))).sin;
+	__m256d a      = _mm256_fmadd_pd(_mm256_mul_pd(cosPhi1, cosPhi2), _mm256_mul_pd(sinLam, sinLam), _mm256_mul_pd(sinPhi, sinPhi));
+	return _mm256_min_pd(_mm256_max_pd(a, _mm256_setzero_pd()), splat(1.0));
+}
+
+NEMATODE_AVX2 inline __m256d
+centralDistance(__m256d a)
+{
+	__m256d angle = arcTan2(_mm256_sqrt_pd(a), _mm256_sqrt_pd(_mm256_sub_pd(splat(1.0), a)));
+	return _mm256_mul_pd(angle, splat(2 * EarthMeanRadius));
+}
+
+// Haversine distances of segments i - i+3. The cosine of a fix is computed once
+// and carried over from the previous block in cosines, which starts out as
+// cos(latitude[0]) in every lane.
+NEMATODE_AVX2 inline __m256d
+haversineBlock(const double* latitude, const double* longitude, size_t i, __m256d& cosines)
+{
+	const __m256d toRad = splat(DegToRad);
+
+	__m256d phi1 = _mm256_mul_pd(_mm256_loadu_pd(latitude + i), toRad);
+	__m256d phi2 = _mm256_mul_pd(_mm256_loadu_pd(latitude + i + 1), toRad);
+	__m256d dLam = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(longitude + i + 1), _mm256_loadu_pd(longitude + i)), toRad);
+
+	// cos(phi2) is fixes i+1 - i+4, cos(phi1) the same moved up a lane with fix i from the last block
+	__m256d cosPhi2 = sinCos(phi2).cos;
+	__m256d cosPhi1 = _mm256_blend_pd(_mm256_permute4x64_pd(cosPhi2, _MM_SHUFFLE(2, 1, 0, 3)),
+	                                  _mm256_permute4x64_pd(cosines, _MM_SHUFFLE(2, 1, 0, 3)), 0x1);
+	cosines         = cosPhi2;
+
+	return centralDistance(haversineTerm(phi1, phi2, cosPhi1, cosPhi2, dLam));
+}
+
+NEMATODE_AVX2 void
+haversineSegmentsAVX2(const double* latitude, const double* longitude, size_t size, double* out)
+{
+	size_t i = 0;
+	if ( size >= 5 ) {
+		__m256d cosines = splat(cos(latitude[0] * DegToRad));
+		for ( ; i + 4 <= size - 1; i += 4 ) {
+			_mm256_storeu_pd(out + i, haversineBlock(latitude, longitude, i, cosines));
+		}
+	}
+	for ( ; i + 1 < size; i++ ) {
+		out[i] = haversineDistance(latitude[i], longitude[i], latitude[i + 1], longitude[i + 1]);
+	}
+}
+
+NEMATODE_AVX2 double
+odometerAVX2(const double* latitude, const double* longitude, size_t size)
+{
+	__m256d sum = _mm256_setzero_pd();
+	size_t  i   = 0;
+	if ( size >= 5 ) {
+		__m256d cosines = splat(cos(latitude[0] * DegToRad));
+		for ( ; i + 4 <= size - 1; i += 4 ) {
+			sum = _mm256_add_pd(sum, haversineBlock(latitude, longitude, i, cosines));
+		}
+	}
+
+	alignas(32) double lanes[4];
+	_mm256_store_pd(lanes, sum);
+	double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for ( ; i + 1 < size; i++ ) {
+		total += haversineDistance(latitude[i], longitude[i], latitude[i + 1], longitude[i + 1]);
+	}
+	return total;
+}
+
+NEMATODE_AVX2 void
+bearingSegmentsAVX2(const double* latitude, const double* longitude, size_t size, double* out)
+{
+	const __m256d toRad = splat(DegToRad);
+	size_t        i     = 0;
+	for ( ; size >= 5 && i + 4 <= size - 1; i += 4 ) {
+		SinCos phi1 = sinCos(_mm256_mul_pd(_mm256_loadu_pd(latitude + i), toRad));
+		SinCos phi2 = sinCos(_mm256_mul_pd(_mm256_loadu_pd(latitude + i + 1), toRad));
+		SinCos dLam = sinCos(_mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(longitude + i + 1), _mm256_loadu_pd(longitude + i)), toRad));
+
+		__m256d y   = _mm256_mul_pd(dLam.sin, phi2.cos);
+		__m256d x   = _mm256_fmsub_pd(phi1.cos, phi2.sin, _mm256_mul_pd(_mm256_mul_pd(phi1.sin, phi2.cos), dLam.cos));
+		__m256d deg = _mm256_mul_pd(arcTan2(y, x), splat(RadToDeg));
+		deg         = _mm256_add_pd(deg, _mm256_and_pd(_mm256_cmp_pd(deg, _mm256_setzero_pd(), _CMP_LT_OQ), splat(360.0)));
+		deg         = _mm256_sub_pd(deg, _mm256_and_pd(_mm256_cmp_pd(deg, splat(360.0), _CMP_GE_OQ), splat(360.0)));
+		_mm256_storeu_pd(out + i, deg);
+	}
+	for ( ; i + 1 < size; i++ ) {
+		out[i] = initialBearing(latitude[i], longitude[i], latitude[i + 1], longitude[i + 1]);
+	}
+}
+
+struct ECEFLanes {
+	__m256d x;
+	__m256d y;
+	__m256d z;
+};
+
+NEMATODE_AVX2 inline ECEFLanes
+ecefLanes(__m256d latitude, __m256d longitude, __m256d altitude)
+{
+	SinCos lat = sinCos(_mm256_mul_pd(latitude, splat(DegToRad)));
+	SinCos lon = sinCos(_mm256_mul_pd(longitude, splat(DegToRad)));
+
+	__m256d N   = _mm256_div_pd(splat(WGS84SemiMajor), _mm256_sqrt_pd(_mm256_fnmadd_pd(splat(WGS84E2), _mm256_mul_pd(lat.sin, lat.sin), splat(1.0))));
+	__m256d rho = _mm256_mul_pd(_mm256_add_pd(N, altitude), lat.cos);
+
+	ECEFLanes point;
+	point.x = _mm256_mul_pd(rho, lon.cos);
+	point.y = _mm256_mul_pd(rho, lon.sin);
+	point.z = _mm256_mul_pd(_mm256_fmadd_pd(N, splat(1 - WGS84E2), altitude), lat.sin);
+	return point;
+}
+
+NEMATODE_AVX2 size_t
+toECEFAVX2(const double* latitude, const double* longitude, const double* altitude, size_t size, double* x, double* y, double* z)
+{
+	size_t i = 0;
+	for ( ; i + 4 <= size; i += 4 ) {
+		ECEFLanes point = ecefLanes(_mm256_loadu_pd(latitude + i), _mm256_loadu_pd(longitude + i), _mm256_loadu_pd(altitude + i));
+		_mm256_storeu_pd(x + i, point.x);
+		_mm256_storeu_pd(y + i, point.y);
+		_mm256_storeu_pd(z + i, point.z);
+	}
+	return i;
+}
+
+// rotation rows: east, north, up
+NEMATODE_AVX2 size_t
+toENUAVX2(const ECEF& origin, const double (&rotation)[3][3], const double* latitude, const double* longitude, const double* altitude, size_t size,
+          double* east, double* north, double* up)
+{
+	size_t i = 0;
+	for ( ; i + 4 <= size; i += 4 ) {
+		ECEFLanes point = ecefLanes(_mm256_loadu_pd(latitude + i), _mm256_loadu_pd(longitude + i), _mm256_loadu_pd(altitude + i));
+		__m256d   dx    = _mm256_sub_pd(point.x, splat(origin.x));
+		__m256d   dy    = _mm256_sub_pd(point.y, splat(origin.y));
+		__m256d   dz    = _mm256_sub_pd(point.z, splat(origin.z));
+
+		double* outputs[3] = { east, north, up };
+		for ( int row = 0; row < 3; row++ ) {
+			__m256d value = _mm256_mul_pd(dx, splat(rotation[row][0]));
+			value         = _mm256_fmadd_pd(dy, splat(rotation[row][1]), value);
+			value         = _mm256_fmadd_pd(dz, splat(rotation[row][2]), value);
+			_mm256_storeu_pd(outputs[row] + i, value);
+		}
+	}
+	return i;
+}
+
+// 64 bit lanes of whole numbers in [0, 2^52) as integers
+NEMATODE_AVX2 inline __m256i
+toIntegers(__m256d value)
+{
+	const __m256d magic = splat(4503599627370496.0); // 2^52
+	return _mm256_xor_si256(_mm256_castpd_si256(_mm256_add_pd(value, magic)), _mm256_castpd_si256(magic));
+}
+
+NEMATODE_AVX2 inline __m256i
+spreadLanes(__m256i value)
+{
+	value = _mm256_and_si256(_mm256_or_si256(value, _mm256_slli_epi64(value, 16)), _mm256_set1_epi64x(0x0000FFFF0000FFFFLL));
+	value = _mm256_and_si256(_mm256_or_si256(value, _mm256_slli_epi64(value, 8)), _mm256_set1_epi64x(0x00FF00FF00FF00FFLL));
+	value = _mm256_and_si256(_mm256_or_si256(value, _mm256_slli_epi64(value, 4)), _mm256_set1_epi64x(0x0F0F0F0F0F0F0F0FLL));
+	value = _mm256_and_si256(_mm256_or_si256(value, _mm256_slli_epi64(value, 2)), _mm256_set1_epi64x(0x3333333333333333LL));
+	value = _mm256_and_si256(_mm256_or_si256(value, _mm256_slli_epi64(value, 1)), _mm256_set1_epi64x(0x5555555555555555LL));
+	return value;
+}
+
+NEMATODE_AVX2 inline __m256d
+cellLanes(__m256d value, double low, double span, int bits)
+{
+	double  cells = ldexp(1.0, bits);
+	__m256d index = _mm256_floor_pd(_mm256_mul_pd(_mm256_sub_pd(value, splat(low)), splat(cells / span)));
+	return _mm256_min_pd(_mm256_max_pd(index, _mm256_setzero_pd()), splat(cells - 1));
+}
+
+NEMATODE_AVX2 size_t
+geohashBitsAVX2(const double* latitude, const double* longitude, size_t size, int lonBits, int latBits, uint64_t* out)
+{
+	size_t i = 0;
+	for ( ; i + 4 <= size; i += 4 ) {
+		__m256i lon = spreadLanes(toIntegers(cellLanes(_mm256_loadu_pd(longitude + i), -180, 360, lonBits)));
+		__m256i lat = spreadLanes(toIntegers(cellLanes(_mm256_loadu_pd(latitude + i), -90, 180, latBits)));
+		__m256i hash = lonBits > latBits ? _mm256_or_si256(lon, _mm256_slli_epi64(lat, 1)) : _mm256_or_si256(_mm256_slli_epi64(lon, 1), lat);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), hash);
+	}
+	return i;
+}
+
+} // namespace
+
+static bool
+hasAVX2()
+{
+	static const bool has = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	return has;
+}
+
+#else
+
+static bool
+hasAVX2()
+{
+	return false;
+}
+
+#endif
+
+// ------------- BATCH KERNELS -------------
+
+bool
+nmea::geodesyUsesAVX2()
+{
+	return hasAVX2();
+}
+
+void
+nmea::haversineSegments(const double* latitude, const double* longitude, size_t size, double* out)
+{
+#ifdef NEMATODE_GEODESY_AVX2
+	if ( hasAVX2() ) {
+		haversineSegmentsAVX2(latitude, longitude, size, out);
+		return;
+	}
+#endif
+	for ( size_t i = 0; i + 1 < size; i++ ) {
+		out[i] = haversineDistance(latitude[i], longitude[i], latitude[i + 1], longitude[i + 1]);
+	}
+}
+
+void
+nmea::vincentySegments(const double* latitude, const double* longitude, size_t size, double* out)
+{
+	for ( size_t i = 0; i + 1 < size; i++ ) {
+		out[i] = vincentyDistance(latitude[i], longitude[i], latitude[i + 1], longitude[i + 1]);
+	}
+}
+
+void
+nmea::bearingSegments(const double* latitude, const double* longitude, size_t size, double* out)
+{
+#ifdef NEMATODE_GEODESY_AVX2
+	if ( hasAVX2() ) {
+		bearingSegmentsAVX2(latitude, longitude, size, out);
+		return;
+	}
+#endif
+	for ( size_t i = 0; i + 1 < size; i++ ) {
+		out[i] = initialBearing(latitude[i], longitude[i], latitude[i + 1], longitude[i + 1]);
+	}
+}
+
+double
+nmea::odometer(const double* latitude, const double* longitude, size_t size)
+{
+#ifdef NEMATODE_GEODESY_AVX2
+	if ( hasAVX2() ) {
+		return odometerAVX2(latitude, longitude, size);
+	}
+#endif
+	double total = 0;
+	for ( size_t i = 0; i + 1 < size; i++ ) {
+		total += haversineDistance(latitude[i], longitude[i], latitude[i + 1], longitude[i + 1]);
+	}
+	return total;
+}
+
+double
+nmea::odometer(const CoordinateArrays& track)
+{
+	return odometer(track.latitude_.data(), track.longitude_.data(), track.size());
+}
+
+void
+nmea::toECEF(const double* latitude, const double* longitude, const double* altitude, size_t size, double* x, double* y, double* z)
+{
+	size_t i = 0;
+#ifdef NEMATODE_GEODESY_AVX2
+	if ( hasAVX2() ) {
+		i = toECEFAVX2(latitude, longitude, altitude, size, x, y, z);
+	}
+#endif
+	for ( ; i < size; i++ ) {
+		ECEF point = toECEF(latitude[i], longitude[i], altitude[i]);
+		x[i]       = point.x;
+		y[i]       = point.y;
+		z[i]       = point.z;
+	}
+}
+
+void
+nmea::geohashBits(const double* latitude, const double* longitude, size_t size, int precision, uint64_t* out)
+{
+	size_t i = 0;
+#ifdef NEMATODE_GEODESY_AVX2
+	if ( hasAVX2() ) {
+		int lonBits = 0;
+		int latBits = 0;
+		geohashSplit(precision, lonBits, latBits);
+		i = geohashBitsAVX2(latitude, longitude, size, lonBits, latBits, out);
+	}
+#endif
+	for ( ; i < size; i++ ) {
+		out[i] = geohashBits(latitude[i], longitude[i], precision);
+	}
+}
+
+// ------------- LOCAL FRAME -------------
+
+LocalFrame::LocalFrame(double latitude, double longitude, double altitude)
+    : origin_(nmea::toECEF(latitude, longitude, altitude))
+    , sinLat_(sin(latitude * DegToRad))
+    , cosLat_(cos(latitude * DegToRad))
+    , sinLon_(sin(longitude * DegToRad))
+    , cosLon_(cos(longitude * DegToRad))
+{
+}
+
+ENU
+LocalFrame::toENU(const ECEF& point) const
+{
+	double dx = point.x - origin_.x;
+	double dy = point.y - origin_.y;
+	double dz = point.z - origin_.z;
+
+	ENU local;
+	local.east  = -sinLon_ * dx + cosLon_ * dy;
+	local.north = -sinLat_ * cosLon_ * dx - sinLat_ * sinLon_ * dy + cosLat_ * dz;
+	local.up    = cosLat_ * cosLon_ * dx + cosLat_ * sinLon_ * dy + sinLat_ * dz;
+	return local;
+}
+
+ENU
+LocalFrame::toENU(double latitude, double longitude, double altitude) const
+{
+	return toENU(nmea::toECEF(latitude, longitude, altitude));
+}
+
+void
+LocalFrame::toENU(const double* latitude, const double* longitude, const double* altitude, size_t size, double* east, double* north, double* up) const
+{
+	size_t i = 0;
+#ifdef NEMATODE_GEODESY_AVX2
+	if ( hasAVX2() ) {
+		const double rotation[3][3] = {
+			{ -sinLon_, cosLon_, 0 },
+			{ -sinLat_ * cosLon_, -sinLat_ * sinLon_, cosLat_ },
+			{ cosLat_ * cosLon_, cosLat_ * sinLon_, sinLat_ },
+		};
+		i = toENUAVX2(origin_, rotation, latitude, longitude, altitude, size, east, north, up);
+	}
+#endif
+	for ( ; i < size; i++ ) {
+		ENU local = toENU(latitude[i], longitude[i], altitude[i]);
+		east[i]   = local.east;
+		north[i]  = local.north;
+		up[i]     = local.up;
+	}
+}
+
+void
+LocalFrame::toENU(const CoordinateArrays& track, double* east, double* north, double* up) const
+{
+	toENU(track.latitude_.data(), track.longitude_.data(), track.altitude_.data(), track.size(), east, north, up);
+}
@@ -0,0 +1,315 @@
+/*
+ * Geofence.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/Geofence.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "nmeaparse/GPSService.hpp"
+
+using namespace std;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+// Cells are widened by this much (degrees) when looking for edges, so a point
+// rounding into a neighbouring cell still finds the edge next to it.
+static constexpr double CellMargin = 1e-9;
+
+// Liang-Barsky: does the segment a-b touch the box low-high?
+static bool
+segmentTouchesBox(const GeoPoint& a, const GeoPoint& b, const GeoPoint& low, const GeoPoint& high)
+{
+	double dx    = b.longitude_ - a.longitude_;
+	double dy    = b.latitude_ - a.latitude_;
+	double p[4]  = { -dx, dx, -dy, dy };
+	double q[4]  = { a.longitude_ - low.longitude_, high.longitude_ - a.longitude_, a.latitude_ - low.latitude_, high.latitude_ - a.latitude_ };
+	double enter = 0;
+	double leave = 1;
+	for ( int i = 0; i < 4; i++ ) {
+		if ( p[i] == 0 ) {
+			if ( q[i] < 0 ) {
+				return false; // parallel and outside
+			}
+		}
+		else {
+			double t = q[i] / p[i];
+			if ( p[i] < 0 ) {
+				enter = max(enter, t);
+			}
+			else {
+				leave = min(leave, t);
+			}
+		}
+	}
+	return enter <= leave;
+}
+
+// ------------- GEOFENCE ENGINE -------------
+
+GeofenceEngine::GeofenceEngine(double cellSize)
+    : cellSize_(cellSize)
+{
+	if ( !(cellSize > 0) ) {
+		throw invalid_argument("GeofenceEngine cell size must be positive");
+	}
+}
+
+uint64_t
+GeofenceEngine::cellOf(double latitude, double longitude) const
+{
+	auto column = static_cast<uint32_t>(static_cast<int64_t>(floor((longitude + 180) / cellSize_)));
+	auto row    = static_cast<uint32_t>(static_cast<int64_t>(floor((latitude + 90) / cellSize_)));
+	return (static_cast<uint64_t>(column) << 32) | row;
+}
+
+bool
+GeofenceEngine::boxTouchesEdge(const Fence& fence, const GeoPoint& low, const GeoPoint& high) const
+{
+	const auto& polygon = fence.polygon_;
+	for ( size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++ ) {
+		const GeoPoint& a = polygon[j];
+		const GeoPoint& b = polygon[i];
+		if ( max(a.longitude_, b.longitude_) < low.longitude_ || min(a.longitude_, b.longitude_) > high.longitude_
+		     || max(a.latitude_, b.latitude_) < low.latitude_ || min(a.latitude_, b.latitude_) > high.latitude_ ) {
+			continue;
+		}
+		if ( segmentTouchesBox(a, b, low, high) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Crossing number, latitude up and longitude right
+bool
+GeofenceEngine::contains(const Fence& fence, double latitude, double longitude) const
+{
+	if ( latitude < fence.min_.latitude_ || latitude > fence.max_.latitude_ || longitude < fence.min_.longitude_ || longitude > fence.max_.longitude_ ) {
+		return false;
+	}
+
+	const auto& polygon = fence.polygon_;
+	bool        inside  = false;
+	for ( size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++ ) {
+		const GeoPoint& a = polygon[i];
+		const GeoPoint& b = polygon[j];
+		if ( (a.latitude_ > latitude) != (b.latitude_ > latitude) ) {
+			double crossing = a.longitude_ + (latitude - a.latitude_) * (b.longitude_ - a.longitude_) / (b.latitude_ - a.latitude_);
+			if ( longitude < crossing ) {
+				inside = !inside;
+			}
+		}
+	}
+	return inside;
+}
+
+GeofenceEngine::FenceId
+GeofenceEngine::addFence(vector<GeoPoint> polygon)
+{
+	if ( polygon.size() < 3 ) {
+		throw invalid_argument("A geofence needs at least 3 points");
+	}
+
+	Fence fence;
+	fence.polygon_ = move(polygon);
+	fence.min_     = fence.polygon_[0];
+	fence.max_     = fence.polygon_[0];
+	for ( const auto& point: fence.polygon_ ) {
+		fence.min_.latitude_  = min(fence.min_.latitude_, point.latitude_);
+		fence.min_.longitude_ = min(fence.min_.longitude_, point.longitude_);
+		fence.max_.latitude_  = max(fence.max_.latitude_, point.latitude_);
+		fence.max_.longitude_ = max(fence.max_.longitude_, point.longitude_);
+	}
+
+	// every cell of the bounding box is inside, outside or on an edge
+	auto id       = static_cast<FenceId>(fences_.size());
+	auto firstCol = static_cast<int64_t>(floor((fence.min_.longitude_ + 180) / cellSize_));
+	auto lastCol  = static_cast<int64_t>(floor((fence.max_.longitude_ + 180) / cellSize_));
+	auto firstRow = static_cast<int64_t>(floor((fence.min_.latitude_ + 90) / cellSize_));
+	auto lastRow  = static_cast<int64_t>(floor((fence.max_.latitude_ + 90) / cellSize_));
+	for ( int64_t col = firstCol; col <= lastCol; col++ ) {
+		for ( int64_t row = firstRow; row <= lastRow; row++ ) {
+			GeoPoint low;
+			GeoPoint high;
+			low.longitude_  = static_cast<double>(col) * cellSize_ - 180 - CellMargin;
+			low.latitude_   = static_cast<double>(row) * cellSize_ - 90 - CellMargin;
+			high.longitude_ = static_cast<double>(col + 1) * cellSize_ - 180 + CellMargin;
+			high.latitude_  = static_cast<double>(row + 1) * cellSize_ - 90 + CellMargin;
+
+			CellEntry entry{ id, true };
+			if ( !boxTouchesEdge(fence, low, high) ) {
+				// no edge in the cell, so its center tells for all of it
+				if ( !contains(fence, (low.latitude_ + high.latitude_) / 2, (low.longitude_ + high.longitude_) / 2) ) {
+					continue;
+				}
+				entry.boundary_ = false;
+			}
+			uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(col)) << 32) | static_cast<uint32_t>(row);
+			cells_[key].push_back(entry); // ids only grow, so every cell stays sorted
+		}
+	}
+
+	fences_.push_back(move(fence));
+	generation_++;
+	return id;
+}
+
+void
+GeofenceEngine::place(VehicleId id, Vehicle& vehicle, double latitude, double longitude)
+{
+	uint64_t cell     = cellOf(latitude, longitude);
+	bool     sameCell = vehicle.placed_ && vehicle.cell_ == cell && vehicle.generation_ == generation_;
+	if ( sameCell && vehicle.position_.latitude_ == latitude && vehicle.position_.longitude_ == longitude ) {
+		return; // the other sentences of the same epoch
+	}
+
+	vehicle.position_.latitude_  = latitude;
+	vehicle.position_.longitude_ = longitude;
+
+	auto found = cells_.find(cell);
+	if ( sameCell
+	     && (found == cells_.end() || none_of(found->second.begin(), found->second.end(), [](const CellEntry& entry) { return entry.boundary_; })) ) {
+		return; // nothing in this cell depends on where exactly the vehicle is
+	}
+
+	scratch_.clear();
+	if ( found != cells_.end() ) {
+		for ( const auto& entry: found->second ) {
+			if ( entry.boundary_ ) {
+				pointTests_++;
+				if ( !contains(fences_[entry.fence_], latitude, longitude) ) {
+					continue;
+				}
+			}
+			scratch_.push_back(entry.fence_);
+		}
+	}
+
+	vehicle.cell_       = cell;
+	vehicle.generation_ = generation_;
+	vehicle.placed_     = true;
+	vehicle.inside_.swap(scratch_);
+
+	// both sorted, walk them together: scratch_ now has the fences before the move
+	const auto& before = scratch_;
+	const auto& after  = vehicle.inside_;
+	size_t      i      = 0;
+	size_t      j      = 0;
+	while ( i < before.size() || j < after.size() ) {
+		if ( j == after.size() || (i < before.size() && before[i] < after[j]) ) {
+			onExit(id, before[i++]);
+		}
+		else if ( i == before.size() || after[j] < before[i] ) {
+			onEnter(id, after[j++]);
+		}
+		else {
+			i++;
+			j++;
+		}
+	}
+}
+
+void
+GeofenceEngine::update(VehicleId vehicle, double latitude, double longitude)
+{
+	place(vehicle, vehicles_[vehicle], latitude, longitude);
+}
+
+void
+GeofenceEngine::update(const VehicleId* vehicles, const double* latitude, const double* longitude, size_t size)
+{
+	for ( size_t i = 0; i < size; i++ ) {
+		place(vehicles[i], vehicles_[vehicles[i]], latitude[i], longitude[i]);
+	}
+}
+
+void
+GeofenceEngine::attachToService(GPSService& gps, VehicleId vehicle)
+{
+	gps.onUpdate += [this, &gps, vehicle]() {
+		if ( gps.fix_.locked() ) {
+			update(vehicle, gps.fix_.latitude_, gps.fix_.longitude_);
+		}
+	};
+}
+
+const vector<GeofenceEngine::FenceId>&
+GeofenceEngine::fencesOf(VehicleId vehicle) const
+{
+	static const vector<FenceId> none;
+
+	auto found = vehicles_.find(vehicle);
+	return found != vehicles_.end() ? found->second.inside_ : none;
+}
+
+bool
+GeofenceEngine::contains(FenceId fence, double latitude, double longitude) const
+{
+	return fence < fences_.size() && contains(fences_[fence], latitude, longitude);
+}
+
+void
+GeofenceEngine::removeVehicle(VehicleId vehicle)
+{
+	vehicles_.erase(vehicle);
+}
+
+void
+GeofenceEngine::clear()
+{
+	fences_.clear();
+	cells_.clear();
+	vehicles_.clear();
+	generation_++;
+}
+
+size_t
+GeofenceEngine::fences() const
+{
+	return fences_.size();
+}
+
+size_t
+GeofenceEngine::vehicles() const
+{
+	return vehicles_.size();
+}
+
+size_t
+GeofenceEngine::cells() const
+{
+	return cells_.size();
+}
+
+uint64_t
+GeofenceEngine::pointTests() const
+{
+	return pointTests_;
+}
+
+size_t
+GeofenceEngine::memoryUsage() const
+{
+	// hash nodes hold the value plus a link and the cached hash
+	const size_t nodeOverhead = 2 * sizeof(void*);
+
+	size_t bytes = sizeof(*this) + fences_.capacity() * sizeof(Fence) + cells_.bucket_count() * sizeof(void*)
+	               + vehicles_.bucket_count() * sizeof(void*);
+	for ( const auto& fence: fences_ ) {
+		bytes += fence.polygon_.capacity() * sizeof(GeoPoint);
+	}
+	for ( const auto& cell: cells_ ) {
+		bytes += sizeof(cell) + nodeOverhead + cell.second.capacity() * sizeof(CellEntry);
+	}
+	for ( const auto& vehicle: vehicles_ ) {
+		bytes += sizeof(vehicle) + nodeOverhead + vehicle.second.inside_.capacity() * sizeof(FenceId);
+	}
+	return bytes;
+}
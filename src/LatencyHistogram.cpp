@@ -0,0 +1,286 @@
+/*
+ * LatencyHistogram.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/LatencyHistogram.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+#include "nmeaparse/SentenceKey.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace nmea;
+
+// ===========================================================
+// ======================== HISTOGRAM ========================
+// ===========================================================
+
+static uint32_t
+highestBit(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return 63U - static_cast<uint32_t>(__builtin_clzll(value));
+#else
+	uint32_t bit = 0;
+	while ( value >>= 1 ) {
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+uint32_t
+LatencyHistogram::bucketIndex(uint64_t value)
+{
+	if ( value < SubBucketCount ) {
+		return static_cast<uint32_t>(value);
+	}
+
+	uint32_t msb = highestBit(value);
+	if ( msb >= MaxValueBits ) {
+		return BucketCount - 1;
+	}
+
+	uint32_t shift = msb - SubBucketBits;
+	return (shift + 1) * SubBucketCount + static_cast<uint32_t>((value >> shift) & (SubBucketCount - 1));
+}
+
+uint64_t
+LatencyHistogram::bucketUpperBound(uint32_t index)
+{
+	if ( index < SubBucketCount ) {
+		return index;
+	}
+
+	uint32_t shift = index / SubBucketCount - 1;
+	uint64_t lower = static_cast<uint64_t>(SubBucketCount + index % SubBucketCount) << shift;
+	return lower + (uint64_t(1) << shift) - 1;
+}
+
+void
+LatencyHistogram::record(uint64_t nanoseconds)
+{
+	buckets_[bucketIndex(nanoseconds)].fetch_add(1, memory_order_relaxed);
+	count_.fetch_add(1, memory_order_relaxed);
+	sum_.fetch_add(nanoseconds, memory_order_relaxed);
+
+	uint64_t prev = max_.load(memory_order_relaxed);
+	while ( prev < nanoseconds && !max_.compare_exchange_weak(prev, nanoseconds, memory_order_relaxed) ) {
+	}
+}
+
+void
+LatencyHistogram::record(nanoseconds duration)
+{
+	record(duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0);
+}
+
+void
+LatencyHistogram::reset()
+{
+	for ( auto& bucket: buckets_ ) {
+		bucket.store(0, memory_order_relaxed);
+	}
+	count_.store(0, memory_order_relaxed);
+	sum_.store(0, memory_order_relaxed);
+	max_.store(0, memory_order_relaxed);
+}
+
+uint64_t
+LatencyHistogram::count() const
+{
+	return count_.load(memory_order_relaxed);
+}
+
+uint64_t
+LatencyHistogram::max() const
+{
+	return max_.load(memory_order_relaxed);
+}
+
+double
+LatencyHistogram::mean() const
+{
+	uint64_t num = count();
+	if ( num == 0 ) {
+		return 0.0;
+	}
+	return static_cast<double>(sum_.load(memory_order_relaxed)) / static_cast<double>(num);
+}
+
+uint64_t
+LatencyHistogram::percentile(double pct) const
+{
+	uint64_t total = count();
+	if ( total == 0 ) {
+		return 0;
+	}
+
+	auto     wanted = static_cast<uint64_t>(pct / 100.0 * static_cast<double>(total) + 0.5);
+	uint64_t seen   = 0;
+	if ( wanted == 0 ) {
+		wanted = 1;
+	}
+
+	for ( uint32_t i = 0; i < BucketCount; i++ ) {
+		seen += buckets_[i].load(memory_order_relaxed);
+		if ( seen >= wanted ) {
+			// the last bucket also holds everything above its bound
+			uint64_t upper = i == BucketCount - 1 ? max() : bucketUpperBound(i);
+			return upper < max() ? upper : max();
+		}
+	}
+	return max();
+}
+
+// ===========================================================
+// ======================== TRACKER ==========================
+// ===========================================================
+
+const char*
+nmea::latencyStageName(LatencyStage stage)
+{
+	switch ( stage ) {
+	case LatencyStage::Receive:
+		return "receive";
+	case LatencyStage::Parse:
+		return "parse";
+	case LatencyStage::Dispatch:
+		return "dispatch";
+	case LatencyStage::Handler:
+		return "handler";
+	case LatencyStage::Total:
+		return "total";
+	default:
+		return "unknown";
+	}
+}
+
+LatencyTracker::~LatencyTracker()
+{
+	for ( auto& slot: slots_ ) {
+		delete slot.histograms.load(memory_order_acquire);
+	}
+}
+
+LatencyTracker::StageHistograms*
+LatencyTracker::find(uint64_t key, bool create)
+{
+	if ( key == 0 ) {
+		return &other_;
+	}
+
+	// open addressing, a slot is owned by whoever swaps its key away from 0 first
+	auto start = static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 58) % MaxSentenceTypes;
+	for ( size_t n = 0; n < MaxSentenceTypes; n++ ) {
+		Slot&    slot    = slots_[(start + n) % MaxSentenceTypes];
+		uint64_t current = slot.key.load(memory_order_acquire);
+
+		if ( current == 0 ) {
+			if ( !create ) {
+				return nullptr;
+			}
+			if ( !slot.key.compare_exchange_strong(current, key, memory_order_acq_rel) && current != key ) {
+				continue; // somebody else claimed it for another name
+			}
+			if ( current == 0 ) {
+				slot.histograms.store(new StageHistograms(), memory_order_release);
+			}
+		}
+		else if ( current != key ) {
+			continue;
+		}
+
+		// null only for a moment while the owner is still allocating
+		return slot.histograms.load(memory_order_acquire);
+	}
+	return create ? &other_ : nullptr;
+}
+
+void
+LatencyTracker::record(string_view name, const Sample& sample)
+{
+	StageHistograms* hists = find(sentenceKey(name), true);
+	if ( hists == nullptr ) {
+		return;
+	}
+
+	(*hists)[static_cast<size_t>(LatencyStage::Receive)].record(sample.terminated - sample.received);
+	(*hists)[static_cast<size_t>(LatencyStage::Parse)].record(sample.parsed - sample.terminated);
+	(*hists)[static_cast<size_t>(LatencyStage::Dispatch)].record(sample.dispatched - sample.parsed);
+	(*hists)[static_cast<size_t>(LatencyStage::Handler)].record(sample.returned - sample.dispatched);
+	(*hists)[static_cast<size_t>(LatencyStage::Total)].record(sample.returned - sample.received);
+}
+
+void
+LatencyTracker::record(string_view name, LatencyStage stage, nanoseconds duration)
+{
+	StageHistograms* hists = find(sentenceKey(name), true);
+	if ( hists != nullptr ) {
+		(*hists)[static_cast<size_t>(stage)].record(duration);
+	}
+}
+
+const LatencyHistogram*
+LatencyTracker::histogram(string_view name, LatencyStage stage) const
+{
+	const StageHistograms* hists = const_cast<LatencyTracker*>(this)->find(sentenceKey(name), false);
+	if ( hists == nullptr ) {
+		return nullptr;
+	}
+	return &(*hists)[static_cast<size_t>(stage)];
+}
+
+void
+LatencyTracker::reset()
+{
+	for ( auto& slot: slots_ ) {
+		StageHistograms* hists = slot.histograms.load(memory_order_acquire);
+		if ( hists != nullptr ) {
+			for ( auto& hist: *hists ) {
+				hist.reset();
+			}
+		}
+	}
+	for ( auto& hist: other_ ) {
+		hist.reset();
+	}
+}
+
+string
+LatencyTracker::toString() const
+{
+	ostringstream strm;
+	strm << "Sentence  Stage          Count     p50 ns     p90 ns     p99 ns     max ns" << endl;
+
+	auto print = [&strm](const string& name, const StageHistograms& hists) {
+		for ( size_t i = 0; i < hists.size(); i++ ) {
+			const LatencyHistogram& hist = hists[i];
+			if ( hist.count() == 0 ) {
+				continue;
+			}
+			strm << left << setw(10) << name << setw(10) << latencyStageName(static_cast<LatencyStage>(i)) << right
+			     << setw(10) << hist.count()
+			     << setw(11) << hist.percentile(50)
+			     << setw(11) << hist.percentile(90)
+			     << setw(11) << hist.percentile(99)
+			     << setw(11) << hist.max() << endl;
+		}
+	};
+
+	for ( const auto& slot: slots_ ) {
+		const StageHistograms* hists = slot.histograms.load(memory_order_acquire);
+		if ( hists != nullptr ) {
+			char name[8];
+			print(string(name, sentenceKeyName(slot.key.load(memory_order_relaxed), name)), *hists);
+		}
+	}
+	print("other", other_);
+
+	return strm.str();
+}
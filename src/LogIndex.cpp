@@ -0,0 +1,406 @@
+/*
+ * LogIndex.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/LogIndex.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+
+#include "nmeaparse/GPSService.hpp"
+#include "nmeaparse/NMEAParser.hpp"
+#include "nmeaparse/NumberConversion.hpp"
+#include "nmeaparse/StaticSentence.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+namespace {
+
+constexpr char         Magic[8] = { 'N', 'M', 'E', 'A', 'I', 'D', 'X', '\0' };
+constexpr milliseconds Day      = hours(24);
+
+// The UTC times of the epochs in a log, line by line
+class EpochClock {
+private:
+	UTCTime midnight_{}; // of the day of the last time, from RMC
+	UTCTime last_{};
+	bool    hasDate_{ false };
+
+public:
+	// Continues from a known time, e.g. an index entry
+	void start(UTCTime time)
+	{
+		midnight_ = UTCTime(time.time_since_epoch() - time.time_since_epoch() % Day);
+		last_     = time;
+		hasDate_  = true;
+	}
+
+	// The time of a good RMC or GGA sentence, false for every other line
+	bool timeOf(string_view line, UTCTime& time)
+	{
+		// "$GPRMC,hhmmss.ss,..." or "$GPGGA,hhmmss.ss,...", with a good checksum
+		while ( !line.empty() && (line.back() == '\r' || line.back() == '\n') ) {
+			line.remove_suffix(1);
+		}
+		size_t star = line.rfind('*');
+		if ( line.size() < 11 || line[0] != '$' || line[6] != ',' || star == string_view::npos || star + 3 != line.size() ) {
+			return false;
+		}
+		string_view type = line.substr(3, 3);
+		bool        rmc  = type == "RMC";
+		if ( !rmc && type != "GGA" ) {
+			return false;
+		}
+		uint8_t checksum = 0;
+		auto    result   = from_chars(line.data() + star + 1, line.data() + line.size(), checksum, 16);
+		if ( result.ec != errc() || checksum != xorChecksum(line.substr(1, star - 1)) ) {
+			return false;
+		}
+
+		string_view fields = line.substr(7, star - 7);
+		size_t      comma  = fields.find(',');
+		string_view clock  = fields.substr(0, comma);
+		if ( clock.empty() ) {
+			return false;
+		}
+
+		try {
+			GPSTimestamp stamp;
+			stamp.setTime(parseDouble(clock));
+			if ( rmc ) {
+				// the date is the 9th field, after 8 commas
+				size_t pos = comma;
+				for ( int field = 1; field < 8 && pos != string_view::npos; field++ ) {
+					pos = fields.find(',', pos + 1);
+				}
+				if ( pos == string_view::npos ) {
+					return false;
+				}
+				string_view date = fields.substr(pos + 1, fields.find(',', pos + 1) - pos - 1);
+				if ( date.empty() ) {
+					return false;
+				}
+				stamp.setDate(static_cast<int32_t>(parseInt(date)));
+				UTCTime midnight = stamp.toUTCTime();
+				midnight_        = UTCTime(midnight.time_since_epoch() - midnight.time_since_epoch() % Day);
+				hasDate_         = true;
+			}
+			if ( !hasDate_ ) {
+				return false;
+			}
+
+			stamp.year_  = 1970; // time of day only
+			stamp.month_ = 1;
+			stamp.day_   = 1;
+			time         = midnight_ + stamp.toUTCTime().time_since_epoch();
+			if ( !rmc && time + Day / 2 < last_ ) {
+				midnight_ += Day; // GGA past midnight, before the next RMC
+				time += Day;
+			}
+		}
+		catch ( NumberConversionError& ) {
+			return false;
+		}
+		last_ = time;
+		return true;
+	}
+};
+
+void
+putU32(ostream& out, uint32_t value)
+{
+	char bytes[4];
+	for ( int i = 0; i < 4; i++ ) {
+		bytes[i] = static_cast<char>(value >> (8 * i));
+	}
+	out.write(bytes, sizeof(bytes));
+}
+
+void
+putU64(ostream& out, uint64_t value)
+{
+	putU32(out, static_cast<uint32_t>(value));
+	putU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+// 7 bits per byte, low first, the top bit set on all but the last
+void
+putVarint(ostream& out, uint64_t value)
+{
+	char   bytes[10];
+	size_t size = 0;
+	while ( value >= 0x80 ) {
+		bytes[size++] = static_cast<char>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	bytes[size++] = static_cast<char>(value);
+	out.write(bytes, static_cast<streamsize>(size));
+}
+
+uint64_t
+getU64(istream& in, int bytes)
+{
+	uint64_t value = 0;
+	for ( int i = 0; i < bytes; i++ ) {
+		int byte = in.get();
+		if ( byte == char_traits<char>::eof() ) {
+			throw runtime_error("Truncated log index");
+		}
+		value |= static_cast<uint64_t>(byte) << (8 * i);
+	}
+	return value;
+}
+
+uint64_t
+getVarint(istream& in)
+{
+	uint64_t value = 0;
+	for ( int shift = 0; shift < 64; shift += 7 ) {
+		int byte = in.get();
+		if ( byte == char_traits<char>::eof() ) {
+			throw runtime_error("Truncated log index");
+		}
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ( (byte & 0x80) == 0 ) {
+			return value;
+		}
+	}
+	throw runtime_error("Bad number in log index");
+}
+
+// Holds back the events of a service while it is primed
+class HeldBack {
+private:
+	GPSService* gps_;
+	bool        updates_{ true };
+	bool        locks_{ true };
+
+public:
+	explicit HeldBack(GPSService* gps)
+	    : gps_(gps)
+	{
+		if ( gps_ != nullptr ) {
+			updates_                         = gps_->onUpdate.enabled;
+			locks_                           = gps_->onLockStateChanged.enabled;
+			gps_->onUpdate.enabled           = false;
+			gps_->onLockStateChanged.enabled = false;
+		}
+	}
+
+	~HeldBack()
+	{
+		if ( gps_ != nullptr ) {
+			gps_->onUpdate.enabled           = updates_;
+			gps_->onLockStateChanged.enabled = locks_;
+		}
+	}
+
+	HeldBack(const HeldBack&)            = delete;
+	HeldBack& operator=(const HeldBack&) = delete;
+};
+
+// getline() that also says how many bytes it took from the stream
+bool
+readLine(istream& in, string& line, uint64_t& offset)
+{
+	if ( !getline(in, line) ) {
+		return false;
+	}
+	offset += line.size() + (in.eof() ? 0 : 1);
+	if ( !line.empty() && line.back() == '\r' ) {
+		line.pop_back();
+	}
+	return true;
+}
+
+} // namespace
+
+// ------------- LOG INDEX -------------
+
+LogIndex::LogIndex(milliseconds interval)
+    : interval_(interval)
+{
+	if ( interval_.count() <= 0 ) {
+		throw invalid_argument("LogIndex interval must be positive");
+	}
+}
+
+void
+LogIndex::build(istream& log)
+{
+	entries_.clear();
+
+	EpochClock clock;
+	string     line;
+	uint64_t   offset = 0;
+	UTCTime    epoch{};
+	UTCTime    time{};
+	while ( true ) {
+		uint64_t start = offset;
+		if ( !readLine(log, line, offset) ) {
+			break;
+		}
+		if ( !clock.timeOf(line, time) || time == epoch ) {
+			continue;
+		}
+		// a new epoch starts here; times going back (a restarted receiver) are left out
+		epoch = time;
+		if ( entries_.empty() || time >= entries_.back().time_ + interval_ ) {
+			entries_.push_back(LogIndexEntry{ time, start });
+		}
+	}
+	logSize_ = offset;
+}
+
+void
+LogIndex::save(ostream& out) const
+{
+	// header, then each entry as the difference to the one before
+	out.write(Magic, sizeof(Magic));
+	putU32(out, Version);
+	putU32(out, static_cast<uint32_t>(interval_.count()));
+	putU64(out, logSize_);
+	putU64(out, entries_.size());
+
+	int64_t  time   = 0;
+	uint64_t offset = 0;
+	for ( const auto& entry: entries_ ) {
+		putVarint(out, static_cast<uint64_t>(entry.time_.time_since_epoch().count() - time));
+		putVarint(out, entry.offset_ - offset);
+		time   = entry.time_.time_since_epoch().count();
+		offset = entry.offset_;
+	}
+}
+
+void
+LogIndex::load(istream& in)
+{
+	char magic[sizeof(Magic)];
+	if ( !in.read(magic, sizeof(magic)) || !equal(magic, magic + sizeof(magic), Magic) ) {
+		throw runtime_error("Not a log index");
+	}
+	if ( getU64(in, 4) != Version ) {
+		throw runtime_error("Unsupported log index version");
+	}
+	auto     interval = milliseconds(static_cast<int64_t>(getU64(in, 4)));
+	uint64_t logSize  = getU64(in, 8);
+	uint64_t count    = getU64(in, 8);
+
+	vector<LogIndexEntry> entries;
+	entries.reserve(static_cast<size_t>(min<uint64_t>(count, 1 << 20))); // grows if there really are more
+	int64_t  time   = 0;
+	uint64_t offset = 0;
+	for ( uint64_t i = 0; i < count; i++ ) {
+		time += static_cast<int64_t>(getVarint(in));
+		offset += getVarint(in);
+		entries.push_back(LogIndexEntry{ UTCTime(milliseconds(time)), offset });
+	}
+
+	entries_.swap(entries);
+	interval_ = interval;
+	logSize_  = logSize;
+}
+
+const LogIndexEntry*
+LogIndex::find(UTCTime time) const
+{
+	if ( entries_.empty() ) {
+		return nullptr;
+	}
+	auto after = upper_bound(entries_.begin(), entries_.end(), time, [](UTCTime t, const LogIndexEntry& entry) { return t < entry.time_; });
+	return after == entries_.begin() ? &entries_.front() : &*(after - 1);
+}
+
+const vector<LogIndexEntry>&
+LogIndex::entries() const
+{
+	return entries_;
+}
+
+milliseconds
+LogIndex::interval() const
+{
+	return interval_;
+}
+
+uint64_t
+LogIndex::logSize() const
+{
+	return logSize_;
+}
+
+// ------------- LOG READER -------------
+
+LogReader::LogReader(istream& log, const LogIndex& index, NMEAParser& parser)
+    : log_(log)
+    , index_(index)
+    , parser_(parser)
+{
+}
+
+bool
+LogReader::seek(UTCTime time, GPSService* prime, milliseconds warmup)
+{
+	const LogIndexEntry* start = index_.find(time - warmup);
+	if ( start == nullptr ) {
+		return false;
+	}
+
+	log_.clear();
+	log_.seekg(static_cast<streamoff>(start->offset_));
+	offset_  = start->offset_;
+	pending_ = false;
+
+	HeldBack   heldBack(prime);
+	EpochClock clock;
+	clock.start(start->time_);
+	UTCTime lineTime{};
+	while ( true ) {
+		lineOffset_ = offset_;
+		if ( !readLine(log_, line_, offset_) ) {
+			break;
+		}
+		if ( clock.timeOf(line_, lineTime) && lineTime >= time ) {
+			pending_ = true; // the first sentence of the epoch, next() reads it
+			return true;
+		}
+		try {
+			parser_.readLine(line_);
+		}
+		catch ( NMEAParseError& ) {
+			// the warm up only needs the good ones
+		}
+	}
+	return false;
+}
+
+bool
+LogReader::next()
+{
+	if ( !pending_ ) {
+		lineOffset_ = offset_;
+		if ( !readLine(log_, line_, offset_) ) {
+			return false;
+		}
+	}
+	pending_ = false;
+	parser_.readLine(line_);
+	return true;
+}
+
+uint64_t
+LogReader::offset() const
+{
+	return pending_ ? lineOffset_ : offset_;
+}
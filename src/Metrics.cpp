@@ -0,0 +1,272 @@
+/*
+ * Metrics.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/Metrics.hpp"
+
+#include <sstream>
+
+#include "nmeaparse/SentenceKey.hpp"
+
+using namespace std;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+static string
+keyToName(uint64_t key)
+{
+	char name[8];
+	return string(name, sentenceKeyName(key, name));
+}
+
+// Names only ever hold [A-Za-z0-9], but keep the output well formed regardless.
+static string
+escapeLabel(const string& str)
+{
+	string out;
+	for ( auto chr: str ) {
+		if ( chr == '"' || chr == '\\' ) {
+			out.push_back('\\');
+		}
+		out.push_back(chr);
+	}
+	return out;
+}
+
+// ------------- METRICS CLASS -------------
+
+const char*
+Metrics::counterName(Counter counter)
+{
+	switch ( counter ) {
+	case BytesIn:
+		return "bytes_in";
+	case Sentences:
+		return "sentences";
+	case ChecksumFailures:
+		return "checksum_failures";
+	case BufferOverflows:
+		return "buffer_overflows";
+	case DiscardedBytes:
+		return "discarded_bytes";
+	case InvalidLines:
+		return "invalid_lines";
+	case InvalidSentences:
+		return "invalid_sentences";
+	case HandlerMisses:
+		return "handler_misses";
+	case DecodeErrors:
+		return "decode_errors";
+	case SkippedSentences:
+		return "skipped_sentences";
+	case SkippedBytes:
+		return "skipped_bytes";
+	default:
+		return "unknown";
+	}
+}
+
+void
+Metrics::NameCounts::add(uint64_t key, uint64_t value)
+{
+	if ( key != 0 ) {
+		auto start = static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 58) % MaxSentenceTypes;
+		for ( size_t n = 0; n < MaxSentenceTypes; n++ ) {
+			size_t   i       = (start + n) % MaxSentenceTypes;
+			uint64_t current = keys[i].load(memory_order_relaxed);
+			if ( current == 0 && keys[i].compare_exchange_strong(current, key, memory_order_relaxed) ) {
+				current = key;
+			}
+			if ( current == key ) {
+				counts[i].fetch_add(value, memory_order_relaxed);
+				return;
+			}
+		}
+	}
+	other.fetch_add(value, memory_order_relaxed);
+}
+
+Metrics::Shard&
+Metrics::localShard()
+{
+	static atomic<size_t>  nextShard{ 0 };
+	thread_local const size_t shard = nextShard.fetch_add(1, memory_order_relaxed) % ShardCount;
+	return shards_[shard];
+}
+
+void
+Metrics::add(Counter counter, uint64_t value)
+{
+	localShard().counters[counter].fetch_add(value, memory_order_relaxed);
+}
+
+void
+Metrics::addSentence(string_view name)
+{
+	Shard& shard = localShard();
+	shard.counters[Sentences].fetch_add(1, memory_order_relaxed);
+	shard.sentences.add(sentenceKey(name), 1);
+}
+
+void
+Metrics::addDecodeError(string_view name)
+{
+	Shard& shard = localShard();
+	shard.counters[DecodeErrors].fetch_add(1, memory_order_relaxed);
+	shard.decodeErrors.add(sentenceKey(name), 1);
+}
+
+void
+Metrics::trackMemory(const string& name, function<size_t()> probe)
+{
+	lock_guard<mutex> lock(probesMutex_);
+	memoryProbes_[name] = std::move(probe);
+}
+
+void
+Metrics::untrackMemory(const string& name)
+{
+	lock_guard<mutex> lock(probesMutex_);
+	memoryProbes_.erase(name);
+}
+
+uint64_t
+Metrics::get(Counter counter) const
+{
+	uint64_t total = 0;
+	for ( const auto& shard: shards_ ) {
+		total += shard.counters[counter].load(memory_order_relaxed);
+	}
+	return total;
+}
+
+void
+Metrics::mergeNames(const NameCounts& names, map<string, uint64_t>& out)
+{
+	for ( size_t i = 0; i < MaxSentenceTypes; i++ ) {
+		uint64_t key = names.keys[i].load(memory_order_relaxed);
+		if ( key != 0 ) {
+			out[keyToName(key)] += names.counts[i].load(memory_order_relaxed);
+		}
+	}
+	uint64_t other = names.other.load(memory_order_relaxed);
+	if ( other != 0 ) {
+		out["other"] += other;
+	}
+}
+
+map<string, uint64_t>
+Metrics::sentences() const
+{
+	map<string, uint64_t> out;
+	for ( const auto& shard: shards_ ) {
+		mergeNames(shard.sentences, out);
+	}
+	return out;
+}
+
+map<string, uint64_t>
+Metrics::decodeErrors() const
+{
+	map<string, uint64_t> out;
+	for ( const auto& shard: shards_ ) {
+		mergeNames(shard.decodeErrors, out);
+	}
+	return out;
+}
+
+map<string, size_t>
+Metrics::memory() const
+{
+	lock_guard<mutex>   lock(probesMutex_);
+	map<string, size_t> out;
+	for ( const auto& probe: memoryProbes_ ) {
+		out[probe.first] = probe.second();
+	}
+	return out;
+}
+
+void
+Metrics::reset()
+{
+	for ( auto& shard: shards_ ) {
+		for ( auto& counter: shard.counters ) {
+			counter.store(0, memory_order_relaxed);
+		}
+		for ( auto* names: { &shard.sentences, &shard.decodeErrors } ) {
+			for ( auto& count: names->counts ) {
+				count.store(0, memory_order_relaxed);
+			}
+			names->other.store(0, memory_order_relaxed);
+		}
+	}
+}
+
+string
+Metrics::toPrometheus(const string& labels) const
+{
+	ostringstream strm;
+	string        sep = labels.empty() ? "" : ",";
+
+	for ( int i = 0; i < CounterCount; i++ ) {
+		auto counter = static_cast<Counter>(i);
+		strm << "# TYPE nmea_" << counterName(counter) << "_total counter\n"
+		     << "nmea_" << counterName(counter) << "_total";
+		if ( !labels.empty() ) {
+			strm << "{" << labels << "}";
+		}
+		strm << " " << get(counter) << "\n";
+	}
+
+	strm << "# TYPE nmea_sentences_by_name_total counter\n";
+	for ( const auto& item: sentences() ) {
+		strm << "nmea_sentences_by_name_total{" << labels << sep << "sentence=\"" << escapeLabel(item.first) << "\"} " << item.second << "\n";
+	}
+
+	strm << "# TYPE nmea_decode_errors_by_name_total counter\n";
+	for ( const auto& item: decodeErrors() ) {
+		strm << "nmea_decode_errors_by_name_total{" << labels << sep << "sentence=\"" << escapeLabel(item.first) << "\"} " << item.second << "\n";
+	}
+
+	strm << "# TYPE nmea_memory_bytes gauge\n";
+	for ( const auto& item: memory() ) {
+		strm << "nmea_memory_bytes{" << labels << sep << "instance=\"" << escapeLabel(item.first) << "\"} " << item.second << "\n";
+	}
+
+	return strm.str();
+}
+
+string
+Metrics::toJSON() const
+{
+	ostringstream strm;
+
+	auto object = [&strm](const auto& items) {
+		strm << "{";
+		bool first = true;
+		for ( const auto& item: items ) {
+			strm << (first ? "" : ",") << "\"" << escapeLabel(item.first) << "\":" << item.second;
+			first = false;
+		}
+		strm << "}";
+	};
+
+	strm << "{";
+	for ( int i = 0; i < CounterCount; i++ ) {
+		auto counter = static_cast<Counter>(i);
+		strm << "\"" << counterName(counter) << "\":" << get(counter) << ",";
+	}
+	strm << "\"sentences_by_name\":";
+	object(sentences());
+	strm << ",\"decode_errors_by_name\":";
+	object(decodeErrors());
+	strm << ",\"memory_bytes\":";
+	object(memory());
+	strm << "}";
+
+	return strm.str();
+}
@@ -9,8 +9,8 @@
 
 #include "nmeaparse/NMEACommand.hpp"
 
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <charconv>
 
 using namespace std;
 using namespace nmea;
@@ -26,23 +26,57 @@ NMEACommand::~NMEACommand() = default;
 string
 NMEACommand::toString()
 {
-	return addChecksum(message_);
+	// Fits unless message_ is unusually long, then grow until it does
+	string out(max(MaxSize, name_.size() + message_.size() + 8), '\0');
+	size_t len = 0;
+	while ( (len = encode(&out[0], out.size())) == 0 ) {
+		out.resize(out.size() * 2);
+	}
+	out.resize(len);
+
+	// keep the members in sync with what was sent, like before
+	size_t  fields   = name_.size() + 2;
+	size_t  star     = len - 5;
+	uint8_t checksum = 0;
+	message_.assign(out, fields, star - fields);
+	from_chars(&out[star + 1], &out[star + 3], checksum, 16);
+	checksum_ = static_cast<char>(checksum);
+
+	return out;
 }
 
 string
 NMEACommand::addChecksum(const string& str)
 {
-	stringstream zz;
-	zz << name_ << "," << str;
-	checksum_ = NMEAParser::calculateChecksum(zz.str());
+	string         out(name_.size() + str.size() + 8, '\0');
+	SentenceWriter writer(&out[0], out.size());
+	writer.start(name_).field(str);
+	checksum_ = static_cast<char>(writer.checksum());
+	out.resize(writer.finish());
 
-	stringstream       ss;
-	ios_base::fmtflags oldflags = ss.flags();
-	ss << "$" << zz.str() << "*" << hex << uppercase << internal << setfill('0') << setw(2) << (int) checksum_ << "\r\n";
-	ss.flags(oldflags); // reset
+	return out;
+}
+
+size_t
+NMEACommand::encode(char* out, size_t size) const
+{
+	SentenceWriter writer(out, size);
+	return encode(writer);
+}
 
-	return ss.str();
-};
+size_t
+NMEACommand::encode(SentenceWriter& writer) const
+{
+	writer.start(name_);
+	writeFields(writer);
+	return writer.finish();
+}
+
+void
+NMEACommand::writeFields(SentenceWriter& writer) const
+{
+	writer.field(message_);
+}
 
 /*
 // $PSRF100,0,9600,8,1,0*0C
@@ -59,15 +93,10 @@ Table 2-4 Set Serial Port Data Format
  Checksum	*0C
  <CR> <LF> End of message termination
 */
-string
-NMEACommandSerialConfiguration::toString()
+void
+NMEACommandSerialConfiguration::writeFields(SentenceWriter& writer) const
 {
-	stringstream ss;
-
-	ss << "1," << baud_ << "," << databits_ << "," << stopbits_ << "," << parity_;
-	message_ = ss.str();
-
-	return NMEACommand::addChecksum(message_);
+	writer.field(1).field(baud_).field(databits_).field(stopbits_).field(parity_);
 }
 
 //  $PSRF103,00,01,00,01*25
@@ -102,16 +131,55 @@ NMEACommandSerialConfiguration::toString()
 //   int rate;
 //   int checksumEnable;
 // Creates a valid NMEA $PSRF103 command sentence.
-string
-NMEACommandQueryRate::toString()
+void
+NMEACommandQueryRate::writeFields(SentenceWriter& writer) const
+{
+	writer.field(static_cast<int>(messageID_), 2)
+	    .field(static_cast<int>(mode_), 2)
+	    .field(rate_, 2)
+	    .field(checksumEnable_, 2);
+}
+
+// ------------- NMEACOMMANDBATCH CLASS -------------
+
+NMEACommandBatch::NMEACommandBatch(char* buffer, size_t size)
+    : writer_(buffer, size)
+{
+}
+
+bool
+NMEACommandBatch::add(const NMEACommand& command)
 {
-	stringstream ss;
+	size_t before = writer_.size();
+	if ( command.encode(writer_) == 0 ) {
+		writer_.truncate(before);
+		return false;
+	}
+	count_++;
+	return true;
+}
 
-	ss << setfill('0') << setw(2) << messageID_ << ","
-	   << setfill('0') << setw(2) << mode_ << ","
-	   << setfill('0') << setw(2) << rate_ << ","
-	   << setfill('0') << setw(2) << checksumEnable_;
-	message_ = ss.str();
+void
+NMEACommandBatch::clear()
+{
+	writer_.truncate(0);
+	count_ = 0;
+}
 
-	return NMEACommand::addChecksum(message_);
+const char*
+NMEACommandBatch::data() const
+{
+	return writer_.data();
+}
+
+size_t
+NMEACommandBatch::size() const
+{
+	return writer_.size();
+}
+
+size_t
+NMEACommandBatch::count() const
+{
+	return count_;
 }
@@ -0,0 +1,421 @@
+/*
+ * NMEAGenerator.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/NMEAGenerator.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+#include "nmeaparse/SentenceWriter.hpp"
+#include "nmeaparse/StaticSentence.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+static const double Pi           = 3.14159265358979323846;
+static const double EarthRadius  = 6371008.8; // meters, mean radius
+static const double MetersPerDeg = EarthRadius * Pi / 180.0;
+static const double KnotsPerKmh  = 1.0 / 1.852;
+
+static double
+toRad(double deg)
+{
+	return deg * Pi / 180.0;
+}
+
+static double
+wrap360(double deg)
+{
+	deg = fmod(deg, 360.0);
+	return deg < 0 ? deg + 360.0 : deg;
+}
+
+// ------------- GENERATOR CLASS -------------
+
+NMEAGenerator::NMEAGenerator(NMEAGeneratorSettings settings)
+    : settings_(std::move(settings))
+    , rng_(settings_.seed != 0 ? settings_.seed : 1)
+    , latitude_(settings_.latitude)
+    , longitude_(settings_.longitude)
+    , altitude_(settings_.altitude)
+    , heading_(settings_.heading)
+{
+	if ( settings_.rate <= 0 ) {
+		settings_.rate = 1.0;
+	}
+	if ( settings_.sentences == 0 ) {
+		settings_.sentences = (1U << NMEASentence::GGA) | (1U << NMEASentence::GSA) | (1U << NMEASentence::GSV) | (1U << NMEASentence::RMC) | (1U << NMEASentence::VTG);
+	}
+	for ( size_t id = 0; id < rates_.size(); id++ ) {
+		rates_[id] = (settings_.sentences >> id) & 1U;
+	}
+
+	// "GPGGA" etc. are the same in every sentence, render them and their checksum once
+	static const char* names[] = { "GGA", "GLL", "GSA", "GSV", "RMC", "VTG" };
+	for ( size_t id = 0; id < prefixes_.size(); id++ ) {
+		Prefix&        prefix = prefixes_[id];
+		char           buf[16];
+		SentenceWriter writer(buf, sizeof(buf));
+		writer.start(settings_.talker.substr(0, 2)).append(names[id]);
+		prefix.size     = min(writer.size(), sizeof(prefix.text));
+		prefix.checksum = writer.checksum();
+		copy(buf, buf + prefix.size, prefix.text);
+	}
+
+	settings_.satellites = min<uint32_t>(settings_.satellites, MaxSatellites);
+	for ( uint32_t i = 0; i < settings_.satellites; i++ ) {
+		Satellite& sat = sky_[i];
+		sat.prn        = i + 1;
+		sat.elevation  = 5.0 + uniform() * 80.0;
+		sat.azimuth    = uniform() * 360.0;
+		sat.drift      = (uniform() - 0.5) * 0.02;
+		sat.snr        = 0;
+	}
+	step(0);
+}
+
+// xorshift64*, fast and good enough for simulated noise
+uint64_t
+NMEAGenerator::nextRandom()
+{
+	rng_ ^= rng_ >> 12;
+	rng_ ^= rng_ << 25;
+	rng_ ^= rng_ >> 27;
+	return rng_ * 0x2545F4914F6CDD1DULL;
+}
+
+double
+NMEAGenerator::uniform()
+{
+	return static_cast<double>(nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double
+NMEAGenerator::gaussian()
+{
+	// Box-Muller
+	double u1 = max(uniform(), 1e-300);
+	double u2 = uniform();
+	return sqrt(-2.0 * log(u1)) * cos(2.0 * Pi * u2);
+}
+
+// Moves the receiver and the sky forward
+void
+NMEAGenerator::step(double seconds)
+{
+	double dist = settings_.speed / 3.6 * seconds;
+	double hdg  = toRad(heading_);
+	latitude_ += dist * cos(hdg) / MetersPerDeg;
+	longitude_ += dist * sin(hdg) / (MetersPerDeg * cos(toRad(latitude_)));
+	if ( longitude_ > 180.0 ) {
+		longitude_ -= 360.0;
+	}
+	else if ( longitude_ < -180.0 ) {
+		longitude_ += 360.0;
+	}
+	altitude_ += settings_.climbRate * seconds;
+	heading_ = wrap360(heading_ + settings_.turnRate * seconds);
+
+	for ( uint32_t i = 0; i < settings_.satellites; i++ ) {
+		Satellite& sat = sky_[i];
+		sat.azimuth    = wrap360(sat.azimuth + sat.drift * seconds);
+		// signal gets stronger the higher the satellite, low ones aren't tracked. Triangular jitter is plenty here.
+		sat.snr = sat.elevation < 10.0 ? 0.0 : min(99.0, max(1.0, 20.0 + sat.elevation * 0.3 + (uniform() + uniform() - 1.0) * 2.0));
+	}
+}
+
+void
+NMEAGenerator::setSentenceRate(NMEASentence::MessageID id, uint32_t everyEpochs)
+{
+	if ( id >= 0 && static_cast<size_t>(id) < rates_.size() ) {
+		rates_[static_cast<size_t>(id)] = everyEpochs;
+	}
+}
+
+bool
+NMEAGenerator::readCommand(string_view sentence)
+{
+	// $PSRF103,MM,00,RR,CC*HH, see NMEACommandQueryRate
+	static constexpr string_view RateCommand = "$PSRF103,";
+
+	size_t star = sentence.find('*');
+	if ( sentence.substr(0, RateCommand.size()) != RateCommand || star == string_view::npos || star + 3 > sentence.size() ) {
+		return false;
+	}
+	uint8_t checksum = 0;
+	auto    result   = from_chars(sentence.data() + star + 1, sentence.data() + star + 3, checksum, 16);
+	if ( result.ec != errc() || result.ptr != sentence.data() + star + 3 || checksum != xorChecksum(sentence.substr(1, star - 1)) ) {
+		return false;
+	}
+
+	int         fields[4] = { 0, 0, 0, 0 };
+	const char* pos       = sentence.data() + RateCommand.size();
+	const char* end       = sentence.data() + star;
+	for ( int i = 0; i < 4; i++ ) {
+		result = from_chars(pos, end, fields[i]);
+		if ( result.ec != errc() || (i < 3 && (result.ptr == end || *result.ptr != ',')) ) {
+			return false;
+		}
+		pos = result.ptr + 1;
+	}
+	if ( fields[1] != 0 || fields[0] < 0 || static_cast<size_t>(fields[0]) >= rates_.size() || fields[2] < 0 || fields[2] > 255 ) {
+		return false; // a query, or out of range
+	}
+
+	// seconds to epochs, at least one while on
+	uint32_t every = 0;
+	if ( fields[2] > 0 ) {
+		every = max<uint32_t>(1, static_cast<uint32_t>(lround(fields[2] * settings_.rate)));
+	}
+	setSentenceRate(static_cast<NMEASentence::MessageID>(fields[0]), every);
+	return true;
+}
+
+size_t
+NMEAGenerator::writeGGA(char* out, size_t size, UTCTime time, double lat, double lon, uint32_t used)
+{
+	const Prefix&  prefix = prefixes_[NMEASentence::GGA];
+	int64_t        msec   = time.time_since_epoch().count() % 86400000;
+	SentenceWriter w(out, size);
+
+	w.resume(string_view(prefix.text, prefix.size), prefix.checksum);
+	w.field(static_cast<double>(msec / 60000 / 60 * 10000 + msec / 60000 % 60 * 100) + static_cast<double>(msec % 60000) / 1000.0, 3, 6);
+	w.latitude(lat).longitude(lon);
+	w.field(used >= 4 ? 1 : 0).field(used, 2);
+	w.field(used >= 4 ? 0.9 : 99.9, 1);
+	w.field(altitude_, 1).field('M');
+	w.field(46.9, 1).field('M');
+	w.field().field();
+	return w.finish();
+}
+
+size_t
+NMEAGenerator::writeGSA(char* out, size_t size, uint32_t used)
+{
+	const Prefix&  prefix = prefixes_[NMEASentence::GSA];
+	SentenceWriter w(out, size);
+
+	w.resume(string_view(prefix.text, prefix.size), prefix.checksum);
+	w.field('A').field(used >= 4 ? 3 : 1);
+	uint32_t listed = 0;
+	for ( uint32_t i = 0; i < settings_.satellites && listed < 12; i++ ) {
+		if ( sky_[i].snr > 0 ) {
+			w.field(sky_[i].prn, 2);
+			listed++;
+		}
+	}
+	for ( ; listed < 12; listed++ ) {
+		w.field();
+	}
+	w.field(1.5, 1).field(0.9, 1).field(1.2, 1);
+	return w.finish();
+}
+
+size_t
+NMEAGenerator::writeGSV(char* out, size_t size, uint32_t page, uint32_t pages)
+{
+	const Prefix&  prefix = prefixes_[NMEASentence::GSV];
+	SentenceWriter w(out, size);
+
+	w.resume(string_view(prefix.text, prefix.size), prefix.checksum);
+	w.field(pages).field(page).field(settings_.satellites, 2);
+	for ( uint32_t i = (page - 1) * 4; i < page * 4 && i < settings_.satellites; i++ ) {
+		const Satellite& sat = sky_[i];
+		w.field(sat.prn, 2).field(static_cast<int>(sat.elevation), 2).field(static_cast<int>(sat.azimuth), 3);
+		if ( sat.snr > 0 ) {
+			w.field(static_cast<int>(sat.snr), 2);
+		}
+		else {
+			w.field();
+		}
+	}
+	return w.finish();
+}
+
+size_t
+NMEAGenerator::writeRMC(char* out, size_t size, UTCTime time, double lat, double lon)
+{
+	const Prefix&  prefix = prefixes_[NMEASentence::RMC];
+	int64_t        days   = duration_cast<hours>(time.time_since_epoch()).count() / 24;
+	int64_t        msec   = time.time_since_epoch().count() - days * 86400000;
+	CivilDate      date   = civilFromDays(days);
+	SentenceWriter w(out, size);
+
+	w.resume(string_view(prefix.text, prefix.size), prefix.checksum);
+	w.field(static_cast<double>(msec / 60000 / 60 * 10000 + msec / 60000 % 60 * 100) + static_cast<double>(msec % 60000) / 1000.0, 3, 6);
+	w.field('A');
+	w.latitude(lat).longitude(lon);
+	w.field(settings_.speed * KnotsPerKmh, 2).field(heading_, 2);
+	w.field(static_cast<int64_t>(date.day * 10000 + date.month * 100 + static_cast<uint32_t>(date.year % 100)), 6);
+	w.field().field().field('A');
+	return w.finish();
+}
+
+size_t
+NMEAGenerator::writeVTG(char* out, size_t size)
+{
+	const Prefix&  prefix = prefixes_[NMEASentence::VTG];
+	SentenceWriter w(out, size);
+
+	w.resume(string_view(prefix.text, prefix.size), prefix.checksum);
+	w.field(heading_, 2).field('T').field().field('M');
+	w.field(settings_.speed * KnotsPerKmh, 2).field('N');
+	w.field(settings_.speed, 2).field('K').field('A');
+	return w.finish();
+}
+
+// Damages a finished sentence, returns its new size
+size_t
+NMEAGenerator::corrupt(char* sentence, size_t size)
+{
+	if ( size < 12 ) {
+		return size;
+	}
+
+	auto kind = static_cast<Corruption>(nextRandom() % 3);
+	corruptions_[kind]++;
+
+	switch ( kind ) {
+	case FlippedBit: // somewhere between the '$' and the '*'
+		sentence[1 + nextRandom() % (size - 6)] ^= 0x01;
+		return size;
+	case BadChecksum:
+		sentence[size - 3] = sentence[size - 3] == '0' ? '1' : '0';
+		return size;
+	case Truncated:
+	default:
+		size_t cut        = 7 + nextRandom() % (size - 12);
+		sentence[cut]     = '\r';
+		sentence[cut + 1] = '\n';
+		return cut + 2;
+	}
+}
+
+size_t
+NMEAGenerator::nextEpoch(char* out, size_t size)
+{
+	UTCTime  now              = time();
+	uint64_t savedRng         = rng_;
+	auto     savedCorruptions = corruptions_;
+	size_t   written          = 0;
+	double   lat              = latitude_;
+	double   lon              = longitude_;
+	uint32_t used             = 0;
+	bool     corrupted        = settings_.corruptionRate > 0;
+
+	if ( settings_.positionNoise > 0 ) {
+		double noiseDeg = settings_.positionNoise / MetersPerDeg;
+		lat += gaussian() * noiseDeg;
+		lon += gaussian() * noiseDeg / max(0.01, cos(toRad(latitude_)));
+	}
+
+	for ( uint32_t i = 0; i < settings_.satellites; i++ ) {
+		used += sky_[i].snr > 0 ? 1 : 0;
+	}
+	used = min<uint32_t>(used, 12);
+
+	auto emit = [&](size_t len) {
+		if ( len == 0 ) {
+			return false;
+		}
+		if ( corrupted && uniform() < settings_.corruptionRate ) {
+			len = corrupt(out + written, len);
+		}
+		written += len;
+		return true;
+	};
+	auto due = [this](NMEASentence::MessageID id) {
+		uint32_t every = rates_[static_cast<size_t>(id)];
+		return every != 0 && epoch_ % every == 0;
+	};
+
+	bool fits = true;
+	if ( fits && due(NMEASentence::GGA) ) {
+		fits = emit(writeGGA(out + written, size - written, now, lat, lon, used));
+	}
+	if ( fits && due(NMEASentence::GSA) ) {
+		fits = emit(writeGSA(out + written, size - written, used));
+	}
+	if ( fits && due(NMEASentence::GSV) ) {
+		uint32_t pages = max<uint32_t>(1, (settings_.satellites + 3) / 4);
+		for ( uint32_t page = 1; fits && page <= pages; page++ ) {
+			fits = emit(writeGSV(out + written, size - written, page, pages));
+		}
+	}
+	if ( fits && due(NMEASentence::RMC) ) {
+		fits = emit(writeRMC(out + written, size - written, now, lat, lon));
+	}
+	if ( fits && due(NMEASentence::VTG) ) {
+		fits = emit(writeVTG(out + written, size - written));
+	}
+
+	if ( !fits ) {
+		rng_         = savedRng; // try the same epoch again next time, its damage isn't counted twice
+		corruptions_ = savedCorruptions;
+		return 0;
+	}
+
+	epoch_++;
+	step(1.0 / settings_.rate);
+	return written;
+}
+
+size_t
+NMEAGenerator::fill(char* out, size_t size)
+{
+	size_t written = 0;
+	for ( size_t len; (len = nextEpoch(out + written, size - written)) != 0; ) {
+		written += len;
+	}
+	return written;
+}
+
+const NMEAGeneratorSettings&
+NMEAGenerator::settings() const
+{
+	return settings_;
+}
+
+uint64_t
+NMEAGenerator::epoch() const
+{
+	return epoch_;
+}
+
+UTCTime
+NMEAGenerator::time() const
+{
+	return settings_.start + milliseconds(llround(static_cast<double>(epoch_) * 1000.0 / settings_.rate));
+}
+
+double
+NMEAGenerator::latitude() const
+{
+	return latitude_;
+}
+
+double
+NMEAGenerator::longitude() const
+{
+	return longitude_;
+}
+
+double
+NMEAGenerator::altitude() const
+{
+	return altitude_;
+}
+
+uint64_t
+NMEAGenerator::corruptions(Corruption kind) const
+{
+	return corruptions_[kind];
+}
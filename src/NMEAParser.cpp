@@ -15,7 +15,11 @@
 #include <sstream>
 #include <utility>
 
+#include "nmeaparse/LatencyHistogram.hpp"
+#include "nmeaparse/Metrics.hpp"
 #include "nmeaparse/NumberConversion.hpp"
+#include "nmeaparse/SentenceKey.hpp"
+#include "nmeaparse/StaticSentence.hpp"
 
 using namespace std;
 using namespace nmea;
@@ -55,6 +59,12 @@ NMEASentence::valid() const
 	return isvalid_;
 }
 
+bool
+NMEASentence::hasTimestamps() const
+{
+	return receiveStart_ != ReceiveClock::time_point();
+}
+
 bool
 NMEASentence::checksumOK() const
 {
@@ -62,9 +72,21 @@ NMEASentence::checksumOK() const
 	       (parsedChecksum_ == calculatedChecksum_);
 }
 
+size_t
+NMEASentence::size() const
+{
+	return parameters_.size();
+}
+
+string_view
+NMEASentence::parameter(size_t index) const
+{
+	return index < parameters_.size() ? string_view(parameters_[index]) : string_view();
+}
+
 // true if the text contains a non-alpha numeric value
-bool
-hasNonAlphaNum(const string& txt)
+static bool
+hasNonAlphaNum(string_view txt)
 {
 	for ( auto chr: txt ) {
 	    if ( isalnum(chr) == 0 ) {
@@ -75,8 +97,8 @@ hasNonAlphaNum(const string& txt)
 }
 
 // true if alphanumeric or '-'
-bool
-validParamChars(const string& txt)
+static bool
+validParamChars(string_view txt)
 {
 	for ( auto chr: txt ) {
 		if ( isalnum(chr) == 0 ) {
@@ -88,39 +110,162 @@ validParamChars(const string& txt)
 	return true;
 }
 
-// remove all whitespace
-void
-squish(string& str)
+// true if printable and not reserved, for the armored data of '!' sentences
+static bool
+validEncapsulatedChars(string_view txt)
 {
-	for ( auto chr: "\t " ) {
-		str.erase(remove(str.begin(), str.end(), chr), str.end());
+	for ( auto chr: txt ) {
+		if ( chr <= 0x20 || chr >= 0x7F || chr == '\\' || chr == '^' || chr == '~' ) {
+			return false;
+		}
 	}
+	return true;
+}
+
+// --------- NMEA PARSER --------------
+
+NMEAParser::NMEAParser(pmr::memory_resource* resource)
+    : resource_(resource)
+    , eventTable_(resource)
+    , buffer_(resource)
+    , fillingbuffer_(false)
+    , maxbuffersize_(NMEA_PARSER_MAX_BUFFER_SIZE)
+    , latency_(nullptr)
+    , metrics_(nullptr)
+    , discarded_(0)
+    , interest_(Interest::All)
+    , interestKeys_(resource)
+    , skipping_(false)
+    , nameChecked_(true)
+    , nameStart_(0)
+    , skippedBytes_(0)
+    , scratch_(resource)
+    , dispatchDepth_(0)
+    , monitors_(0)
+    , log_(false)
+    , captureTimestamps_(false)
+    , onSentence_(resource)
+{
 }
 
-// remove side whitespace
 void
-trim(string& str)
+NMEAParser::setLatencyTracker(LatencyTracker* tracker)
 {
-	stringstream trimmer;
-	trimmer << str;
-	str.clear();
-	trimmer >> str;
+	latency_ = tracker;
 }
 
-// --------- NMEA PARSER --------------
+void
+NMEAParser::setMetrics(Metrics* metrics)
+{
+	metrics_   = metrics;
+	discarded_ = 0;
+}
 
-NMEAParser::NMEAParser()
-    : fillingbuffer_(false)
-    , maxbuffersize_(NMEA_PARSER_MAX_BUFFER_SIZE)
-    , log_(false)
+size_t
+NMEAParser::memoryUsage() const
+{
+	// unordered_map node: key, value and a link, plus a bucket pointer each
+	size_t bytes = sizeof(*this) + buffer_.capacity() + eventTable_.bucket_count() * sizeof(void*);
+	for ( const auto& entry: eventTable_ ) {
+		bytes += sizeof(entry) + sizeof(void*);
+		if ( entry.first.capacity() > HandlerTable::key_type().capacity() ) {
+			bytes += entry.first.capacity() + 1;
+		}
+	}
+	bytes += onSentence_.size() * (sizeof(EventHandler<void(const NMEASentence&)>) + 2 * sizeof(void*));
+	for ( const auto& scratch: scratch_ ) {
+		const NMEASentence& nmea = scratch.sentence;
+		bytes += sizeof(scratch) + nmea.text_.capacity() + nmea.name_.capacity() + nmea.checksum_.capacity()
+		         + (nmea.parameters_.capacity() + scratch.spare.capacity()) * sizeof(string);
+	}
+	return bytes;
+}
+
+pmr::memory_resource*
+NMEAParser::resource() const
 {
+	return resource_;
+}
+
+bool
+NMEAParser::timestampsEnabled() const
+{
+	return captureTimestamps_ || latency_ != nullptr;
 }
 
 void
 NMEAParser::setSentenceHandler(const string& cmdKey, const function<void(const NMEASentence&)>& handler)
 {
-	eventTable_.erase(cmdKey);
-	eventTable_.insert({ cmdKey, handler });
+	HandlerTable::key_type key(cmdKey.data(), cmdKey.size(), resource_);
+	eventTable_.erase(key);
+	eventTable_.emplace(std::move(key), handler);
+	handlersChanged();
+}
+
+void
+NMEAParser::setInterest(Interest interest)
+{
+	interest_ = interest;
+	interestKeys_.clear();
+	handlersChanged();
+}
+
+void
+NMEAParser::setInterest(initializer_list<string_view> names)
+{
+	interest_ = Interest::Listed;
+	interestKeys_.clear();
+	for ( auto name: names ) {
+		interestKeys_.push_back(sentenceKey(name));
+	}
+}
+
+NMEAParser::Interest
+NMEAParser::interest() const
+{
+	return interest_;
+}
+
+bool
+NMEAParser::hasListeners() const
+{
+	return onSentence_.size() > monitors_;
+}
+
+void
+NMEAParser::handlersChanged()
+{
+	if ( interest_ != Interest::Handlers ) {
+		return;
+	}
+	interestKeys_.clear();
+	for ( const auto& entry: eventTable_ ) {
+		interestKeys_.push_back(sentenceKey(entry.first));
+	}
+}
+
+// Names that don't pack into a key, or with whitespace that readSentence()
+// would remove, are read to be on the safe side
+bool
+NMEAParser::wanted(string_view name) const
+{
+	if ( interest_ == Interest::All || (interest_ == Interest::Handlers && hasListeners()) ) {
+		return true;
+	}
+	uint64_t key = sentenceKey(name);
+	if ( key == 0 || name.find_first_of(" \t\r") != string_view::npos ) {
+		return true;
+	}
+	return find(interestKeys_.begin(), interestKeys_.end(), key) != interestKeys_.end();
+}
+
+void
+NMEAParser::skip(uint32_t bytes)
+{
+	if ( metrics_ != nullptr ) {
+		metrics_->add(Metrics::SkippedSentences);
+		metrics_->add(Metrics::SkippedBytes, bytes);
+	}
 }
 
 string
@@ -149,11 +294,45 @@ NMEAParser::getRegisteredSentenceHandlersCSV() const
 void
 NMEAParser::readByte(uint8_t byte)
 {
-	uint8_t startbyte = '$';
+	if ( metrics_ != nullptr ) {
+		metrics_->add(Metrics::BytesIn);
+	}
+	readByte(byte, nullptr);
+}
+
+void
+NMEAParser::readByte(uint8_t byte, ReceiveClock::time_point rxTime)
+{
+	if ( metrics_ != nullptr ) {
+		metrics_->add(Metrics::BytesIn);
+	}
+	readByte(byte, &rxTime);
+}
+
+// rxTime is null when the caller has no receive time, then the clock is only
+// read for the two bytes that need it.
+void
+NMEAParser::readByte(uint8_t byte, const ReceiveClock::time_point* rxTime)
+{
+	if ( skipping_ ) {
+		if ( byte != '\n' && byte != '$' && byte != '!' ) {
+			skippedBytes_++;
+			return;
+		}
+		skipping_ = false;
+		if ( byte == '\n' ) {
+			skip(skippedBytes_ + 1);
+			return;
+		}
+		skip(skippedBytes_); // cut short by the next sentence, which is read below
+	}
 
 	if ( fillingbuffer_ ) {
 		if ( byte == '\n' ) {
 			buffer_.push_back(static_cast<char>(byte));
+			if ( timestampsEnabled() ) {
+				receiveEnd_ = rxTime != nullptr ? *rxTime : ReceiveClock::now();
+			}
 			try {
 				readSentence(buffer_);
 				buffer_.clear();
@@ -168,18 +347,52 @@ NMEAParser::readByte(uint8_t byte)
 		}
 		else {
 			if ( buffer_.size() < maxbuffersize_ ) {
+				if ( byte == '$' || byte == '!' ) { // the last start counts, see parseText()
+					nameStart_   = buffer_.size();
+					nameChecked_ = interest_ == Interest::All;
+				}
+				else if ( !nameChecked_ && (byte == ',' || byte == '*') ) {
+					nameChecked_ = true;
+					if ( !wanted(string_view(buffer_).substr(nameStart_ + 1)) ) {
+						skipping_      = true;
+						skippedBytes_  = static_cast<uint32_t>(buffer_.size() + 1);
+						fillingbuffer_ = false;
+						buffer_.clear();
+						return;
+					}
+				}
 				buffer_.push_back(static_cast<char>(byte));
 			}
 			else {
 				buffer_.clear(); // clear the host buffer so it won't overflow.
 				fillingbuffer_ = false;
+				if ( metrics_ != nullptr ) {
+					metrics_->add(Metrics::BufferOverflows);
+				}
 			}
 		}
 	}
 	else {
-		if ( byte == startbyte ) { // only start filling when we see the start byte.
+		if ( byte == '$' || byte == '!' ) { // only start filling when we see a start byte, '!' for encapsulation sentences like AIS.
 			fillingbuffer_ = true;
+			nameStart_     = 0;
+			nameChecked_   = interest_ == Interest::All;
 			buffer_.push_back(static_cast<char>(byte));
+			if ( timestampsEnabled() ) {
+				receiveStart_ = rxTime != nullptr ? *rxTime : ReceiveClock::now();
+			}
+			if ( discarded_ != 0 && metrics_ != nullptr ) {
+				metrics_->add(Metrics::DiscardedBytes, discarded_);
+				discarded_ = 0;
+			}
+		}
+		else if ( metrics_ != nullptr && isspace(byte) == 0 ) {
+			discarded_++;
+		}
+		else if ( byte == '\n' && discarded_ != 0 && metrics_ != nullptr ) {
+			metrics_->add(Metrics::DiscardedBytes, discarded_);
+			metrics_->add(Metrics::InvalidLines);
+			discarded_ = 0;
 		}
 	}
 }
@@ -187,48 +400,111 @@ NMEAParser::readByte(uint8_t byte)
 void
 NMEAParser::readBuffer(uint8_t* ptr, uint32_t size)
 {
+	if ( metrics_ != nullptr ) {
+		metrics_->add(Metrics::BytesIn, size);
+	}
 	for ( uint32_t i = 0; i < size; ++i ) {
-		readByte(ptr[i]);
+		readByte(ptr[i], nullptr);
+	}
+}
+
+void
+NMEAParser::readBuffer(uint8_t* ptr, uint32_t size, ReceiveClock::time_point rxTime)
+{
+	if ( metrics_ != nullptr ) {
+		metrics_->add(Metrics::BytesIn, size);
+	}
+	for ( uint32_t i = 0; i < size; ++i ) {
+		readByte(ptr[i], &rxTime);
 	}
 }
 
 void
 NMEAParser::readLine(const string& line)
 {
+	if ( metrics_ != nullptr ) {
+		metrics_->add(Metrics::BytesIn, line.size() + 2);
+	}
 	for ( auto chr: line ) {
-		readByte(static_cast<uint8_t>(chr));
+		readByte(static_cast<uint8_t>(chr), nullptr);
 	}
-	readByte('\r');
-	readByte('\n');
+	readByte('\r', nullptr);
+	readByte('\n', nullptr);
 }
 
-// Loggers
+// Loggers, the callers only build messages when log_ is set
 void
-NMEAParser::onInfo(NMEASentence& /*nmea*/, const string& txt) const
+NMEAParser::onInfo(NMEASentence& /*nmea*/, string_view txt) const
 {
 	if ( log_ ) {
 		cout << "[Info]    " << txt << endl;
 	}
 }
 void
-NMEAParser::onWarning(NMEASentence& /*nmea*/, const string& txt) const
+NMEAParser::onWarning(NMEASentence& /*nmea*/, string_view txt) const
 {
 	if ( log_ ) {
 		cout << "[Warning] " << txt << endl;
 	}
 }
 void
-NMEAParser::onError(NMEASentence& /*nmea*/, const string& txt) const
+NMEAParser::onError(NMEASentence& /*nmea*/, string_view txt) const
 {
-	throw NMEAParseError("[ERROR] " + txt);
+	throw NMEAParseError("[ERROR] " + string(txt));
 }
 
 // takes a complete NMEA string and gets the data bits from it,
 // calls the corresponding handler in eventTable, based on the 5 letter sentence code
 void
-NMEAParser::readSentence(string cmd)
+NMEAParser::readSentence(string_view cmd)
 {
-	NMEASentence nmea;
+	// Injected lines go through the same name check as the ones read byte by
+	// byte, which were checked as they came in
+	if ( interest_ != Interest::All && cmd.data() != buffer_.data() ) {
+		size_t start = cmd.find_last_of("$!");
+		if ( start != string_view::npos ) {
+			string_view name = cmd.substr(start + 1);
+			if ( !wanted(name.substr(0, name.find_first_of(",*\r\n"))) ) {
+				skip(static_cast<uint32_t>(cmd.size()));
+				return;
+			}
+		}
+	}
+	// Each dispatch depth has its own sentence, reused from the last one
+	// dispatched at that depth
+	struct DepthScope {
+		NMEAParser& parser;
+		~DepthScope() { parser.dispatchDepth_--; }
+	} scope{ *this };
+	if ( dispatchDepth_ == scratch_.size() ) {
+		scratch_.emplace_back();
+	}
+	Scratch&      scratch = scratch_[dispatchDepth_++];
+	NMEASentence& nmea    = scratch.sentence;
+	for ( auto& parameter: nmea.parameters_ ) {
+		scratch.spare.push_back(std::move(parameter));
+	}
+	nmea.parameters_.clear();
+	nmea.text_.clear();
+	nmea.name_.clear();
+	nmea.checksum_.clear();
+	nmea.isvalid_              = false;
+	nmea.checksumIsCalculated_ = false;
+	nmea.parsedChecksum_       = 0;
+	nmea.calculatedChecksum_   = 0;
+	nmea.receiveStart_         = ReceiveClock::time_point();
+	nmea.receiveEnd_           = ReceiveClock::time_point();
+
+	if ( timestampsEnabled() ) {
+		// injected directly, there is no wire time so count from here
+		if ( receiveStart_ == ReceiveClock::time_point() ) {
+			receiveStart_ = ReceiveClock::now();
+			receiveEnd_   = receiveStart_;
+		}
+		nmea.receiveStart_ = receiveStart_;
+		nmea.receiveEnd_   = receiveEnd_;
+		receiveStart_      = ReceiveClock::time_point();
+	}
 
 	onInfo(nmea, "Processing NEW string...");
 
@@ -238,32 +514,40 @@ NMEAParser::readSentence(string cmd)
 	}
 
 	// If there is a newline at the end (we are coming from the byte reader
-	if ( *(cmd.end() - 1) == '\n' ) {
-		if ( *(cmd.end() - 2) == '\r' ) { // if there is a \r before the newline, remove it.
-			cmd = cmd.substr(0, cmd.size() - 2);
+	if ( cmd.back() == '\n' ) {
+		if ( cmd.size() > 1 && cmd[cmd.size() - 2] == '\r' ) { // if there is a \r before the newline, remove it.
+			cmd.remove_suffix(2);
 		}
 		else {
 			onWarning(nmea, "Malformed newline, missing carriage return (\\r) ");
-			cmd = cmd.substr(0, cmd.size() - 1);
+			cmd.remove_suffix(1);
 		}
 	}
 
-	// Remove all whitespace characters.
-	size_t beginsize = cmd.size();
-	squish(cmd);
-	if ( cmd.size() != beginsize ) {
-		ostringstream strm;
-		strm << "New NMEA string was full of " << (beginsize - cmd.size()) << " whitespaces!";
-		onWarning(nmea, strm.str());
+	// Remove all whitespace characters, keeping the rest as the text of the sentence.
+	nmea.text_.reserve(cmd.size());
+	for ( auto chr: cmd ) {
+		if ( chr != ' ' && chr != '\t' ) {
+			nmea.text_.push_back(chr);
+		}
+	}
+	if ( log_ ) {
+		if ( nmea.text_.size() != cmd.size() ) {
+			ostringstream strm;
+			strm << "New NMEA string was full of " << (cmd.size() - nmea.text_.size()) << " whitespaces!";
+			onWarning(nmea, strm.str());
+		}
+		onInfo(nmea, "NMEA string: (\"" + string(nmea.text_) + "\")");
 	}
-
-	onInfo(nmea, string("NMEA string: (\"") + cmd + "\")");
 
 	// Seperates the data now that everything is formatted
 	try {
-		parseText(nmea, cmd);
+		parseText(scratch, nmea.text_);
 	}
 	catch ( NMEAParseError& ) {
+		if ( metrics_ != nullptr ) {
+			metrics_->add(Metrics::InvalidSentences);
+		}
 		throw;
 	}
 	catch ( exception& e ) {
@@ -273,10 +557,14 @@ NMEAParser::readSentence(string cmd)
 
 	// Handle/Throw parse errors
 	if ( !nmea.valid() ) {
+		if ( metrics_ != nullptr ) {
+			metrics_->add(Metrics::InvalidSentences);
+		}
+
 		const size_t linewidth = 35;
 		stringstream strm;
 		if ( nmea.text_.size() > linewidth ) {
-			strm << "Invalid text. (\"" << nmea.text_.substr(0, linewidth) << "...\")";
+			strm << "Invalid text. (\"" << string_view(nmea.text_).substr(0, linewidth) << "...\")";
 		}
 		else {
 			strm << "Invalid text. (\"" << nmea.text_ << "\")";
@@ -286,69 +574,101 @@ NMEAParser::readSentence(string cmd)
 		return;
 	}
 
+	if ( metrics_ != nullptr ) {
+		metrics_->addSentence(nmea.name_);
+		if ( nmea.checksumIsCalculated_ && !nmea.checksumOK() ) {
+			metrics_->add(Metrics::ChecksumFailures);
+		}
+	}
+
+	LatencyTracker::Sample sample;
+	if ( latency_ != nullptr ) {
+		sample.received   = nmea.receiveStart_;
+		sample.terminated = nmea.receiveEnd_;
+		sample.parsed     = ReceiveClock::now();
+	}
+
 	// Call the "any sentence" event handler, even if invalid checksum, for possible logging elsewhere.
 	onInfo(nmea, "Calling generic onSentence().");
 	onSentence_(nmea);
 
-	// Call event handlers based on map entries
-	auto handler = eventTable_[nmea.name_];
-	if ( handler ) {
-		onInfo(nmea, string("Calling specific handler for sentence named \"") + nmea.name_ + "\"");
-		handler(nmea);
+	// Call event handlers based on map entries, names are short enough not to allocate the key
+	HandlerTable::key_type                     name(nmea.name_.data(), nmea.name_.size(), resource_);
+	auto                                       entry   = eventTable_.find(name);
+	const function<void(const NMEASentence&)>* handler = entry != eventTable_.end() && entry->second ? &entry->second : nullptr;
+	if ( handler != nullptr ) {
+		if ( log_ ) {
+			onInfo(nmea, "Calling specific handler for sentence named \"" + string(nmea.name_) + "\"");
+		}
+		if ( latency_ != nullptr ) {
+			sample.dispatched = ReceiveClock::now();
+			(*handler)(nmea);
+			sample.returned = ReceiveClock::now();
+			latency_->record(nmea.name_, sample);
+		}
+		else {
+			(*handler)(nmea);
+		}
 	}
 	else {
-		onWarning(nmea, string("Null event handler for type (name: \"") + nmea.name_ + "\")");
+		if ( log_ ) {
+			onWarning(nmea, "Null event handler for type (name: \"" + string(nmea.name_) + "\")");
+		}
+		if ( metrics_ != nullptr ) {
+			metrics_->add(Metrics::HandlerMisses);
+		}
+		if ( latency_ != nullptr ) {
+			sample.dispatched = ReceiveClock::now();
+			sample.returned   = sample.dispatched;
+			latency_->record(nmea.name_, sample);
+		}
 	}
 }
 
 // takes the string *between* the '$' and '*' in nmea sentence,
 // then calculates a rolling XOR on the bytes
 uint8_t
-NMEAParser::calculateChecksum(const string& str)
+NMEAParser::calculateChecksum(string_view str)
 {
-	uint8_t checksum = 0;
-	for ( auto chr: str ) {
-		checksum = checksum ^ static_cast<uint8_t>(chr);
-	}
-
-	// will display the calculated checksum in hex
-	// if(log)
-	//{
-	//	ios_base::fmtflags oldflags = cout.flags();
-	//	cout << "NMEA parser Info: calculated CHECKSUM for \""  << s << "\": 0x" << hex << (int)checksum << endl;
-	//	cout.flags(oldflags);  //reset
-	//}
-	return checksum;
+	return xorChecksum(str);
 }
 
 void
-NMEAParser::parseText(NMEASentence& nmea, string txt)
+NMEAParser::parseText(Scratch& scratch, string_view txt)
 {
+	NMEASentence& nmea = scratch.sentence;
+
+	// parameters reuse the strings of earlier sentences
+	auto addParameter = [&](string_view parameter) {
+		if ( scratch.spare.empty() ) {
+			nmea.parameters_.emplace_back(parameter);
+			return;
+		}
+		nmea.parameters_.push_back(std::move(scratch.spare.back()));
+		scratch.spare.pop_back();
+		nmea.parameters_.back().assign(parameter);
+	};
+
+	nmea.isvalid_ = false; // assume it's invalid first
+
 	if ( txt.empty() ) {
-		nmea.isvalid_ = false;
 		return;
 	}
 
-	nmea.isvalid_ = false; // assume it's invalid first
-	nmea.text_    = txt;   // save the received text of the sentence
-
-	// Looking for index of last '$'
-	size_t startbyte = 0;
-	size_t dollar    = txt.find_last_of('$');
-	if ( dollar == string::npos ) {
+	// Looking for index of last '$' (or '!')
+	size_t dollar = txt.find_last_of("$!");
+	if ( dollar == string_view::npos ) {
 		// No dollar sign... INVALID!
 		return;
 	}
-	else {
-		startbyte = dollar;
-	}
+	bool encapsulated = txt[dollar] == '!';
 
 	// Get rid of data up to last'$'
-	txt = txt.substr(startbyte + 1);
+	txt = txt.substr(dollar + 1);
 
 	// Look for checksum
 	size_t checkstri   = txt.find_last_of('*');
-	bool   haschecksum = checkstri != string::npos;
+	bool   haschecksum = checkstri != string_view::npos;
 	if ( haschecksum ) {
 		// A checksum was passed in the message, so calculate what we expect to see
 		nmea.calculatedChecksum_ = calculateChecksum(txt.substr(0, checkstri));
@@ -360,101 +680,102 @@ NMEAParser::parseText(NMEASentence& nmea, string txt)
 
 	// Handle comma edge cases
 	size_t comma = txt.find(',');
-	if ( comma == string::npos ) { // comma not found, but there is a name...
-		if ( !txt.empty() ) {      // the received data must just be the name
+	if ( comma == string_view::npos ) { // comma not found, but there is a name...
+		if ( !txt.empty() ) {           // the received data must just be the name
 			if ( hasNonAlphaNum(txt) ) {
-				nmea.isvalid_ = false;
 				return;
 			}
 			nmea.name_    = txt;
 			nmea.isvalid_ = true;
-			return;
-		}
-		else { // it is a '$' with no information
-			nmea.isvalid_ = false;
-			return;
 		}
+		// else it is a '$' with no information
+		return;
 	}
 
 	//"$," case - no name
 	if ( comma == 0 ) {
-		nmea.isvalid_ = false;
 		return;
 	}
 
 	// name should not include first comma
 	nmea.name_ = txt.substr(0, comma);
 	if ( hasNonAlphaNum(nmea.name_) ) {
-		nmea.isvalid_ = false;
 		return;
 	}
 
 	// comma is the last character/only comma
 	if ( comma + 1 == txt.size() ) {
-		nmea.parameters_.emplace_back("");
+		addParameter(string_view());
 		nmea.isvalid_ = true;
 		return;
 	}
 
 	// move to data after first comma
-	txt = txt.substr(comma + 1, txt.size() - (comma + 1));
+	txt = txt.substr(comma + 1);
 
 	// parse parameters according to csv
-	istringstream istrm(txt);
-	for ( string str; getline(istrm, str, ','); ) {
-		nmea.parameters_.push_back(str);
+	for ( size_t start = 0; start < txt.size(); ) {
+		size_t end = txt.find(',', start);
+		if ( end == string_view::npos ) {
+			end = txt.size();
+		}
+		addParameter(txt.substr(start, end - start));
+		start = end + 1;
 	}
 
 	// above line parsing does not add a blank parameter if there is a comma at the end...
 	//  so do it here.
-	if ( *(txt.end() - 1) == ',' ) {
+	if ( txt.back() == ',' ) {
 		// supposed to have checksum but there is a comma at the end... invalid
 		if ( haschecksum ) {
-			nmea.isvalid_ = false;
 			return;
 		}
 
-		// cout << "NMEA parser Warning: extra comma at end of sentence, but no information...?" << endl;		// it's actually standard, if checksum is disabled
-		nmea.parameters_.emplace_back("");
+		// it's actually standard, if checksum is disabled
+		addParameter(string_view());
 
-		stringstream strm;
-		strm << "Found " << nmea.parameters_.size() << " parameters.";
-		onInfo(nmea, strm.str());
+		if ( log_ ) {
+			onInfo(nmea, "Found " + to_string(nmea.parameters_.size()) + " parameters.");
+		}
 	}
 	else {
-		stringstream strm;
-		strm << "Found " << nmea.parameters_.size() << " parameters.";
-		onInfo(nmea, strm.str());
+		if ( log_ ) {
+			onInfo(nmea, "Found " + to_string(nmea.parameters_.size()) + " parameters.");
+		}
 
 		// possible checksum at end...
-		size_t endi   = nmea.parameters_.size() - 1;
-		size_t checki = nmea.parameters_[endi].find_last_of('*');
+		string& last   = nmea.parameters_.back();
+		size_t  checki = last.find_last_of('*');
 		if ( checki != string::npos ) {
-			string last           = nmea.parameters_[endi];
-			nmea.parameters_[endi] = last.substr(0, checki);
 			if ( checki == last.size() - 1 ) {
+				last.resize(checki);
 				onError(nmea, "Checksum '*' character at end, but no data.");
 			}
 			else {
-				nmea.checksum_ = last.substr(checki + 1, last.size() - checki); // extract checksum without '*'
+				nmea.checksum_ = string_view(last).substr(checki + 1); // extract checksum without '*'
+				last.resize(checki);
 
-				onInfo(nmea, string("Found checksum. (\"*") + nmea.checksum_ + "\")");
+				if ( log_ ) {
+					onInfo(nmea, "Found checksum. (\"*" + string(nmea.checksum_) + "\")");
+				}
 
 				try {
 					nmea.parsedChecksum_       = (uint8_t) parseInt(nmea.checksum_, 16);
 					nmea.checksumIsCalculated_ = true;
 				}
 				catch ( NumberConversionError& ) {
-					onError(nmea, string("parseInt() error. Parsed checksum string was not readable as hex. (\"") + nmea.checksum_ + "\")");
+					onError(nmea, "parseInt() error. Parsed checksum string was not readable as hex. (\"" + string(nmea.checksum_) + "\")");
 				}
 
-				onInfo(nmea, string("Checksum ok? ") + (nmea.checksumOK() ? "YES" : "NO") + "!");
+				if ( log_ ) {
+					onInfo(nmea, string("Checksum ok? ") + (nmea.checksumOK() ? "YES" : "NO") + "!");
+				}
 			}
 		}
 	}
 
 	for ( size_t i = 0; i < nmea.parameters_.size(); i++ ) {
-		if ( !validParamChars(nmea.parameters_[i]) ) {
+		if ( encapsulated ? !validEncapsulatedChars(nmea.parameters_[i]) : !validParamChars(nmea.parameters_[i]) ) {
 			nmea.isvalid_ = false;
 			stringstream strm;
 			strm << "Invalid character (non-alpha-num) in parameter " << i << " (from 0): \"" << nmea.parameters_[i] << "\"";
@@ -16,36 +16,57 @@ using namespace std;
 namespace nmea {
 // Note: both parseDouble and parseInt return 0 with "" input.
 
+// strtod()/strtoll() need a terminated string, fields are short enough for the stack.
+// Returns the value and how many characters were read.
+template <typename Convert>
+static auto
+convert(string_view str, Convert conv)
+{
+	char        local[64];
+	string      heap;
+	const char* text = local;
+	if ( str.size() < sizeof(local) ) {
+		str.copy(local, str.size());
+		local[str.size()] = '\0';
+	}
+	else {
+		heap = string(str);
+		text = heap.c_str();
+	}
+
+	char* ptr   = nullptr;
+	auto  value = conv(text, &ptr);
+	return make_pair(value, static_cast<size_t>(ptr - text));
+}
+
 double
-parseDouble(const string& str)
+parseDouble(string_view str)
 {
-	char*  ptr   = nullptr;
-	double value = ::strtod(str.c_str(), &ptr);
+	auto result = convert(str, [](const char* text, char** end) { return ::strtod(text, end); });
 
-	if ( *ptr != '\0' ) {
+	if ( result.second != str.size() ) {
 		stringstream strm;
 		strm << "NumberConversionError: parseDouble() error in argument \"" << str << "\", '"
-		   << *ptr << "' is not a number.";
+		   << str[result.second] << "' is not a number.";
 		throw NumberConversionError(strm.str());
 	}
 
-	return value;
+	return result.first;
 }
 
 int64_t
-parseInt(const string& str, int radix)
+parseInt(string_view str, int radix)
 {
-	char*   ptr   = nullptr;
-	int64_t value = ::strtoll(str.c_str(), &ptr, radix);
+	auto result = convert(str, [radix](const char* text, char** end) { return static_cast<int64_t>(::strtoll(text, end, radix)); });
 
-	if ( *ptr != '\0' ) {
+	if ( result.second != str.size() ) {
 		stringstream strm;
 		strm << "NumberConversionError: parseInt() error in argument \"" << str << "\", '"
-		   << *ptr << "' is not a number.";
+		   << str[result.second] << "' is not a number.";
 		throw NumberConversionError(strm.str());
 	}
 
-	return value;
+	return result.first;
 }
 
 } // namespace nmea
@@ -0,0 +1,185 @@
+/*
+ * OutputProfile.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/OutputProfile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "nmeaparse/NMEACommand.hpp"
+
+using namespace std;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+// The types NemaTode knows, by $PSRF103 message number
+static bool
+known(size_t id)
+{
+	return id <= NMEASentence::VTG || id == NMEASentence::ZDA;
+}
+
+// The sentences GPSService::attachToParser() registers
+static bool
+serviceSentence(string_view name)
+{
+	return name == "GPGGA" || name == "GPGSA" || name == "GPGSV" || name == "GPRMC" || name == "GPVTG" || name == "PSRF150";
+}
+
+// ------------- OUTPUT PROFILE -------------
+
+void
+OutputProfile::setRate(NMEASentence::MessageID id, uint32_t seconds)
+{
+	if ( id >= 0 && known(static_cast<size_t>(id)) ) {
+		rates_[static_cast<size_t>(id)] = static_cast<uint8_t>(min(seconds, MaxRate));
+	}
+}
+
+uint32_t
+OutputProfile::rate(NMEASentence::MessageID id) const
+{
+	return id >= 0 && static_cast<size_t>(id) < Types ? rates_[static_cast<size_t>(id)] : 0;
+}
+
+NMEASentence::MessageID
+OutputProfile::typeOf(string_view name)
+{
+	static const char* names[] = { "GGA", "GLL", "GSA", "GSV", "RMC", "VTG", nullptr, nullptr, "ZDA" };
+
+	if ( name.size() != 5 ) {
+		return NMEASentence::Unknown; // talker and type, not proprietary
+	}
+	for ( size_t id = 0; id < sizeof(names) / sizeof(names[0]); id++ ) {
+		if ( names[id] != nullptr && name.substr(2) == names[id] ) {
+			return static_cast<NMEASentence::MessageID>(id);
+		}
+	}
+	return NMEASentence::Unknown;
+}
+
+void
+OutputProfile::addHandlers(const NMEAParser& parser, const ServiceNeeds* service)
+{
+	// the fastest rate anyone wants
+	auto need = [this](NMEASentence::MessageID id, uint32_t seconds) {
+		if ( seconds != 0 && (rate(id) == 0 || seconds < rate(id)) ) {
+			setRate(id, seconds);
+		}
+	};
+
+	if ( parser.hasListeners() ) {
+		for ( size_t id = 0; id < Types; id++ ) {
+			need(static_cast<NMEASentence::MessageID>(id), 1);
+		}
+		return;
+	}
+
+	string names = parser.getRegisteredSentenceHandlersCSV();
+	for ( size_t start = 0; start < names.size(); ) {
+		size_t      end  = min(names.find(',', start), names.size());
+		string_view name = string_view(names).substr(start, end - start);
+		start            = end + 1;
+		if ( service != nullptr && serviceSentence(name) ) {
+			continue;
+		}
+		need(typeOf(name), 1);
+	}
+
+	if ( service != nullptr ) {
+		// VTG only repeats the speed and course of RMC
+		need(NMEASentence::GGA, service->position);
+		need(NMEASentence::RMC, service->position);
+		need(NMEASentence::GSA, service->dilution);
+		need(NMEASentence::GSV, service->satellites);
+	}
+}
+
+size_t
+OutputProfile::commands(const OutputProfile& current, NMEACommandBatch& batch) const
+{
+	size_t               added = 0;
+	NMEACommandQueryRate command;
+	for ( size_t id = 0; id < Types; id++ ) {
+		if ( !known(id) || rates_[id] == current.rates_[id] ) {
+			continue;
+		}
+		command.messageID_ = static_cast<NMEASentence::MessageID>(id);
+		command.mode_      = NMEACommandQueryRate::SETRATE;
+		command.rate_      = rates_[id];
+		if ( !batch.add(command) ) {
+			break;
+		}
+		added++;
+	}
+	return added;
+}
+
+uint32_t
+OutputProfile::differences(const OutputProfile& other) const
+{
+	uint32_t count = 0;
+	for ( size_t id = 0; id < Types; id++ ) {
+		count += rates_[id] != other.rates_[id] ? 1 : 0;
+	}
+	return count;
+}
+
+// ------------- OUTPUT MONITOR -------------
+
+OutputMonitor::OutputMonitor(NMEAParser& parser)
+    : parser_(parser)
+    , handler_(parser.onSentence_ += [this](const NMEASentence& nmea) { seen(nmea); })
+{
+	parser_.monitors_++;
+}
+
+OutputMonitor::~OutputMonitor()
+{
+	parser_.onSentence_ -= handler_;
+	parser_.monitors_--;
+}
+
+void
+OutputMonitor::seen(const NMEASentence& nmea)
+{
+	NMEASentence::MessageID id = OutputProfile::typeOf(nmea.name_);
+	if ( id == NMEASentence::Unknown || !nmea.checksumOK() ) {
+		return;
+	}
+	if ( id == NMEASentence::GSV && (nmea.parameters_.size() < 2 || nmea.parameters_[1] != "1") ) {
+		return; // the later pages of the same set
+	}
+	counts_[static_cast<size_t>(id)]++;
+}
+
+void
+OutputMonitor::reset()
+{
+	counts_.fill(0);
+}
+
+uint64_t
+OutputMonitor::count(NMEASentence::MessageID id) const
+{
+	return id >= 0 && static_cast<size_t>(id) < counts_.size() ? counts_[static_cast<size_t>(id)] : 0;
+}
+
+OutputProfile
+OutputMonitor::profile(double seconds) const
+{
+	OutputProfile profile;
+	for ( size_t id = 0; id < counts_.size(); id++ ) {
+		if ( counts_[id] != 0 ) {
+			double every = seconds / static_cast<double>(counts_[id]);
+			profile.setRate(static_cast<NMEASentence::MessageID>(id), static_cast<uint32_t>(max(1L, lround(every))));
+		}
+	}
+	return profile;
+}
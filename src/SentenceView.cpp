@@ -0,0 +1,159 @@
+/*
+ * SentenceView.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/SentenceView.hpp"
+
+#include "nmeaparse/StaticSentence.hpp"
+
+using namespace std;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+static bool
+isAlphaNum(char chr)
+{
+	return (chr >= '0' && chr <= '9') || (chr >= 'A' && chr <= 'Z') || (chr >= 'a' && chr <= 'z');
+}
+
+// Encapsulation sentences ('!') carry armored data, anything printable that
+// isn't reserved by NMEA 0183
+static bool
+isEncapsulated(char chr)
+{
+	return chr > 0x20 && chr < 0x7F && chr != '\\' && chr != '^' && chr != '~';
+}
+
+static int
+hexValue(char chr)
+{
+	if ( chr >= '0' && chr <= '9' ) {
+		return chr - '0';
+	}
+	if ( chr >= 'A' && chr <= 'F' ) {
+		return chr - 'A' + 10;
+	}
+	if ( chr >= 'a' && chr <= 'f' ) {
+		return chr - 'a' + 10;
+	}
+	return -1;
+}
+
+// ------------- SENTENCEVIEW -------------
+
+const char*
+nmea::parseStatusName(ParseStatus status)
+{
+	switch ( status ) {
+	case ParseStatus::Ok:
+		return "Ok";
+	case ParseStatus::Pending:
+		return "Pending";
+	case ParseStatus::Overflow:
+		return "Overflow";
+	case ParseStatus::Empty:
+		return "Empty";
+	case ParseStatus::BadName:
+		return "BadName";
+	case ParseStatus::BadCharacter:
+		return "BadCharacter";
+	case ParseStatus::BadChecksum:
+		return "BadChecksum";
+	case ParseStatus::TooManyFields:
+		return "TooManyFields";
+	case ParseStatus::ChecksumMismatch:
+		return "ChecksumMismatch";
+	case ParseStatus::MissingFields:
+		return "MissingFields";
+	case ParseStatus::BadNumber:
+		return "BadNumber";
+	case ParseStatus::MissingFragment:
+		return "MissingFragment";
+	case ParseStatus::MissingChecksum:
+		return "MissingChecksum";
+	}
+	return "Unknown";
+}
+
+ParseStatus
+nmea::parseSentenceView(string_view line, SentenceView& sentence)
+{
+	sentence = SentenceView();
+
+	if ( line.size() > SentenceView::MaxSentenceSize ) {
+		return ParseStatus::Overflow;
+	}
+
+	// Everything up to the last '$' or '!' is dropped
+	size_t dollar = line.find_last_of("$!");
+	if ( dollar == string_view::npos ) {
+		return ParseStatus::Empty;
+	}
+	size_t begin = dollar + 1;
+	size_t end   = line.size();
+
+	// Checksum, "*HH" at the end
+	size_t star = line.rfind('*');
+	if ( star != string_view::npos && star > dollar ) {
+		string_view digits = line.substr(star + 1);
+		if ( digits.empty() || digits.size() > 2 ) {
+			return ParseStatus::BadChecksum;
+		}
+		int value = 0;
+		for ( auto chr: digits ) {
+			int digit = hexValue(chr);
+			if ( digit < 0 ) {
+				return ParseStatus::BadChecksum;
+			}
+			value = value * 16 + digit;
+		}
+		sentence.parsedChecksum_       = static_cast<uint8_t>(value);
+		sentence.calculatedChecksum_   = xorChecksum(line.substr(begin, star - begin));
+		sentence.checksumIsCalculated_ = true;
+		end                            = star;
+	}
+
+	if ( begin == end ) {
+		return ParseStatus::Empty;
+	}
+	sentence.text_ = line.substr(0, end);
+
+	// Name, up to the first comma
+	size_t comma = line.substr(0, end).find(',', begin);
+	if ( comma == string_view::npos ) {
+		comma = end;
+	}
+	sentence.name_ = line.substr(begin, comma - begin);
+	if ( sentence.name_.empty() ) {
+		return ParseStatus::BadName;
+	}
+	for ( auto chr: sentence.name_ ) {
+		if ( !isAlphaNum(chr) ) {
+			return ParseStatus::BadName;
+		}
+	}
+
+	// Parameters, each one starts after a comma
+	bool   encapsulated = line[dollar] == '!';
+	size_t count        = 0;
+	for ( size_t pos = comma; pos < end; pos++ ) {
+		char chr = line[pos];
+		if ( chr == ',' ) {
+			if ( count == SentenceView::MaxParameters ) {
+				return ParseStatus::TooManyFields;
+			}
+			sentence.starts_[count++] = static_cast<uint8_t>(pos + 1);
+		}
+		else if ( encapsulated ? !isEncapsulated(chr) : !isAlphaNum(chr) && chr != '-' && chr != '.' ) {
+			return ParseStatus::BadCharacter;
+		}
+	}
+	sentence.starts_[count]    = static_cast<uint8_t>(end + 1);
+	sentence.parameterCount_ = static_cast<uint8_t>(count);
+
+	return ParseStatus::Ok;
+}
@@ -0,0 +1,510 @@
+/*
+ * SharedFix.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/SharedFix.hpp"
+
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include "nmeaparse/GPSService.hpp"
+
+#if defined(__linux__)
+#	include <cerrno>
+#	include <fcntl.h>
+#	include <linux/futex.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace nmea;
+
+static_assert(sizeof(SharedFixRecord) == 128, "SharedFixRecord is part of the shared memory layout");
+
+namespace {
+
+constexpr uint64_t Magic   = 0x5849465f41454d4eULL; // "NMEA_FIX" in memory
+constexpr uint32_t Version = 1;
+constexpr size_t   Words   = sizeof(SharedFixRecord) / sizeof(uint64_t);
+
+// Tries of latest() at the newest slot. A live publisher is done with a slot
+// long before, one that died while writing it never is.
+constexpr int ReadAttempts = 1000;
+
+// The start of the segment. The publisher fills it in and writes magic last,
+// readers that find no magic come too early.
+struct Header {
+	std::atomic<uint64_t> magic;
+	uint32_t              version;
+	uint32_t              recordSize;
+	uint32_t              slots;
+	uint32_t              contents; // SharedFixReader::Contents bits
+
+	alignas(64) std::atomic<uint64_t> head; // sequence of the newest fix
+	std::atomic<uint32_t> wake;             // futex word, bumped by every publish
+	std::atomic<uint32_t> waiters;          // readers sleeping on wake
+	std::atomic<uint32_t> closed;
+};
+
+// The record is kept as atomic words, so copying it while the publisher
+// writes is not a data race. Relaxed loads and stores are plain moves.
+struct alignas(64) Slot {
+	std::atomic<uint64_t> sequence; // 2 * the record's sequence, minus 1 while it is written
+	std::atomic<uint64_t> words[Words];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free, "shared between processes");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "the futex word");
+
+Header*
+headerOf(void* map)
+{
+	return static_cast<Header*>(map);
+}
+
+Slot*
+slotsOf(void* map)
+{
+	return reinterpret_cast<Slot*>(static_cast<char*>(map) + sizeof(Header));
+}
+
+size_t
+segmentSize(uint32_t slots)
+{
+	return sizeof(Header) + static_cast<size_t>(slots) * sizeof(Slot);
+}
+
+int64_t
+steadyNanoseconds()
+{
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+nanoseconds
+SharedFixRecord::age() const
+{
+	return nanoseconds(steadyNanoseconds() - published_);
+}
+
+#if defined(__linux__)
+
+namespace {
+
+long
+futex(std::atomic<uint32_t>& word, int op, uint32_t value, const timespec* timeout = nullptr)
+{
+	// not FUTEX_PRIVATE_FLAG, the waiters are in other processes
+	return ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), op, value, timeout, nullptr, 0);
+}
+
+void
+closeSegment(void* map)
+{
+	Header* header = headerOf(map);
+	header->closed.store(1, memory_order_release);
+	header->wake.fetch_add(1);
+	futex(header->wake, FUTEX_WAKE, INT_MAX);
+}
+
+} // namespace
+
+SharedFixPublisher::SharedFixPublisher(const string& name, SharedFixSettings settings)
+    : name_(name)
+    , settings_(settings)
+    , size_(segmentSize(settings.slots))
+{
+	if ( settings_.slots == 0 || settings_.slots > (1U << 20) ) {
+		throw invalid_argument("SharedFixPublisher: slots must be 1 - 1048576");
+	}
+	uint32_t contents = (settings_.almanac ? SharedFixReader::Almanac : 0U) | (settings_.dirtyMask ? SharedFixReader::DirtyMask : 0U);
+	string   path     = "/" + name_;
+
+	int fd = ::shm_open(path.c_str(), O_RDWR | O_CREAT, static_cast<mode_t>(settings_.permissions));
+	if ( fd < 0 ) {
+		throw system_error(errno, system_category(), "SharedFixPublisher: shm_open()");
+	}
+
+	// Carry on in a segment of the same layout, otherwise close the old one for
+	// its readers and start a new one next to it.
+	struct stat st {};
+	::fstat(fd, &st);
+	if ( st.st_size >= static_cast<off_t>(sizeof(Header)) ) {
+		auto  old     = static_cast<size_t>(st.st_size);
+		void* map     = ::mmap(nullptr, old, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if ( map != MAP_FAILED ) {
+			Header* header = headerOf(map);
+			if ( header->magic.load(memory_order_acquire) == Magic ) {
+				if ( old == size_ && header->version == Version && header->recordSize == sizeof(SharedFixRecord) && header->slots == settings_.slots && header->contents == contents ) {
+					::close(fd);
+					map_      = map;
+					sequence_ = header->head.load(memory_order_acquire);
+					header->closed.store(0, memory_order_release);
+					return;
+				}
+				closeSegment(map);
+			}
+			::munmap(map, old);
+		}
+	}
+	if ( st.st_size != 0 ) {
+		::close(fd);
+		::shm_unlink(path.c_str());
+		fd = ::shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, static_cast<mode_t>(settings_.permissions));
+		if ( fd < 0 ) {
+			throw system_error(errno, system_category(), "SharedFixPublisher: shm_open()");
+		}
+	}
+
+	// the umask doesn't apply to fchmod()
+	if ( ::fchmod(fd, static_cast<mode_t>(settings_.permissions)) != 0 || ::ftruncate(fd, static_cast<off_t>(size_)) != 0 ) {
+		int err = errno;
+		::close(fd);
+		throw system_error(err, system_category(), "SharedFixPublisher: setting up the segment");
+	}
+	void* map = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	int   err = errno;
+	::close(fd);
+	if ( map == MAP_FAILED ) {
+		throw system_error(err, system_category(), "SharedFixPublisher: mmap()");
+	}
+	map_ = map;
+
+	// ftruncate() zeroed it: no fixes, every slot empty
+	Header* header = new (map_) Header();
+	header->version    = Version;
+	header->recordSize = sizeof(SharedFixRecord);
+	header->slots      = settings_.slots;
+	header->contents   = contents;
+	for ( uint32_t i = 0; i < settings_.slots; i++ ) {
+		new (slotsOf(map_) + i) Slot();
+	}
+	header->magic.store(Magic, memory_order_release);
+}
+
+SharedFixPublisher::~SharedFixPublisher()
+{
+	closeSegment(map_);
+	::munmap(map_, size_);
+}
+
+void
+SharedFixPublisher::write(SharedFixRecord& record)
+{
+	Header*  header   = headerOf(map_);
+	uint64_t sequence = ++sequence_;
+	Slot&    slot     = slotsOf(map_)[(sequence - 1) % settings_.slots];
+
+	record.sequence_  = sequence;
+	record.published_ = steadyNanoseconds();
+
+	uint64_t words[Words];
+	memcpy(words, &record, sizeof(record));
+
+	slot.sequence.store(2 * sequence - 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	for ( size_t i = 0; i < Words; i++ ) {
+		slot.words[i].store(words[i], memory_order_relaxed);
+	}
+	slot.sequence.store(2 * sequence, memory_order_release);
+	header->head.store(sequence, memory_order_release);
+
+	// Bumping the word before looking for sleepers pairs with wait(), which
+	// registers before the kernel compares the word: one of the two sees the other.
+	header->wake.fetch_add(1);
+	if ( header->waiters.load() != 0 ) {
+		futex(header->wake, FUTEX_WAKE, INT_MAX);
+	}
+}
+
+void
+SharedFixPublisher::remove(const string& name)
+{
+	::shm_unlink(("/" + name).c_str());
+}
+
+SharedFixReader::SharedFixReader(const string& name)
+{
+	int fd = ::shm_open(("/" + name).c_str(), O_RDWR, 0);
+	if ( fd < 0 ) {
+		throw system_error(errno, system_category(), "SharedFixReader: shm_open()");
+	}
+	struct stat st {};
+	::fstat(fd, &st);
+	if ( st.st_size < static_cast<off_t>(sizeof(Header)) ) {
+		::close(fd);
+		throw runtime_error("SharedFixReader: \"" + name + "\" is not set up yet");
+	}
+	size_     = static_cast<size_t>(st.st_size);
+	void* map = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	int   err = errno;
+	::close(fd);
+	if ( map == MAP_FAILED ) {
+		throw system_error(err, system_category(), "SharedFixReader: mmap()");
+	}
+
+	Header* header = headerOf(map);
+	if ( header->magic.load(memory_order_acquire) != Magic || header->version != Version || header->recordSize != sizeof(SharedFixRecord)
+	     || header->slots == 0 || segmentSize(header->slots) > size_ ) {
+		::munmap(map, size_);
+		throw runtime_error("SharedFixReader: \"" + name + "\" is not a fix segment of version " + to_string(Version) + ", or not set up yet");
+	}
+	map_      = map;
+	slots_    = header->slots;
+	contents_ = header->contents;
+}
+
+SharedFixReader::~SharedFixReader()
+{
+	::munmap(map_, size_);
+}
+
+bool
+SharedFixReader::read(uint64_t sequence, SharedFixRecord& record) const
+{
+	const Slot& slot   = slotsOf(map_)[(sequence - 1) % slots_];
+	uint64_t    before = slot.sequence.load(memory_order_acquire);
+	if ( before != 2 * sequence ) {
+		return false;
+	}
+
+	uint64_t words[Words];
+	for ( size_t i = 0; i < Words; i++ ) {
+		words[i] = slot.words[i].load(memory_order_relaxed);
+	}
+	atomic_thread_fence(memory_order_acquire);
+	if ( slot.sequence.load(memory_order_relaxed) != before ) {
+		return false;
+	}
+	memcpy(&record, words, sizeof(record));
+	return true;
+}
+
+bool
+SharedFixReader::wait(SharedFixRecord& record, nanoseconds timeout)
+{
+	Header* header   = headerOf(map_);
+	auto    deadline = steady_clock::now() + timeout;
+	while ( true ) {
+		// the word first: a publish after it changes it, and the kernel won't sleep
+		uint32_t word = header->wake.load();
+		if ( next(record) ) {
+			return true;
+		}
+		if ( closed() ) {
+			return false;
+		}
+		auto left = deadline - steady_clock::now();
+		if ( left <= nanoseconds::zero() ) {
+			return false;
+		}
+
+		auto     secs = duration_cast<seconds>(left);
+		timespec ts{ static_cast<time_t>(secs.count()), static_cast<long>(duration_cast<nanoseconds>(left - secs).count()) };
+		header->waiters.fetch_add(1);
+		futex(header->wake, FUTEX_WAIT, word, &ts);
+		header->waiters.fetch_sub(1);
+	}
+}
+
+#else
+
+SharedFixPublisher::SharedFixPublisher(const string& name, SharedFixSettings settings)
+    : name_(name)
+    , settings_(settings)
+{
+	throw runtime_error("SharedFixPublisher: only supported on Linux");
+}
+
+SharedFixPublisher::~SharedFixPublisher() = default;
+
+void
+SharedFixPublisher::write(SharedFixRecord& /*record*/)
+{
+}
+
+void
+SharedFixPublisher::remove(const string& /*name*/)
+{
+}
+
+SharedFixReader::SharedFixReader(const string& /*name*/)
+{
+	throw runtime_error("SharedFixReader: only supported on Linux");
+}
+
+SharedFixReader::~SharedFixReader() = default;
+
+bool
+SharedFixReader::read(uint64_t /*sequence*/, SharedFixRecord& /*record*/) const
+{
+	return false;
+}
+
+bool
+SharedFixReader::wait(SharedFixRecord& /*record*/, nanoseconds /*timeout*/)
+{
+	return false;
+}
+
+#endif
+
+void
+SharedFixPublisher::publish(const GPSFix& fix)
+{
+	SharedFixRecord record;
+	record.time_               = fix.timestamp_.toUTCTime().time_since_epoch().count();
+	record.latitude_           = fix.latitude_;
+	record.longitude_          = fix.longitude_;
+	record.altitude_           = fix.altitude_;
+	record.speed_              = fix.speed_;
+	record.travelAngle_        = fix.travelAngle_;
+	record.dilution_           = fix.dilution_;
+	record.horizontalDilution_ = fix.horizontalDilution_;
+	record.verticalDilution_   = fix.verticalDilution_;
+	record.trackingSatellites_ = fix.trackingSatellites_;
+	record.visibleSatellites_  = fix.visibleSatellites_;
+	record.status_             = fix.status_;
+	record.type_               = fix.type_;
+	record.quality_            = fix.quality_;
+	record.locked_             = fix.locked();
+
+	if ( settings_.almanac ) {
+		const GPSAlmanac& almanac = fix.almanac_;
+		record.satellites_        = static_cast<uint32_t>(almanac.satellites_.size());
+		record.averageSNR_        = static_cast<float>(almanac.averageSNR());
+		record.minSNR_            = static_cast<float>(almanac.minSNR());
+		record.maxSNR_            = static_cast<float>(almanac.maxSNR());
+		record.almanacComplete_   = static_cast<float>(almanac.percentComplete());
+	}
+
+	if ( settings_.dirtyMask ) {
+		const SharedFixRecord& last = last_;
+		if ( last.sequence_ == 0 ) {
+			record.dirty_ = SharedFixRecord::AllFields;
+		}
+		else {
+			uint32_t dirty = 0;
+			dirty |= record.time_ != last.time_ ? SharedFixRecord::Time : 0U;
+			dirty |= record.locked_ != last.locked_ || record.status_ != last.status_ || record.type_ != last.type_ || record.quality_ != last.quality_ ? SharedFixRecord::Lock : 0U;
+			dirty |= record.latitude_ != last.latitude_ || record.longitude_ != last.longitude_ ? SharedFixRecord::Position : 0U;
+			dirty |= record.altitude_ != last.altitude_ ? SharedFixRecord::Altitude : 0U;
+			dirty |= record.speed_ != last.speed_ || record.travelAngle_ != last.travelAngle_ ? SharedFixRecord::Velocity : 0U;
+			dirty |= record.dilution_ != last.dilution_ || record.horizontalDilution_ != last.horizontalDilution_ || record.verticalDilution_ != last.verticalDilution_ ? SharedFixRecord::Dilution : 0U;
+			dirty |= record.trackingSatellites_ != last.trackingSatellites_ || record.visibleSatellites_ != last.visibleSatellites_ ? SharedFixRecord::Satellites : 0U;
+			dirty |= record.satellites_ != last.satellites_ || record.averageSNR_ != last.averageSNR_ || record.minSNR_ != last.minSNR_ || record.maxSNR_ != last.maxSNR_ || record.almanacComplete_ != last.almanacComplete_ ? SharedFixRecord::Almanac : 0U;
+			record.dirty_ = dirty;
+		}
+	}
+
+	write(record);
+	last_ = record;
+}
+
+void
+SharedFixPublisher::attachToService(GPSService& gps)
+{
+	gps.onUpdate += [this, &gps]() {
+		publish(gps.fix_);
+	};
+}
+
+const string&
+SharedFixPublisher::name() const
+{
+	return name_;
+}
+
+const SharedFixSettings&
+SharedFixPublisher::settings() const
+{
+	return settings_;
+}
+
+uint64_t
+SharedFixPublisher::published() const
+{
+	return sequence_;
+}
+
+bool
+SharedFixReader::latest(SharedFixRecord& record)
+{
+	for ( int attempt = 0; attempt < ReadAttempts; attempt++ ) {
+		uint64_t head = published();
+		if ( head == 0 ) {
+			return false;
+		}
+		// lost only if the publisher went round the whole ring meanwhile, or
+		// (one slot) is writing the next fix over it
+		if ( read(head, record) ) {
+			last_ = head;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool
+SharedFixReader::next(SharedFixRecord& record)
+{
+	// every pass moves last_ on, up to the head
+	while ( true ) {
+		uint64_t head = published();
+		if ( last_ >= head ) {
+			return false;
+		}
+		uint64_t wanted = last_ + 1;
+		if ( head - wanted >= slots_ ) {
+			missed_ += head - slots_ + 1 - wanted;
+			wanted = head - slots_ + 1;
+		}
+		last_ = wanted;
+		if ( read(wanted, record) ) {
+			return true;
+		}
+		missed_++; // overwritten while it was copied
+	}
+}
+
+uint64_t
+SharedFixReader::published() const
+{
+	return map_ != nullptr ? headerOf(map_)->head.load(memory_order_acquire) : 0;
+}
+
+uint64_t
+SharedFixReader::missed() const
+{
+	return missed_;
+}
+
+bool
+SharedFixReader::closed() const
+{
+	return map_ == nullptr || headerOf(map_)->closed.load(memory_order_acquire) != 0;
+}
+
+uint32_t
+SharedFixReader::slots() const
+{
+	return slots_;
+}
+
+uint32_t
+SharedFixReader::contents() const
+{
+	return contents_;
+}
@@ -0,0 +1,391 @@
+/*
+ * StreamDemultiplexer.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/StreamDemultiplexer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+
+#include "nmeaparse/NMEAParser.hpp"
+
+using namespace std;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+namespace {
+
+// Bytes up to and including the length, per protocol
+constexpr size_t UBXHeader   = 6;
+constexpr size_t SiRFHeader  = 4;
+constexpr size_t RTCM3Header = 3;
+
+constexpr array<uint32_t, 256>
+makeCRC24QTable()
+{
+	array<uint32_t, 256> table{};
+	for ( uint32_t i = 0; i < 256; i++ ) {
+		uint32_t crc = i << 16;
+		for ( int bit = 0; bit < 8; bit++ ) {
+			crc <<= 1;
+			if ( (crc & 0x1000000) != 0 ) {
+				crc ^= 0x1864CFB; // CRC-24Q polynomial
+			}
+		}
+		table[i] = crc & 0xFFFFFF;
+	}
+	return table;
+}
+
+constexpr array<uint32_t, 256> CRC24QTable = makeCRC24QTable();
+
+} // namespace
+
+const char*
+nmea::frameProtocolName(FrameProtocol protocol)
+{
+	switch ( protocol ) {
+	case FrameProtocol::NMEA:
+		return "NMEA";
+	case FrameProtocol::UBX:
+		return "UBX";
+	case FrameProtocol::SiRF:
+		return "SiRF";
+	case FrameProtocol::RTCM3:
+		return "RTCM3";
+	default:
+		return "?";
+	}
+}
+
+// ------------- STREAM DEMULTIPLEXER -------------
+
+StreamDemultiplexer::StreamDemultiplexer(NMEAParser* parser, pmr::memory_resource* resource)
+    : parser_(parser)
+    , buffer_(resource)
+    , rescan_(resource)
+    , onFrame(resource)
+{
+	buffer_.reserve(MaxFrameSize);
+	// a dropped frame puts back less than it held, so this never grows
+	rescan_.reserve(MaxFrameSize);
+}
+
+void
+StreamDemultiplexer::setParser(NMEAParser* parser)
+{
+	parser_ = parser;
+}
+
+uint16_t
+StreamDemultiplexer::ubxChecksum(const uint8_t* data, size_t size)
+{
+	// 8 bit Fletcher
+	uint8_t a = 0;
+	uint8_t b = 0;
+	for ( size_t i = 0; i < size; i++ ) {
+		a = static_cast<uint8_t>(a + data[i]);
+		b = static_cast<uint8_t>(b + a);
+	}
+	return static_cast<uint16_t>(a | (b << 8));
+}
+
+uint32_t
+StreamDemultiplexer::crc24q(const uint8_t* data, size_t size)
+{
+	uint32_t crc = 0;
+	for ( size_t i = 0; i < size; i++ ) {
+		crc = ((crc << 8) & 0xFFFFFF) ^ CRC24QTable[((crc >> 16) ^ data[i]) & 0xFF];
+	}
+	return crc;
+}
+
+void
+StreamDemultiplexer::readBuffer(const uint8_t* data, size_t size)
+{
+	rescan(); // left over when a handler threw
+	size_t i = 0;
+	while ( i < size ) {
+		// the middle of a line or frame is copied in one go, the byte that may
+		// end it goes through readByte()
+		size_t run = 0;
+		if ( state_ == State::Line ) {
+			size_t limit = min(size - i, MaxFrameSize - buffer_.size());
+			while ( run < limit && data[i + run] < 0x80 && data[i + run] != '$' && data[i + run] != '!' && data[i + run] != '\n' ) {
+				run++;
+			}
+		}
+		else if ( state_ == State::Frame && frameSize_ != 0 ) {
+			run = min(size - i, frameSize_ - buffer_.size() - 1);
+		}
+		buffer_.insert(buffer_.end(), data + i, data + i + run);
+		i += run;
+		if ( i < size ) {
+			readByte(data[i++]);
+		}
+	}
+}
+
+void
+StreamDemultiplexer::readByte(uint8_t byte)
+{
+	rescan(); // left over when a handler threw
+	step(byte);
+	rescan();
+}
+
+void
+StreamDemultiplexer::rescan()
+{
+	if ( rescanning_ ) {
+		return; // a frame dropped while rescanning, the loop below picks its bytes up
+	}
+	rescanning_ = true;
+	try {
+		while ( !rescan_.empty() ) {
+			uint8_t byte = rescan_.back();
+			rescan_.pop_back();
+			step(byte);
+		}
+	}
+	catch ( ... ) {
+		rescanning_ = false;
+		throw;
+	}
+	rescanning_ = false;
+}
+
+void
+StreamDemultiplexer::step(uint8_t byte)
+{
+	switch ( state_ ) {
+	case State::Idle:
+		start(byte);
+		break;
+
+	case State::Line:
+		if ( byte >= 0x80 || byte == '$' || byte == '!' ) {
+			// a binary frame (or the next sentence) cut the line short
+			discarded_ += buffer_.size();
+			buffer_.clear();
+			state_ = State::Idle;
+			start(byte);
+		}
+		else if ( buffer_.size() == MaxFrameSize ) {
+			// no '$' or binary sync byte in it, nothing to read again
+			discarded_ += buffer_.size();
+			buffer_.clear();
+			state_ = State::Idle;
+			oversize_++;
+		}
+		else {
+			buffer_.push_back(byte);
+			if ( byte == '\n' ) {
+				frames_[static_cast<size_t>(FrameProtocol::NMEA)]++;
+				state_ = State::Idle;
+				if ( parser_ != nullptr ) {
+					try {
+						parser_->readSentence(string_view(reinterpret_cast<const char*>(buffer_.data()), buffer_.size()));
+					}
+					catch ( ... ) {
+						buffer_.clear();
+						throw;
+					}
+				}
+				buffer_.clear();
+			}
+		}
+		break;
+
+	case State::Frame:
+		frameByte(byte);
+		break;
+	}
+}
+
+void
+StreamDemultiplexer::start(uint8_t byte)
+{
+	switch ( byte ) {
+	case '$':
+	case '!': // encapsulation sentences, AIS
+		state_ = State::Line;
+		break;
+	case 0xB5:
+		protocol_ = FrameProtocol::UBX;
+		state_    = State::Frame;
+		break;
+	case 0xA0:
+		protocol_ = FrameProtocol::SiRF;
+		state_    = State::Frame;
+		break;
+	case 0xD3:
+		protocol_ = FrameProtocol::RTCM3;
+		state_    = State::Frame;
+		break;
+	default:
+		discarded_++;
+		return;
+	}
+	buffer_.clear();
+	buffer_.push_back(byte);
+	frameSize_ = 0;
+}
+
+void
+StreamDemultiplexer::frameByte(uint8_t byte)
+{
+	buffer_.push_back(byte);
+	size_t size = buffer_.size();
+
+	if ( frameSize_ == 0 ) {
+		// still in the header: second sync byte, then the length
+		switch ( protocol_ ) {
+		case FrameProtocol::UBX:
+			if ( size == 2 && byte != 0x62 ) {
+				drop(false);
+			}
+			else if ( size == UBXHeader ) {
+				frameSize_ = UBXHeader + (buffer_[4] | (buffer_[5] << 8)) + 2;
+			}
+			break;
+		case FrameProtocol::SiRF:
+			if ( size == 2 && byte != 0xA2 ) {
+				drop(false);
+			}
+			else if ( size == SiRFHeader ) {
+				frameSize_ = SiRFHeader + (((buffer_[2] & 0x7F) << 8) | buffer_[3]) + 4; // checksum and 0xB0 0xB3
+			}
+			break;
+		case FrameProtocol::RTCM3:
+			if ( size == 2 && (byte & 0xFC) != 0 ) {
+				drop(false); // the 6 reserved bits are 0
+			}
+			else if ( size == RTCM3Header ) {
+				frameSize_ = RTCM3Header + (((buffer_[1] & 0x03) << 8) | buffer_[2]) + 3;
+			}
+			break;
+		default:
+			break;
+		}
+
+		if ( frameSize_ > MaxFrameSize ) {
+			drop(false);
+			oversize_++;
+		}
+		return;
+	}
+
+	if ( size == frameSize_ ) {
+		finishFrame();
+	}
+}
+
+void
+StreamDemultiplexer::finishFrame()
+{
+	const uint8_t* data = buffer_.data();
+	size_t         size = buffer_.size();
+
+	BinaryFrame frame{ protocol_, 0, data, size, nullptr, 0 };
+	bool        good = false;
+	switch ( protocol_ ) {
+	case FrameProtocol::UBX:
+		good               = ubxChecksum(data + 2, size - 4) == (data[size - 2] | (data[size - 1] << 8));
+		frame.type_        = static_cast<uint16_t>((data[2] << 8) | data[3]);
+		frame.payload_     = data + UBXHeader;
+		frame.payloadSize_ = size - UBXHeader - 2;
+		break;
+	case FrameProtocol::SiRF: {
+		frame.payload_     = data + SiRFHeader;
+		frame.payloadSize_ = size - SiRFHeader - 4;
+		uint32_t sum       = 0;
+		for ( size_t i = 0; i < frame.payloadSize_; i++ ) {
+			sum += frame.payload_[i];
+		}
+		good        = (sum & 0x7FFF) == static_cast<uint32_t>((data[size - 4] << 8) | data[size - 3]) && data[size - 2] == 0xB0 && data[size - 1] == 0xB3;
+		frame.type_ = frame.payloadSize_ > 0 ? frame.payload_[0] : 0;
+		break;
+	}
+	case FrameProtocol::RTCM3:
+		good               = crc24q(data, size - 3) == static_cast<uint32_t>((data[size - 3] << 16) | (data[size - 2] << 8) | data[size - 1]);
+		frame.payload_     = data + RTCM3Header;
+		frame.payloadSize_ = size - RTCM3Header - 3;
+		frame.type_        = frame.payloadSize_ >= 2 ? static_cast<uint16_t>((frame.payload_[0] << 4) | (frame.payload_[1] >> 4)) : 0;
+		break;
+	default:
+		break;
+	}
+
+	if ( !good ) {
+		drop(true);
+		return;
+	}
+
+	frames_[static_cast<size_t>(protocol_)]++;
+	state_     = State::Idle;
+	frameSize_ = 0;
+	try {
+		onFrame(frame);
+	}
+	catch ( ... ) {
+		buffer_.clear();
+		throw;
+	}
+	buffer_.clear();
+}
+
+void
+StreamDemultiplexer::drop(bool checksumError)
+{
+	if ( checksumError ) {
+		checksumErrors_++;
+	}
+	else {
+		discarded_++; // the sync byte, the rest is read again
+	}
+	// the next frame may start anywhere after the sync byte, even in a part
+	// readBuffer() copied in one go
+	rescan_.insert(rescan_.end(), buffer_.rbegin(), buffer_.rend() - 1);
+	buffer_.clear();
+	state_     = State::Idle;
+	frameSize_ = 0;
+}
+
+void
+StreamDemultiplexer::reset()
+{
+	buffer_.clear();
+	rescan_.clear();
+	state_     = State::Idle;
+	frameSize_ = 0;
+}
+
+uint64_t
+StreamDemultiplexer::frames(FrameProtocol protocol) const
+{
+	return protocol < FrameProtocol::Count ? frames_[static_cast<size_t>(protocol)] : 0;
+}
+
+uint64_t
+StreamDemultiplexer::checksumErrors() const
+{
+	return checksumErrors_;
+}
+
+uint64_t
+StreamDemultiplexer::oversize() const
+{
+	return oversize_;
+}
+
+uint64_t
+StreamDemultiplexer::discarded() const
+{
+	return discarded_;
+}
@@ -0,0 +1,214 @@
+/*
+ * TrackSimplifier.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/TrackSimplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "nmeaparse/GPSService.hpp"
+#include "nmeaparse/Geodesy.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace nmea;
+
+// ------ Some helpers ----------
+
+static constexpr double DegToRad = 3.14159265358979323846 / 180.0;
+
+// ------------- TRACK SIMPLIFIER -------------
+
+TrackSimplifier::TrackSimplifier(TrackSimplifierSettings settings)
+{
+	setSettings(settings);
+}
+
+void
+TrackSimplifier::setSettings(const TrackSimplifierSettings& settings)
+{
+	if ( settings.maxWindow < 2 ) {
+		throw invalid_argument("TrackSimplifier window must hold at least 2 points");
+	}
+	settings_ = settings;
+	window_.reserve(settings_.maxWindow);
+	offsets_.reserve(settings_.maxWindow);
+}
+
+const TrackSimplifierSettings&
+TrackSimplifier::settings() const
+{
+	return settings_;
+}
+
+void
+TrackSimplifier::keep(const FixRecord& point)
+{
+	kept_++;
+	onPoint(point);
+}
+
+void
+TrackSimplifier::restart(const FixRecord& point)
+{
+	window_.clear();
+	window_.push_back(point);
+	offsets_.clear();
+	offsets_.push_back(Offset{ 0, 0 });
+	anchorCos_ = cos(point.latitude_ * DegToRad);
+}
+
+// Meters east and north of the last kept point, flat around it. Plenty for the
+// distances in one window.
+TrackSimplifier::Offset
+TrackSimplifier::offset(const FixRecord& point) const
+{
+	const double metersPerDegree = EarthMeanRadius * DegToRad;
+
+	double longitude = point.longitude_ - window_.front().longitude_;
+	longitude        = longitude > 180 ? longitude - 360 : longitude < -180 ? longitude + 360 : longitude;
+	return Offset{ longitude * anchorCos_ * metersPerDegree, (point.latitude_ - window_.front().latitude_) * metersPerDegree };
+}
+
+// Would the line from the last kept point to end pass every point since within tolerance?
+bool
+TrackSimplifier::windowFits(Offset end) const
+{
+	// squared distances from the segment 0-end (the window starts at 0), without
+	// an early exit so the loop vectorizes
+	double length    = end.east * end.east + end.north * end.north;
+	double inverse   = length > 0 ? 1 / length : 0;
+	double tolerance = settings_.tolerance * settings_.tolerance;
+	bool   fits      = true;
+	for ( size_t i = 1; i < offsets_.size(); i++ ) {
+		const Offset& p = offsets_[i];
+		double        t = min(max((p.east * end.east + p.north * end.north) * inverse, 0.0), 1.0);
+		double        e = p.east - t * end.east;
+		double        n = p.north - t * end.north;
+		fits            = fits && e * e + n * n <= tolerance;
+	}
+	return fits;
+}
+
+void
+TrackSimplifier::push(const FixRecord& point)
+{
+	received_++;
+	if ( window_.empty() ) {
+		keep(point);
+		restart(point);
+		return;
+	}
+
+	// overdue, keep this one, and the one before if the line wouldn't fit
+	if ( settings_.maxInterval.count() > 0 && point.time_ - window_.front().time_ >= settings_.maxInterval ) {
+		if ( settings_.mode == SimplifyMode::OpeningWindow && window_.size() > 1 && !windowFits(offset(point)) ) {
+			keep(window_.back());
+		}
+		keep(point);
+		restart(point);
+		return;
+	}
+
+	if ( settings_.mode == SimplifyMode::DeadBand ) {
+		Offset moved  = offset(point);
+		bool   keepIt = hypot(moved.east, moved.north) > settings_.tolerance;
+		if ( settings_.headingChange > 0 && point.speed_ > 0 ) {
+			double turn = fabs(fmod(static_cast<double>(point.travelAngle_ - window_.front().travelAngle_) + 540.0, 360.0) - 180.0);
+			keepIt      = keepIt || turn > settings_.headingChange;
+		}
+		if ( keepIt ) {
+			keep(point);
+			restart(point);
+		}
+		else if ( window_.size() == 1 ) {
+			window_.push_back(point);
+		}
+		else {
+			window_.back() = point; // only the last one is needed, for flush()
+		}
+		return;
+	}
+
+	if ( window_.size() >= settings_.maxWindow ) {
+		FixRecord last = window_.back();
+		keep(last);
+		restart(last);
+	}
+	Offset end = offset(point);
+	if ( !windowFits(end) ) {
+		// the window ends at the point before, which fitted
+		FixRecord last = window_.back();
+		keep(last);
+		restart(last);
+		end = offset(point);
+	}
+	window_.push_back(point);
+	offsets_.push_back(end);
+}
+
+void
+TrackSimplifier::flush()
+{
+	if ( hasPending_ ) {
+		hasPending_ = false;
+		push(pending_);
+	}
+	if ( window_.size() > 1 ) {
+		FixRecord last = window_.back();
+		keep(last);
+		restart(last);
+	}
+}
+
+void
+TrackSimplifier::reset()
+{
+	window_.clear();
+	offsets_.clear();
+	hasPending_ = false;
+}
+
+void
+TrackSimplifier::attachToService(GPSService& gps)
+{
+	gps.onUpdate += [this, &gps]() {
+		if ( !gps.fix_.locked() ) {
+			return;
+		}
+		FixRecord record(gps.fix_);
+		if ( hasPending_ && record.time_ != pending_.time_ ) {
+			push(pending_); // all sentences of that epoch are in
+		}
+		pending_    = record;
+		hasPending_ = true;
+	};
+}
+
+void
+TrackSimplifier::simplify(const FixHistory& history, vector<FixRecord>& out) const
+{
+	TrackSimplifier simplifier(settings_);
+	simplifier.onPoint += [&out](const FixRecord& point) { out.push_back(point); };
+	for ( const auto& record: history ) {
+		simplifier.push(record);
+	}
+	simplifier.flush();
+}
+
+uint64_t
+TrackSimplifier::received() const
+{
+	return received_;
+}
+
+uint64_t
+TrackSimplifier::kept() const
+{
+	return kept_;
+}
@@ -0,0 +1,131 @@
+/*
+ * UDPSource.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include "nmeaparse/UDPSource.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(__linux__)
+#	include <arpa/inet.h>
+#	include <cerrno>
+#	include <linux/errqueue.h>
+#	include <linux/net_tstamp.h>
+#	include <netinet/in.h>
+#	include <sys/socket.h>
+#	include <unistd.h>
+#endif
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace nmea;
+
+#if defined(__linux__)
+
+UDPSource::UDPSource(uint16_t port, const string& bindAddress)
+    : fd_(::socket(AF_INET, SOCK_DGRAM, 0))
+    , kernelTimestamps_(false)
+    , buffer_(65536)
+{
+	if ( fd_ < 0 ) {
+		throw system_error(errno, system_category(), "UDPSource: socket()");
+	}
+
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_port   = htons(port);
+	if ( ::inet_pton(AF_INET, bindAddress.c_str(), &addr.sin_addr) != 1 ) {
+		::close(fd_);
+		throw invalid_argument("UDPSource: bad bind address \"" + bindAddress + "\"");
+	}
+	if ( ::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ) {
+		int err = errno;
+		::close(fd_);
+		throw system_error(err, system_category(), "UDPSource: bind()");
+	}
+
+	int flags         = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+	kernelTimestamps_ = ::setsockopt(fd_, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0;
+}
+
+UDPSource::~UDPSource()
+{
+	::close(fd_);
+}
+
+size_t
+UDPSource::receive(NMEAParser& parser)
+{
+	alignas(cmsghdr) char control[256];
+
+	iovec  iov{ buffer_.data(), buffer_.size() };
+	msghdr msg{};
+	msg.msg_iov        = &iov;
+	msg.msg_iovlen     = 1;
+	msg.msg_control    = control;
+	msg.msg_controllen = sizeof(control);
+
+	ssize_t size = ::recvmsg(fd_, &msg, 0);
+	if ( size < 0 ) {
+		throw system_error(errno, system_category(), "UDPSource: recvmsg()");
+	}
+
+	ReceiveClock::time_point rxTime = ReceiveClock::now();
+
+	for ( cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg) ) {
+		if ( cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPING ) {
+			scm_timestamping stamps{};
+			memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+			if ( stamps.ts[0].tv_sec == 0 && stamps.ts[0].tv_nsec == 0 ) {
+				break;
+			}
+
+			// The kernel stamps in CLOCK_REALTIME, move it over to the monotonic clock.
+			auto kernel = system_clock::time_point(duration_cast<system_clock::duration>(seconds(stamps.ts[0].tv_sec) + nanoseconds(stamps.ts[0].tv_nsec)));
+			auto age    = system_clock::now() - kernel;
+			if ( age >= system_clock::duration::zero() ) {
+				rxTime -= duration_cast<ReceiveClock::duration>(age);
+			}
+			break;
+		}
+	}
+
+	parser.readBuffer(buffer_.data(), static_cast<uint32_t>(size), rxTime);
+	return static_cast<size_t>(size);
+}
+
+#else
+
+UDPSource::UDPSource(uint16_t /*port*/, const string& /*bindAddress*/)
+    : fd_(-1)
+    , kernelTimestamps_(false)
+{
+	throw runtime_error("UDPSource: only supported on Linux");
+}
+
+UDPSource::~UDPSource() = default;
+
+size_t
+UDPSource::receive(NMEAParser& /*parser*/)
+{
+	return 0;
+}
+
+#endif
+
+int
+UDPSource::fd() const
+{
+	return fd_;
+}
+
+bool
+UDPSource::kernelTimestamps() const
+{
+	return kernelTimestamps_;
+}
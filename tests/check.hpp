@@ -0,0 +1,52 @@
+/*
+ * check.hpp
+ *
+ *  See the license file included with this source.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+// What the tests assert with. A failed CHECK prints where and carries on, the
+// test's main() returns finish().
+namespace nmea::test {
+
+inline int failures = 0;
+
+inline bool
+check(bool ok, const char* expression, const char* file, int line)
+{
+	if ( !ok ) {
+		std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", file, line, expression);
+		failures++;
+	}
+	return ok;
+}
+
+inline bool
+checkNear(double value, double expected, double tolerance, const char* expression, const char* file, int line)
+{
+	if ( !(std::fabs(value - expected) <= tolerance) ) {
+		std::fprintf(stderr, "%s:%d: CHECK_NEAR failed: %s is %.17g, expected %.17g +- %g\n", file, line, expression, value, expected, tolerance);
+		failures++;
+		return false;
+	}
+	return true;
+}
+
+inline int
+finish()
+{
+	if ( failures != 0 ) {
+		std::fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	return 0;
+}
+
+} // namespace nmea::test
+
+#define CHECK(expression)                        nmea::test::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+#define CHECK_NEAR(value, expected, tolerance)   nmea::test::checkNear((value), (expected), (tolerance), #value, __FILE__, __LINE__)
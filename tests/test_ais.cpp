@@ -0,0 +1,156 @@
+/*
+ * test_ais.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// Published AIVDM sentences and what they decode to, then the ways messages
+// of several sentences go wrong.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "nmeaparse/AISDecoder.hpp"
+
+using namespace std;
+using namespace nmea;
+
+namespace {
+
+struct Seen {
+	vector<AISPosition> positions;
+	vector<AISVoyage>   voyages;
+};
+
+void
+position(void* context, const AISPosition& report)
+{
+	static_cast<Seen*>(context)->positions.push_back(report);
+}
+
+void
+voyage(void* context, const AISVoyage& report)
+{
+	static_cast<Seen*>(context)->voyages.push_back(report);
+}
+
+// "!" + body + its checksum
+string
+sentence(const string& body)
+{
+	uint8_t checksum = 0;
+	for ( char chr: body ) {
+		checksum ^= static_cast<uint8_t>(chr);
+	}
+	char hex[4];
+	snprintf(hex, sizeof(hex), "*%02X", checksum);
+	return "!" + body + hex;
+}
+
+// Type 5, two sentences: EVER DIADEM bound for New York
+const string VoyagePart1 = "55?MbV02;H;s<HtKR20EHE:0@T4@Dn2222222216L961O5Gf0NSQEp6ClRp8";
+const string VoyagePart2 = "88888888880";
+
+string
+voyageSentence(int number, int sequence, char channel)
+{
+	return sentence("AIVDM,2," + to_string(number) + "," + to_string(sequence) + "," + channel + "," + (number == 1 ? VoyagePart1 + ",0" : VoyagePart2 + ",2"));
+}
+
+bool
+isEverDiadem(const AISVoyage& v)
+{
+	return v.type_ == 5 && v.mmsi_ == 351759000 && v.version_ == 0 && v.imo_ == 9134270 && strcmp(v.callsign_, "3FOF8") == 0
+	       && strcmp(v.name_, "EVER DIADEM") == 0 && v.shipType_ == 70 && v.toBow_ == 225 && v.toStern_ == 70 && v.toPort_ == 1
+	       && v.toStarboard_ == 31 && v.epfd_ == 1 && v.etaMonth_ == 5 && v.etaDay_ == 15 && v.etaHour_ == 14 && v.etaMinute_ == 0
+	       && v.draught_ == 12.2 && strcmp(v.destination_, "NEW YORK") == 0;
+}
+
+} // namespace
+
+int
+main()
+{
+	Seen       seen;
+	AISDecoder ais;
+	ais.setPositionHandler(&position, &seen);
+	ais.setVoyageHandler(&voyage, &seen);
+
+	// type 1, class A position report
+	CHECK(ais.readSentence("!AIVDM,1,1,,A,13HOI:0P0000VOHLCnHQKwvL05Ip,0*23\r\n") == ParseStatus::Ok);
+	if ( CHECK(seen.positions.size() == 1) ) {
+		const AISPosition& p = seen.positions[0];
+		CHECK(p.type_ == 1 && p.repeat_ == 0 && p.mmsi_ == 227006760 && p.channel_ == 'A' && !p.own_);
+		CHECK(p.status_ == 0 && p.turn_ == -128 && !p.accurate_ && !p.raim_);
+		CHECK(p.speed_ == 0.0);
+		CHECK_NEAR(p.longitude_, 0.13138, 1e-9);
+		CHECK_NEAR(p.latitude_, 49.475577, 1e-6);
+		CHECK_NEAR(p.course_, 36.7, 1e-9);
+		CHECK(p.heading_ == 511 && p.second_ == 14);
+	}
+
+	// type 18, class B position report, west of Greenwich
+	CHECK(ais.readSentence("!AIVDM,1,1,,A,B52K>;h00Fc>jpUlNV@ikwpUoP06,0*4C") == ParseStatus::Ok);
+	if ( CHECK(seen.positions.size() == 2) ) {
+		const AISPosition& p = seen.positions[1];
+		CHECK(p.type_ == 18 && p.mmsi_ == 338087471 && p.status_ == 15 && p.turn_ == -128);
+		CHECK_NEAR(p.speed_, 0.1, 1e-9);
+		CHECK_NEAR(p.longitude_, -74.072132, 1e-6);
+		CHECK_NEAR(p.latitude_, 40.68454, 1e-9);
+		CHECK_NEAR(p.course_, 79.6, 1e-9);
+		CHECK(p.heading_ == 511 && p.second_ == 49 && p.raim_);
+	}
+
+	// type 5 in two sentences, the second with 2 fill bits
+	CHECK(ais.readSentence(voyageSentence(1, 1, 'A')) == ParseStatus::Pending);
+	CHECK(seen.voyages.empty());
+	CHECK(ais.readSentence(voyageSentence(2, 1, 'A')) == ParseStatus::Ok);
+	if ( CHECK(seen.voyages.size() == 1) ) {
+		CHECK(isEverDiadem(seen.voyages[0]));
+		CHECK(!seen.voyages[0].dte_);
+	}
+
+	// two messages at once, by sequential message id and by channel
+	seen.voyages.clear();
+	CHECK(ais.readSentence(voyageSentence(1, 3, 'A')) == ParseStatus::Pending);
+	CHECK(ais.readSentence(voyageSentence(1, 4, 'A')) == ParseStatus::Pending);
+	CHECK(ais.readSentence(voyageSentence(1, 3, 'B')) == ParseStatus::Pending);
+	CHECK(ais.readSentence(voyageSentence(2, 4, 'A')) == ParseStatus::Ok);
+	CHECK(ais.readSentence(voyageSentence(2, 3, 'B')) == ParseStatus::Ok);
+	CHECK(ais.readSentence(voyageSentence(2, 3, 'A')) == ParseStatus::Ok);
+	if ( CHECK(seen.voyages.size() == 3) ) {
+		CHECK(isEverDiadem(seen.voyages[0]) && isEverDiadem(seen.voyages[1]) && isEverDiadem(seen.voyages[2]));
+		CHECK(seen.voyages[1].channel_ == 'B');
+	}
+	CHECK(ais.dropped() == 0);
+
+	// a second sentence without its first
+	seen.voyages.clear();
+	CHECK(ais.readSentence(voyageSentence(2, 7, 'A')) == ParseStatus::MissingFragment);
+	CHECK(ais.readSentence(voyageSentence(2, 1, 'A')) == ParseStatus::MissingFragment); // finished above already
+	CHECK(seen.voyages.empty());
+
+	// fill bits: 426 bits less 4 end right before DTE, which then isn't sent;
+	// less 5 the destination is one bit short
+	const string whole = VoyagePart1 + VoyagePart2;
+	CHECK(ais.readPayload(whole.substr(0, 71), 4) == ParseStatus::Ok);
+	if ( CHECK(seen.voyages.size() == 1) ) {
+		CHECK(isEverDiadem(seen.voyages[0]));
+		CHECK(seen.voyages[0].dte_);
+	}
+	CHECK(ais.readPayload(whole.substr(0, 71), 5) == ParseStatus::MissingFields);
+	CHECK(ais.readPayload(whole, 6) == ParseStatus::MissingFields);
+
+	// truncated payloads are rejected, not decoded from zeros
+	const uint32_t messages = ais.messages();
+	CHECK(ais.readSentence(sentence("AIVDM,1,1,,A,13HOI:0P0000VOHLCnHQ,0")) == ParseStatus::MissingFields);
+	CHECK(ais.readPayload("13HOI:", 0) == ParseStatus::MissingFields);
+	CHECK(ais.readPayload("13HOI:0P0000VOHLCnHQKwvL05I~", 0) == ParseStatus::BadCharacter);
+	CHECK(ais.messages() == messages);
+	CHECK(seen.positions.size() == 2);
+
+	return nmea::test::finish();
+}
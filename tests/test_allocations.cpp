@@ -0,0 +1,136 @@
+/*
+ * test_allocations.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// Good sentences cost no heap allocation once the parser and the service
+// have seen one of each: the parser's sentences and the almanac are reused.
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "nmeaparse/nmea.hpp"
+
+using namespace std;
+using namespace nmea;
+
+static atomic<uint64_t> allocations{ 0 };
+
+void*
+operator new(size_t size)
+{
+	allocations.fetch_add(1, memory_order_relaxed);
+	if ( void* ptr = malloc(size == 0 ? 1 : size) ) {
+		return ptr;
+	}
+	throw bad_alloc();
+}
+
+void*
+operator new(size_t size, align_val_t alignment)
+{
+	allocations.fetch_add(1, memory_order_relaxed);
+	auto align = static_cast<size_t>(alignment);
+	if ( void* ptr = aligned_alloc(align, (size + align - 1) / align * align) ) {
+		return ptr;
+	}
+	throw bad_alloc();
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t /*size*/) noexcept
+{
+	free(ptr);
+}
+
+void
+operator delete(void* ptr, align_val_t /*alignment*/) noexcept
+{
+	free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t /*size*/, align_val_t /*alignment*/) noexcept
+{
+	free(ptr);
+}
+
+// The lines of the corpus that parse and read, the bad ones throw and allocate their message
+static vector<string>
+goodCorpusLines()
+{
+	vector<string> lines;
+	NMEAParser     parser;
+	GPSService     gps(parser);
+	ifstream       file(NEMATODE_TEST_CORPUS);
+	for ( string line; getline(file, line); ) {
+		try {
+			parser.readLine(line);
+			lines.push_back(line);
+		}
+		catch ( exception& ) {
+		}
+	}
+	return lines;
+}
+
+static vector<string>
+syntheticLines()
+{
+	NMEAGeneratorSettings settings;
+	settings.rate = 10.0;
+	NMEAGenerator  generator(settings);
+	vector<string> lines;
+	char           buf[NMEAGenerator::MaxEpochSize];
+	for ( int e = 0; e < 100; e++ ) {
+		string epoch(buf, generator.nextEpoch(buf, sizeof(buf)));
+		for ( size_t start = 0, end; (end = epoch.find('\n', start)) != string::npos; start = end + 1 ) {
+			lines.push_back(epoch.substr(start, end - start - 1)); // without the "\r\n"
+		}
+	}
+	return lines;
+}
+
+static uint64_t
+allocationsAfterWarmUp(const vector<string>& lines)
+{
+	NMEAParser parser;
+	GPSService gps(parser);
+	for ( const auto& line: lines ) {
+		parser.readLine(line);
+	}
+
+	uint64_t before = allocations.load();
+	for ( int pass = 0; pass < 3; pass++ ) {
+		for ( const auto& line: lines ) {
+			parser.readLine(line);
+		}
+	}
+	return allocations.load() - before;
+}
+
+int
+main()
+{
+	vector<string> corpus    = goodCorpusLines();
+	vector<string> synthetic = syntheticLines();
+	CHECK(corpus.size() > 10);
+	CHECK(synthetic.size() > 500);
+
+	CHECK(allocationsAfterWarmUp(corpus) == 0);
+	CHECK(allocationsAfterWarmUp(synthetic) == 0);
+
+	return nmea::test::finish();
+}
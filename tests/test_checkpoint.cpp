@@ -0,0 +1,175 @@
+/*
+ * test_checkpoint.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// A snapshot read back gives the same fix and the same partial sentence: both
+// services go on to the same fix from the rest of the stream. Damaged and cut
+// short snapshots are rejected.
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "check.hpp"
+#include "nmeaparse/nmea.hpp"
+
+using namespace std;
+using namespace nmea;
+
+namespace {
+
+string
+sentence(const string& body)
+{
+	char checksum[8];
+	snprintf(checksum, sizeof(checksum), "*%02X\r\n", NMEAParser::calculateChecksum(body));
+	return "$" + body + checksum;
+}
+
+void
+feed(NMEAParser& parser, const string& text)
+{
+	string bytes = text;
+	parser.readBuffer(reinterpret_cast<uint8_t*>(bytes.data()), static_cast<uint32_t>(bytes.size()));
+}
+
+bool
+sameFix(const GPSFix& a, const GPSFix& b)
+{
+	bool same = a.locked() == b.locked() && a.status_ == b.status_ && a.type_ == b.type_ && a.quality_ == b.quality_
+	            && a.dilution_ == b.dilution_ && a.altitude_ == b.altitude_ && a.latitude_ == b.latitude_
+	            && a.longitude_ == b.longitude_ && a.speed_ == b.speed_ && a.travelAngle_ == b.travelAngle_
+	            && a.trackingSatellites_ == b.trackingSatellites_ && a.visibleSatellites_ == b.visibleSatellites_
+	            && a.timestamp_.rawTime_ == b.timestamp_.rawTime_ && a.timestamp_.rawDate_ == b.timestamp_.rawDate_
+	            && a.almanac_.satellites_.size() == b.almanac_.satellites_.size()
+	            && a.almanac_.percentComplete() == b.almanac_.percentComplete();
+	for ( size_t i = 0; same && i < a.almanac_.satellites_.size(); i++ ) {
+		const GPSSatellite& sa = a.almanac_.satellites_[i];
+		const GPSSatellite& sb = b.almanac_.satellites_[i];
+		same = sa.prn_ == sb.prn_ && sa.elevation_ == sb.elevation_ && sa.azimuth_ == sb.azimuth_ && sa.snr_ == sb.snr_;
+	}
+	return same;
+}
+
+bool
+rejected(const string& snapshot)
+{
+	try {
+		istringstream    in(snapshot);
+		CheckpointReader checkpoint(in);
+		NMEAParser       parser;
+		GPSService       gps(parser);
+		while ( checkpoint.next() ) {
+			checkpoint.restore(gps, &parser);
+		}
+	}
+	catch ( const CheckpointError& ) {
+		return true;
+	}
+	return false;
+}
+
+string
+snapshotOf(const GPSService& gps, const NMEAParser& parser)
+{
+	ostringstream    out;
+	CheckpointWriter checkpoint(out);
+	checkpoint.add(1, gps, &parser);
+	checkpoint.finish();
+	return out.str();
+}
+
+// The header has 8 magic bytes, then the version
+string
+withVersion(string snapshot, uint8_t version)
+{
+	snapshot[8] = static_cast<char>(version);
+	return snapshot;
+}
+
+} // namespace
+
+int
+main()
+{
+	const string gga = sentence("GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,");
+	const string rmc = sentence("GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A");
+	const string gsv = sentence("GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30");
+	const string gsv2 = sentence("GPGSV,3,2,11,02,39,223,19,13,28,070,17,26,23,252,,04,14,186,14");
+	const string gsv3 = sentence("GPGSV,3,3,11,29,09,301,24,16,09,020,,36,,,");
+
+	// a fix, the first GSV page of three and half of the second
+	NMEAParser parser;
+	GPSService gps(parser);
+	feed(parser, gga + rmc + gsv + gsv2.substr(0, 30));
+	CHECK(gps.fix_.locked());
+
+	ostringstream out;
+	{
+		CheckpointWriter checkpoint(out);
+		checkpoint.add(7, gps, &parser, 1234);
+		checkpoint.finish();
+	}
+	const string snapshot = out.str();
+
+	NMEAParser restoredParser;
+	GPSService restored(restoredParser);
+	{
+		istringstream    in(snapshot);
+		CheckpointReader checkpoint(in);
+		CHECK(checkpoint.next());
+		CHECK(checkpoint.stream() == 7);
+		CHECK(checkpoint.offset() == 1234);
+		checkpoint.restore(restored, &restoredParser);
+		CHECK(!checkpoint.next());
+	}
+	CHECK(sameFix(restored.fix_, gps.fix_));
+
+	// the rest of the stream, starting in the middle of a sentence
+	const string rest = gsv2.substr(30) + gsv3;
+	feed(parser, rest);
+	feed(restoredParser, rest);
+	CHECK(gps.fix_.almanac_.satellites_.size() == 11);
+	CHECK(sameFix(restored.fix_, gps.fix_));
+
+	// damaged, cut short and without its end
+	string damaged = snapshot;
+	damaged[40] ^= 0x01;
+	CHECK(rejected(damaged));
+	CHECK(rejected(snapshot.substr(0, snapshot.size() / 2)));
+	CHECK(rejected(snapshot.substr(0, snapshot.size() - 4)));
+	CHECK(rejected("NMEACKPT"));
+	CHECK(!rejected(snapshot));
+
+	// a parser skipping a sentence it isn't interested in goes on skipping it
+	NMEAParser skipping;
+	GPSService skippingGPS(skipping);
+	skipping.setInterest({ "GPGGA" });
+	feed(skipping, gsv.substr(0, 20));
+	const string skipped = snapshotOf(skippingGPS, skipping);
+
+	NMEAParser resumed;
+	GPSService resumedGPS(resumed);
+	resumed.setInterest({ "GPGGA" });
+	int sentences = 0;
+	resumed.onSentence_ += [&sentences](const NMEASentence&) { sentences++; };
+	{
+		istringstream    in(skipped);
+		CheckpointReader checkpoint(in);
+		CHECK(checkpoint.next());
+		checkpoint.restore(resumedGPS, &resumed);
+	}
+	feed(resumed, gsv.substr(20) + gga);
+	CHECK(sentences == 1);
+	CHECK(resumedGPS.fix_.timestamp_.rawTime_ == 92750);
+
+	// version 1 snapshots are still read, but never had a parser skipping a sentence
+	CHECK(!rejected(withVersion(snapshot, 1)));
+	CHECK(rejected(withVersion(skipped, 1)));
+	CHECK(rejected(withVersion(snapshot, CheckpointWriter::Version + 1)));
+	CHECK(rejected(withVersion(snapshot, 0)));
+
+	return nmea::test::finish();
+}
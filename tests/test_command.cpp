@@ -0,0 +1,130 @@
+/*
+ * test_command.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// NMEACommand::encode() against the stringstream code it replaced, toString()
+// keeping the members it always set, and batches that run out of room.
+
+#include <array>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "check.hpp"
+#include "nmeaparse/NMEACommand.hpp"
+
+using namespace std;
+using namespace nmea;
+
+namespace {
+
+// The sentences as the stringstream code wrote them
+string
+oldSentence(const string& name, const string& fields)
+{
+	string       body = name + "," + fields;
+	stringstream ss;
+	ss << "$" << body << "*" << hex << uppercase << internal << setfill('0') << setw(2) << static_cast<int>(NMEAParser::calculateChecksum(body)) << "\r\n";
+	return ss.str();
+}
+
+string
+oldQueryRate(int messageID, int mode, int rate, int checksumEnable)
+{
+	stringstream ss;
+	ss << setfill('0') << setw(2) << messageID << "," << setfill('0') << setw(2) << mode << "," << setfill('0') << setw(2) << rate << ","
+	   << setfill('0') << setw(2) << checksumEnable;
+	return oldSentence("PSRF103", ss.str());
+}
+
+string
+oldSerial(int baud, int databits, int stopbits, int parity)
+{
+	stringstream ss;
+	ss << "1," << baud << "," << databits << "," << stopbits << "," << parity;
+	return oldSentence("PSRF100", ss.str());
+}
+
+string
+encoded(const NMEACommand& command)
+{
+	array<char, NMEACommand::MaxSize> out;
+	return string(out.data(), command.encode(out));
+}
+
+} // namespace
+
+int
+main()
+{
+	// the example of the SiRF manual
+	NMEACommandQueryRate rate;
+	rate.messageID_ = NMEASentence::GGA;
+	rate.mode_      = NMEACommandQueryRate::QUERY;
+	CHECK(encoded(rate) == "$PSRF103,00,01,00,01*25\r\n");
+
+	// the same bytes as before, for every message and a range of rates
+	for ( int id = NMEASentence::GGA; id <= NMEASentence::VTG; id++ ) {
+		for ( int r: { 0, 1, 9, 10, 99, 100, 255 } ) {
+			rate.messageID_ = static_cast<NMEASentence::MessageID>(id);
+			rate.mode_      = NMEACommandQueryRate::SETRATE;
+			rate.rate_      = r;
+			CHECK(encoded(rate) == oldQueryRate(id, 0, r, 1));
+		}
+	}
+
+	NMEACommandSerialConfiguration serial;
+	CHECK(encoded(serial) == oldSerial(4800, 8, 1, 0));
+	serial.baud_   = 115200;
+	serial.parity_ = 2;
+	CHECK(encoded(serial) == oldSerial(115200, 8, 1, 2));
+
+	// negative fields, the sign counted in the width
+	serial.stopbits_ = -1;
+	CHECK(encoded(serial) == oldSerial(115200, 8, -1, 2));
+	rate.messageID_ = NMEASentence::Unknown;
+	for ( int r: { -1, -9, -12, -255 } ) {
+		rate.rate_ = r;
+		CHECK(encoded(rate) == oldQueryRate(-1, 0, r, 1));
+	}
+	CHECK(encoded(rate).find("$PSRF103,-1,00,-255,01*") == 0);
+
+	// toString() gives the same, and leaves the fields and the checksum in the members
+	rate.messageID_ = NMEASentence::GGA;
+	rate.mode_      = NMEACommandQueryRate::QUERY;
+	rate.rate_      = 0;
+	rate.message_   = "stale";
+	string sentence = rate.toString();
+	CHECK(sentence == "$PSRF103,00,01,00,01*25\r\n");
+	CHECK(rate.message_ == "00,01,00,01");
+	CHECK(rate.checksum_ == 0x25);
+
+	NMEACommand plain("PTEST");
+	plain.message_ = "a,b";
+	CHECK(plain.toString() == oldSentence("PTEST", "a,b"));
+	CHECK(plain.message_ == "a,b");
+	CHECK(static_cast<uint8_t>(plain.checksum_) == NMEAParser::calculateChecksum("PTEST,a,b"));
+	CHECK(plain.addChecksum("x") == oldSentence("PTEST", "x"));
+
+	// longer than a standard sentence, toString() grows to fit, encode() doesn't
+	plain.message_ = string(100, '1');
+	CHECK(plain.toString() == oldSentence("PTEST", string(100, '1')));
+	CHECK(encoded(plain).empty());
+
+	// a full batch takes nothing of a command that doesn't fit
+	array<char, 60>  buffer;
+	NMEACommandBatch batch(buffer);
+	CHECK(batch.add(rate) && batch.add(rate));
+	CHECK(batch.count() == 2 && batch.size() == 2 * sentence.size());
+	CHECK(!batch.add(rate));
+	CHECK(!batch.add(serial));
+	CHECK(batch.count() == 2 && batch.size() == 2 * sentence.size());
+	CHECK(string(batch.data(), batch.size()) == sentence + sentence);
+	batch.clear();
+	CHECK(batch.add(serial) && batch.size() == encoded(serial).size());
+	CHECK(string(batch.data(), batch.size()) == encoded(serial));
+
+	return nmea::test::finish();
+}
@@ -0,0 +1,108 @@
+/*
+ * test_demultiplexer.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "nmeaparse/NMEAParser.hpp"
+#include "nmeaparse/StreamDemultiplexer.hpp"
+
+using namespace std;
+using namespace nmea;
+
+namespace {
+
+const string GGA = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n";
+
+void
+append(vector<uint8_t>& out, const string& text)
+{
+	out.insert(out.end(), text.begin(), text.end());
+}
+
+// UBX frame with a good checksum
+void
+appendUBX(vector<uint8_t>& out, uint8_t cls, uint8_t id, const vector<uint8_t>& payload)
+{
+	size_t start = out.size();
+	out.insert(out.end(), { 0xB5, 0x62, cls, id, static_cast<uint8_t>(payload.size()), static_cast<uint8_t>(payload.size() >> 8) });
+	out.insert(out.end(), payload.begin(), payload.end());
+	uint16_t checksum = StreamDemultiplexer::ubxChecksum(out.data() + start + 2, out.size() - start - 2);
+	out.push_back(static_cast<uint8_t>(checksum));
+	out.push_back(static_cast<uint8_t>(checksum >> 8));
+}
+
+struct Counts {
+	int      sentences;
+	uint64_t ubx;
+	uint64_t checksumErrors;
+};
+
+// The stream in pieces of chunk bytes, 0 for one byte at a time through readByte()
+Counts
+feed(const vector<uint8_t>& stream, size_t chunk)
+{
+	NMEAParser          parser;
+	StreamDemultiplexer demux(&parser);
+	int                 sentences = 0;
+	parser.setSentenceHandler("GPGGA", [&](const NMEASentence& nmea) { sentences += nmea.checksumOK() ? 1 : 0; });
+
+	if ( chunk == 0 ) {
+		for ( uint8_t byte : stream ) {
+			demux.readByte(byte);
+		}
+	}
+	else {
+		for ( size_t i = 0; i < stream.size(); i += chunk ) {
+			demux.readBuffer(stream.data() + i, min(chunk, stream.size() - i));
+		}
+	}
+	return Counts{ sentences, demux.frames(FrameProtocol::UBX), demux.checksumErrors() };
+}
+
+} // namespace
+
+int
+main()
+{
+	const size_t chunks[] = { 0, 1, 7, 64, 4096 };
+
+	// a stray RTCM3 sync and header claiming 70 bytes, then a sentence inside them
+	vector<uint8_t> stray = { 0xD3, 0x00, 0x40 };
+	append(stray, GGA);
+	append(stray, GGA);
+	for ( size_t chunk : chunks ) {
+		Counts counts = feed(stray, chunk);
+		CHECK(counts.sentences == 2);
+		CHECK(counts.checksumErrors == 1);
+	}
+
+	// a UBX header claiming 32 bytes, with a good frame and the start of a
+	// sentence in them
+	vector<uint8_t> nested = { 0xB5, 0x62, 0x01, 0x07, 0x20, 0x00 };
+	appendUBX(nested, 0x01, 0x02, { 1, 2, 3, 4 });
+	append(nested, GGA);
+	for ( size_t chunk : chunks ) {
+		Counts counts = feed(nested, chunk);
+		CHECK(counts.ubx == 1);
+		CHECK(counts.sentences == 1);
+		CHECK(counts.checksumErrors == 1);
+	}
+
+	// a false second sync byte, the byte after it starts the frame
+	vector<uint8_t> resync = { 0xB5, 0xB5 };
+	appendUBX(resync, 0x01, 0x02, { 5, 6, 7, 8 });
+	for ( size_t chunk : chunks ) {
+		Counts counts = feed(resync, chunk);
+		CHECK(counts.ubx == 1);
+		CHECK(counts.checksumErrors == 0);
+	}
+
+	return nmea::test::finish();
+}
@@ -0,0 +1,76 @@
+/*
+ * test_fix_encoder.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include <string>
+
+#include "check.hpp"
+#include "nmeaparse/GPSFixEncoder.hpp"
+#include "nmeaparse/GPSService.hpp"
+
+using namespace std;
+using namespace nmea;
+
+static size_t
+count(const string& text, const string& what)
+{
+	size_t found = 0;
+	for ( size_t pos = text.find(what); pos != string::npos; pos = text.find(what, pos + 1) ) {
+		found++;
+	}
+	return found;
+}
+
+int
+main()
+{
+	GPSFix fix;
+	fix.status_             = 'A';
+	fix.type_               = 3;
+	fix.quality_            = 1;
+	fix.latitude_           = 53.361336;
+	fix.longitude_          = -6.505620;
+	fix.altitude_           = 61.7;
+	fix.speed_              = 50.0;
+	fix.travelAngle_        = 31.66;
+	fix.trackingSatellites_ = 12;
+	fix.horizontalDilution_ = 0.9;
+	fix.timestamp_.setTime(92750.0);
+	fix.timestamp_.setDate(280511);
+
+	GPSFixEncoder encoder;
+	char          buf[4096];
+
+	// all of them fit in 8 pages
+	for ( uint32_t prn = 1; prn <= 32; prn++ ) {
+		fix.almanac_.satellites_.push_back(GPSSatellite{ 30.0, prn, 45.0, 180.0 });
+	}
+	fix.visibleSatellites_ = 32;
+	string text(buf, encoder.encode(fix, buf, sizeof(buf)));
+	CHECK(count(text, "$GPGSV,8,") == 8);
+	CHECK(GPSFixEncoder::gsvDropped(fix) == 0);
+	CHECK(encoder.truncatedFixes() == 0);
+
+	// what it writes reads back to the same sentences
+	NMEAParser parser;
+	GPSService gps(parser);
+	parser.readBuffer(reinterpret_cast<uint8_t*>(buf), static_cast<uint32_t>(text.size()));
+	CHECK(string(buf, encoder.encode(gps.fix_, buf, sizeof(buf))) == text);
+
+	// 40 satellites: 9 pages of 4, the last 4 are left out and counted
+	for ( uint32_t prn = 33; prn <= 40; prn++ ) {
+		fix.almanac_.satellites_.push_back(GPSSatellite{ 30.0, prn, 45.0, 180.0 });
+	}
+	fix.visibleSatellites_ = 40;
+	text = string(buf, encoder.encode(fix, buf, sizeof(buf)));
+	CHECK(count(text, "$GPGSV,9,") == 9);
+	CHECK(text.find(",36,45,180,30") != string::npos);
+	CHECK(text.find(",37,45,180,30") == string::npos);
+	CHECK(GPSFixEncoder::gsvDropped(fix) == 4);
+	CHECK(encoder.truncatedFixes() == 1);
+	CHECK(encoder.encodeGSV(fix, 10, buf, sizeof(buf)) == 0);
+
+	return nmea::test::finish();
+}
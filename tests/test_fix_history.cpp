@@ -0,0 +1,70 @@
+/*
+ * test_fix_history.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include <cstdio>
+#include <string>
+
+#include "check.hpp"
+#include "nmeaparse/GPSService.hpp"
+
+using namespace std;
+using namespace nmea;
+
+static void
+read(NMEAParser& parser, const string& body)
+{
+	char checksum[4];
+	snprintf(checksum, sizeof(checksum), "*%02X", NMEAParser::calculateChecksum(body));
+	parser.readSentence("$" + body + checksum);
+}
+
+static void
+gga(NMEAParser& parser, const char* time)
+{
+	read(parser, string("GPGGA,") + time + ",5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,");
+}
+
+static void
+rmc(NMEAParser& parser, const char* time, const char* date)
+{
+	read(parser, string("GPRMC,") + time + ",A,5321.6802,N,00630.3372,W,0.02,31.66," + date + ",,,A");
+}
+
+int
+main()
+{
+	NMEAParser parser;
+	GPSService gps(parser);
+	gps.enableHistory(16);
+	const FixHistory& history = *gps.history();
+
+	// no date before the first RMC, nothing to record
+	gga(parser, "235957.000");
+	CHECK(history.empty());
+
+	// over midnight, GGA comes first with the date of the day before
+	rmc(parser, "235958.000", "280511");
+	gga(parser, "235958.000");
+	rmc(parser, "235959.000", "280511");
+	gga(parser, "235959.000");
+	gga(parser, "000000.000");
+	rmc(parser, "000000.000", "290511");
+	gga(parser, "000001.000");
+	rmc(parser, "000001.000", "290511");
+
+	CHECK(history.size() == 4);
+	for ( size_t i = 1; i < history.size(); i++ ) {
+		CHECK(history[i].time_ - history[i - 1].time_ == chrono::seconds(1));
+	}
+	CHECK(history.front().time_ == UTCTime(chrono::milliseconds(1306627198000))); // May 28, 2011 23:59:58
+	CHECK(history.back().time_ == UTCTime(chrono::milliseconds(1306627201000)));  // May 29, 2011 00:00:01
+
+	// a receiver whose clock really goes back, with the date, still starts over
+	rmc(parser, "120000.000", "280511");
+	CHECK(history.size() == 1);
+
+	return nmea::test::finish();
+}
@@ -0,0 +1,59 @@
+/*
+ * test_generator.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "check.hpp"
+#include "nmeaparse/NMEAGenerator.hpp"
+#include "nmeaparse/SentenceWriter.hpp"
+
+using namespace std;
+using namespace nmea;
+
+static string
+written(void (*write)(SentenceWriter&))
+{
+	char           buf[128];
+	SentenceWriter writer(buf, sizeof(buf));
+	write(writer);
+	return string(buf, writer.size());
+}
+
+int
+main()
+{
+	// fields
+	CHECK(written([](SentenceWriter& w) { w.field(numeric_limits<int64_t>::min()); }) == ",-9223372036854775808");
+	CHECK(written([](SentenceWriter& w) { w.field(int64_t{ -42 }, 4); }) == ",-042");
+	CHECK(written([](SentenceWriter& w) { w.field(-0.0004, 3); }) == ",0.000");
+	CHECK(written([](SentenceWriter& w) { w.field(-0.0, 1); }) == ",0.0");
+	CHECK(written([](SentenceWriter& w) { w.field(-0.0006, 3); }) == ",-0.001");
+	CHECK(written([](SentenceWriter& w) { w.field(-12.345, 2, 3); }) == ",-012.35");
+
+	// Every sentence damaged, epochs that don't fit are tried again: each
+	// damaged sentence in the output is counted once.
+	NMEAGeneratorSettings settings;
+	settings.corruptionRate = 1.0;
+	NMEAGenerator generator(settings);
+	char          buf[NMEAGenerator::MaxEpochSize];
+	uint64_t      sentences = 0;
+	for ( int epoch = 0; epoch < 50; epoch++ ) {
+		CHECK(generator.nextEpoch(buf, 100) == 0); // too small, retried below
+		size_t size = generator.nextEpoch(buf, sizeof(buf));
+		CHECK(size != 0);
+		for ( size_t i = 0; i < size; i++ ) {
+			sentences += buf[i] == '\n' ? 1 : 0;
+		}
+	}
+	uint64_t counted = generator.corruptions(NMEAGenerator::FlippedBit) + generator.corruptions(NMEAGenerator::BadChecksum)
+	                 + generator.corruptions(NMEAGenerator::Truncated);
+	CHECK(sentences > 0);
+	CHECK(counted == sentences);
+
+	return nmea::test::finish();
+}
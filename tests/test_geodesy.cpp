@@ -0,0 +1,106 @@
+/*
+ * test_geodesy.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// The batch kernels (AVX2 where the CPU has it) against the scalar reference,
+// over points anywhere on earth, with the tolerances the header promises.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "nmeaparse/Geodesy.hpp"
+
+using namespace std;
+using namespace nmea;
+
+int
+main()
+{
+	const size_t Size = 1027; // not a multiple of 4, the tails are checked too
+
+	mt19937                           random(11);
+	uniform_real_distribution<double> anyLat(-89.9, 89.9);
+	uniform_real_distribution<double> anyLon(-180, 180);
+	uniform_real_distribution<double> anyAlt(-500, 10000);
+	CoordinateArrays                  world;
+	world.reserve(Size);
+	for ( size_t i = 0; i < Size; i++ ) {
+		world.append(anyLat(random), anyLon(random), anyAlt(random));
+	}
+	const double* lat = world.latitude_.data();
+	const double* lon = world.longitude_.data();
+	const double* alt = world.altitude_.data();
+
+	printf("batch kernels: %s\n", geodesyUsesAVX2() ? "AVX2" : "scalar");
+
+	vector<double> out(Size);
+	vector<double> x(Size);
+	vector<double> y(Size);
+	vector<double> z(Size);
+
+	// haversine, relative
+	double distanceError = 0;
+	double total         = 0;
+	haversineSegments(lat, lon, Size, out.data());
+	for ( size_t i = 0; i + 1 < Size; i++ ) {
+		double reference = haversineDistance(lat[i], lon[i], lat[i + 1], lon[i + 1]);
+		distanceError    = max(distanceError, fabs(out[i] - reference) / max(reference, 1.0));
+		total += reference;
+	}
+	CHECK(distanceError < 1e-12);
+	CHECK_NEAR(odometer(world), total, total * 1e-12);
+
+	// bearing, degrees around the circle
+	double bearingError = 0;
+	bearingSegments(lat, lon, Size, out.data());
+	for ( size_t i = 0; i + 1 < Size; i++ ) {
+		double difference = fabs(out[i] - initialBearing(lat[i], lon[i], lat[i + 1], lon[i + 1]));
+		bearingError      = max(bearingError, min(difference, 360 - difference));
+	}
+	CHECK(bearingError < 1e-9);
+
+	// ECEF and ENU, meters
+	double ecefError = 0;
+	toECEF(lat, lon, alt, Size, x.data(), y.data(), z.data());
+	for ( size_t i = 0; i < Size; i++ ) {
+		ECEF point = toECEF(lat[i], lon[i], alt[i]);
+		ecefError  = max({ ecefError, fabs(x[i] - point.x), fabs(y[i] - point.y), fabs(z[i] - point.z) });
+	}
+	CHECK(ecefError < 1e-6);
+
+	double     enuError = 0;
+	LocalFrame frame(lat[0], lon[0], alt[0]);
+	frame.toENU(world, x.data(), y.data(), z.data());
+	for ( size_t i = 0; i < Size; i++ ) {
+		ENU local = frame.toENU(lat[i], lon[i], alt[i]);
+		enuError  = max({ enuError, fabs(x[i] - local.east), fabs(y[i] - local.north), fabs(z[i] - local.up) });
+	}
+	CHECK(enuError < 1e-6);
+
+	// geohash, exact at every precision
+	vector<uint64_t> hashes(Size);
+	size_t           hashMismatch = 0;
+	for ( int precision = 1; precision <= 12; precision++ ) {
+		geohashBits(lat, lon, Size, precision, hashes.data());
+		for ( size_t i = 0; i < Size; i++ ) {
+			hashMismatch += hashes[i] != geohashBits(lat[i], lon[i], precision) ? 1 : 0;
+		}
+	}
+	CHECK(hashMismatch == 0);
+
+	// and the scalar reference against known values
+	char text[12];
+	CHECK(geohash(57.64911, 10.40744, 11, text) == 11 && string(text, 11) == "u4pruydqqvj");
+	CHECK_NEAR(haversineDistance(0, 0, 0, 1), EarthMeanRadius * M_PI / 180, 1e-6); // a degree of the equator
+	CHECK_NEAR(initialBearing(0, 0, 1, 0), 0, 1e-12);
+	CHECK_NEAR(initialBearing(0, 0, 0, 1), 90, 1e-12);
+
+	printf("haversine %.1e relative, bearing %.1e deg, ECEF %.1e m, ENU %.1e m\n", distanceError, bearingError, ecefError, enuError);
+	return nmea::test::finish();
+}
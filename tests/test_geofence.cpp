@@ -0,0 +1,135 @@
+/*
+ * test_geofence.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// Enter and exit events of a concave fence, the cells that need no point
+// test, and the fences added or dropped while vehicles are placed.
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "nmeaparse/Geofence.hpp"
+
+using namespace std;
+using namespace nmea;
+
+namespace {
+
+// "+vehicle:fence" or "-vehicle:fence" for every event, in order
+struct Events {
+	vector<string> seen;
+
+	void attach(GeofenceEngine& fences)
+	{
+		fences.onEnter += [this](uint32_t vehicle, uint32_t fence) { seen.push_back("+" + to_string(vehicle) + ":" + to_string(fence)); };
+		fences.onExit += [this](uint32_t vehicle, uint32_t fence) { seen.push_back("-" + to_string(vehicle) + ":" + to_string(fence)); };
+	}
+
+	// the events since the last call
+	vector<string> take()
+	{
+		vector<string> taken;
+		taken.swap(seen);
+		return taken;
+	}
+};
+
+bool
+throwsInvalid(double cellSize, size_t points)
+{
+	try {
+		GeofenceEngine  fences(cellSize);
+		vector<GeoPoint> polygon(points, GeoPoint{ 1, 1 });
+		fences.addFence(polygon);
+	}
+	catch ( const invalid_argument& ) {
+		return true;
+	}
+	return false;
+}
+
+} // namespace
+
+int
+main()
+{
+	GeofenceEngine fences(0.01);
+	Events         events;
+	events.attach(fences);
+
+	// a U, 0.1 degrees wide, open to the north between 20.04 and 20.06 E
+	auto u = fences.addFence({ { 10.00, 20.00 },
+	                           { 10.00, 20.10 },
+	                           { 10.10, 20.10 },
+	                           { 10.10, 20.06 },
+	                           { 10.03, 20.06 },
+	                           { 10.03, 20.04 },
+	                           { 10.10, 20.04 },
+	                           { 10.10, 20.00 } });
+	CHECK(u == 0);
+	CHECK(fences.fences() == 1);
+
+	fences.update(1, 9.95, 20.05); // south of it
+	CHECK(events.take().empty());
+	fences.update(1, 10.08, 20.02); // west arm
+	CHECK((events.take() == vector<string>{ "+1:0" }));
+	fences.update(1, 10.08, 20.05); // the notch
+	CHECK((events.take() == vector<string>{ "-1:0" }));
+	CHECK(fences.fencesOf(1).empty());
+	fences.update(1, 10.015, 20.05); // the base
+	CHECK((events.take() == vector<string>{ "+1:0" }));
+	fences.update(1, 10.08, 20.08); // east arm
+	CHECK(events.take().empty());
+	CHECK((fences.fencesOf(1) == vector<uint32_t>{ u }));
+	fences.update(1, 10.20, 20.08); // north of it
+	CHECK((events.take() == vector<string>{ "-1:0" }));
+
+	// a cell wholly inside the fence needs no point test, however the vehicle moves in it
+	uint64_t tests = fences.pointTests();
+	fences.update(2, 10.015, 20.015);
+	fences.update(2, 10.016, 20.017);
+	fences.update(2, 10.0185, 20.0112);
+	CHECK((events.take() == vector<string>{ "+2:0" }));
+	CHECK(fences.pointTests() == tests);
+	CHECK(fences.contains(u, 10.0185, 20.0112));
+	CHECK(!fences.contains(u, 10.08, 20.05));
+
+	// a fence added after a vehicle was placed is seen on its next update, at the same place too
+	fences.update(3, 30.005, 40.005);
+	auto square = fences.addFence({ { 30.00, 40.00 }, { 30.00, 40.02 }, { 30.02, 40.02 }, { 30.02, 40.00 } });
+	CHECK(events.take().empty());
+	fences.update(3, 30.005, 40.005);
+	CHECK((events.take() == vector<string>{ "+3:" + to_string(square) }));
+
+	// a vehicle removed is forgotten without an exit, and starts over
+	CHECK(fences.vehicles() == 3);
+	fences.removeVehicle(3);
+	CHECK(fences.vehicles() == 2);
+	CHECK(fences.fencesOf(3).empty());
+	CHECK(events.take().empty());
+	fences.update(3, 30.005, 40.005);
+	CHECK((events.take() == vector<string>{ "+3:" + to_string(square) }));
+
+	// clear drops fences and vehicles, without exits
+	fences.clear();
+	CHECK(fences.fences() == 0 && fences.vehicles() == 0 && fences.cells() == 0);
+	CHECK(events.take().empty());
+	fences.update(2, 10.015, 20.015);
+	CHECK(events.take().empty());
+	CHECK(fences.fencesOf(2).empty());
+	CHECK(fences.addFence({ { 0, 0 }, { 0, 1 }, { 1, 1 } }) == 0); // ids start over
+
+	CHECK(throwsInvalid(0, 3));
+	CHECK(throwsInvalid(-0.01, 3));
+	CHECK(throwsInvalid(nan(""), 3));
+	CHECK(throwsInvalid(0.01, 2));
+	CHECK(throwsInvalid(0.01, 0));
+	CHECK(!throwsInvalid(0.01, 3));
+
+	return nmea::test::finish();
+}
@@ -0,0 +1,133 @@
+/*
+ * test_gps_services.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// GPSService and FixedGPSService read sentences with the same decoder, they
+// have to agree on every line: the same fix after it, and both or neither
+// rejecting it.
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "nmeaparse/nmea.hpp"
+
+using namespace std;
+using namespace nmea;
+
+static bool
+sameFix(const GPSFix& a, const GPSFix& b)
+{
+	bool same = a.locked() == b.locked() && a.status_ == b.status_ && a.type_ == b.type_ && a.quality_ == b.quality_
+	            && a.dilution_ == b.dilution_ && a.horizontalDilution_ == b.horizontalDilution_
+	            && a.verticalDilution_ == b.verticalDilution_ && a.altitude_ == b.altitude_ && a.latitude_ == b.latitude_
+	            && a.longitude_ == b.longitude_ && a.speed_ == b.speed_ && a.travelAngle_ == b.travelAngle_
+	            && a.trackingSatellites_ == b.trackingSatellites_ && a.visibleSatellites_ == b.visibleSatellites_
+	            && a.timestamp_.rawTime_ == b.timestamp_.rawTime_ && a.timestamp_.rawDate_ == b.timestamp_.rawDate_
+	            && a.almanac_.satellites_.size() == b.almanac_.satellites_.size();
+	for ( size_t i = 0; same && i < a.almanac_.satellites_.size(); i++ ) {
+		const GPSSatellite& sa = a.almanac_.satellites_[i];
+		const GPSSatellite& sb = b.almanac_.satellites_[i];
+		same = sa.prn_ == sb.prn_ && sa.elevation_ == sb.elevation_ && sa.azimuth_ == sb.azimuth_ && sa.snr_ == sb.snr_;
+	}
+	return same;
+}
+
+// Lines that are GPS sentences FixedNMEAParser can hold, the rest aren't read the same way by design
+static bool
+comparable(const string& line)
+{
+	static const char* names[] = { "$GPGGA,", "$GPGSA,", "$GPGSV,", "$GPRMC,", "$GPVTG," };
+	if ( line.size() > SentenceView::MaxSentenceSize - 2 ) {
+		return false;
+	}
+	for ( const char* name: names ) {
+		if ( line.rfind(name, 0) == 0 ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void
+compare(const vector<string>& lines, const char* source)
+{
+	NMEAParser      parser;
+	GPSService      gps(parser);
+	FixedNMEAParser fixedParser;
+	FixedGPSService fixedGps(fixedParser);
+
+	size_t compared = 0;
+	size_t rejected = 0;
+	for ( const auto& line: lines ) {
+		if ( !comparable(line) ) {
+			continue;
+		}
+		bool failed = false;
+		try {
+			parser.readSentence(line);
+		}
+		catch ( NMEAParseError& ) {
+			failed = true;
+		}
+		bool fixedFailed = fixedParser.readSentence(line) != ParseStatus::Ok;
+
+		compared++;
+		rejected += failed ? 1 : 0;
+		if ( !CHECK(failed == fixedFailed) || !CHECK(sameFix(gps.fix_, fixedGps.fix_)) ) {
+			fprintf(stderr, "  %s: %s\n", source, line.c_str());
+			return;
+		}
+	}
+	CHECK(compared > 10);
+	printf("%s: %zu sentences agree, %zu rejected by both\n", source, compared, rejected);
+}
+
+int
+main()
+{
+	vector<string> corpus;
+	ifstream       file(NEMATODE_TEST_CORPUS);
+	for ( string line; getline(file, line); ) {
+		if ( !line.empty() && line.back() == '\r' ) {
+			line.pop_back();
+		}
+		corpus.push_back(line);
+	}
+	compare(corpus, "corpus");
+
+	NMEAGeneratorSettings settings;
+	settings.rate           = 10.0;
+	settings.corruptionRate = 0.05;
+	NMEAGenerator  generator(settings);
+	vector<string> synthetic;
+	char           buf[NMEAGenerator::MaxEpochSize];
+	for ( int e = 0; e < 200; e++ ) {
+		string epoch(buf, generator.nextEpoch(buf, sizeof(buf)));
+		for ( size_t start = 0, end; (end = epoch.find('\n', start)) != string::npos; start = end + 1 ) {
+			synthetic.push_back(epoch.substr(start, end - start - 1)); // without the "\r\n"
+		}
+	}
+	compare(synthetic, "synthetic");
+
+	// a sentence without a checksum is rejected by both, and not as a mismatch
+	NMEAParser      parser;
+	GPSService      gps(parser);
+	FixedNMEAParser fixedParser;
+	FixedGPSService fixedGps(fixedParser);
+	string          message;
+	try {
+		parser.readSentence("$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38");
+	}
+	catch ( NMEAParseError& ex ) {
+		message = ex.message_;
+	}
+	CHECK(message.find("Checksum is missing") != string::npos);
+	CHECK(fixedParser.readSentence("$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38") == ParseStatus::MissingChecksum);
+	CHECK(fixedParser.readSentence("$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*00") == ParseStatus::ChecksumMismatch);
+
+	return nmea::test::finish();
+}
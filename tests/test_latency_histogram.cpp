@@ -0,0 +1,83 @@
+/*
+ * test_latency_histogram.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// Known values into LatencyHistogram, and the percentiles they come back as:
+// exact below 16 ns, the top of their bucket above, and no more than the
+// largest value recorded.
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#include "check.hpp"
+#include "nmeaparse/LatencyHistogram.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace nmea;
+
+int
+main()
+{
+	using H = LatencyHistogram;
+
+	// bucket edges: 1 ns wide up to 31, then 16 buckets per power of two
+	CHECK(H::bucketIndex(0) == 0 && H::bucketIndex(15) == 15 && H::bucketIndex(16) == 16 && H::bucketIndex(31) == 31);
+	CHECK(H::bucketIndex(32) == 32 && H::bucketIndex(33) == 32 && H::bucketIndex(34) == 33);
+	CHECK(H::bucketUpperBound(31) == 31 && H::bucketUpperBound(32) == 33 && H::bucketUpperBound(33) == 35);
+	for ( uint32_t i = 1; i < H::BucketCount; i++ ) {
+		CHECK(H::bucketIndex(H::bucketUpperBound(i)) == i);
+		CHECK(H::bucketIndex(H::bucketUpperBound(i - 1) + 1) == i);
+	}
+	for ( uint64_t value = 1; value < (uint64_t(1) << H::MaxValueBits); value = value * 3 + 1 ) {
+		CHECK(H::bucketUpperBound(H::bucketIndex(value)) - value <= value / H::SubBucketCount);
+	}
+
+	// past 2^34 - 1 everything is in the last bucket
+	const uint64_t last = (uint64_t(1) << H::MaxValueBits) - 1;
+	CHECK(H::bucketIndex(last) == H::BucketCount - 1 && H::bucketUpperBound(H::BucketCount - 1) == last);
+	CHECK(H::bucketIndex(last + 1) == H::BucketCount - 1);
+	CHECK(H::bucketIndex(numeric_limits<uint64_t>::max()) == H::BucketCount - 1);
+
+	// exact values
+	LatencyHistogram small;
+	CHECK(small.percentile(50) == 0 && small.mean() == 0);
+	for ( uint64_t value = 1; value <= 10; value++ ) {
+		small.record(value);
+	}
+	CHECK(small.count() == 10 && small.max() == 10);
+	CHECK_NEAR(small.mean(), 5.5, 1e-12);
+	CHECK(small.percentile(0) == 1 && small.percentile(10) == 1 && small.percentile(50) == 5);
+	CHECK(small.percentile(94) == 9 && small.percentile(96) == 10 && small.percentile(100) == 10);
+
+	// 90 of 1000 ns, bucket 992-1023, and 10 of 5000 ns, which is also the largest
+	LatencyHistogram hist;
+	for ( int i = 0; i < 90; i++ ) {
+		hist.record(nanoseconds(1000));
+	}
+	for ( int i = 0; i < 10; i++ ) {
+		hist.record(microseconds(5));
+	}
+	CHECK(hist.percentile(50) == 1023 && hist.percentile(90) == 1023);
+	CHECK(hist.percentile(91) == 5000 && hist.percentile(100) == 5000);
+
+	// a value past the last bucket's bound comes back as itself, not as the
+	// bound; 5000 ns now as the top of its bucket, 5119
+	hist.record(hours(1));
+	const uint64_t hour = static_cast<uint64_t>(nanoseconds(hours(1)).count());
+	CHECK(hist.max() == hour);
+	CHECK(hist.percentile(100) == hour);
+	CHECK(hist.percentile(99) == 5119);
+	CHECK(hist.percentile(89) == 1023);
+
+	// negative durations count as 0
+	hist.reset();
+	CHECK(hist.count() == 0 && hist.max() == 0 && hist.percentile(50) == 0);
+	hist.record(nanoseconds(-5));
+	CHECK(hist.count() == 1 && hist.percentile(100) == 0);
+
+	return nmea::test::finish();
+}
@@ -0,0 +1,155 @@
+/*
+ * test_log_index.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// A log over UTC midnight, each epoch's GGA before its RMC, so the first GGA
+// of the day comes with the date of the day before. The index has to put it on
+// the next day, and LogReader has to start there.
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "nmeaparse/GPSService.hpp"
+#include "nmeaparse/LogIndex.hpp"
+#include "nmeaparse/NMEAParser.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace nmea;
+
+namespace {
+
+const UTCTime Midnight = UTCTime(seconds(1584316800)); // 2020-03-16
+
+// "$" + body + its checksum + CRLF
+string
+sentence(const string& body)
+{
+	uint8_t checksum = 0;
+	for ( char chr: body ) {
+		checksum ^= static_cast<uint8_t>(chr);
+	}
+	char hex[6];
+	snprintf(hex, sizeof(hex), "*%02X\r\n", checksum);
+	return "$" + body + hex;
+}
+
+struct Log {
+	string           text;
+	vector<uint64_t> gga; // offsets of the GGA lines
+	vector<uint64_t> rmc;
+};
+
+// 1 Hz from 23:59:57 to 00:00:03, GGA, RMC and GSA each second
+Log
+overMidnight()
+{
+	const char* times[] = { "235957.00", "235958.00", "235959.00", "000000.00", "000001.00", "000002.00", "000003.00" };
+	Log         log;
+	for ( const char* time: times ) {
+		string date = time[0] == '2' ? "150320" : "160320";
+		log.gga.push_back(log.text.size());
+		log.text += sentence("GPGGA," + string(time) + ",5321.6802,N,00630.3372,W,1,08,1.0,100.0,M,50.0,M,,");
+		log.rmc.push_back(log.text.size());
+		log.text += sentence("GPRMC," + string(time) + ",A,5321.6802,N,00630.3372,W,0.0,0.0," + date + ",,,A");
+		log.text += sentence("GPGSA,A,3,04,05,09,12,,,,,,,,,2.5,1.0,2.3");
+	}
+	return log;
+}
+
+bool
+throwsOnLoad(const string& saved, LogIndex& index)
+{
+	try {
+		istringstream in(saved);
+		index.load(in);
+	}
+	catch ( const runtime_error& ) {
+		return true;
+	}
+	return false;
+}
+
+} // namespace
+
+int
+main()
+{
+	const Log log = overMidnight();
+
+	// one entry a second, at the first line that has its time: the first RMC,
+	// then every GGA, the one after midnight included
+	istringstream file(log.text);
+	LogIndex      index;
+	index.build(file);
+	CHECK(index.logSize() == log.text.size());
+	if ( CHECK(index.entries().size() == 7) ) {
+		for ( size_t i = 0; i < 7; i++ ) {
+			CHECK(index.entries()[i].time_ == Midnight + seconds(i) - seconds(3));
+			CHECK(index.entries()[i].offset_ == (i == 0 ? log.rmc[0] : log.gga[i]));
+		}
+	}
+	CHECK(index.find(Midnight)->offset_ == log.gga[3]);
+	CHECK(index.find(Midnight + milliseconds(1500))->offset_ == log.gga[4]);
+	CHECK(index.find(Midnight - hours(1))->offset_ == log.rmc[0]);
+
+	// save and load give back the same index, a damaged one is refused and changes nothing
+	ostringstream out;
+	index.save(out);
+	const string saved = out.str();
+	LogIndex     loaded(seconds(5));
+	CHECK(!throwsOnLoad(saved, loaded));
+	CHECK(loaded.interval() == index.interval() && loaded.logSize() == index.logSize());
+	if ( CHECK(loaded.entries().size() == index.entries().size()) ) {
+		for ( size_t i = 0; i < loaded.entries().size(); i++ ) {
+			CHECK(loaded.entries()[i].time_ == index.entries()[i].time_ && loaded.entries()[i].offset_ == index.entries()[i].offset_);
+		}
+	}
+	for ( size_t size: { saved.size() - 1, size_t(30), size_t(12), size_t(0) } ) {
+		CHECK(throwsOnLoad(saved.substr(0, size), loaded));
+	}
+	string magic = saved;
+	magic[0]     = 'X';
+	CHECK(throwsOnLoad(magic, loaded));
+	CHECK(loaded.entries().size() == 7 && loaded.interval() == seconds(1));
+
+	// seek past midnight, after a warm up from 23:59:59
+	NMEAParser     parser;
+	GPSService     gps(parser);
+	vector<string> seen; // name and time of the sentences read
+	int            updates = 0;
+	parser.onSentence_ += [&seen](const NMEASentence& nmea) { seen.push_back(nmea.name_ + " " + (nmea.name_ == "GPGSA" ? "" : nmea.parameters_[0])); };
+	gps.onUpdate += [&updates]() { updates++; };
+
+	LogReader reader(file, loaded, parser);
+	CHECK(reader.seek(Midnight + seconds(1), &gps, seconds(2)));
+	CHECK(reader.offset() == log.gga[4]);
+	CHECK((seen == vector<string>{ "GPGGA 235959.00", "GPRMC 235959.00", "GPGSA ", "GPGGA 000000.00", "GPRMC 000000.00", "GPGSA " }));
+	CHECK(updates == 0); // held back while warming up
+	CHECK(gps.fix_.timestamp_.toUTCTime() == Midnight);
+
+	// the first sentence of the epoch is pending, next() reads it
+	seen.clear();
+	CHECK(reader.next());
+	CHECK((seen == vector<string>{ "GPGGA 000001.00" }));
+	CHECK(updates != 0);
+	CHECK(reader.offset() == log.rmc[4]);
+	while ( reader.next() ) {
+	}
+	CHECK(reader.offset() == log.text.size());
+	CHECK(seen.size() == 9);
+
+	// before the log starts at its first time, nothing after its end
+	CHECK(reader.seek(Midnight - hours(1), nullptr, seconds(0)));
+	CHECK(reader.offset() == log.rmc[0]);
+	CHECK(!reader.seek(Midnight + minutes(1)));
+
+	return nmea::test::finish();
+}
@@ -0,0 +1,106 @@
+/*
+ * test_metrics.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// More threads than shards count into one Metrics at once, the exports have
+// to add up to every count.
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "nmeaparse/Metrics.hpp"
+
+using namespace std;
+using namespace nmea;
+
+int
+main()
+{
+	const int Threads = 20;
+	const int Rounds  = 1000;
+
+	Metrics metrics;
+	metrics.trackMemory("parser", []() { return size_t(1024); });
+
+	vector<thread> threads;
+	for ( int t = 0; t < Threads; t++ ) {
+		threads.emplace_back([&metrics]() {
+			for ( int i = 0; i < Rounds; i++ ) {
+				metrics.add(Metrics::BytesIn, 3);
+				metrics.addSentence("GPGGA");
+				if ( i % 10 == 0 ) {
+					metrics.addSentence("GPRMC");
+				}
+			}
+			metrics.add(Metrics::ChecksumFailures);
+			metrics.addDecodeError("GPRMC");
+		});
+	}
+	for ( auto& thread: threads ) {
+		thread.join();
+	}
+
+	CHECK(metrics.get(Metrics::BytesIn) == 60000);
+	CHECK(metrics.get(Metrics::Sentences) == 22000);
+
+	CHECK(metrics.toPrometheus("receiver=\"r42\"")
+	      == "# TYPE nmea_bytes_in_total counter\n"
+	         "nmea_bytes_in_total{receiver=\"r42\"} 60000\n"
+	         "# TYPE nmea_sentences_total counter\n"
+	         "nmea_sentences_total{receiver=\"r42\"} 22000\n"
+	         "# TYPE nmea_checksum_failures_total counter\n"
+	         "nmea_checksum_failures_total{receiver=\"r42\"} 20\n"
+	         "# TYPE nmea_buffer_overflows_total counter\n"
+	         "nmea_buffer_overflows_total{receiver=\"r42\"} 0\n"
+	         "# TYPE nmea_discarded_bytes_total counter\n"
+	         "nmea_discarded_bytes_total{receiver=\"r42\"} 0\n"
+	         "# TYPE nmea_invalid_lines_total counter\n"
+	         "nmea_invalid_lines_total{receiver=\"r42\"} 0\n"
+	         "# TYPE nmea_invalid_sentences_total counter\n"
+	         "nmea_invalid_sentences_total{receiver=\"r42\"} 0\n"
+	         "# TYPE nmea_handler_misses_total counter\n"
+	         "nmea_handler_misses_total{receiver=\"r42\"} 0\n"
+	         "# TYPE nmea_decode_errors_total counter\n"
+	         "nmea_decode_errors_total{receiver=\"r42\"} 20\n"
+	         "# TYPE nmea_skipped_sentences_total counter\n"
+	         "nmea_skipped_sentences_total{receiver=\"r42\"} 0\n"
+	         "# TYPE nmea_skipped_bytes_total counter\n"
+	         "nmea_skipped_bytes_total{receiver=\"r42\"} 0\n"
+	         "# TYPE nmea_sentences_by_name_total counter\n"
+	         "nmea_sentences_by_name_total{receiver=\"r42\",sentence=\"GPGGA\"} 20000\n"
+	         "nmea_sentences_by_name_total{receiver=\"r42\",sentence=\"GPRMC\"} 2000\n"
+	         "# TYPE nmea_decode_errors_by_name_total counter\n"
+	         "nmea_decode_errors_by_name_total{receiver=\"r42\",sentence=\"GPRMC\"} 20\n"
+	         "# TYPE nmea_memory_bytes gauge\n"
+	         "nmea_memory_bytes{receiver=\"r42\",instance=\"parser\"} 1024\n");
+
+	CHECK(metrics.toJSON()
+	      == "{\"bytes_in\":60000,\"sentences\":22000,\"checksum_failures\":20,\"buffer_overflows\":0,\"discarded_bytes\":0,"
+	         "\"invalid_lines\":0,\"invalid_sentences\":0,\"handler_misses\":0,\"decode_errors\":20,\"skipped_sentences\":0,"
+	         "\"skipped_bytes\":0,\"sentences_by_name\":{\"GPGGA\":20000,\"GPRMC\":2000},\"decode_errors_by_name\":{\"GPRMC\":20},"
+	         "\"memory_bytes\":{\"parser\":1024}}");
+
+	// without labels, and after a reset the names stay, at 0
+	metrics.untrackMemory("parser");
+	metrics.reset();
+	string text = metrics.toPrometheus();
+	CHECK(text.find("nmea_bytes_in_total 0\n") != string::npos);
+	CHECK(text.find("nmea_sentences_by_name_total{sentence=\"GPGGA\"} 0\n") != string::npos);
+	CHECK(text.find("instance=") == string::npos);
+
+	// names past the table of a shard are counted as other
+	Metrics names;
+	for ( int i = 0; i < 70; i++ ) {
+		names.addSentence("P" + to_string(100 + i));
+	}
+	auto counts = names.sentences();
+	CHECK(counts.size() == Metrics::MaxSentenceTypes + 1);
+	CHECK(counts["other"] == 70 - Metrics::MaxSentenceTypes);
+	CHECK(names.get(Metrics::Sentences) == 70);
+
+	return nmea::test::finish();
+}
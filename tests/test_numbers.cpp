@@ -0,0 +1,82 @@
+/*
+ * test_numbers.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include <cstdint>
+
+#include "check.hpp"
+#include "nmeaparse/NumberConversion.hpp"
+
+using namespace nmea;
+
+static bool
+readsDouble(const char* text, double expected)
+{
+	double value = -1;
+	return tryParseDouble(text, value) && value == expected;
+}
+
+static bool
+readsInt(const char* text, int64_t expected)
+{
+	int64_t value = -1;
+	return tryParseInt(text, value) && value == expected;
+}
+
+static bool
+rejectsDouble(const char* text)
+{
+	double value = 0;
+	return !tryParseDouble(text, value);
+}
+
+static bool
+rejectsInt(const char* text)
+{
+	int64_t value = 0;
+	return !tryParseInt(text, value);
+}
+
+int
+main()
+{
+	CHECK(readsDouble("", 0));
+	CHECK(readsDouble("5.5", 5.5));
+	CHECK(readsDouble("+5.5", 5.5));
+	CHECK(readsDouble("-5.5", -5.5));
+	CHECK(rejectsDouble("+"));
+	CHECK(rejectsDouble("+-5"));
+	CHECK(rejectsDouble("++5"));
+	CHECK(rejectsDouble("-+5"));
+	CHECK(rejectsDouble("--5"));
+	CHECK(rejectsDouble("5.5x"));
+
+	CHECK(readsInt("", 0));
+	CHECK(readsInt("42", 42));
+	CHECK(readsInt("+42", 42));
+	CHECK(readsInt("-42", -42));
+	CHECK(rejectsInt("+"));
+	CHECK(rejectsInt("+-42"));
+	CHECK(rejectsInt("++42"));
+	CHECK(rejectsInt("-+42"));
+	CHECK(rejectsInt("--42"));
+	CHECK(rejectsInt("4.2"));
+
+#ifndef NEMATODE_EMBEDDED
+	// the throwing versions agree
+	for ( const char* text : { "+-5", "++5", "-+5", "+" } ) {
+		bool threw = false;
+		try {
+			(void) parseDouble(text);
+		}
+		catch ( NumberConversionError& ) {
+			threw = true;
+		}
+		CHECK(threw);
+	}
+#endif
+
+	return nmea::test::finish();
+}
@@ -0,0 +1,59 @@
+/*
+ * test_output_profile.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include <string>
+
+#include "check.hpp"
+#include "nmeaparse/NMEAParser.hpp"
+#include "nmeaparse/OutputProfile.hpp"
+
+using namespace std;
+using namespace nmea;
+
+int
+main()
+{
+	const string gga = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n";
+	const string gsa = "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A\r\n";
+
+	NMEAParser parser;
+	parser.setSentenceHandler("GPGGA", [](const NMEASentence&) {});
+	OutputMonitor monitor(parser);
+
+	// the monitor's own listener doesn't want every type
+	CHECK(!parser.hasListeners());
+	OutputProfile wanted;
+	wanted.addHandlers(parser);
+	CHECK(wanted.rate(NMEASentence::GGA) == 1);
+	CHECK(wanted.rate(NMEASentence::GSA) == 0);
+	CHECK(wanted.rate(NMEASentence::RMC) == 0);
+
+	// nor does it make the parser read sentences nothing handles
+	parser.setInterest(NMEAParser::Interest::Handlers);
+	parser.readLine(gga);
+	parser.readLine(gsa);
+	CHECK(monitor.count(NMEASentence::GGA) == 1);
+	CHECK(monitor.count(NMEASentence::GSA) == 0);
+
+	// any other listener does both
+	{
+		EventHandler<void(const NMEASentence&)> listener = parser.onSentence_ += [](const NMEASentence&) {};
+		CHECK(parser.hasListeners());
+		OutputProfile all;
+		all.addHandlers(parser);
+		CHECK(all.rate(NMEASentence::GSA) == 1);
+		parser.readLine(gsa);
+		CHECK(monitor.count(NMEASentence::GSA) == 1);
+		parser.onSentence_ -= listener;
+	}
+
+	// everything is counted with Interest::All
+	parser.setInterest(NMEAParser::Interest::All);
+	parser.readLine(gsa);
+	CHECK(monitor.count(NMEASentence::GSA) == 2);
+
+	return nmea::test::finish();
+}
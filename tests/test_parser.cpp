@@ -0,0 +1,81 @@
+/*
+ * test_parser.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "nmeaparse/NMEAParser.hpp"
+#include "nmeaparse/SentenceRange.hpp"
+#include "nmeaparse/SentenceView.hpp"
+
+using namespace std;
+using namespace nmea;
+
+int
+main()
+{
+	NMEAParser   parser;
+	NMEASentence last;
+	parser.onSentence_ += [&](const NMEASentence& nmea) { last = nmea; };
+
+	// the sentence members are plain std types
+	parser.readSentence("$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76");
+	string         name       = last.name_;
+	vector<string> parameters = last.parameters_;
+	CHECK(name == "GPGGA");
+	CHECK(parameters.size() == 14);
+	CHECK(parameters[0] == "092750.000");
+	CHECK(parameters[13].empty());
+	CHECK(last.checksum_ == "76");
+	CHECK(last.checksumOK());
+
+	// a shorter sentence after a longer one, without a checksum, doesn't keep anything of it
+	parser.readSentence("$GPXYZ,a,b");
+	CHECK(last.name_ == "GPXYZ");
+	CHECK((last.parameters_ == vector<string>{ "a", "b" }));
+	CHECK(last.checksum_.empty());
+	CHECK(!last.checksumIsCalculated_);
+
+	// a sentence read by a handler doesn't touch the one being handled
+	string outerBefore;
+	string outerAfter;
+	string inner;
+	parser.setSentenceHandler("GPOUT", [&](const NMEASentence& nmea) {
+		outerBefore = nmea.text_ + "|" + nmea.parameters_[0];
+		parser.readSentence("$GPIN,inner,longer,than,the,outer,one");
+		inner      = last.parameters_[0];
+		outerAfter = nmea.text_ + "|" + nmea.parameters_[0];
+	});
+	parser.readSentence("$GPOUT,outer");
+	CHECK(outerBefore == "$GPOUT,outer|outer");
+	CHECK(outerAfter == outerBefore);
+	CHECK(inner == "inner");
+
+	// and again, now that both depths have sentences to reuse
+	parser.readSentence("$GPOUT,again");
+	CHECK(outerAfter == "$GPOUT,again|again");
+
+	// views only reject a checksum that is there and wrong
+	SentenceView view;
+	CHECK(parseSentenceView("$GPXYZ,a,b", view) == ParseStatus::Ok);
+	CHECK(!view.checksumMismatch() && !view.checksumOK());
+	CHECK(parseSentenceView("$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76", view) == ParseStatus::Ok);
+	CHECK(!view.checksumMismatch() && view.checksumOK());
+	CHECK(parseSentenceView("$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*77", view) == ParseStatus::Ok);
+	CHECK(view.checksumMismatch());
+
+	string          lines = "$GPXYZ,a,b\r\n$GPXYZ,c*00\r\n$GPXYZ,d*04\r\n";
+	SentenceScanner scanner;
+	string          read;
+	for ( const SentenceView& sentence: scanner.sentences(lines) ) {
+		read += string(sentence.parameter(0));
+	}
+	CHECK(read == "ad");
+	CHECK(scanner.rejected() == 1);
+
+	return nmea::test::finish();
+}
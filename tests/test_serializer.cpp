@@ -0,0 +1,80 @@
+/*
+ * test_serializer.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+
+#include "check.hpp"
+#include "nmeaparse/FixSerializer.hpp"
+
+using namespace std;
+using namespace nmea;
+
+static string
+serialized(const GPSFix& fix, FixSerializerSettings settings, bool header = false)
+{
+	string        out;
+	FixSerializer serializer([&out](const char* data, size_t size) { out.append(data, size); }, settings);
+	if ( header ) {
+		serializer.writeHeader(FixSerializer::FixRecord);
+	}
+	serializer.write(fix);
+	serializer.flush();
+	return out;
+}
+
+int
+main()
+{
+	GPSFix fix;
+	fix.status_      = 'A';
+	fix.type_        = 3;
+	fix.quality_     = 1;
+	fix.latitude_    = 53.36155;
+	fix.longitude_   = -6.50562;
+	fix.altitude_    = 1e300; // too long for fixed decimals
+	fix.speed_       = numeric_limits<double>::quiet_NaN();
+	fix.travelAngle_ = 31.66;
+	fix.timestamp_.setTime(92750.0);
+	fix.timestamp_.setDate(280511);
+
+	FixSerializerSettings json;
+	CHECK(serialized(fix, json)
+	      == "{\"time\":\"2011-05-28T09:27:50.000Z\",\"status\":\"A\",\"lock\":false,\"type\":3,\"quality\":1,\"lat\":53.36155,\"lon\":-6.50562,"
+	         "\"alt\":1e+300,\"speed\":null,\"course\":31.66,\"pdop\":0,\"hdop\":0,\"vdop\":0,\"tracking\":0,\"visible\":0}\n");
+
+	json.coordinatePrecision = 7;
+	json.valuePrecision      = 2;
+	CHECK(serialized(fix, json)
+	      == "{\"time\":\"2011-05-28T09:27:50.000Z\",\"status\":\"A\",\"lock\":false,\"type\":3,\"quality\":1,\"lat\":53.3615500,\"lon\":-6.5056200,"
+	         "\"alt\":1.00e+300,\"speed\":null,\"course\":31.66,\"pdop\":0.00,\"hdop\":0.00,\"vdop\":0.00,\"tracking\":0,\"visible\":0}\n");
+
+	FixSerializerSettings csv;
+	csv.format = SerialFormat::CSV;
+	csv.fields = FixSerializer::Time | FixSerializer::Latitude | FixSerializer::Altitude | FixSerializer::Speed;
+	CHECK(serialized(fix, csv, true) == "time,lat,alt,speed\n2011-05-28T09:27:50.000Z,53.36155,1e+300,\n");
+
+	// negative values that round to zero have no sign
+	fix.altitude_      = -0.001;
+	csv.fields         = FixSerializer::Altitude;
+	csv.valuePrecision = 2;
+	CHECK(serialized(fix, csv) == "0.00\n");
+
+	// the shortest form reads back as the same double
+	mt19937_64                        rng(1);
+	uniform_real_distribution<double> degrees(-180, 180);
+	csv.fields = FixSerializer::Latitude;
+	int differ = 0;
+	for ( int i = 0; i < 10000; i++ ) {
+		fix.latitude_ = i % 2 == 0 ? degrees(rng) : round(degrees(rng) * 1e5) / 1e5;
+		differ += strtod(serialized(fix, csv).c_str(), nullptr) != fix.latitude_ ? 1 : 0;
+	}
+	CHECK(differ == 0);
+
+	return nmea::test::finish();
+}
@@ -0,0 +1,55 @@
+/*
+ * test_shared_fix.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// A reader of a segment whose publisher died in the middle of a write gives
+// up on that slot instead of spinning on it.
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "check.hpp"
+#include "nmeaparse/GPSFix.hpp"
+#include "nmeaparse/SharedFix.hpp"
+
+using namespace std;
+using namespace nmea;
+
+int
+main()
+{
+#if defined(__linux__)
+	string name = "nematode-test-" + to_string(chrono::steady_clock::now().time_since_epoch().count());
+
+	SharedFixSettings settings;
+	settings.slots = 1;
+	{
+		SharedFixPublisher publisher(name, settings);
+		SharedFixReader    reader(name);
+		SharedFixRecord    record;
+		GPSFix             fix;
+		fix.latitude_ = 53.36;
+		publisher.publish(fix);
+		CHECK(reader.latest(record));
+		CHECK(record.sequence_ == 1 && record.latitude_ == 53.36);
+
+		// the publisher starts on fix 2 in the only slot and dies: the layout of
+		// version 1 is a 128 byte header, then the slots, each starting with its
+		// counter, odd while written
+		{
+			fstream  segment("/dev/shm/" + name, ios::in | ios::out | ios::binary);
+			uint64_t writing = 2 * 2 - 1;
+			segment.seekp(128);
+			segment.write(reinterpret_cast<const char*>(&writing), sizeof(writing));
+		}
+		CHECK(!reader.latest(record));
+		CHECK(!reader.next(record));
+	}
+	SharedFixPublisher::remove(name);
+#endif
+	return nmea::test::finish();
+}
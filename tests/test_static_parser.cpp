@@ -0,0 +1,75 @@
+/*
+ * test_static_parser.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// BasicNMEAParser finds a line's handler by the packed name, without parsing
+// the line first. It has to pick the same sentences NMEAParser reads by name.
+
+#include <string>
+#include <string_view>
+
+#include "check.hpp"
+#include "nmeaparse/NMEAGenerator.hpp"
+#include "nmeaparse/NMEAParser.hpp"
+#include "nmeaparse/StaticNMEAParser.hpp"
+
+using namespace std;
+using namespace nmea;
+
+int
+main()
+{
+	int gga      = 0;
+	int gsv      = 0;
+	int short1   = 0;
+	int longest  = 0;
+	auto counter = [](int& count) { return [&count](const SentenceView&) { count++; }; };
+
+	BasicNMEAParser parser(on<sentenceKey("GPGGA")>(counter(gga)), on<sentenceKey("GPGSV")>(counter(gsv)),
+	                       on<sentenceKey("P")>(counter(short1)), on<sentenceKey("PABCDEFG")>(counter(longest)));
+
+	// names of every length, and close misses
+	const char* lines[] = { "$P,1", "$PABCDEFG,1", "$PABCDEFGH,1", "$GPGGAX,1", "$GPGG,1", "$GPGGA", "$GPGSV*55", "$", "$,1" };
+	for ( const char* line: lines ) {
+		parser.readSentence(line);
+	}
+	CHECK(short1 == 1);
+	CHECK(longest == 1);
+	CHECK(gga == 1);
+	CHECK(gsv == 1);
+	CHECK(parser.skipped() == 5);
+
+	// the name after the last '$' or '!', as parseSentenceView() takes it
+	const char* framed[] = { "x$GPGGA,1", "$GPGSV,1$GPGGA,2", "!GPGGA,3", "$GPGGA,4$", "$PABCDEFGH$GPGSV" };
+	for ( const char* line: framed ) {
+		parser.readSentence(line);
+	}
+	CHECK(gga == 4);
+	CHECK(gsv == 2);
+	CHECK(parser.skipped() == 6);
+
+	// the same sentences as NMEAParser, over a minute of a receiver
+	NMEAParser reference;
+	int        referenceGGA = 0;
+	int        referenceGSV = 0;
+	reference.setSentenceHandler("GPGGA", [&](const NMEASentence&) { referenceGGA++; });
+	reference.setSentenceHandler("GPGSV", [&](const NMEASentence&) { referenceGSV++; });
+
+	gga = 0;
+	gsv = 0;
+	NMEAGenerator generator;
+	string        epoch(NMEAGenerator::MaxEpochSize, '\0');
+	for ( int i = 0; i < 60; i++ ) {
+		size_t size = generator.nextEpoch(&epoch[0], epoch.size());
+		parser.readBuffer(reinterpret_cast<const uint8_t*>(epoch.data()), size);
+		reference.readBuffer(reinterpret_cast<uint8_t*>(&epoch[0]), static_cast<uint32_t>(size));
+	}
+	CHECK(gga == 60);
+	CHECK(gga == referenceGGA);
+	CHECK(gsv == referenceGSV);
+	CHECK(gsv != 0);
+
+	return nmea::test::finish();
+}
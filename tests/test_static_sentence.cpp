@@ -0,0 +1,126 @@
+/*
+ * test_static_sentence.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// StaticSentence::set() patches the checksum instead of computing it again, so
+// it has to come out as xorChecksum() of the body as rewritten. Checked while
+// compiling where it can be, then for every value of a template.
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "check.hpp"
+#include "nmeaparse/StaticSentence.hpp"
+
+using namespace std;
+using namespace nmea;
+
+namespace {
+
+constexpr auto RateTemplate = makeSentence("PSRF103,##,00,##,01");
+
+// The checksum and its hex digits agree with the body between '$' and '*'
+template <size_t N>
+constexpr bool
+consistent(const StaticSentence<N>& sentence)
+{
+	string_view text     = sentence.view();
+	uint8_t     checksum = xorChecksum(text.substr(1, text.size() - 6));
+	const char* hex      = "0123456789ABCDEF";
+	return sentence.checksum() == checksum && text[text.size() - 4] == hex[checksum >> 4] && text[text.size() - 3] == hex[checksum & 0xF]
+	       && text.substr(text.size() - 5, 1) == "*" && text.substr(text.size() - 2) == "\r\n";
+}
+
+constexpr StaticSentence<20>
+rate(uint32_t message, uint32_t seconds)
+{
+	auto sentence = RateTemplate;
+	sentence.set(0, message);
+	sentence.set(1, seconds);
+	return sentence;
+}
+
+// set over values set before, the old digits XOR-ed out
+constexpr StaticSentence<20>
+overwritten()
+{
+	auto sentence = rate(97, 53);
+	sentence.set(0, 4);
+	sentence.set(1, 1);
+	return sentence;
+}
+
+// set() that fails leaves the sentence as it was
+constexpr bool
+rejected(size_t placeholder, uint32_t value)
+{
+	auto sentence = rate(4, 1);
+	bool set      = sentence.set(placeholder, value);
+	return !set && sentence.view() == rate(4, 1).view() && sentence.checksum() == rate(4, 1).checksum();
+}
+
+template <size_t N>
+bool
+throwsInvalid(const char (&body)[N])
+{
+	try {
+		StaticSentence<N> sentence(body);
+	}
+	catch ( const invalid_argument& ) {
+		return true;
+	}
+	return false;
+}
+
+} // namespace
+
+// the manual's example, and the template before and after set()
+static_assert(makeSentence("PSRF103,00,01,00,01").view() == "$PSRF103,00,01,00,01*25\r\n");
+static_assert(RateTemplate.placeholders() == 2 && RateTemplate.view() == "$PSRF103,00,00,00,01*24\r\n");
+static_assert(consistent(RateTemplate));
+static_assert(rate(4, 1).view() == "$PSRF103,04,00,01,01*21\r\n");
+static_assert(consistent(rate(4, 1)) && consistent(rate(99, 99)) && consistent(rate(0, 0)));
+static_assert(rate(0, 0).view() == RateTemplate.view());
+static_assert(overwritten().view() == rate(4, 1).view() && consistent(overwritten()));
+
+// no third placeholder, no 3 digits in 2
+static_assert(rejected(2, 1));
+static_assert(rejected(100, 1));
+static_assert(rejected(0, 100));
+static_assert(rejected(1, 4294967295U));
+static_assert(!rejected(1, 99));
+
+int
+main()
+{
+	// every value of both fields, each set over the one before
+	auto sentence = RateTemplate;
+	for ( uint32_t message = 0; message < 100; message++ ) {
+		for ( uint32_t seconds = 0; seconds < 100; seconds++ ) {
+			CHECK(sentence.set(0, message) && sentence.set(1, seconds));
+			if ( !CHECK(consistent(sentence)) ) {
+				return nmea::test::finish();
+			}
+		}
+	}
+
+	// widths up to 10 digits, the largest value there is
+	auto wide = makeSentence("PTEST,##########,#");
+	CHECK(wide.set(0, 4294967295U) && wide.set(1, 7));
+	CHECK(wide.view().substr(0, 20) == "$PTEST,4294967295,7*" && consistent(wide));
+	CHECK(!wide.set(1, 10));
+	CHECK(wide.view().substr(0, 20) == "$PTEST,4294967295,7*" && consistent(wide));
+
+	// what doesn't compile as a constant throws at runtime
+	CHECK(throwsInvalid("GP$GGA"));
+	CHECK(throwsInvalid("GPGGA*"));
+	CHECK(throwsInvalid("GP\tGGA"));
+	CHECK(throwsInvalid("P,###########"));
+	CHECK(throwsInvalid("P,#,#,#,#,#,#,#,#,#,#,#,#,#,#,#,#,#"));
+	CHECK(!throwsInvalid("P,#,#,#,#,#,#,#,#,#,#,#,#,#,#,#,#"));
+
+	return nmea::test::finish();
+}
@@ -0,0 +1,191 @@
+/*
+ * test_track_simplifier.cpp
+ *
+ *  See the license file included with this source.
+ */
+
+// What TrackSimplifier guarantees: every dropped fix of a noisy drive within
+// tolerance of the kept track (opening window) or of the kept point before it
+// (dead band), and the points kept for a full window, an interval, flush() and
+// reset().
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "nmeaparse/Geodesy.hpp"
+#include "nmeaparse/TrackSimplifier.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace nmea;
+
+namespace {
+
+constexpr double DegToRad = 3.14159265358979323846 / 180.0;
+
+FixRecord
+record(size_t i, double lat, double lon, double heading, milliseconds interval)
+{
+	FixRecord record;
+	record.time_        = UTCTime(milliseconds(1306574870000) + interval * static_cast<int64_t>(i));
+	record.latitude_    = lat;
+	record.longitude_   = lon;
+	record.speed_       = 50;
+	record.travelAngle_ = static_cast<float>(heading);
+	return record;
+}
+
+// 10 Hz, straights and turns with half a meter of noise
+vector<FixRecord>
+drive(size_t size)
+{
+	mt19937                     random(13);
+	normal_distribution<double> noise(0, 0.5 / 111000);
+	vector<FixRecord>           fixes;
+	double                      lat     = 53.36;
+	double                      lon     = -6.50;
+	double                      heading = 0;
+	for ( size_t i = 0; i < size; i++ ) {
+		heading += (i / 300) % 3 == 0 ? 0.0 : (i / 300) % 3 == 1 ? 0.6 : -0.3; // degrees per fix
+		lat += 1.4 / 111000 * cos(heading * DegToRad);
+		lon += 1.4 / 111000 * sin(heading * DegToRad) / cos(lat * DegToRad);
+		fixes.push_back(record(i, lat + noise(random), lon + noise(random), fmod(heading + 360 * 100, 360), milliseconds(100)));
+	}
+	return fixes;
+}
+
+// north, a meter a fix
+vector<FixRecord>
+straight(size_t size, milliseconds interval)
+{
+	vector<FixRecord> fixes;
+	for ( size_t i = 0; i < size; i++ ) {
+		fixes.push_back(record(i, 53.36 + static_cast<double>(i) / 111000, -6.50, 0, interval));
+	}
+	return fixes;
+}
+
+vector<FixRecord>
+simplify(const vector<FixRecord>& track, const TrackSimplifierSettings& settings)
+{
+	TrackSimplifier   simplifier(settings);
+	vector<FixRecord> kept;
+	simplifier.onPoint += [&kept](const FixRecord& point) { kept.push_back(point); };
+	for ( const auto& point: track ) {
+		simplifier.push(point);
+	}
+	simplifier.flush();
+	return kept;
+}
+
+// The largest distance of a fix from the kept track (opening window) or the
+// kept point before it (dead band), meters
+double
+largestError(const vector<FixRecord>& track, const vector<FixRecord>& kept, SimplifyMode mode)
+{
+	double error = 0;
+	size_t next  = 1;
+	for ( const auto& point: track ) {
+		while ( next + 1 < kept.size() && kept[next].time_ < point.time_ ) {
+			next++;
+		}
+		const FixRecord& before = kept[next - 1];
+		const FixRecord& after  = kept[next];
+		if ( after.time_ == point.time_ ) {
+			continue; // kept itself
+		}
+		double best = haversineDistance(point.latitude_, point.longitude_, before.latitude_, before.longitude_);
+		for ( int step = 1; mode == SimplifyMode::OpeningWindow && step <= 1000; step++ ) {
+			double u   = step / 1000.0; // along the segment
+			double lat = before.latitude_ + u * (after.latitude_ - before.latitude_);
+			double lon = before.longitude_ + u * (after.longitude_ - before.longitude_);
+			best       = min(best, haversineDistance(point.latitude_, point.longitude_, lat, lon));
+		}
+		error = max(error, best);
+	}
+	return error;
+}
+
+// The positions in track of the kept points
+vector<size_t>
+indices(const vector<FixRecord>& track, const vector<FixRecord>& kept)
+{
+	vector<size_t> found;
+	for ( const auto& point: kept ) {
+		auto at = find_if(track.begin(), track.end(), [&point](const FixRecord& r) { return r.time_ == point.time_; });
+		found.push_back(static_cast<size_t>(at - track.begin()));
+	}
+	return found;
+}
+
+} // namespace
+
+int
+main()
+{
+	// both modes over a drive, to the tolerance give or take the flat earth of a window
+	const vector<FixRecord> track = drive(6000);
+
+	TrackSimplifierSettings window;
+	vector<FixRecord>       kept = simplify(track, window);
+	CHECK(kept.size() > 2 && kept.size() < track.size() / 4);
+	CHECK(kept.front().time_ == track.front().time_ && kept.back().time_ == track.back().time_);
+	CHECK(largestError(track, kept, SimplifyMode::OpeningWindow) <= window.tolerance * 1.01);
+
+	TrackSimplifierSettings deadBand;
+	deadBand.mode          = SimplifyMode::DeadBand;
+	deadBand.tolerance     = 25;
+	deadBand.headingChange = 15;
+	kept                   = simplify(track, deadBand);
+	CHECK(kept.size() > 2 && kept.size() < track.size() / 4);
+	CHECK(kept.front().time_ == track.front().time_ && kept.back().time_ == track.back().time_);
+	CHECK(largestError(track, kept, SimplifyMode::DeadBand) <= deadBand.tolerance * 1.01);
+
+	// a straight line is its ends, unless the window fills up first
+	const vector<FixRecord> line = straight(100, seconds(1));
+	CHECK((indices(line, simplify(line, window)) == vector<size_t>{ 0, 99 }));
+
+	TrackSimplifierSettings small;
+	small.maxWindow = 10;
+	CHECK((indices(line, simplify(line, small)) == vector<size_t>{ 0, 9, 18, 27, 36, 45, 54, 63, 72, 81, 90, 99 }));
+
+	// a point at least every 10 s, in both modes
+	TrackSimplifierSettings interval;
+	interval.maxInterval = seconds(10);
+	CHECK((indices(line, simplify(line, interval)) == vector<size_t>{ 0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 99 }));
+	interval.mode      = SimplifyMode::DeadBand;
+	interval.tolerance = 25;
+	CHECK((indices(line, simplify(line, interval)) == vector<size_t>{ 0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 99 }));
+	interval.tolerance = 5.5; // the distance comes first
+	CHECK((indices(line, simplify(line, interval)) == vector<size_t>{ 0, 6, 12, 18, 24, 30, 36, 42, 48, 54, 60, 66, 72, 78, 84, 90, 96, 99 }));
+
+	// flush() keeps the last point, once
+	TrackSimplifier   simplifier;
+	vector<FixRecord> points;
+	simplifier.onPoint += [&points](const FixRecord& point) { points.push_back(point); };
+	for ( size_t i = 0; i < 50; i++ ) {
+		simplifier.push(line[i]);
+	}
+	CHECK(points.size() == 1 && simplifier.kept() == 1 && simplifier.received() == 50);
+	simplifier.flush();
+	CHECK((indices(line, points) == vector<size_t>{ 0, 49 }));
+	simplifier.flush();
+	CHECK(points.size() == 2);
+
+	// reset() drops the window without keeping it: the next point starts a track
+	for ( size_t i = 50; i < 60; i++ ) {
+		simplifier.push(line[i]);
+	}
+	simplifier.reset();
+	simplifier.flush();
+	CHECK(points.size() == 2);
+	simplifier.push(line[99]);
+	CHECK((indices(line, points) == vector<size_t>{ 0, 49, 99 }));
+	CHECK(simplifier.kept() == 3 && simplifier.received() == 61);
+
+	return nmea::test::finish();
+}
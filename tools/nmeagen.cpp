@@ -0,0 +1,167 @@
+/*
+ * nmeagen.cpp
+ *
+ *  Writes a synthetic NMEA stream, e.g. to feed a receiver pipeline under test.
+ *
+ *  Usage: nmeagen [--rate hz] [--talker GP] [--epochs n] [--noise meters]
+ *                 [--corrupt probability] [--seed n] [--sentences GGA,RMC,...]
+ *                 [--out file]
+ *
+ *  See the license file included with this source.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "nmeaparse/NMEAGenerator.hpp"
+
+using namespace std;
+using namespace nmea;
+
+static void
+usage()
+{
+	cerr << "Usage: nmeagen [--rate hz] [--talker GP] [--epochs n] [--noise meters]" << endl
+	     << "               [--corrupt probability] [--seed n] [--sentences GGA,GSA,GSV,RMC,VTG]" << endl
+	     << "               [--out file]" << endl
+	     << "Without --epochs the stream is endless. Output goes to stdout unless --out is given." << endl;
+}
+
+static uint32_t
+parseSentences(const string& list)
+{
+	static const pair<const char*, NMEASentence::MessageID> names[] = {
+		{ "GGA", NMEASentence::GGA },
+		{ "GSA", NMEASentence::GSA },
+		{ "GSV", NMEASentence::GSV },
+		{ "RMC", NMEASentence::RMC },
+		{ "VTG", NMEASentence::VTG },
+	};
+
+	uint32_t mask = 0;
+	size_t   pos  = 0;
+	while ( pos <= list.size() ) {
+		size_t comma = list.find(',', pos);
+		string name  = list.substr(pos, comma == string::npos ? string::npos : comma - pos);
+		bool   found = false;
+		for ( const auto& item: names ) {
+			if ( name == item.first ) {
+				mask |= 1u << item.second;
+				found = true;
+			}
+		}
+		if ( !found ) {
+			cerr << "Unknown sentence \"" << name << "\"" << endl;
+			exit(2);
+		}
+		if ( comma == string::npos ) {
+			break;
+		}
+		pos = comma + 1;
+	}
+	return mask;
+}
+
+int
+main(int argc, char** argv)
+{
+	NMEAGeneratorSettings settings;
+	uint64_t              epochs = 0; // 0 = endless
+	string                outPath;
+
+	for ( int i = 1; i < argc; i++ ) {
+		string arg = argv[i];
+		if ( arg == "--help" || arg == "-h" ) {
+			usage();
+			return 0;
+		}
+		if ( i + 1 >= argc ) {
+			usage();
+			return 2;
+		}
+		string value = argv[++i];
+		if ( arg == "--rate" ) {
+			settings.rate = atof(value.c_str());
+		}
+		else if ( arg == "--talker" ) {
+			settings.talker = value;
+		}
+		else if ( arg == "--epochs" ) {
+			epochs = strtoull(value.c_str(), nullptr, 10);
+		}
+		else if ( arg == "--noise" ) {
+			settings.positionNoise = atof(value.c_str());
+		}
+		else if ( arg == "--corrupt" ) {
+			settings.corruptionRate = atof(value.c_str());
+		}
+		else if ( arg == "--seed" ) {
+			settings.seed = strtoull(value.c_str(), nullptr, 10);
+		}
+		else if ( arg == "--sentences" ) {
+			settings.sentences = parseSentences(value);
+		}
+		else if ( arg == "--out" ) {
+			outPath = value;
+		}
+		else {
+			usage();
+			return 2;
+		}
+	}
+
+	if ( settings.rate <= 0 || settings.talker.size() != 2 ) {
+		cerr << "The rate must be positive and the talker two characters." << endl;
+		return 2;
+	}
+
+	FILE* out = stdout;
+	if ( !outPath.empty() ) {
+		out = fopen(outPath.c_str(), "wb");
+		if ( out == nullptr ) {
+			perror(outPath.c_str());
+			return 1;
+		}
+	}
+
+	// Whole epochs are formatted into a large buffer and written with one call,
+	// the generator itself is far faster than any per-sentence write.
+	NMEAGenerator generator(settings);
+	vector<char>  buf(4 << 20);
+	bool          ok = true;
+	while ( ok && (epochs == 0 || generator.epoch() < epochs) ) {
+		size_t used = 0;
+		while ( epochs == 0 || generator.epoch() < epochs ) {
+			size_t len = generator.nextEpoch(buf.data() + used, buf.size() - used);
+			if ( len == 0 ) {
+				break;
+			}
+			used += len;
+		}
+		ok = fwrite(buf.data(), 1, used, out) == used;
+	}
+
+	if ( out != stdout ) {
+		ok = fclose(out) == 0 && ok;
+	}
+	else {
+		ok = fflush(out) == 0 && ok;
+	}
+	if ( !ok ) {
+		perror("nmeagen");
+		return 1;
+	}
+
+	cerr << generator.epoch() << " epochs";
+	if ( settings.corruptionRate > 0 ) {
+		cerr << ", " << generator.corruptions(NMEAGenerator::FlippedBit) << " flipped bits, "
+		     << generator.corruptions(NMEAGenerator::BadChecksum) << " bad checksums, "
+		     << generator.corruptions(NMEAGenerator::Truncated) << " truncated";
+	}
+	cerr << endl;
+	return 0;
+}
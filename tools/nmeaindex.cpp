@@ -0,0 +1,172 @@
+/*
+ * nmeaindex.cpp
+ *
+ *  Builds the seek index of an NMEA log, or prints the fixes of a time window
+ *  of an indexed log without reading everything before it.
+ *
+ *  Usage: nmeaindex log [--interval ms] [--index file]
+ *         nmeaindex log --from time [--to time] [--index file]
+ *
+ *  See the license file included with this source.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "nmeaparse/FixSerializer.hpp"
+#include "nmeaparse/GPSService.hpp"
+#include "nmeaparse/LogIndex.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace nmea;
+
+static void
+usage()
+{
+	cerr << "Usage: nmeaindex log [--interval ms] [--index file]" << endl
+	     << "       nmeaindex log --from time [--to time] [--index file]" << endl
+	     << "Times are UTC, 2011-05-28T09:30:00 or 2011-05-28T09:30:00.500. The index is log.idx" << endl
+	     << "unless --index is given, and is (re)built when it doesn't match the log." << endl;
+}
+
+static bool
+parseTime(const string& text, UTCTime& time)
+{
+	int    year   = 0;
+	int    month  = 0;
+	int    day    = 0;
+	int    hour   = 0;
+	int    minute = 0;
+	double second = 0;
+	if ( sscanf(text.c_str(), "%d-%d-%dT%d:%d:%lf", &year, &month, &day, &hour, &minute, &second) != 6 || year < 2000 || year > 2099 ) {
+		return false;
+	}
+	GPSTimestamp stamp;
+	stamp.setDate(day * 10000 + month * 100 + year % 100);
+	stamp.setTime(hour * 10000 + minute * 100 + second);
+	time = stamp.toUTCTime();
+	return true;
+}
+
+int
+main(int argc, char** argv)
+{
+	if ( argc < 2 || string(argv[1]) == "--help" || string(argv[1]) == "-h" ) {
+		usage();
+		return argc < 2 ? 2 : 0;
+	}
+
+	string       logPath = argv[1];
+	string       indexPath;
+	milliseconds interval = seconds(1);
+	UTCTime      from{};
+	UTCTime      to     = UTCTime::max();
+	bool         window = false;
+	for ( int i = 2; i < argc; i++ ) {
+		string arg = argv[i];
+		if ( i + 1 >= argc ) {
+			usage();
+			return 2;
+		}
+		string value = argv[++i];
+		if ( arg == "--interval" ) {
+			interval = milliseconds(strtoll(value.c_str(), nullptr, 10));
+		}
+		else if ( arg == "--index" ) {
+			indexPath = value;
+		}
+		else if ( arg == "--from" && parseTime(value, from) ) {
+			window = true;
+		}
+		else if ( arg == "--to" && parseTime(value, to) ) {
+		}
+		else {
+			usage();
+			return 2;
+		}
+	}
+	if ( indexPath.empty() ) {
+		indexPath = logPath + ".idx";
+	}
+	if ( interval.count() <= 0 ) {
+		cerr << "The interval must be positive." << endl;
+		return 2;
+	}
+
+	ifstream log(logPath, ios::binary | ios::ate);
+	if ( !log ) {
+		perror(logPath.c_str());
+		return 1;
+	}
+	auto logSize = static_cast<uint64_t>(log.tellg());
+	log.seekg(0);
+
+	// an index of the log as it is now, built if there is none
+	LogIndex index(interval);
+	bool     loaded = false;
+	if ( window ) {
+		ifstream in(indexPath, ios::binary);
+		try {
+			if ( in ) {
+				index.load(in);
+				loaded = index.logSize() == logSize;
+			}
+		}
+		catch ( runtime_error& ex ) {
+			cerr << indexPath << ": " << ex.what() << ", rebuilding it" << endl;
+		}
+	}
+	if ( !loaded ) {
+		index.build(log);
+		ofstream out(indexPath, ios::binary | ios::trunc);
+		index.save(out);
+		if ( !out.flush() ) {
+			perror(indexPath.c_str());
+			return 1;
+		}
+		cerr << index.entries().size() << " entries for " << logSize << " bytes, written to " << indexPath << endl;
+	}
+	if ( !window ) {
+		return 0;
+	}
+
+	// one JSON line per epoch, once all its sentences are in
+	NMEAParser    parser;
+	GPSService    gps(parser);
+	LogReader     reader(log, index, parser);
+	FixSerializer out(stdout);
+	GPSFix        epoch;
+	bool          hasEpoch = false;
+	gps.onUpdate += [&]() {
+		if ( hasEpoch && epoch.timestamp_.toUTCTime() != gps.fix_.timestamp_.toUTCTime() ) {
+			out.write(epoch);
+		}
+		epoch    = gps.fix_;
+		hasEpoch = true;
+	};
+
+	log.clear();
+	if ( !reader.seek(from, &gps) ) {
+		cerr << "Nothing at or after the given time." << endl;
+		return 1;
+	}
+	while ( gps.fix_.timestamp_.toUTCTime() <= to ) {
+		try {
+			if ( !reader.next() ) {
+				break;
+			}
+		}
+		catch ( NMEAParseError& ) {
+			// damaged sentences are part of most captures
+		}
+	}
+	if ( hasEpoch && epoch.timestamp_.toUTCTime() <= to ) {
+		out.write(epoch);
+	}
+	out.flush();
+	return 0;
+}